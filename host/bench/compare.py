@@ -0,0 +1,69 @@
+#!/usr/bin/env python3
+"""Compara dos archivos de resultados de sensor_bench.
+
+Uso: compare.py base.json nuevo.json [--umbral 10]
+
+Acepta tanto el JSON del host como la salida de consola del equipo
+(toma lo que esté entre BENCH_JSON_BEGIN y BENCH_JSON_END).
+Termina con código 1 si algún caso empeora más del umbral (en %) en
+tiempo o ciclos, o si hace más asignaciones de memoria.
+"""
+import argparse
+import json
+import sys
+
+
+def load_results(path):
+    with open(path, encoding='utf-8', errors='ignore') as f:
+        text = f.read()
+    if 'BENCH_JSON_BEGIN' in text:
+        text = text.split('BENCH_JSON_BEGIN', 1)[1].split('BENCH_JSON_END', 1)[0]
+    data = json.loads(text)
+    return data, {r['name']: r for r in data['results']}
+
+
+def delta_pct(old, new):
+    if old == 0:
+        return 0.0
+    return (new - old) * 100.0 / old
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('base')
+    parser.add_argument('nuevo')
+    parser.add_argument('--umbral', type=float, default=10.0,
+                        help='regresión máxima tolerada en tiempo/ciclos (%%)')
+    args = parser.parse_args()
+
+    base_info, base = load_results(args.base)
+    new_info, new = load_results(args.nuevo)
+    print(f"base: {base_info['rev']} ({base_info['target']})  nuevo: {new_info['rev']} ({new_info['target']})")
+    print(f"{'caso':<22} {'ns/op':>18} {'ciclos/op':>18} {'allocs/op':>14} {'B/op':>14}")
+
+    regressions = []
+    for name, cur in new.items():
+        old = base.get(name)
+        if old is None:
+            print(f"{name:<22} (nuevo)")
+            continue
+        ns = delta_pct(old['ns_per_op'], cur['ns_per_op'])
+        cyc = delta_pct(old['cycles_per_op'], cur['cycles_per_op'])
+        print(f"{name:<22} {cur['ns_per_op']:>10.1f} {ns:+6.1f}% {cur['cycles_per_op']:>10.1f} {cyc:+6.1f}% "
+              f"{old['allocs_per_op']:>6.2f}->{cur['allocs_per_op']:<6.2f} "
+              f"{old['alloc_bytes_per_op']:>6.0f}->{cur['alloc_bytes_per_op']:<6.0f}")
+        if ns > args.umbral or cyc > args.umbral:
+            regressions.append(f"{name}: tiempo {ns:+.1f}%, ciclos {cyc:+.1f}%")
+        if cur['allocs_per_op'] > old['allocs_per_op'] or cur['alloc_bytes_per_op'] > old['alloc_bytes_per_op']:
+            regressions.append(f"{name}: más asignaciones de memoria")
+
+    if regressions:
+        print("\nRegresiones:")
+        for r in regressions:
+            print(f"  - {r}")
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,393 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "cJSON.h"
+#include "config.h"
+#include "hal_adc.h"
+#include "hal_clock.h"
+#include "task_main.h"
+#include "task_sensor.h"
+#include "task_sensor_config.h"
+#include "task_sensors_unified.h"
+#include "task_http.h"
+#include "task_mqtt.h"
+#include "task_error_logger.h"
+#include "http_compress.h"
+#if CONFIG_IDF_TARGET_LINUX
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#else
+#include "esp_cpu.h"
+#include "adc_shared.h"
+#endif
+
+// Microbenchmarks de los caminos calientes del pipeline. Cada caso se ejecuta
+// N veces y se reporta por operación: tiempo, ciclos de CPU, asignaciones de
+// memoria (las que pasan por cJSON) y bytes producidos. Los casos de
+// compresión reportan además los bytes de entrada y el costo por KB.
+//
+// Salida: JSON en BENCH_OUTPUT (por defecto bench_results.json) en el host;
+// en el equipo se imprime por consola entre BENCH_JSON_BEGIN y BENCH_JSON_END.
+
+static const char *TAG = "BENCH";
+
+#ifndef BENCH_GIT_REV
+#define BENCH_GIT_REV "unknown"
+#endif
+
+#define BENCH_MAX_CASES 16
+#define BENCH_DEDUP_ENTRIES 20  // Tabla de deduplicación llena (MAX_ERROR_TYPES)
+
+void host_runtime_init(void);
+
+// ============= CONTADORES =============
+
+static uint32_t alloc_count = 0;
+static uint32_t alloc_bytes = 0;
+
+static void *bench_malloc(size_t size)
+{
+    alloc_count++;
+    alloc_bytes += size;
+    return malloc(size);
+}
+
+static void bench_free(void *ptr)
+{
+    free(ptr);
+}
+
+static inline uint64_t bench_cycles(void)
+{
+#if !CONFIG_IDF_TARGET_LINUX
+    return esp_cpu_get_cycle_count();
+#elif defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0; // Sin contador de ciclos: solo se reporta tiempo
+#endif
+}
+
+// Evita que el compilador descarte los resultados de los casos
+static volatile int32_t bench_sink;
+
+// ============= CASOS =============
+
+typedef struct {
+    const char *name;
+    uint32_t iterations;
+    void (*setup)(void);
+    size_t (*run)(uint32_t i);   // Devuelve los bytes producidos por la operación
+} bench_case_t;
+
+typedef struct {
+    const char *name;
+    uint32_t iterations;
+    double ns_per_op;
+    double cycles_per_op;
+    double allocs_per_op;
+    double alloc_bytes_per_op;
+    double out_bytes_per_op;
+    double in_bytes_per_op;     // Solo casos de compresión (0 en el resto)
+} bench_result_t;
+
+static sensor_frame_t bench_frame;
+static error_log_entry_t bench_error;
+static QueueHandle_t bench_queue = NULL;
+static char *bench_json = NULL;                 // Cuerpo a comprimir (casos *_deflate)
+static size_t bench_in_bytes = 0;
+static uint8_t bench_deflate_out[HTTP_COMPRESS_BUFFER_SIZE];
+static const char *bench_mqtt_config =
+    "{\"sensorConfig\":{\"id_sensor\":8,\"interval_seconds\":30,\"state\":\"active\","
+    "\"max_value\":80.5,\"min_value\":null,\"id_user_created\":3,\"id_user_modified\":null,"
+    "\"created_at\":\"2025-01-10T12:00:00Z\",\"modified_at\":\"2025-01-11T08:30:00Z\"}}";
+
+static size_t run_raw_to_mv(uint32_t i)
+{
+    int voltage_mv = 0;
+    hal_adc_raw_to_mv((int)(i & 4095), &voltage_mv);
+    bench_sink = voltage_mv;
+    return 0;
+}
+
+static size_t run_humidity_percent(uint32_t i)
+{
+    bench_sink = (int32_t)(convert_to_humidity_percent((int)(i & 4095)) * 10.0f);
+    return 0;
+}
+
+static size_t run_light_percent(uint32_t i)
+{
+    bench_sink = (int32_t)(convert_to_light_percentage((int)(i & 4095)) * 10.0f);
+    return 0;
+}
+
+static void setup_frame_payload(void)
+{
+    // Trama completa de un ciclo: humedad y luz
+    memset(&bench_frame, 0, sizeof(bench_frame));
+    bench_frame.count = 2;
+    bench_frame.seq = 1;
+    bench_frame.readings[0].type = SENSOR_TYPE_SOIL_HUMIDITY;
+    bench_frame.readings[0].raw_value = 2345;
+    bench_frame.readings[0].adc_voltage = 1890.0f;
+    bench_frame.readings[0].converted_value = 47.36f;
+    bench_frame.readings[1].type = SENSOR_TYPE_LIGHT;
+    bench_frame.readings[1].raw_value = 1234;
+    bench_frame.readings[1].adc_voltage = 995.0f;
+    bench_frame.readings[1].converted_value = 61.5f;
+    sensor_config_begin_update(SENSOR_TYPE_SOIL_HUMIDITY)->id_sensor = 8;
+    sensor_config_end_update(SENSOR_TYPE_SOIL_HUMIDITY);
+    sensor_config_begin_update(SENSOR_TYPE_LIGHT)->id_sensor = 9;
+    sensor_config_end_update(SENSOR_TYPE_LIGHT);
+}
+
+static size_t run_frame_payload(uint32_t i)
+{
+    bench_frame.readings[0].raw_value = 2000 + (int)(i & 1023);
+    char *json_string = http_build_frame_payload(&bench_frame);
+    size_t len = json_string ? strlen(json_string) : 0;
+    free(json_string);
+    return len;
+}
+
+static void setup_error_payload(void)
+{
+    memset(&bench_error, 0, sizeof(bench_error));
+    bench_error.source_type = ERROR_SOURCE_SENSOR;
+    bench_error.id_sensor = 8;
+    bench_error.id_controller_station = -1;
+    bench_error.id_actuator = -1;
+    strcpy(bench_error.error_code, "SENSOR_READ_ERROR");
+    bench_error.severity = ERROR_SEVERITY_ERROR;
+    strcpy(bench_error.message, "Error leyendo sensor de humedad");
+    strcpy(bench_error.details_json, "{\"adc_channel\": 2, \"error\": \"ESP_ERR_TIMEOUT\"}");
+    strcpy(bench_error.ip_address, "192.168.1.50");
+    strcpy(bench_error.device_serial, DEVICE_SERIAL_HUMIDITY);
+}
+
+static size_t run_error_payload(uint32_t i)
+{
+    char *json_string = error_logger_build_payload(&bench_error, 1 + (i % 3));
+    size_t len = json_string ? strlen(json_string) : 0;
+    free(json_string);
+    return len;
+}
+
+// Bytes en el aire: el mismo cuerpo que arman los casos *_payload_json, comprimido
+static void setup_deflate_input(char *json_string)
+{
+    free(bench_json);
+    bench_json = json_string;
+    bench_in_bytes = json_string ? strlen(json_string) : 0;
+}
+
+static void setup_frame_deflate(void)
+{
+    setup_frame_payload();
+    setup_deflate_input(http_build_frame_payload(&bench_frame));
+}
+
+static void setup_error_deflate(void)
+{
+    setup_error_payload();
+    setup_deflate_input(error_logger_build_payload(&bench_error, 1));
+}
+
+static size_t run_deflate(uint32_t i)
+{
+    (void)i;
+    return http_compress((const uint8_t *)bench_json, bench_in_bytes, bench_deflate_out,
+                         sizeof(bench_deflate_out), HTTP_COMPRESS_DEFLATE);
+}
+
+static void setup_dedup(void)
+{
+    setup_error_payload();
+    for (int i = 0; i < BENCH_DEDUP_ENTRIES; i++) {
+        snprintf(bench_error.error_code, sizeof(bench_error.error_code), "BENCH_ERROR_%02d", i);
+        error_logger_dedup_mark_sent(&bench_error);
+    }
+}
+
+static size_t run_dedup_lookup(uint32_t i)
+{
+    // Mitad aciertos (en distintas posiciones de la tabla), mitad fallos
+    snprintf(bench_error.error_code, sizeof(bench_error.error_code), "BENCH_ERROR_%02d",
+             (int)(i % (2 * BENCH_DEDUP_ENTRIES)));
+    uint32_t occurrences = 0;
+    bench_sink = error_logger_dedup_check(&bench_error, &occurrences);
+    return 0;
+}
+
+static void setup_queue_handoff(void)
+{
+    setup_frame_payload();
+    if (bench_queue == NULL) {
+        bench_queue = xQueueCreate(SENSOR_QUEUE_SIZE, sizeof(sensor_frame_t));
+    }
+}
+
+static size_t run_queue_handoff(uint32_t i)
+{
+    sensor_frame_t received;
+    bench_frame.readings[0].raw_value = (int)i;
+    xQueueSend(bench_queue, &bench_frame, 0);
+    xQueueReceive(bench_queue, &received, 0);
+    bench_sink = received.readings[0].raw_value;
+    return sizeof(sensor_frame_t);
+}
+
+static size_t run_config_snapshot(uint32_t i)
+{
+    // Copia completa con el seqlock (lo que paga un lector cuando cambió la versión)
+    sensor_config_t config;
+    sensor_config_get_snapshot((i & 1) ? SENSOR_TYPE_LIGHT : SENSOR_TYPE_SOIL_HUMIDITY, &config);
+    bench_sink = config.id_sensor;
+    return sizeof(sensor_config_t);
+}
+
+static size_t run_mqtt_config(uint32_t i)
+{
+    (void)i;
+    // Incluye el guardado en NVS (simulada) y la lectura de la versión publicada
+    mqtt_process_sensor_config(DEVICE_SERIAL_HUMIDITY, bench_mqtt_config);
+    sensor_config_t config;
+    sensor_config_get_snapshot(SENSOR_TYPE_SOIL_HUMIDITY, &config);
+    bench_sink = config.interval_s;
+    return strlen(bench_mqtt_config);
+}
+
+static const bench_case_t bench_cases[] = {
+    { "adc_raw_to_mv",        100000, NULL,                 run_raw_to_mv },
+    { "humidity_percent",     100000, NULL,                 run_humidity_percent },
+    { "light_percent",        100000, NULL,                 run_light_percent },
+    { "frame_payload_json",   5000,   setup_frame_payload,  run_frame_payload },
+    { "errlog_payload_json",  5000,   setup_error_payload,  run_error_payload },
+    { "frame_deflate",        5000,   setup_frame_deflate,  run_deflate },
+    { "errlog_deflate",       5000,   setup_error_deflate,  run_deflate },
+    { "errlog_dedup_lookup",  50000,  setup_dedup,          run_dedup_lookup },
+    { "sensor_queue_handoff", 50000,  setup_queue_handoff,  run_queue_handoff },
+    { "config_snapshot",      100000, NULL,                 run_config_snapshot },
+    { "mqtt_config_parse",    2000,   NULL,                 run_mqtt_config },
+};
+
+// ============= EJECUCIÓN =============
+
+static void bench_run_case(const bench_case_t *bench, bench_result_t *result)
+{
+    bench_in_bytes = 0;
+    if (bench->setup != NULL) {
+        bench->setup();
+    }
+
+    // Calentamiento (caches, primeras asignaciones)
+    for (uint32_t i = 0; i < bench->iterations / 10; i++) {
+        bench->run(i);
+    }
+
+    alloc_count = 0;
+    alloc_bytes = 0;
+    uint64_t out_bytes = 0;
+
+    int64_t start_us = hal_clock_now_us();
+    uint64_t start_cycles = bench_cycles();
+    for (uint32_t i = 0; i < bench->iterations; i++) {
+        out_bytes += bench->run(i);
+    }
+    uint64_t cycles = bench_cycles() - start_cycles;
+    int64_t elapsed_us = hal_clock_now_us() - start_us;
+
+#if !CONFIG_IDF_TARGET_LINUX
+    cycles &= 0xFFFFFFFF; // Contador de 32 bits (cada caso dura mucho menos que una vuelta)
+#endif
+
+    result->name = bench->name;
+    result->iterations = bench->iterations;
+    result->ns_per_op = (double)elapsed_us * 1000.0 / bench->iterations;
+    result->cycles_per_op = (double)cycles / bench->iterations;
+    result->allocs_per_op = (double)alloc_count / bench->iterations;
+    result->alloc_bytes_per_op = (double)alloc_bytes / bench->iterations;
+    result->out_bytes_per_op = (double)out_bytes / bench->iterations;
+    result->in_bytes_per_op = (double)bench_in_bytes;
+
+    ESP_LOGW(TAG, "%-22s %10.1f ns/op %10.1f ciclos/op %6.2f allocs/op %8.1f B/op",
+             result->name, result->ns_per_op, result->cycles_per_op,
+             result->allocs_per_op, result->alloc_bytes_per_op);
+    if (bench_in_bytes > 0) {
+        ESP_LOGW(TAG, "%-22s %10.1f ns/KB %.0f -> %.0f B en el aire (%.1f%%)",
+                 "", result->ns_per_op * 1024.0 / bench_in_bytes, result->in_bytes_per_op,
+                 result->out_bytes_per_op, 100.0 * result->out_bytes_per_op / bench_in_bytes);
+    }
+}
+
+static void bench_write_json(FILE *out, const bench_result_t *results, size_t count)
+{
+    fprintf(out, "{\"rev\":\"%s\",\"target\":\"%s\",\"results\":[", BENCH_GIT_REV,
+#if CONFIG_IDF_TARGET_LINUX
+            "linux"
+#else
+            CONFIG_IDF_TARGET
+#endif
+    );
+    for (size_t i = 0; i < count; i++) {
+        fprintf(out, "%s\n{\"name\":\"%s\",\"iterations\":%lu,\"ns_per_op\":%.1f,\"cycles_per_op\":%.1f,"
+                "\"allocs_per_op\":%.3f,\"alloc_bytes_per_op\":%.1f,\"out_bytes_per_op\":%.1f,"
+                "\"in_bytes_per_op\":%.1f}",
+                i > 0 ? "," : "", results[i].name, (unsigned long)results[i].iterations,
+                results[i].ns_per_op, results[i].cycles_per_op, results[i].allocs_per_op,
+                results[i].alloc_bytes_per_op, results[i].out_bytes_per_op, results[i].in_bytes_per_op);
+    }
+    fprintf(out, "\n]}\n");
+}
+
+void app_main(void)
+{
+    // Los logs de INFO de los módulos medidos distorsionarían los tiempos
+    esp_log_level_set("*", ESP_LOG_WARN);
+
+    host_runtime_init();
+#if !CONFIG_IDF_TARGET_LINUX
+    init_shared_adc();
+#endif
+
+    cJSON_Hooks hooks = {
+        .malloc_fn = bench_malloc,
+        .free_fn = bench_free,
+    };
+    cJSON_InitHooks(&hooks);
+
+    static bench_result_t results[BENCH_MAX_CASES];
+    size_t count = sizeof(bench_cases) / sizeof(bench_cases[0]);
+
+    ESP_LOGW(TAG, "=== BENCHMARKS (%s) ===", BENCH_GIT_REV);
+    for (size_t i = 0; i < count; i++) {
+        bench_run_case(&bench_cases[i], &results[i]);
+    }
+
+#if CONFIG_IDF_TARGET_LINUX
+    const char *path = getenv("BENCH_OUTPUT");
+    if (path == NULL) {
+        path = "bench_results.json";
+    }
+    FILE *out = fopen(path, "w");
+    if (out == NULL) {
+        ESP_LOGE(TAG, "No se pudo abrir %s", path);
+        exit(1);
+    }
+    bench_write_json(out, results, count);
+    fclose(out);
+    ESP_LOGW(TAG, "Resultados en %s", path);
+    exit(0);
+#else
+    printf("BENCH_JSON_BEGIN\n");
+    bench_write_json(stdout, results, count);
+    printf("BENCH_JSON_END\n");
+    vTaskDelete(NULL);
+#endif
+}
@@ -0,0 +1,440 @@
+#!/usr/bin/env python3
+"""Flota simulada: N instancias del build de host contra el backend local.
+
+Cada instancia tiene sus propios seriales, client_id y señal de ADC
+sintética (HOST_SERIAL_*, HOST_CLIENT_ID, HOST_ADC_SEED) y habla con
+host/mock_backend/mock_backend.py por sockets reales. Sirve para dimensionar
+el backend y validar el espaciado de los envíos antes de un despliegue:
+
+  - arranque simultáneo (--spawn-rate 0), como tras reiniciar el router
+  - caídas y lentitud del backend guionadas con --scenario
+  - tasa de peticiones agregada, latencias de cola, tormentas de reintentos
+    y crecimiento de memoria (RSS) por instancia
+  - espaciado de main/pacing.c con --pacing (mismo JSON que el objeto
+    "pacing" de la config MQTT); '{"phase_offset":false,"rate_per_min":0}'
+    reproduce la flota en fase para comparar
+
+Uso:
+  fleet.py --count 200 --duration 600 [--spawn-rate 0] [--scenario fallas.json]
+           [--pacing '{"rate_per_min":20}'] [--binary host/build/sensor_host.elf]
+           [--workdir fleet_run] [--out reporte.json]
+
+Requiere el build de host (idf.py --preview set-target linux && idf.py build
+en host/). Los logs de cada instancia quedan en <workdir>/inst_NNNN.log.
+"""
+import argparse
+import json
+import os
+import signal
+import statistics
+import subprocess
+import sys
+import time
+import urllib.request
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+DEFAULT_BINARY = os.path.join(HERE, '..', 'build', 'sensor_host.elf')
+MOCK_BACKEND = os.path.join(HERE, '..', 'mock_backend', 'mock_backend.py')
+
+# Límites de los buckets de los histogramas de metrics.c (el último es abierto)
+HIST_BOUNDS_MS = [50, 100, 250, 500, 1000, 2500, 5000, 10000, 20000]
+SNAPSHOT_MARK = '\U0001F4C8 '   # Prefijo del snapshot de métricas en el log (host_main.c)
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description='Flota de dispositivos simulados contra el backend local')
+    parser.add_argument('--count', type=int, default=50, help='Cantidad de instancias')
+    parser.add_argument('--duration', type=int, default=300, help='Segundos de ejecución de cada instancia')
+    parser.add_argument('--spawn-rate', type=float, default=0.0,
+                        help='Instancias lanzadas por segundo (0 = todas a la vez)')
+    parser.add_argument('--binary', default=DEFAULT_BINARY, help='Ejecutable del build de host')
+    parser.add_argument('--scenario', help='Escenario de fallas para el backend local')
+    parser.add_argument('--pacing', help='HOST_PACING de cada instancia (JSON, ver main/pacing.h)')
+    parser.add_argument('--backend', help='Usar un backend ya levantado (host); si no, se lanza uno')
+    parser.add_argument('--http-port', type=int, default=8080)
+    parser.add_argument('--mqtt-port', type=int, default=1883)
+    parser.add_argument('--ntp-port', type=int, default=12300, help='Servidor NTP del backend (0 = sin hora)')
+    parser.add_argument('--workdir', default='fleet_run', help='Directorio para logs y resultados')
+    parser.add_argument('--out', help='Archivo del reporte (por defecto <workdir>/reporte.json)')
+    parser.add_argument('--log-level', default='W', help='HOST_LOG_LEVEL de cada instancia')
+    parser.add_argument('--sample-interval', type=float, default=1.0, help='Período de muestreo (s)')
+    parser.add_argument('--warmup', type=float, default=15.0,
+                        help='Segundos antes de tomar el RSS de referencia de cada instancia')
+    parser.add_argument('--storm-factor', type=float, default=3.0,
+                        help='Una ventana es tormenta si supera factor x la tasa mediana')
+    return parser.parse_args()
+
+
+def read_rss_kb(pid):
+    try:
+        with open('/proc/%d/status' % pid) as f:
+            for line in f:
+                if line.startswith('VmRSS:'):
+                    return int(line.split()[1])
+    except (OSError, ValueError):
+        pass
+    return None
+
+
+def fetch_stats(host, port):
+    try:
+        with urllib.request.urlopen('http://%s:%d/__mock/stats' % (host, port), timeout=2) as r:
+            return json.loads(r.read().decode('utf-8'))
+    except (OSError, ValueError):
+        return None
+
+
+def wait_for_backend(host, port, timeout_s=10.0):
+    deadline = time.monotonic() + timeout_s
+    while time.monotonic() < deadline:
+        if fetch_stats(host, port) is not None:
+            return True
+        time.sleep(0.2)
+    return False
+
+
+class Instance:
+    def __init__(self, index, args, host):
+        self.index = index
+        self.serial_humidity = '0x%04X' % (0x2000 + 2 * index)
+        self.serial_light = '0x%04X' % (0x2000 + 2 * index + 1)
+        self.log_path = os.path.join(args.workdir, 'inst_%04d.log' % index)
+        self.env = dict(os.environ,
+                        HOST_BACKEND_HTTP='%s:%d' % (host, args.http_port),
+                        HOST_BACKEND_MQTT='%s:%d' % (host, args.mqtt_port),
+                        HOST_SERIAL_HUMIDITY=self.serial_humidity,
+                        HOST_SERIAL_LIGHT=self.serial_light,
+                        HOST_CLIENT_ID='fleet-%04d' % index,
+                        HOST_ADC_SEED=str(index + 1),
+                        HOST_RUN_SECONDS=str(args.duration),
+                        HOST_LOG_LEVEL=args.log_level)
+        if args.pacing:
+            self.env['HOST_PACING'] = args.pacing
+        if args.ntp_port:
+            self.env['HOST_NTP_SERVER'] = '%s:%d' % (host, args.ntp_port)
+        self.binary = args.binary
+        self.proc = None
+        self.started = None
+        self.rss_first_kb = None
+        self.rss_last_kb = None
+        self.rss_max_kb = 0
+
+    def start(self):
+        self.log_file = open(self.log_path, 'w')
+        self.proc = subprocess.Popen([self.binary], env=self.env, stdout=self.log_file,
+                                     stderr=subprocess.STDOUT, stdin=subprocess.DEVNULL)
+        self.started = time.monotonic()
+
+    def alive(self):
+        return self.proc is not None and self.proc.poll() is None
+
+    def sample(self, warmup_s):
+        if not self.alive():
+            return
+        rss = read_rss_kb(self.proc.pid)
+        if rss is None:
+            return
+        self.rss_last_kb = rss
+        self.rss_max_kb = max(self.rss_max_kb, rss)
+        if self.rss_first_kb is None and time.monotonic() - self.started >= warmup_s:
+            self.rss_first_kb = rss
+
+    def stop(self):
+        if self.alive():
+            self.proc.send_signal(signal.SIGTERM)
+            try:
+                self.proc.wait(timeout=5)
+            except subprocess.TimeoutExpired:
+                self.proc.kill()
+                self.proc.wait()
+        self.log_file.close()
+
+    def last_snapshot(self):
+        snapshot = None
+        try:
+            with open(self.log_path, encoding='utf-8', errors='ignore') as f:
+                for line in f:
+                    pos = line.find(SNAPSHOT_MARK)
+                    if pos >= 0:
+                        # Hasta la última llave: descarta el código de color del log
+                        text = line[pos + len(SNAPSHOT_MARK):]
+                        try:
+                            snapshot = json.loads(text[:text.rfind('}') + 1])
+                        except ValueError:
+                            pass
+        except OSError:
+            pass
+        return snapshot
+
+
+def hist_percentile(buckets, pct):
+    """Percentil aproximado (límite superior del bucket) de un histograma."""
+    total = sum(buckets)
+    if total == 0:
+        return 0
+    target = total * pct / 100.0
+    acc = 0
+    for i, count in enumerate(buckets):
+        acc += count
+        if acc >= target:
+            return HIST_BOUNDS_MS[i] if i < len(HIST_BOUNDS_MS) else '>%d' % HIST_BOUNDS_MS[-1]
+    return '>%d' % HIST_BOUNDS_MS[-1]
+
+
+def summarize_devices(instances):
+    counters = {}
+    histograms = {}
+    reported = 0
+    per_instance = []
+    for inst in instances:
+        snapshot = inst.last_snapshot()
+        if snapshot is None:
+            continue
+        reported += 1
+        for name, value in snapshot.get('c', {}).items():
+            counters[name] = counters.get(name, 0) + value
+        for name, hist in snapshot.get('h', {}).items():
+            merged = histograms.setdefault(name, {'n': 0, 'max': 0, 'b': [0] * (len(HIST_BOUNDS_MS) + 1)})
+            merged['n'] += hist.get('n', 0)
+            merged['max'] = max(merged['max'], hist.get('max', 0))
+            for i, count in enumerate(hist.get('b', [])[:len(merged['b'])]):
+                merged['b'][i] += count
+        per_instance.append({'index': inst.index, 'http_fail': snapshot.get('c', {}).get('http_fail', 0),
+                             'mqtt_disc': snapshot.get('c', {}).get('mqtt_disc', 0),
+                             'pace_defer': snapshot.get('c', {}).get('pace_defer', 0)})
+
+    latencies = {}
+    for name in ('http_post_ms', 'errlog_post_ms', 'tr_e2e_ms'):
+        hist = histograms.get(name)
+        if hist:
+            latencies[name] = {'n': hist['n'], 'p50': hist_percentile(hist['b'], 50),
+                               'p95': hist_percentile(hist['b'], 95), 'p99': hist_percentile(hist['b'], 99),
+                               'max': hist['max']}
+    worst = sorted(per_instance, key=lambda x: x['http_fail'], reverse=True)[:5]
+    return {'reported': reported, 'counters': counters, 'latency_ms': latencies, 'worst_http_fail': worst}
+
+
+def summarize_memory(instances):
+    growth = []
+    for inst in instances:
+        if inst.rss_first_kb is not None and inst.rss_last_kb is not None:
+            growth.append((inst.rss_last_kb - inst.rss_first_kb, inst))
+    if not growth:
+        return {}
+    values = [g for g, _ in growth]
+    growth.sort(key=lambda x: x[0], reverse=True)
+    return {
+        'instances': len(growth),
+        'rss_median_kb': statistics.median(inst.rss_last_kb for _, inst in growth),
+        'growth_median_kb': statistics.median(values),
+        'growth_max_kb': max(values),
+        'top_growth': [{'index': inst.index, 'first_kb': inst.rss_first_kb, 'last_kb': inst.rss_last_kb,
+                        'max_kb': inst.rss_max_kb} for _, inst in growth[:5]],
+    }
+
+
+def summarize_timeline(timeline, interval_s, storm_factor):
+    rates = [point['rps'] for point in timeline]
+    if not rates:
+        return {}
+    median = statistics.median(rates)
+    threshold = max(median * storm_factor, 1.0)
+    storms = []
+    current = None
+    for point in timeline:
+        if point['rps'] > threshold:
+            if current is None:
+                current = {'start_s': point['t_s'], 'end_s': point['t_s'], 'peak_rps': point['rps'],
+                           'requests': 0}
+                storms.append(current)
+            current['end_s'] = point['t_s']
+            current['peak_rps'] = max(current['peak_rps'], point['rps'])
+            current['requests'] += int(point['rps'] * interval_s)
+        else:
+            current = None
+    return {
+        'rps_median': round(median, 2),
+        'rps_mean': round(statistics.mean(rates), 2),
+        'rps_peak': round(max(rates), 2),
+        'storm_threshold_rps': round(threshold, 2),
+        'storms': storms,
+    }
+
+
+def main():
+    args = parse_args()
+    if not os.path.exists(args.binary):
+        print('No existe %s: compilar primero el build de host' % args.binary, file=sys.stderr)
+        return 1
+    os.makedirs(args.workdir, exist_ok=True)
+    out_path = args.out or os.path.join(args.workdir, 'reporte.json')
+
+    # Cientos de procesos con sockets: subir el límite de descriptores si se puede
+    try:
+        import resource
+        soft, hard = resource.getrlimit(resource.RLIMIT_NOFILE)
+        resource.setrlimit(resource.RLIMIT_NOFILE, (hard, hard))
+    except (ImportError, ValueError, OSError):
+        pass
+
+    backend_proc = None
+    host = args.backend or '127.0.0.1'
+    if args.backend is None:
+        cmd = [sys.executable, MOCK_BACKEND, '--quiet', '--http-port', str(args.http_port),
+               '--mqtt-port', str(args.mqtt_port), '--stats-out', os.path.join(args.workdir, 'backend_stats.json')]
+        if args.ntp_port:
+            cmd += ['--ntp-port', str(args.ntp_port)]
+        if args.scenario:
+            cmd += ['--scenario', args.scenario]
+        backend_log = open(os.path.join(args.workdir, 'backend.log'), 'w')
+        backend_proc = subprocess.Popen(cmd, stdout=backend_log, stderr=subprocess.STDOUT)
+    if not wait_for_backend(host, args.http_port):
+        print('El backend local no responde en %s:%d' % (host, args.http_port), file=sys.stderr)
+        if backend_proc:
+            backend_proc.kill()
+        return 1
+
+    instances = [Instance(i, args, host) for i in range(args.count)]
+    timeline = []
+    started = time.monotonic()
+    next_spawn = 0
+    last_requests = None
+    last_sample = started
+    deadline = started + args.duration + 60 + (args.count / args.spawn_rate if args.spawn_rate > 0 else 0)
+
+    print('Lanzando %d instancias (%s) contra %s:%d' % (
+        args.count, 'todas a la vez' if args.spawn_rate <= 0 else '%.1f/s' % args.spawn_rate,
+        host, args.http_port), flush=True)
+
+    try:
+        while True:
+            elapsed = time.monotonic() - started
+            # Lanzamiento (escalonado o simultáneo)
+            while next_spawn < len(instances) and (args.spawn_rate <= 0 or next_spawn <= elapsed * args.spawn_rate):
+                instances[next_spawn].start()
+                next_spawn += 1
+
+            for inst in instances:
+                inst.sample(args.warmup)
+
+            stats = fetch_stats(host, args.http_port)
+            if stats is not None:
+                requests = stats['requests']
+                now = time.monotonic()
+                dt = max(now - last_sample, 0.001)
+                rps = (requests - last_requests) / dt if last_requests is not None else 0.0
+                last_requests, last_sample = requests, now
+                errors = sum(count for ep in stats['endpoints'].values()
+                             for code, count in ep['status'].items() if not code.startswith(('2', '3')))
+                alive = sum(1 for inst in instances if inst.alive())
+                timeline.append({'t_s': round(elapsed, 1), 'rps': rps, 'alive': alive, 'errors_total': errors,
+                                 'mqtt_connects': stats['mqtt']['connects']})
+                if len(timeline) % 10 == 0:
+                    print('[%6.0f s] vivas=%d  %.1f req/s  errores=%d' % (elapsed, alive, rps, errors), flush=True)
+
+            if next_spawn == len(instances) and not any(inst.alive() for inst in instances):
+                break
+            if time.monotonic() > deadline:
+                print('Tiempo agotado: deteniendo instancias', flush=True)
+                break
+            time.sleep(args.sample_interval)
+    except KeyboardInterrupt:
+        print('Interrumpido: deteniendo instancias', flush=True)
+    finally:
+        for inst in instances:
+            if inst.proc is not None:
+                inst.stop()
+
+    backend_stats = fetch_stats(host, args.http_port)
+    if backend_proc is not None:
+        backend_proc.send_signal(signal.SIGTERM)
+        try:
+            backend_proc.wait(timeout=10)
+        except subprocess.TimeoutExpired:
+            backend_proc.kill()
+
+    exit_codes = {}
+    for inst in instances:
+        if inst.proc is not None:
+            code = str(inst.proc.returncode)
+            exit_codes[code] = exit_codes.get(code, 0) + 1
+
+    report = {
+        'count': args.count,
+        'duration_s': args.duration,
+        'spawn_rate': args.spawn_rate,
+        'scenario': args.scenario,
+        'pacing': args.pacing,
+        'exit_codes': exit_codes,
+        'server': backend_stats,
+        'rate': summarize_timeline(timeline, args.sample_interval, args.storm_factor),
+        'devices': summarize_devices(instances),
+        'memory': summarize_memory(instances),
+        'timeline': timeline,
+    }
+    devices = report['devices']
+    posts_ok = devices['counters'].get('http_ok', 0)
+    if backend_stats and posts_ok:
+        server_posts = backend_stats['endpoints'].get('POST /process-data', {}).get('requests', 0)
+        # > 1: peticiones extra (reintentos) por cada envío exitoso
+        report['rate']['requests_per_ok_post'] = round(server_posts / float(posts_ok), 2)
+
+    with open(out_path, 'w', encoding='utf-8') as f:
+        json.dump(report, f, indent=2)
+
+    rate = report['rate']
+    print('\n=== RESUMEN DE LA FLOTA ===')
+    print('Instancias: %d (códigos de salida %s)' % (args.count, exit_codes))
+    if rate:
+        print('Tasa: mediana %.1f req/s, pico %.1f req/s, %d tormentas (> %.1f req/s)' % (
+            rate['rps_median'], rate['rps_peak'], len(rate['storms']), rate['storm_threshold_rps']))
+        if 'requests_per_ok_post' in rate:
+            print('Peticiones por POST exitoso: %.2f' % rate['requests_per_ok_post'])
+    print('Envíos diferidos por pacing: %d' % devices['counters'].get('pace_defer', 0))
+    counters = devices['counters']
+    print('Breakers: %d aperturas, %d cierres, %d rechazos; buffer local: %d guardadas, %d reenviadas, %d descartadas' % (
+        counters.get('brk_open', 0), counters.get('brk_close', 0), counters.get('brk_reject', 0),
+        counters.get('buf_in', 0), counters.get('buf_out', 0), counters.get('buf_drop', 0)))
+    if counters.get('body_raw_b', 0):
+        # Cuerpos de /process-data y /error-logs (main/http_compress.c)
+        print('Cuerpos HTTP: %d B de JSON, %d B enviados (%.1f%%); compresión %.1f µs de CPU por KB' % (
+            counters['body_raw_b'], counters.get('body_tx_b', 0),
+            100.0 * counters.get('body_tx_b', 0) / counters['body_raw_b'],
+            1024.0 * counters.get('gz_us', 0) / counters['gz_in_b'] if counters.get('gz_in_b', 0) else 0.0))
+    if counters.get('http_fly_ms', 0):
+        print('HTTP: %d ms en vuelo, %d ms bloqueada (%.1f%%; con peticiones bloqueantes sería 100%%)' % (
+            counters['http_fly_ms'], counters.get('http_blk_ms', 0),
+            100.0 * counters.get('http_blk_ms', 0) / counters['http_fly_ms']))
+    for name, lat in devices['latency_ms'].items():
+        print('%-15s n=%-7d p50<=%s p95<=%s p99<=%s max=%s ms' % (
+            name, lat['n'], lat['p50'], lat['p95'], lat['p99'], lat['max']))
+    if report['memory']:
+        mem = report['memory']
+        print('RSS: mediana %d kB, crecimiento mediano %d kB, máximo %d kB' % (
+            mem['rss_median_kb'], mem['growth_median_kb'], mem['growth_max_kb']))
+    if backend_stats:
+        recovery = backend_stats['recovery']
+        print('Recuperación tras fallas: %d medidas, p50 %.0f ms, p95 %.0f ms, máx %.0f ms (%d pendientes)' % (
+            recovery['measured'], recovery['p50_ms'], recovery['p95_ms'], recovery['max_ms'], recovery['pending']))
+        clock = backend_stats['time']
+        print('Hora: %d envíos con timestamp, %d sin sincronizar (%d corregidos, %d pendientes)' % (
+            clock['synced'], clock['unsynced'], clock['corrected'], clock['pending']))
+        uploads = backend_stats['uploads']
+        print('Subidas: %d únicas, %d duplicadas descartadas, %d perdidas (huecos de seq en %d flujos)' % (
+            uploads['unique'], uploads['duplicates'], uploads['lost'], uploads['streams']))
+        data_posts = backend_stats['endpoints'].get('POST /process-data', {}).get('requests', 0)
+        if uploads.get('readings') and data_posts:
+            # Una trama por ciclo: con dos sensores, ~2 lecturas por POST
+            print('Lecturas: %d en %d POST a /process-data (%.2f por petición)' % (
+                uploads['readings'], data_posts, uploads['readings'] / float(data_posts)))
+        config_gets = backend_stats['endpoints'].get('GET /sensors/config', {})
+        if config_gets.get('requests'):
+            # Con la configuración sin cambios, cada arranque cuesta un 304 sin cuerpo
+            print('Configuración: %d GET a /sensors/config, %d sin cambios (304)' % (
+                config_gets['requests'], config_gets['status'].get('304', 0)))
+    print('Reporte: %s' % out_path)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,71 @@
+#include "config.h"
+#include "esp_log.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Identidad del dispositivo en el build de host. Por defecto es la del
+// firmware; la flota simulada (host/fleet) le da a cada instancia la suya:
+//   HOST_SERIAL_HUMIDITY=<serial>  HOST_SERIAL_LIGHT=<serial>  HOST_CLIENT_ID=<id>
+//   HOST_MAC=<aa:bb:cc:dd:ee:ff>
+// Los tópicos de configuración se derivan de los seriales; sin HOST_MAC la
+// MAC (fase y jitter de pacing.c) se deriva del client_id.
+
+static const char *TAG = "HOST_ID";
+
+const char *host_device_serial_humidity = "0x001C";
+const char *host_device_serial_light = "0x001D";
+const char *host_mqtt_client_id = "7b0acd8e8fb242379eb6c4983fc30401";
+const char *host_mqtt_topic_config_humidity = "ong/sensor/0x001C/config";
+const char *host_mqtt_topic_config_light = "ong/sensor/0x001D/config";
+
+static char topic_humidity[MQTT_MAX_TOPIC_LEN];
+static char topic_light[MQTT_MAX_TOPIC_LEN];
+
+void host_identity_init(void)
+{
+    const char *value;
+
+    if ((value = getenv("HOST_SERIAL_HUMIDITY")) != NULL) {
+        host_device_serial_humidity = value;
+        snprintf(topic_humidity, sizeof(topic_humidity), "ong/sensor/%s/config", value);
+        host_mqtt_topic_config_humidity = topic_humidity;
+    }
+    if ((value = getenv("HOST_SERIAL_LIGHT")) != NULL) {
+        host_device_serial_light = value;
+        snprintf(topic_light, sizeof(topic_light), "ong/sensor/%s/config", value);
+        host_mqtt_topic_config_light = topic_light;
+    }
+    if ((value = getenv("HOST_CLIENT_ID")) != NULL) {
+        host_mqtt_client_id = value;
+    }
+
+    ESP_LOGI(TAG, "Identidad: humedad=%s luz=%s client_id=%s",
+             host_device_serial_humidity, host_device_serial_light, host_mqtt_client_id);
+}
+
+void host_identity_mac(uint8_t mac[6])
+{
+    unsigned int bytes[6];
+    const char *value = getenv("HOST_MAC");
+    if (value != NULL && sscanf(value, "%x:%x:%x:%x:%x:%x", &bytes[0], &bytes[1], &bytes[2],
+                                &bytes[3], &bytes[4], &bytes[5]) == 6) {
+        for (int i = 0; i < 6; i++) {
+            mac[i] = (uint8_t)bytes[i];
+        }
+        return;
+    }
+
+    // FNV-1a del client_id como MAC administrada localmente (02:xx:...)
+    uint32_t hash = 2166136261u;
+    for (const char *c = host_mqtt_client_id; *c != '\0'; c++) {
+        hash ^= (uint8_t)*c;
+        hash *= 16777619u;
+    }
+    mac[0] = 0x02;
+    mac[1] = (uint8_t)(hash >> 24);
+    mac[2] = (uint8_t)(hash >> 16);
+    mac[3] = (uint8_t)(hash >> 8);
+    mac[4] = (uint8_t)hash;
+    mac[5] = (uint8_t)(hash >> 13);
+}
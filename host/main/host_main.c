@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "config.h"
+#include "mock_hal.h"
+#include "metrics.h"
+#include "pacing.h"
+#include "circuit_breaker.h"
+#include "http_compress.h"
+#include "config_sync.h"
+#include "config_store.h"
+#include "net_config.h"
+#include "sequence.h"
+#include "time_service.h"
+#include "task_main.h"
+#include "task_sensor.h"
+#include "task_sensor_config.h"
+#include "task_sensors_unified.h"
+#include "task_http.h"
+#include "task_mqtt.h"
+#include "task_error_logger.h"
+
+// Punto de entrada del build de host (target linux de ESP-IDF). Levanta las
+// mismas tareas de aplicación que el firmware, con la HAL simulada.
+// HOST_RUN_SECONDS=<n> termina el proceso tras n segundos de hal_clock.
+// HOST_VIRTUAL_CLOCK=<ms_inicial> usa el reloj virtual: HOST_RUN_SECONDS=2592000
+// simula 30 días en segundos (4294900000 arranca justo antes de la vuelta de 32 bits).
+// HOST_REPLAY_FILE=<traza.csv> reproduce lecturas grabadas en el equipo y
+// termina al agotarse la traza.
+// HOST_BACKEND_HTTP=<host:puerto> y HOST_BACKEND_MQTT=<host:puerto> usan el
+// backend local (host/mock_backend/mock_backend.py) en lugar de los mocks.
+// HOST_SERIAL_HUMIDITY, HOST_SERIAL_LIGHT y HOST_CLIENT_ID cambian la identidad
+// del dispositivo (host_identity.c); HOST_ADC_SEED=<n> genera lecturas
+// sintéticas propias de la instancia y HOST_LOG_LEVEL=E|W|I|D filtra los logs
+// (el snapshot de métricas se imprime siempre). HOST_MAC fija la MAC que usa
+// pacing.c y HOST_PACING='{"rate_per_min":20,...}' ajusta su configuración
+// con el mismo formato que el objeto "pacing" de la config MQTT.
+// HOST_NTP_SERVER=<host:puerto> sincroniza la hora contra el servidor NTP del
+// backend local; sin ella el reloj queda sin sincronizar.
+// Ver host/fleet/fleet.py.
+
+static const char *TAG = "HOST_MAIN";
+
+void host_runtime_init(void);
+void host_identity_init(void);
+void host_identity_mac(uint8_t mac[6]);
+
+static char snapshot[METRICS_SNAPSHOT_MAX_LEN];
+
+static void log_snapshot(void)
+{
+    metrics_update_system_gauges();
+    if (metrics_build_snapshot_json(snapshot, sizeof(snapshot)) > 0) {
+        ESP_LOGI(TAG, "📈 %s", snapshot);
+    }
+}
+
+static void apply_log_level(const char *level)
+{
+    esp_log_level_t log_level;
+    switch (level[0]) {
+        case 'E': log_level = ESP_LOG_ERROR; break;
+        case 'W': log_level = ESP_LOG_WARN; break;
+        case 'D': log_level = ESP_LOG_DEBUG; break;
+        default: log_level = ESP_LOG_INFO; break;
+    }
+    esp_log_level_set("*", log_level);
+    esp_log_level_set(TAG, ESP_LOG_INFO);
+}
+
+void app_main(void)
+{
+    const char *log_level_env = getenv("HOST_LOG_LEVEL");
+    if (log_level_env != NULL) {
+        apply_log_level(log_level_env);
+    }
+
+    ESP_LOGI(TAG, "=== ONG SENSOR - BUILD DE HOST ===");
+    host_identity_init();
+
+    const char *virtual_clock_env = getenv("HOST_VIRTUAL_CLOCK");
+    if (virtual_clock_env != NULL) {
+        mock_clock_use_virtual((uint32_t)strtoul(virtual_clock_env, NULL, 0));
+    }
+
+    host_runtime_init();
+
+    uint8_t mac[6];
+    host_identity_mac(mac);
+    pacing_init(mac);
+    const char *pacing_env = getenv("HOST_PACING");
+    if (pacing_env != NULL) {
+        cJSON *pacing_json = cJSON_Parse(pacing_env);
+        if (pacing_json == NULL || pacing_apply_json(pacing_json) != ESP_OK) {
+            ESP_LOGE(TAG, "HOST_PACING inválida: %s", pacing_env);
+            cJSON_Delete(pacing_json);
+            exit(1);
+        }
+        cJSON_Delete(pacing_json);
+    }
+    circuit_breaker_init();
+    http_compress_init();
+    config_store_init();
+    config_sync_init();
+    net_config_init();
+    sequence_init(mac);
+    time_service_init();
+
+    const char *replay_file = getenv("HOST_REPLAY_FILE");
+    if (replay_file != NULL && mock_adc_replay_load(replay_file) != ESP_OK) {
+        exit(1);
+    }
+    const char *adc_seed_env = getenv("HOST_ADC_SEED");
+    if (adc_seed_env != NULL) {
+        mock_adc_use_synthetic((uint32_t)strtoul(adc_seed_env, NULL, 0));
+    }
+
+    if (error_logger_init() != ESP_OK) {
+        ESP_LOGW(TAG, "⚠ Error inicializando sistema de logs, continuando sin él");
+    }
+
+    QueueHandle_t sensor_queue = xQueueCreate(SENSOR_QUEUE_SIZE, sizeof(sensor_frame_t));
+    if (sensor_queue == NULL) {
+        ESP_LOGE(TAG, "Error creando cola de sensores");
+        exit(1);
+    }
+    metrics_watch_queue(METRIC_GAUGE_SENSOR_QUEUE_DEPTH, sensor_queue);
+    metrics_watch_queue(METRIC_GAUGE_SUPERVISOR_QUEUE_DEPTH, supervisor_queue_global);
+
+    xTaskCreate(task_sensor_config_init, "sensor_config", 4096, NULL, 3, NULL);
+    if (xSemaphoreTake(sensor_config_semaphore, pdMS_TO_TICKS(15000)) != pdTRUE) {
+        ESP_LOGW(TAG, "Timeout configurando sensores, usando valores por defecto");
+    }
+
+    xTaskCreate(task_sensors_unified_reading, "sensors_unified", 4096, sensor_queue, 3, NULL);
+    xTaskCreate(task_http_client, "http_task", 6144, sensor_queue, 2, NULL);
+    xTaskCreate(task_mqtt_client, "mqtt_task", 4096, NULL, 2, NULL);
+    xTaskCreate(task_error_logger, "error_logger", 4096, NULL, 1, NULL);
+
+    const char *run_seconds_env = getenv("HOST_RUN_SECONDS");
+    int64_t run_until_us = run_seconds_env ? hal_clock_now_us() + atoll(run_seconds_env) * 1000000LL : 0;
+    uint32_t last_snapshot = hal_clock_now_ms();
+
+    while (1) {
+        hal_clock_delay_ms(1000);
+
+        if (hal_clock_elapsed_ms(last_snapshot) >= METRICS_PUBLISH_INTERVAL_MS) {
+            log_snapshot();
+            last_snapshot = hal_clock_now_ms();
+        }
+
+        if (replay_file != NULL && mock_adc_replay_finished()) {
+            ESP_LOGI(TAG, "Fin de la traza %s", replay_file);
+            log_snapshot();
+            exit(0);
+        }
+        if (run_until_us > 0 && hal_clock_now_us() >= run_until_us) {
+            ESP_LOGI(TAG, "Fin de la ejecución (HOST_RUN_SECONDS=%s)", run_seconds_env);
+            log_snapshot();
+            exit(0);
+        }
+    }
+}
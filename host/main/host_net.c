@@ -0,0 +1,216 @@
+#include "host_net.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+// Utilidades de sockets compartidas por host_net_http.c y host_net_mqtt.c.
+// Las tareas de FreeRTOS del target linux no deben bloquearse en llamadas
+// al sistema (el planificador no puede desalojarlas), así que los sockets
+// son no bloqueantes y la espera se hace con poll() sin timeout + vTaskDelay.
+
+static const char *TAG = "HOST_NET";
+
+static int64_t real_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+int64_t host_net_now_us(void)
+{
+    return real_now_us();
+}
+
+// Esperar a que el socket esté listo para events, cediendo la CPU entre consultas
+static esp_err_t host_net_wait(int fd, short events, int timeout_ms)
+{
+    int64_t deadline_us = real_now_us() + (int64_t)timeout_ms * 1000;
+    while (1) {
+        struct pollfd pfd = {
+            .fd = fd,
+            .events = events,
+        };
+        int ret = poll(&pfd, 1, 0);
+        if (ret > 0) {
+            return ESP_OK;  // Incluye errores/cierre: los reporta la llamada siguiente
+        }
+        if (ret < 0 && errno != EINTR) {
+            return ESP_FAIL;
+        }
+        if (real_now_us() >= deadline_us) {
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(1);
+    }
+}
+
+bool host_net_endpoint_from_env(const char *var, host_net_endpoint_t *endpoint)
+{
+    const char *value = getenv(var);
+    if (value == NULL || endpoint == NULL) {
+        return false;
+    }
+    const char *colon = strrchr(value, ':');
+    if (colon == NULL || colon == value || (size_t)(colon - value) >= sizeof(endpoint->host)) {
+        ESP_LOGE(TAG, "%s inválida (se espera host:puerto): %s", var, value);
+        return false;
+    }
+    long port = strtol(colon + 1, NULL, 10);
+    if (port <= 0 || port > 65535) {
+        ESP_LOGE(TAG, "%s con puerto inválido: %s", var, value);
+        return false;
+    }
+    memcpy(endpoint->host, value, colon - value);
+    endpoint->host[colon - value] = '\0';
+    endpoint->port = (uint16_t)port;
+    return true;
+}
+
+esp_err_t host_net_connect_start(const host_net_endpoint_t *endpoint, int *fd_out)
+{
+    char port_str[8];
+    snprintf(port_str, sizeof(port_str), "%u", (unsigned)endpoint->port);
+
+    struct addrinfo hints = {
+        .ai_family = AF_UNSPEC,
+        .ai_socktype = SOCK_STREAM,
+    };
+    struct addrinfo *result = NULL;
+    if (getaddrinfo(endpoint->host, port_str, &hints, &result) != 0 || result == NULL) {
+        ESP_LOGE(TAG, "No se pudo resolver %s", endpoint->host);
+        return ESP_FAIL;
+    }
+
+    int fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+    if (fd < 0) {
+        freeaddrinfo(result);
+        return ESP_FAIL;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    int ret = connect(fd, result->ai_addr, result->ai_addrlen);
+    freeaddrinfo(result);
+    if (ret < 0 && errno != EINPROGRESS) {
+        close(fd);
+        return ESP_FAIL;
+    }
+
+    *fd_out = fd;
+    return ESP_OK;
+}
+
+esp_err_t host_net_connect_poll(int fd)
+{
+    struct pollfd pfd = {
+        .fd = fd,
+        .events = POLLOUT,
+    };
+    int ret = poll(&pfd, 1, 0);
+    if (ret == 0 || (ret < 0 && errno == EINTR)) {
+        return ESP_ERR_NOT_FINISHED;
+    }
+    int so_error = 0;
+    socklen_t so_len = sizeof(so_error);
+    if (ret < 0 || getsockopt(fd, SOL_SOCKET, SO_ERROR, &so_error, &so_len) != 0 || so_error != 0) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t host_net_connect(const host_net_endpoint_t *endpoint, int timeout_ms, int *fd_out)
+{
+    int fd = -1;
+    esp_err_t err = host_net_connect_start(endpoint, &fd);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    err = host_net_wait(fd, POLLOUT, timeout_ms);
+    if (err == ESP_OK) {
+        err = host_net_connect_poll(fd);
+    }
+    if (err != ESP_OK) {
+        close(fd);
+        return err == ESP_ERR_TIMEOUT ? ESP_ERR_TIMEOUT : ESP_FAIL;
+    }
+
+    *fd_out = fd;
+    return ESP_OK;
+}
+
+esp_err_t host_net_send_all(int fd, const void *data, size_t len, int timeout_ms)
+{
+    const uint8_t *ptr = (const uint8_t *)data;
+    while (len > 0) {
+        ssize_t sent = send(fd, ptr, len, MSG_NOSIGNAL);
+        if (sent > 0) {
+            ptr += sent;
+            len -= (size_t)sent;
+            continue;
+        }
+        if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            return ESP_FAIL;
+        }
+        esp_err_t err = host_net_wait(fd, POLLOUT, timeout_ms);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t host_net_send_some(int fd, const void *data, size_t len, size_t *sent)
+{
+    *sent = 0;
+    ssize_t ret = send(fd, data, len, MSG_NOSIGNAL);
+    if (ret >= 0) {
+        *sent = (size_t)ret;
+        return ESP_OK;
+    }
+    return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t host_net_recv(int fd, void *buf, size_t len, int timeout_ms, size_t *received)
+{
+    *received = 0;
+    while (1) {
+        ssize_t ret = recv(fd, buf, len, 0);
+        if (ret >= 0) {
+            *received = (size_t)ret;
+            return ESP_OK;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            return ESP_FAIL;    // ECONNRESET, etc.
+        }
+        if (timeout_ms <= 0) {
+            return ESP_ERR_TIMEOUT;
+        }
+        esp_err_t err = host_net_wait(fd, POLLIN, timeout_ms);
+        if (err != ESP_OK) {
+            return err;
+        }
+        timeout_ms = 0;         // Ya hay datos (o un error) para leer
+    }
+}
+
+void host_net_close(int fd)
+{
+    if (fd >= 0) {
+        close(fd);
+    }
+}
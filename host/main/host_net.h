@@ -0,0 +1,169 @@
+#ifndef HOST_NET_H
+#define HOST_NET_H
+
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "hal_http.h"
+#include "hal_mqtt.h"
+#include "hal_sntp.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Transporte real (sockets POSIX) del build de host para probar contra el
+// backend local (host/mock_backend). Se activa por variable de entorno:
+//   HOST_BACKEND_HTTP=<host:puerto>  hal_http va al backend local
+//   HOST_BACKEND_MQTT=<host:puerto>  hal_mqtt va al broker local
+//   HOST_NTP_SERVER=<host:puerto>    hal_sntp consulta el servidor NTP local
+// Sin ellas se usan los mocks en proceso. De la URL del firmware solo se
+// conserva el path; no hay TLS.
+//
+// Las esperas de red se miden con el reloj real aun con el reloj virtual,
+// que no tiene sentido frente a un servidor externo.
+
+// Dirección leída de una variable de entorno
+typedef struct {
+    char host[64];
+    uint16_t port;
+} host_net_endpoint_t;
+
+/**
+ * @brief Leer "host:puerto" de una variable de entorno
+ *
+ * @return true si la variable existe y es válida
+ */
+bool host_net_endpoint_from_env(const char *var, host_net_endpoint_t *endpoint);
+
+/**
+ * @brief Reloj real en µs (plazos de red, independiente del reloj virtual)
+ */
+int64_t host_net_now_us(void);
+
+/**
+ * @brief Iniciar una conexión TCP sin esperar (socket no bloqueante)
+ *
+ * @param fd_out Socket, conectado o con la conexión en curso
+ */
+esp_err_t host_net_connect_start(const host_net_endpoint_t *endpoint, int *fd_out);
+
+/**
+ * @brief Consultar una conexión iniciada con host_net_connect_start()
+ *
+ * @return ESP_OK conectado, ESP_ERR_NOT_FINISHED en curso, ESP_FAIL rechazada
+ */
+esp_err_t host_net_connect_poll(int fd);
+
+/**
+ * @brief Conectar por TCP (socket no bloqueante)
+ *
+ * @param fd_out Socket conectado
+ * @return ESP_OK, ESP_ERR_TIMEOUT o ESP_FAIL
+ */
+esp_err_t host_net_connect(const host_net_endpoint_t *endpoint, int timeout_ms, int *fd_out);
+
+/**
+ * @brief Enviar todo el buffer
+ *
+ * @param timeout_ms Plazo máximo sin poder escribir
+ */
+esp_err_t host_net_send_all(int fd, const void *data, size_t len, int timeout_ms);
+
+/**
+ * @brief Enviar lo que el socket acepte sin esperar
+ *
+ * @param sent Bytes enviados (0 si el buffer del socket está lleno)
+ */
+esp_err_t host_net_send_some(int fd, const void *data, size_t len, size_t *sent);
+
+/**
+ * @brief Recibir lo que haya disponible (hasta len bytes)
+ *
+ * @param timeout_ms Espera máxima por datos (0 = no esperar)
+ * @param received Bytes recibidos; 0 con ESP_OK = el otro extremo cerró
+ * @return ESP_OK, ESP_ERR_TIMEOUT si no llegó nada, ESP_FAIL si se cortó la conexión
+ */
+esp_err_t host_net_recv(int fd, void *buf, size_t len, int timeout_ms, size_t *received);
+
+/**
+ * @brief Cerrar el socket
+ */
+void host_net_close(int fd);
+
+// ============= HTTP =============
+/**
+ * @brief true si HOST_BACKEND_HTTP está definida
+ */
+bool host_net_http_enabled(void);
+
+/**
+ * @brief hal_http_perform() sobre el backend local (HTTP/1.1 sin keep-alive)
+ */
+esp_err_t host_net_http_perform(const hal_http_request_t *request, hal_http_response_t *response);
+
+// Petición en curso contra el backend local
+typedef struct host_net_http_async host_net_http_async_t;
+
+/**
+ * @brief hal_http_start() sobre el backend local
+ */
+esp_err_t host_net_http_start(const hal_http_request_t *request, host_net_http_async_t **handle);
+
+/**
+ * @brief hal_http_poll() sobre el backend local (libera handle al terminar)
+ */
+bool host_net_http_poll(host_net_http_async_t *handle, esp_err_t *result, hal_http_response_t *response);
+
+/**
+ * @brief hal_http_abort() sobre el backend local
+ */
+void host_net_http_abort(host_net_http_async_t *handle);
+
+// ============= MQTT =============
+/**
+ * @brief true si HOST_BACKEND_MQTT está definida
+ */
+bool host_net_mqtt_enabled(void);
+
+/**
+ * @brief hal_mqtt_start() contra el broker local (MQTT 3.1.1, reconexión automática)
+ */
+esp_err_t host_net_mqtt_start(const hal_mqtt_config_t *config, hal_mqtt_event_cb_t callback);
+
+/**
+ * @brief hal_mqtt_subscribe() sobre el broker local
+ */
+int host_net_mqtt_subscribe(const char *topic, int qos);
+
+/**
+ * @brief hal_mqtt_publish() sobre el broker local
+ */
+int host_net_mqtt_publish(const char *topic, const char *data, int len, int qos, int retain);
+
+/**
+ * @brief hal_mqtt_set_reconnect_timeout() sobre el broker local (aplica a la espera en curso)
+ */
+void host_net_mqtt_set_reconnect_timeout(int reconnect_timeout_ms);
+
+// ============= SNTP =============
+/**
+ * @brief true si HOST_NTP_SERVER está definida
+ */
+bool host_net_sntp_enabled(void);
+
+/**
+ * @brief hal_sntp_start() contra el servidor NTP local (SNTPv4 sobre UDP)
+ */
+esp_err_t host_net_sntp_start(uint32_t interval_ms, hal_sntp_sync_cb_t callback);
+
+#if !CONFIG_IDF_TARGET_LINUX
+// Benchmark en el equipo (host/bench): sin sockets POSIX, siempre los mocks en proceso
+#define host_net_http_enabled() false
+#define host_net_mqtt_enabled() false
+#define host_net_http_start(request, handle) ESP_ERR_NOT_SUPPORTED
+#define host_net_http_poll(handle, result, response) true
+#define host_net_http_abort(handle) ((void)(handle))
+#define host_net_sntp_enabled() false
+#define host_net_sntp_start(interval_ms, callback) ESP_ERR_NOT_SUPPORTED
+#endif
+
+#endif // HOST_NET_H
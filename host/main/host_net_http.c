@@ -0,0 +1,296 @@
+#include "host_net.h"
+#include "hal_clock.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+// hal_http sobre el backend local. Una conexión por petición
+// (Connection: close), como el firmware con esp_http_client. La petición es
+// una máquina de estados no bloqueante (hal_http_start/poll); la versión
+// bloqueante la recorre cediendo la CPU entre consultas. El timeout corre
+// desde el último avance, no desde el inicio: una respuesta que llega byte
+// a byte no vence mientras siga llegando.
+
+static const char *TAG = "HOST_NET_HTTP";
+
+#define HOST_HTTP_HEADER_MAX 1024
+
+static host_net_endpoint_t endpoint;
+static int endpoint_state = -1;     // -1 sin leer, 0 deshabilitado, 1 habilitado
+
+bool host_net_http_enabled(void)
+{
+    if (endpoint_state < 0) {
+        endpoint_state = host_net_endpoint_from_env("HOST_BACKEND_HTTP", &endpoint) ? 1 : 0;
+        if (endpoint_state) {
+            ESP_LOGI(TAG, "HTTP contra backend local %s:%u", endpoint.host, (unsigned)endpoint.port);
+        }
+    }
+    return endpoint_state == 1;
+}
+
+// Path de la URL del firmware ("https://host/api/v1/x" -> "/api/v1/x")
+static const char *url_path(const char *url)
+{
+    const char *authority = strstr(url, "://");
+    authority = authority ? authority + 3 : url;
+    const char *path = strchr(authority, '/');
+    return path ? path : "/";
+}
+
+// Buscar un header en el bloque de headers de la respuesta (sin distinguir mayúsculas)
+static const char *find_header(const char *headers, const char *name)
+{
+    size_t name_len = strlen(name);
+    const char *line = strstr(headers, "\r\n");
+    while (line != NULL) {
+        line += 2;
+        if (strncasecmp(line, name, name_len) == 0 && line[name_len] == ':') {
+            const char *value = line + name_len + 1;
+            while (*value == ' ') {
+                value++;
+            }
+            return value;
+        }
+        line = strstr(line, "\r\n");
+    }
+    return NULL;
+}
+
+// Una petición avanza por fases sin bloquear: conexión, envío de headers y
+// cuerpo, y recepción de la respuesta
+typedef enum {
+    HTTP_PHASE_CONNECTING,
+    HTTP_PHASE_SENDING,
+    HTTP_PHASE_RECEIVING,
+} http_phase_t;
+
+struct host_net_http_async {
+    const hal_http_request_t *request;
+    hal_http_response_t response;
+    const char *method;
+    const char *path;
+    int fd;
+    http_phase_t phase;
+    int timeout_ms;
+    int64_t last_progress_us;       // El timeout corre desde el último avance
+    char out[HOST_HTTP_HEADER_MAX]; // Línea de petición y headers a enviar
+    size_t out_len;
+    size_t sent;                    // Bytes enviados de out + body
+    char header[HOST_HTTP_HEADER_MAX];
+    size_t header_used;
+    size_t body_received;
+    long content_length;
+    bool headers_done;
+};
+
+esp_err_t host_net_http_start(const hal_http_request_t *request, host_net_http_async_t **handle)
+{
+    host_net_http_async_t *req = calloc(1, sizeof(*req));
+    if (req == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    req->request = request;
+    req->method = request->method == HAL_HTTP_METHOD_POST ? "POST" : "GET";
+    req->path = url_path(request->url);
+    req->timeout_ms = request->timeout_ms > 0 ? request->timeout_ms : 5000;
+    req->content_length = -1;
+    req->phase = HTTP_PHASE_CONNECTING;
+
+    // Línea de petición y headers
+    int out_len = snprintf(req->out, sizeof(req->out),
+                           "%s %s HTTP/1.1\r\nHost: %s:%u\r\nConnection: close\r\nContent-Length: %u\r\n",
+                           req->method, req->path, endpoint.host, (unsigned)endpoint.port,
+                           (unsigned)(request->body ? request->body_len : 0));
+    for (size_t i = 0; i < request->header_count && out_len < (int)sizeof(req->out); i++) {
+        out_len += snprintf(req->out + out_len, sizeof(req->out) - out_len, "%s: %s\r\n",
+                            request->headers[i].key, request->headers[i].value);
+    }
+    if (out_len + 2 >= (int)sizeof(req->out)) {
+        free(req);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    out_len += snprintf(req->out + out_len, sizeof(req->out) - out_len, "\r\n");
+    req->out_len = (size_t)out_len;
+
+    esp_err_t err = host_net_connect_start(&endpoint, &req->fd);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "No se pudo conectar a %s:%u (%s)", endpoint.host, (unsigned)endpoint.port, esp_err_to_name(err));
+        free(req);
+        return err;
+    }
+    req->last_progress_us = host_net_now_us();
+    *handle = req;
+    return ESP_OK;
+}
+
+// Procesar un bloque recibido: headers completos en header[], cuerpo en response_buf.
+// Devuelve ESP_ERR_NOT_FINISHED mientras falte respuesta.
+static esp_err_t http_consume(host_net_http_async_t *req, const char *chunk, size_t received)
+{
+    const hal_http_request_t *request = req->request;
+    const char *body_data = chunk;
+    size_t body_len = received;
+
+    if (!req->headers_done) {
+        size_t room = sizeof(req->header) - 1 - req->header_used;
+        size_t copy = received < room ? received : room;
+        memcpy(req->header + req->header_used, chunk, copy);
+        req->header_used += copy;
+        req->header[req->header_used] = '\0';
+
+        char *end = strstr(req->header, "\r\n\r\n");
+        if (end == NULL) {
+            return req->header_used >= sizeof(req->header) - 1 ? ESP_ERR_INVALID_RESPONSE : ESP_ERR_NOT_FINISHED;
+        }
+        req->headers_done = true;
+        size_t headers_len = (size_t)(end - req->header) + 4;
+        end[2] = '\0';
+
+        if (sscanf(req->header, "HTTP/%*d.%*d %d", &req->response.status_code) != 1) {
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        const char *length_value = find_header(req->header, "Content-Length");
+        if (length_value != NULL) {
+            req->content_length = strtol(length_value, NULL, 10);
+        }
+        for (size_t i = 0; i < request->capture_count; i++) {
+            const char *value = find_header(req->header, request->captures[i].key);
+            if (value != NULL) {
+                hal_http_captures_store(request, request->captures[i].key, value, strcspn(value, "\r"));
+            }
+        }
+
+        // Lo que sobra del bloque leído ya es cuerpo
+        size_t consumed = headers_len - (req->header_used - copy);
+        body_data = chunk + consumed;
+        body_len = received - consumed;
+    }
+
+    if (request->response_buf != NULL && request->response_buf_size > 0) {
+        size_t room = request->response_buf_size - 1 - req->response.response_len;
+        size_t copy = body_len < room ? body_len : room;
+        memcpy(request->response_buf + req->response.response_len, body_data, copy);
+        req->response.response_len += copy;
+        request->response_buf[req->response.response_len] = '\0';
+    }
+    req->body_received += body_len;
+
+    if (req->content_length >= 0 && req->body_received >= (size_t)req->content_length) {
+        return ESP_OK;
+    }
+    return ESP_ERR_NOT_FINISHED;
+}
+
+// Avanzar todo lo posible sin esperar. ESP_ERR_NOT_FINISHED = seguir más tarde.
+static esp_err_t http_advance(host_net_http_async_t *req)
+{
+    const hal_http_request_t *request = req->request;
+
+    if (req->phase == HTTP_PHASE_CONNECTING) {
+        esp_err_t err = host_net_connect_poll(req->fd);
+        if (err != ESP_OK) {
+            return err;
+        }
+        req->phase = HTTP_PHASE_SENDING;
+        req->last_progress_us = host_net_now_us();
+    }
+
+    if (req->phase == HTTP_PHASE_SENDING) {
+        size_t body_len = request->body != NULL ? request->body_len : 0;
+        while (req->sent < req->out_len + body_len) {
+            const char *data;
+            size_t len;
+            if (req->sent < req->out_len) {
+                data = req->out + req->sent;
+                len = req->out_len - req->sent;
+            } else {
+                data = request->body + (req->sent - req->out_len);
+                len = req->out_len + body_len - req->sent;
+            }
+            size_t sent = 0;
+            if (host_net_send_some(req->fd, data, len, &sent) != ESP_OK) {
+                return ESP_FAIL;
+            }
+            if (sent == 0) {
+                return ESP_ERR_NOT_FINISHED;
+            }
+            if (req->sent < req->out_len && req->sent + sent >= req->out_len && request->sent_us != NULL) {
+                *request->sent_us = hal_clock_now_us();
+            }
+            req->sent += sent;
+            req->last_progress_us = host_net_now_us();
+        }
+        req->phase = HTTP_PHASE_RECEIVING;
+    }
+
+    char chunk[512];
+    while (1) {
+        size_t received = 0;
+        esp_err_t err = host_net_recv(req->fd, chunk, sizeof(chunk), 0, &received);
+        if (err == ESP_ERR_TIMEOUT) {
+            return ESP_ERR_NOT_FINISHED;
+        }
+        if (err != ESP_OK) {
+            return err;
+        }
+        if (received == 0) {
+            // Cierre del servidor: válido solo si ya llegaron los headers
+            return req->headers_done ? ESP_OK : ESP_ERR_INVALID_RESPONSE;
+        }
+        req->last_progress_us = host_net_now_us();
+        err = http_consume(req, chunk, received);
+        if (err != ESP_ERR_NOT_FINISHED) {
+            return err;
+        }
+    }
+}
+
+bool host_net_http_poll(host_net_http_async_t *req, esp_err_t *result, hal_http_response_t *response)
+{
+    esp_err_t err = http_advance(req);
+    if (err == ESP_ERR_NOT_FINISHED) {
+        if (host_net_now_us() - req->last_progress_us < (int64_t)req->timeout_ms * 1000) {
+            return false;
+        }
+        err = ESP_ERR_TIMEOUT;
+    }
+
+    if (err != ESP_OK) {
+        const char *what = req->phase == HTTP_PHASE_CONNECTING ? "conectando" :
+                           req->phase == HTTP_PHASE_SENDING ? "enviando" : "respuesta incompleta";
+        ESP_LOGW(TAG, "%s %s: error %s (%s)", req->method, req->path, what, esp_err_to_name(err));
+    } else {
+        ESP_LOGD(TAG, "%s %s -> %d (%u bytes)", req->method, req->path, req->response.status_code,
+                 (unsigned)req->body_received);
+    }
+    *response = req->response;
+    *result = err;
+    host_net_http_abort(req);
+    return true;
+}
+
+void host_net_http_abort(host_net_http_async_t *req)
+{
+    if (req != NULL) {
+        host_net_close(req->fd);
+        free(req);
+    }
+}
+
+esp_err_t host_net_http_perform(const hal_http_request_t *request, hal_http_response_t *response)
+{
+    host_net_http_async_t *req = NULL;
+    esp_err_t err = host_net_http_start(request, &req);
+    if (err != ESP_OK) {
+        return err;
+    }
+    while (!host_net_http_poll(req, &err, response)) {
+        vTaskDelay(1);  // Ceder la CPU: las tareas del target linux no se desalojan en llamadas al sistema
+    }
+    return err;
+}
@@ -0,0 +1,426 @@
+#include "host_net.h"
+#include "config.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Cliente MQTT 3.1.1 mínimo para el broker local (QoS 0/1, sin sesión
+// persistente). Igual que esp-mqtt: una tarea propia lee del socket, entrega
+// los eventos en su contexto y reconecta tras reconnect_timeout_ms. El
+// firmware vuelve a suscribirse en cada HAL_MQTT_EVENT_CONNECTED.
+
+static const char *TAG = "HOST_NET_MQTT";
+
+#define HOST_MQTT_CONNECT_TIMEOUT_MS 10000
+#define HOST_MQTT_SEND_TIMEOUT_MS 5000
+#define HOST_MQTT_RX_BUF_SIZE (MQTT_MAX_TOPIC_LEN + MQTT_MAX_PAYLOAD_LEN + 16)
+#define HOST_MQTT_TX_BUF_SIZE (MQTT_MAX_TOPIC_LEN + MQTT_MAX_PAYLOAD_LEN + 16)
+
+// Tipos de paquete MQTT
+#define MQTT_PKT_CONNECT 1
+#define MQTT_PKT_CONNACK 2
+#define MQTT_PKT_PUBLISH 3
+#define MQTT_PKT_PUBACK 4
+#define MQTT_PKT_SUBSCRIBE 8
+#define MQTT_PKT_SUBACK 9
+#define MQTT_PKT_PINGREQ 12
+#define MQTT_PKT_PINGRESP 13
+
+static host_net_endpoint_t endpoint;
+static int endpoint_state = -1;     // -1 sin leer, 0 deshabilitado, 1 habilitado
+
+static hal_mqtt_config_t client_config;
+static hal_mqtt_event_cb_t event_callback = NULL;
+static SemaphoreHandle_t tx_lock = NULL;
+static int sock = -1;
+static volatile bool connected = false;
+static uint16_t next_packet_id = 1;
+static int64_t last_tx_us = 0;
+
+static uint8_t rx_buf[HOST_MQTT_RX_BUF_SIZE];
+static size_t rx_len = 0;
+static uint8_t tx_buf[HOST_MQTT_TX_BUF_SIZE];
+
+static int64_t real_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+bool host_net_mqtt_enabled(void)
+{
+    if (endpoint_state < 0) {
+        endpoint_state = host_net_endpoint_from_env("HOST_BACKEND_MQTT", &endpoint) ? 1 : 0;
+        if (endpoint_state) {
+            ESP_LOGI(TAG, "MQTT contra broker local %s:%u", endpoint.host, (unsigned)endpoint.port);
+        }
+    }
+    return endpoint_state == 1;
+}
+
+static void dispatch(hal_mqtt_event_id_t id, int msg_id)
+{
+    hal_mqtt_event_t event = {
+        .id = id,
+        .msg_id = msg_id,
+        .transport_error = (id == HAL_MQTT_EVENT_ERROR),
+    };
+    if (event_callback != NULL) {
+        event_callback(&event);
+    }
+}
+
+// ============= CODIFICACIÓN =============
+
+static size_t put_u16(uint8_t *buf, uint16_t value)
+{
+    buf[0] = (uint8_t)(value >> 8);
+    buf[1] = (uint8_t)(value & 0xFF);
+    return 2;
+}
+
+static size_t put_string(uint8_t *buf, const char *str, size_t len)
+{
+    put_u16(buf, (uint16_t)len);
+    memcpy(buf + 2, str, len);
+    return 2 + len;
+}
+
+// Encabezado fijo delante del cuerpo ya escrito en tx_buf + 5; devuelve el inicio del paquete
+static uint8_t *finish_packet(uint8_t type_flags, size_t body_len, size_t *packet_len)
+{
+    uint8_t encoded[4];
+    size_t encoded_len = 0;
+    size_t remaining = body_len;
+    do {
+        uint8_t byte = remaining % 128;
+        remaining /= 128;
+        encoded[encoded_len++] = byte | (remaining > 0 ? 0x80 : 0);
+    } while (remaining > 0 && encoded_len < sizeof(encoded));
+
+    uint8_t *start = tx_buf + 5 - encoded_len - 1;
+    start[0] = type_flags;
+    memcpy(start + 1, encoded, encoded_len);
+    *packet_len = 1 + encoded_len + body_len;
+    return start;
+}
+
+// Enviar el paquete armado en tx_buf (con tx_lock tomado)
+static esp_err_t send_packet(uint8_t type_flags, size_t body_len)
+{
+    size_t packet_len = 0;
+    uint8_t *packet = finish_packet(type_flags, body_len, &packet_len);
+    esp_err_t err = host_net_send_all(sock, packet, packet_len, HOST_MQTT_SEND_TIMEOUT_MS);
+    if (err == ESP_OK) {
+        last_tx_us = real_now_us();
+    }
+    return err;
+}
+
+static uint16_t take_packet_id(void)
+{
+    uint16_t id = next_packet_id;
+    next_packet_id = next_packet_id == 0xFFFF ? 1 : next_packet_id + 1;
+    return id;
+}
+
+// ============= CONEXIÓN =============
+
+static esp_err_t mqtt_connect(void)
+{
+    esp_err_t err = host_net_connect(&endpoint, HOST_MQTT_CONNECT_TIMEOUT_MS, &sock);
+    if (err != ESP_OK) {
+        sock = -1;
+        return err;
+    }
+
+    uint8_t *body = tx_buf + 5;
+    size_t len = put_string(body, "MQTT", 4);
+    body[len++] = 4;                                    // Nivel de protocolo 3.1.1
+    uint8_t flags = 0x02;                               // Clean session
+    if (client_config.username != NULL) {
+        flags |= 0x80;
+    }
+    if (client_config.password != NULL) {
+        flags |= 0x40;
+    }
+    body[len++] = flags;
+    len += put_u16(body + len, (uint16_t)client_config.keepalive_s);
+    const char *client_id = client_config.client_id ? client_config.client_id : "";
+    len += put_string(body + len, client_id, strlen(client_id));
+    if (client_config.username != NULL) {
+        len += put_string(body + len, client_config.username, strlen(client_config.username));
+    }
+    if (client_config.password != NULL) {
+        len += put_string(body + len, client_config.password, strlen(client_config.password));
+    }
+
+    xSemaphoreTake(tx_lock, portMAX_DELAY);
+    err = send_packet(MQTT_PKT_CONNECT << 4, len);
+    xSemaphoreGive(tx_lock);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // CONNACK: 4 bytes, código de retorno en el último
+    uint8_t connack[4];
+    size_t got = 0;
+    while (got < sizeof(connack)) {
+        size_t received = 0;
+        err = host_net_recv(sock, connack + got, sizeof(connack) - got, HOST_MQTT_CONNECT_TIMEOUT_MS, &received);
+        if (err != ESP_OK || received == 0) {
+            return err != ESP_OK ? err : ESP_FAIL;
+        }
+        got += received;
+    }
+    if ((connack[0] >> 4) != MQTT_PKT_CONNACK || connack[3] != 0) {
+        ESP_LOGW(TAG, "Broker rechazó la conexión (código %d)", connack[3]);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static void mqtt_drop(void)
+{
+    xSemaphoreTake(tx_lock, portMAX_DELAY);
+    connected = false;
+    host_net_close(sock);
+    sock = -1;
+    xSemaphoreGive(tx_lock);
+    rx_len = 0;
+}
+
+// Procesar un paquete completo recibido del broker
+static void handle_packet(uint8_t header, const uint8_t *body, size_t len)
+{
+    switch (header >> 4) {
+        case MQTT_PKT_PUBLISH: {
+            if (len < 2) {
+                return;
+            }
+            uint8_t qos = (header >> 1) & 0x03;
+            size_t topic_len = ((size_t)body[0] << 8) | body[1];
+            size_t offset = 2 + topic_len;
+            uint16_t packet_id = 0;
+            if (qos > 0) {
+                if (offset + 2 > len) {
+                    return;
+                }
+                packet_id = (uint16_t)((body[offset] << 8) | body[offset + 1]);
+                offset += 2;
+            }
+            if (offset > len) {
+                return;
+            }
+            hal_mqtt_event_t event = {
+                .id = HAL_MQTT_EVENT_DATA,
+                .msg_id = packet_id,
+                .topic = (const char *)body + 2,
+                .topic_len = (int)topic_len,
+                .data = (const char *)body + offset,
+                .data_len = (int)(len - offset),
+            };
+            if (qos > 0) {
+                xSemaphoreTake(tx_lock, portMAX_DELAY);
+                size_t ack_len = put_u16(tx_buf + 5, packet_id);
+                send_packet(MQTT_PKT_PUBACK << 4, ack_len);
+                xSemaphoreGive(tx_lock);
+            }
+            if (event_callback != NULL) {
+                event_callback(&event);
+            }
+            break;
+        }
+        case MQTT_PKT_PUBACK:
+            if (len >= 2) {
+                dispatch(HAL_MQTT_EVENT_PUBLISHED, (body[0] << 8) | body[1]);
+            }
+            break;
+        case MQTT_PKT_SUBACK:
+            if (len >= 2) {
+                dispatch(HAL_MQTT_EVENT_SUBSCRIBED, (body[0] << 8) | body[1]);
+            }
+            break;
+        case MQTT_PKT_PINGRESP:
+        default:
+            break;
+    }
+}
+
+// Extraer los paquetes completos de rx_buf; false si el flujo es inválido
+static bool parse_rx(void)
+{
+    while (rx_len >= 2) {
+        size_t remaining = 0;
+        size_t multiplier = 1;
+        size_t pos = 1;
+        bool complete = false;
+        while (pos < rx_len && pos <= 4) {
+            uint8_t byte = rx_buf[pos++];
+            remaining += (byte & 0x7F) * multiplier;
+            multiplier *= 128;
+            if (!(byte & 0x80)) {
+                complete = true;
+                break;
+            }
+        }
+        if (!complete) {
+            return pos <= 4;
+        }
+        if (pos + remaining > sizeof(rx_buf)) {
+            ESP_LOGE(TAG, "Paquete de %u bytes excede el buffer", (unsigned)remaining);
+            return false;
+        }
+        if (pos + remaining > rx_len) {
+            return true;    // Falta el resto del paquete
+        }
+        handle_packet(rx_buf[0], rx_buf + pos, remaining);
+        memmove(rx_buf, rx_buf + pos + remaining, rx_len - pos - remaining);
+        rx_len -= pos + remaining;
+    }
+    return true;
+}
+
+static void host_net_mqtt_task(void *pvParameters)
+{
+    while (1) {
+        esp_err_t err = mqtt_connect();
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "No se pudo conectar al broker %s:%u (%s)", endpoint.host, (unsigned)endpoint.port,
+                     esp_err_to_name(err));
+            host_net_close(sock);
+            sock = -1;
+            dispatch(HAL_MQTT_EVENT_ERROR, 0);
+            dispatch(HAL_MQTT_EVENT_DISCONNECTED, 0);   // Como esp-mqtt al abortar la conexión
+            vTaskDelay(pdMS_TO_TICKS(__atomic_load_n(&client_config.reconnect_timeout_ms, __ATOMIC_RELAXED)));
+            continue;
+        }
+
+        connected = true;
+        rx_len = 0;
+        dispatch(HAL_MQTT_EVENT_CONNECTED, 0);
+
+        while (1) {
+            size_t received = 0;
+            err = host_net_recv(sock, rx_buf + rx_len, sizeof(rx_buf) - rx_len, 100, &received);
+            if (err == ESP_OK && received == 0) {
+                err = ESP_FAIL;     // El broker cerró la conexión
+            }
+            if (err == ESP_OK) {
+                rx_len += received;
+                if (!parse_rx()) {
+                    err = ESP_FAIL;
+                }
+            } else if (err == ESP_ERR_TIMEOUT) {
+                err = ESP_OK;
+            }
+            if (err != ESP_OK) {
+                break;
+            }
+
+            // Keepalive: PINGREQ a mitad del período sin tráfico saliente
+            if (client_config.keepalive_s > 0 &&
+                real_now_us() - last_tx_us > (int64_t)client_config.keepalive_s * 500000) {
+                xSemaphoreTake(tx_lock, portMAX_DELAY);
+                err = send_packet(MQTT_PKT_PINGREQ << 4, 0);
+                xSemaphoreGive(tx_lock);
+                if (err != ESP_OK) {
+                    break;
+                }
+            }
+        }
+
+        ESP_LOGW(TAG, "Conexión con el broker perdida");
+        mqtt_drop();
+        dispatch(HAL_MQTT_EVENT_DISCONNECTED, 0);
+        vTaskDelay(pdMS_TO_TICKS(__atomic_load_n(&client_config.reconnect_timeout_ms, __ATOMIC_RELAXED)));
+    }
+}
+
+// ============= API =============
+
+esp_err_t host_net_mqtt_start(const hal_mqtt_config_t *config, hal_mqtt_event_cb_t callback)
+{
+    if (config == NULL || callback == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (tx_lock != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    client_config = *config;
+    event_callback = callback;
+    tx_lock = xSemaphoreCreateMutex();
+    if (tx_lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreate(host_net_mqtt_task, "mqtt_net", 4096, NULL, 4, NULL) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+int host_net_mqtt_subscribe(const char *topic, int qos)
+{
+    if (!connected || topic == NULL) {
+        return -1;
+    }
+    size_t topic_len = strlen(topic);
+    if (topic_len > MQTT_MAX_TOPIC_LEN) {
+        return -1;
+    }
+
+    xSemaphoreTake(tx_lock, portMAX_DELAY);
+    uint16_t packet_id = take_packet_id();
+    uint8_t *body = tx_buf + 5;
+    size_t len = put_u16(body, packet_id);
+    len += put_string(body + len, topic, topic_len);
+    body[len++] = (uint8_t)(qos & 0x03);
+    esp_err_t err = send_packet((MQTT_PKT_SUBSCRIBE << 4) | 0x02, len);
+    xSemaphoreGive(tx_lock);
+
+    return err == ESP_OK ? packet_id : -1;
+}
+
+int host_net_mqtt_publish(const char *topic, const char *data, int len, int qos, int retain)
+{
+    if (!connected || topic == NULL || data == NULL) {
+        return -1;
+    }
+    if (len == 0) {
+        len = (int)strlen(data);
+    }
+    size_t topic_len = strlen(topic);
+    if (topic_len > MQTT_MAX_TOPIC_LEN || len > MQTT_MAX_PAYLOAD_LEN) {
+        ESP_LOGW(TAG, "Mensaje demasiado grande para %s (%d bytes)", topic, len);
+        return -1;
+    }
+    qos = qos > 0 ? 1 : 0;
+
+    xSemaphoreTake(tx_lock, portMAX_DELAY);
+    uint16_t packet_id = qos > 0 ? take_packet_id() : 0;
+    uint8_t *body = tx_buf + 5;
+    size_t body_len = put_string(body, topic, topic_len);
+    if (qos > 0) {
+        body_len += put_u16(body + body_len, packet_id);
+    }
+    memcpy(body + body_len, data, (size_t)len);
+    body_len += (size_t)len;
+    esp_err_t err = send_packet((MQTT_PKT_PUBLISH << 4) | (qos << 1) | (retain ? 1 : 0), body_len);
+    xSemaphoreGive(tx_lock);
+
+    // QoS 0 no tiene msg_id ni confirmación
+    return err == ESP_OK ? packet_id : -1;
+}
+
+void host_net_mqtt_set_reconnect_timeout(int reconnect_timeout_ms)
+{
+    if (reconnect_timeout_ms > 0) {
+        __atomic_store_n(&client_config.reconnect_timeout_ms, reconnect_timeout_ms, __ATOMIC_RELAXED);
+    }
+}
@@ -0,0 +1,159 @@
+#include "host_net.h"
+#include "hal_clock.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include <fcntl.h>
+#include <netdb.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Cliente SNTPv4 mínimo para el servidor NTP del backend local
+// (mock_backend.py --ntp-port). Igual que el SNTP de lwIP: una tarea propia
+// consulta cada interval_ms y reintenta más seguido hasta la primera
+// respuesta. El par (hora del servidor, hal_clock) se toma en el punto medio
+// del viaje de ida y vuelta.
+//
+// Con el reloj virtual la hora no tiene sentido: el servidor usa tiempo real.
+
+static const char *TAG = "HOST_NET_SNTP";
+
+#define HOST_SNTP_TIMEOUT_MS 2000
+#define HOST_SNTP_RETRY_MS 15000
+#define HOST_SNTP_PACKET_LEN 48
+#define NTP_UNIX_EPOCH_DELTA_S 2208988800ULL    // 1900-01-01 -> 1970-01-01
+
+static host_net_endpoint_t endpoint;
+static int endpoint_state = -1;     // -1 sin leer, 0 deshabilitado, 1 habilitado
+static uint32_t sync_interval_ms = 0;
+static hal_sntp_sync_cb_t sync_callback = NULL;
+
+bool host_net_sntp_enabled(void)
+{
+    if (endpoint_state < 0) {
+        endpoint_state = host_net_endpoint_from_env("HOST_NTP_SERVER", &endpoint) ? 1 : 0;
+        if (endpoint_state) {
+            ESP_LOGI(TAG, "SNTP contra servidor local %s:%u", endpoint.host, (unsigned)endpoint.port);
+        }
+    }
+    return endpoint_state == 1;
+}
+
+static uint32_t read_be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+// Timestamp NTP de 64 bits (segundos desde 1900 + fracción) a µs desde 1970
+static int64_t ntp_to_epoch_us(const uint8_t *p)
+{
+    uint64_t seconds = read_be32(p);
+    uint64_t fraction = read_be32(p + 4);
+    return (int64_t)(seconds - NTP_UNIX_EPOCH_DELTA_S) * 1000000 + (int64_t)((fraction * 1000000) >> 32);
+}
+
+static int open_udp_socket(void)
+{
+    char port_str[8];
+    snprintf(port_str, sizeof(port_str), "%u", (unsigned)endpoint.port);
+
+    struct addrinfo hints = {
+        .ai_family = AF_UNSPEC,
+        .ai_socktype = SOCK_DGRAM,
+    };
+    struct addrinfo *result = NULL;
+    if (getaddrinfo(endpoint.host, port_str, &hints, &result) != 0 || result == NULL) {
+        ESP_LOGE(TAG, "No se pudo resolver %s", endpoint.host);
+        return -1;
+    }
+    int fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+    if (fd >= 0) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        if (connect(fd, result->ai_addr, result->ai_addrlen) < 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(result);
+    return fd;
+}
+
+// Una consulta: hora del servidor y el instante de hal_clock al que corresponde
+static esp_err_t sntp_query(int64_t *epoch_us, int64_t *mono_us)
+{
+    int fd = open_udp_socket();
+    if (fd < 0) {
+        return ESP_FAIL;
+    }
+
+    uint8_t packet[HOST_SNTP_PACKET_LEN] = {0};
+    packet[0] = 0x23;   // LI 0, versión 4, modo 3 (cliente)
+    // Transmit timestamp propio: el servidor lo devuelve como originate
+    int64_t t1_us = hal_clock_now_us();
+    memcpy(&packet[40], &t1_us, sizeof(t1_us));
+
+    size_t sent = 0;
+    esp_err_t err = host_net_send_some(fd, packet, sizeof(packet), &sent);
+    if (err != ESP_OK || sent != sizeof(packet)) {
+        host_net_close(fd);
+        return ESP_FAIL;
+    }
+
+    uint8_t reply[HOST_SNTP_PACKET_LEN];
+    size_t received = 0;
+    err = host_net_recv(fd, reply, sizeof(reply), HOST_SNTP_TIMEOUT_MS, &received);
+    int64_t t4_us = hal_clock_now_us();
+    host_net_close(fd);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (received < HOST_SNTP_PACKET_LEN || (reply[0] & 0x07) != 4 || reply[1] == 0 ||
+        memcmp(&reply[24], &t1_us, sizeof(t1_us)) != 0) {
+        ESP_LOGW(TAG, "Respuesta NTP inválida (%u bytes, modo %u, estrato %u)",
+                 (unsigned)received, (unsigned)(reply[0] & 0x07), (unsigned)reply[1]);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    int64_t t2_us = ntp_to_epoch_us(&reply[32]);    // Recepción en el servidor
+    int64_t t3_us = ntp_to_epoch_us(&reply[40]);    // Envío del servidor
+    *epoch_us = t2_us + (t3_us - t2_us) / 2;
+    *mono_us = t1_us + (t4_us - t1_us) / 2;
+    return ESP_OK;
+}
+
+static void sntp_task(void *pvParameters)
+{
+    bool synced = false;
+    while (1) {
+        int64_t epoch_us = 0;
+        int64_t mono_us = 0;
+        esp_err_t err = sntp_query(&epoch_us, &mono_us);
+        if (err == ESP_OK) {
+            synced = true;
+            sync_callback(epoch_us, mono_us);
+        } else {
+            ESP_LOGW(TAG, "Sin respuesta NTP de %s:%u (%s)", endpoint.host, (unsigned)endpoint.port,
+                     esp_err_to_name(err));
+        }
+        hal_clock_delay_ms(synced ? sync_interval_ms : HOST_SNTP_RETRY_MS);
+    }
+}
+
+esp_err_t host_net_sntp_start(uint32_t interval_ms, hal_sntp_sync_cb_t callback)
+{
+    if (!host_net_sntp_enabled()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (sync_callback != NULL) {
+        return ESP_OK;
+    }
+    sync_interval_ms = interval_ms;
+    sync_callback = callback;
+    if (xTaskCreate(sntp_task, "host_sntp", 4096, NULL, 2, NULL) != pdPASS) {
+        sync_callback = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,108 @@
+#include "task_main.h"
+#include "config.h"
+#include "task_sensor.h"
+#include "task_sensor_config.h"
+#include "config_bus.h"
+#include "esp_log.h"
+#include <string.h>
+
+// Implementación de host de los servicios del supervisor (task_main.c) y del
+// LED de estado (task_led_status.c), que dependen del hardware. Las tareas
+// de aplicación se enlazan sin cambios contra estas funciones.
+
+static const char *TAG = "HOST_RT";
+
+EventGroupHandle_t g_connectivity_event_group = NULL;
+
+SemaphoreHandle_t init_config_semaphore = NULL;
+SemaphoreHandle_t wifi_init_semaphore = NULL;
+SemaphoreHandle_t sensor_config_semaphore = NULL;
+SemaphoreHandle_t system_ready_semaphore = NULL;
+
+QueueHandle_t supervisor_queue_global = NULL;
+
+uint32_t sensor_sampling_interval_ms = SENSOR_READING_INTERVAL_MS;
+uint32_t sensor_post_interval_ms = SENSOR_POST_INTERVAL_MS_DEFAULT;
+float sensor_adc_min = 0.0f;
+float sensor_adc_max = 3300.0f;
+
+static QueueHandle_t led_status_queue = NULL;
+
+static const char *state_names[SYSTEM_STATE_MAX] = {
+    "INIT", "WIFI", "CONFIG", "READY", "SENSOR_READ", "HTTP_SEND",
+    "ERROR", "ESPERANDO_WIFI", "PROVISIONING", "WARNING",
+};
+
+void host_runtime_init(void)
+{
+    supervisor_queue_global = xQueueCreate(10, sizeof(supervisor_message_t));
+    sensor_config_snapshot_init();
+    config_bus_init();
+    init_led_status_queue();
+
+    init_config_semaphore = xSemaphoreCreateBinary();
+    wifi_init_semaphore = xSemaphoreCreateBinary();
+    sensor_config_semaphore = xSemaphoreCreateBinary();
+    system_ready_semaphore = xSemaphoreCreateBinary();
+
+    // En el host la red siempre está disponible
+    g_connectivity_event_group = xEventGroupCreate();
+    xEventGroupSetBits(g_connectivity_event_group,
+                       CONNECTIVITY_WIFI_CONNECTED_BIT | CONNECTIVITY_INTERNET_AVAILABLE_BIT);
+}
+
+// ============= LED DE ESTADO =============
+
+void init_led_status_queue(void)
+{
+    if (led_status_queue == NULL) {
+        led_status_queue = xQueueCreate(10, sizeof(led_status_message_t));
+    }
+}
+
+void send_led_status(system_state_t state, const char *message)
+{
+    ESP_LOGI(TAG, "💡 LED -> %s (%s)", state < SYSTEM_STATE_MAX ? state_names[state] : "?",
+             message ? message : "");
+}
+
+QueueHandle_t get_led_status_queue(void)
+{
+    return led_status_queue;
+}
+
+// ============= SUPERVISOR =============
+
+void task_send_heartbeat(task_type_t task_type, const char *message)
+{
+    ESP_LOGD(TAG, "💓 Heartbeat tarea %d: %s", task_type, message ? message : "");
+}
+
+void task_report_error(task_type_t task_type, task_error_t error_code, const char *message)
+{
+    ESP_LOGW(TAG, "❌ Error tarea %d (código %d): %s", task_type, error_code, message ? message : "");
+}
+
+void task_send_status(task_type_t task_type, const char *message)
+{
+    ESP_LOGI(TAG, "📊 Estado tarea %d: %s", task_type, message ? message : "");
+}
+
+// Sin watchdog en el host: las tareas alimentan pero nadie las reinicia
+void task_feed_watchdog(task_type_t task_type)
+{
+    (void)task_type;
+}
+
+void task_watchdog_get_stats(task_type_t task_type, task_watchdog_stats_t *out_stats)
+{
+    (void)task_type;
+    if (out_stats != NULL) {
+        memset(out_stats, 0, sizeof(*out_stats));
+    }
+}
+
+void task_watchdog_unregister(task_type_t task_type)
+{
+    (void)task_type;
+}
@@ -0,0 +1,94 @@
+#ifndef MOCK_HAL_H
+#define MOCK_HAL_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Control de los mocks de la HAL usados por el build de host
+
+// ============= ADC =============
+/**
+ * @brief Fijar el valor crudo que devolverá un canal (por defecto 2000)
+ */
+void mock_adc_set_raw(int channel, int raw_value);
+
+/**
+ * @brief Forzar que las lecturas de un canal fallen
+ */
+void mock_adc_set_fail(int channel, bool fail);
+
+/**
+ * @brief Cargar una traza grabada para reproducir en lugar de los valores fijos
+ *
+ * Formato CSV "t_ms,canal,raw" (el de ADC_CAPTURE_ENABLED). La traza se
+ * alinea con hal_clock al cargarla: cada lectura devuelve la última muestra
+ * del canal cuyo tiempo ya se alcanzó.
+ */
+esp_err_t mock_adc_replay_load(const char *path);
+
+/**
+ * @brief true si el reloj ya pasó la última muestra de la traza cargada
+ */
+bool mock_adc_replay_finished(void);
+
+/**
+ * @brief Generar en cada canal una señal lenta con ruido en lugar del valor fijo
+ *
+ * Los parámetros de la señal dependen de la semilla: cada instancia de una
+ * flota simulada lee valores distintos pero reproducibles.
+ */
+void mock_adc_use_synthetic(uint32_t seed);
+
+// ============= RELOJ =============
+/**
+ * @brief Pasar hal_clock a tiempo virtual (llamar antes de crear las tareas)
+ *
+ * El tiempo avanza al instante hasta la próxima hal_clock_delay_ms() cuando
+ * todas las tareas están bloqueadas. start_ms permite arrancar cerca de la
+ * vuelta de hal_clock_now_ms() (p. ej. 4294900000) para probarla.
+ */
+void mock_clock_use_virtual(uint32_t start_ms);
+
+// ============= HTTP =============
+// Comportamiento de las respuestas del backend simulado
+typedef struct {
+    int status_code;            // Código HTTP de respuesta (p. ej. 201)
+    uint32_t latency_ms;        // Demora simulada antes de enviar los headers
+    uint32_t server_ms;         // Demora simulada entre envío y respuesta
+    esp_err_t transport_error;  // != ESP_OK: la petición falla sin respuesta
+} mock_http_behavior_t;
+
+/**
+ * @brief Configurar el comportamiento del backend simulado
+ */
+void mock_http_set_behavior(const mock_http_behavior_t *behavior);
+
+/**
+ * @brief Cantidad de peticiones recibidas por el backend simulado
+ */
+uint32_t mock_http_request_count(void);
+
+// ============= MQTT =============
+/**
+ * @brief Entregar un mensaje al cliente como si llegara del broker
+ */
+void mock_mqtt_inject(const char *topic, const char *payload);
+
+/**
+ * @brief Simular conexión/desconexión del broker
+ */
+void mock_mqtt_set_connected(bool connected);
+
+/**
+ * @brief Cantidad de mensajes publicados por el cliente
+ */
+uint32_t mock_mqtt_published_count(void);
+
+// ============= NVS =============
+/**
+ * @brief Borrar todo el almacenamiento simulado
+ */
+void mock_nvs_reset(void);
+
+#endif // MOCK_HAL_H
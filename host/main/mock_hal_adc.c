@@ -0,0 +1,209 @@
+#include "hal_adc.h"
+#include "hal_clock.h"
+#include "mock_hal.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Mock de hal_adc.h: valores crudos fijados por el test (12 bits), una
+// traza grabada en el equipo (ADC_CAPTURE_ENABLED) reproducida contra
+// hal_clock, o una señal sintética distinta por instancia (flota simulada).
+
+static const char *TAG = "MOCK_ADC";
+
+#define MOCK_ADC_CHANNELS 10
+#define MOCK_ADC_DEFAULT_RAW 2000
+
+static int adc_raw[MOCK_ADC_CHANNELS];
+static bool adc_fail[MOCK_ADC_CHANNELS];
+static bool adc_raw_set[MOCK_ADC_CHANNELS];
+
+// Traza de reproducción: muestras de cada canal ordenadas por tiempo
+typedef struct {
+    uint32_t t_ms;      // Relativo a la primera muestra de la traza
+    int raw;
+} replay_sample_t;
+
+typedef struct {
+    replay_sample_t *samples;
+    size_t count;
+    size_t capacity;
+    size_t next;        // Primera muestra aún no alcanzada por el reloj
+} replay_channel_t;
+
+// Señal sintética: onda triangular lenta + ruido, con parámetros por canal
+typedef struct {
+    int center;
+    int amplitude;
+    uint32_t period_ms;
+    uint32_t phase_ms;
+} synthetic_channel_t;
+
+static synthetic_channel_t synthetic[MOCK_ADC_CHANNELS];
+static bool synthetic_enabled = false;
+static uint32_t synthetic_state = 1;
+
+static replay_channel_t replay[MOCK_ADC_CHANNELS];
+static bool replay_loaded = false;
+static uint32_t replay_start_ms = 0;
+static uint32_t replay_end_ms = 0;
+
+esp_err_t mock_adc_replay_load(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        ESP_LOGE(TAG, "No se pudo abrir la traza %s", path);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    char line[128];
+    long long first_t = -1;
+    size_t total = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        long long t_ms;
+        int channel, raw;
+        // Formato: t_ms,canal,raw (se ignoran encabezados y comentarios)
+        if (sscanf(line, "%lld,%d,%d", &t_ms, &channel, &raw) != 3) {
+            continue;
+        }
+        if (channel < 0 || channel >= MOCK_ADC_CHANNELS || t_ms < 0) {
+            continue;
+        }
+        if (first_t < 0) {
+            first_t = t_ms;
+        }
+        replay_channel_t *ch = &replay[channel];
+        if (ch->count > 0 && t_ms - first_t < ch->samples[ch->count - 1].t_ms) {
+            continue; // Fuera de orden
+        }
+        if (ch->count == ch->capacity) {
+            size_t capacity = ch->capacity ? ch->capacity * 2 : 1024;
+            replay_sample_t *grown = realloc(ch->samples, capacity * sizeof(replay_sample_t));
+            if (grown == NULL) {
+                fclose(file);
+                return ESP_ERR_NO_MEM;
+            }
+            ch->samples = grown;
+            ch->capacity = capacity;
+        }
+        ch->samples[ch->count].t_ms = (uint32_t)(t_ms - first_t);
+        ch->samples[ch->count].raw = raw;
+        ch->count++;
+        if ((uint32_t)(t_ms - first_t) > replay_end_ms) {
+            replay_end_ms = (uint32_t)(t_ms - first_t);
+        }
+        total++;
+    }
+    fclose(file);
+
+    if (total == 0) {
+        ESP_LOGE(TAG, "La traza %s no tiene muestras", path);
+        return ESP_ERR_INVALID_ARG;
+    }
+    replay_start_ms = hal_clock_now_ms();
+    replay_loaded = true;
+    ESP_LOGI(TAG, "▶️ Reproduciendo %s: %u muestras, %lu s", path, (unsigned)total,
+             (unsigned long)(replay_end_ms / 1000));
+    return ESP_OK;
+}
+
+bool mock_adc_replay_finished(void)
+{
+    return replay_loaded && hal_clock_elapsed_ms(replay_start_ms) > replay_end_ms;
+}
+
+// Valor del canal en el instante actual (la señal se mantiene entre muestras)
+static bool replay_read(int channel, int *out_raw)
+{
+    replay_channel_t *ch = &replay[channel];
+    if (!replay_loaded || ch->count == 0) {
+        return false;
+    }
+    uint32_t elapsed_ms = hal_clock_elapsed_ms(replay_start_ms);
+    while (ch->next < ch->count && ch->samples[ch->next].t_ms <= elapsed_ms) {
+        ch->next++;
+    }
+    *out_raw = ch->samples[ch->next > 0 ? ch->next - 1 : 0].raw;
+    return true;
+}
+
+// Generador congruencial: reproducible por semilla y sin depender de rand()
+static uint32_t synthetic_next(void)
+{
+    synthetic_state = synthetic_state * 1664525u + 1013904223u;
+    return synthetic_state >> 8;
+}
+
+void mock_adc_use_synthetic(uint32_t seed)
+{
+    synthetic_state = seed * 2654435761u + 1;
+    for (int i = 0; i < MOCK_ADC_CHANNELS; i++) {
+        synthetic[i].center = 1200 + (int)(synthetic_next() % 1600);
+        synthetic[i].amplitude = 100 + (int)(synthetic_next() % 600);
+        synthetic[i].period_ms = 600000 + synthetic_next() % 3000000;  // 10-60 min
+        synthetic[i].phase_ms = synthetic_next() % synthetic[i].period_ms;
+    }
+    synthetic_enabled = true;
+    ESP_LOGI(TAG, "Señal sintética (semilla %lu)", (unsigned long)seed);
+}
+
+static int synthetic_read(int channel)
+{
+    const synthetic_channel_t *ch = &synthetic[channel];
+    uint32_t t = (hal_clock_now_ms() + ch->phase_ms) % ch->period_ms;
+    // Triangular entre -amplitude y +amplitude
+    int32_t half = (int32_t)(ch->period_ms / 2);
+    int32_t pos = t < (uint32_t)half ? (int32_t)t : (int32_t)(ch->period_ms - t);
+    int value = ch->center - ch->amplitude + (int)((int64_t)pos * 2 * ch->amplitude / half);
+    value += (int)(synthetic_next() % 41) - 20;
+    if (value < 0) value = 0;
+    if (value > 4095) value = 4095;
+    return value;
+}
+
+void mock_adc_set_raw(int channel, int raw_value)
+{
+    if (channel < 0 || channel >= MOCK_ADC_CHANNELS) return;
+    adc_raw[channel] = raw_value;
+    adc_raw_set[channel] = true;
+}
+
+void mock_adc_set_fail(int channel, bool fail)
+{
+    if (channel < 0 || channel >= MOCK_ADC_CHANNELS) return;
+    adc_fail[channel] = fail;
+}
+
+esp_err_t hal_adc_read_raw(int channel, int *out_raw)
+{
+    if (channel < 0 || channel >= MOCK_ADC_CHANNELS || out_raw == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (adc_fail[channel]) {
+        return ESP_ERR_TIMEOUT;
+    }
+    if (replay_read(channel, out_raw)) {
+        return ESP_OK;
+    }
+    if (adc_raw_set[channel]) {
+        *out_raw = adc_raw[channel];
+    } else {
+        *out_raw = synthetic_enabled ? synthetic_read(channel) : MOCK_ADC_DEFAULT_RAW;
+    }
+    return ESP_OK;
+}
+
+esp_err_t hal_adc_raw_to_mv(int raw_value, int *out_voltage_mv)
+{
+    if (out_voltage_mv == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // Aproximación lineal 0-4095 -> 0-3300 mV (atenuación 12 dB)
+    *out_voltage_mv = raw_value * 3300 / 4095;
+    return ESP_OK;
+}
+
+bool hal_adc_is_ready(void)
+{
+    return true;
+}
@@ -0,0 +1,152 @@
+#include "hal_clock.h"
+#include "mock_hal.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include <stdlib.h>
+#include <time.h>
+
+// Mock de hal_clock.h. Por defecto usa el reloj monotónico del sistema
+// operativo. En modo virtual el tiempo solo avanza cuando todas las tareas
+// están bloqueadas: una tarea de prioridad mínima salta directamente al
+// vencimiento de la próxima hal_clock_delay_ms() y despierta a esa tarea.
+// Así días de operación se ejecutan en segundos con el mismo orden de eventos.
+//
+// Las esperas con timeout en colas y event groups siguen en ticks reales:
+// son esperas de actividad, no mediciones de tiempo.
+
+static const char *TAG = "MOCK_CLOCK";
+
+#define MOCK_CLOCK_MAX_WAITERS 16
+
+typedef struct {
+    bool used;
+    int64_t wake_us;
+    uint32_t seq;               // Orden de llegada entre esperas que vencen juntas
+    SemaphoreHandle_t wake;
+    TaskHandle_t notify_task;   // hal_clock_wait_notify_ms(): se despierta con una notificación
+} clock_waiter_t;
+
+static bool virtual_mode = false;
+static int64_t virtual_now_us = 0;
+static clock_waiter_t waiters[MOCK_CLOCK_MAX_WAITERS];
+static SemaphoreHandle_t waiters_lock = NULL;
+static uint32_t next_seq = 0;
+
+static int64_t real_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+int64_t hal_clock_now_us(void)
+{
+    if (virtual_mode) {
+        return __atomic_load_n(&virtual_now_us, __ATOMIC_SEQ_CST);
+    }
+    return real_now_us();
+}
+
+// Reservar una espera en el reloj virtual. Aborta si no quedan lugares.
+static clock_waiter_t *waiter_add(uint32_t ms, TaskHandle_t notify_task)
+{
+    xSemaphoreTake(waiters_lock, portMAX_DELAY);
+    clock_waiter_t *slot = NULL;
+    for (int i = 0; i < MOCK_CLOCK_MAX_WAITERS; i++) {
+        if (!waiters[i].used) {
+            slot = &waiters[i];
+            break;
+        }
+    }
+    if (slot == NULL) {
+        xSemaphoreGive(waiters_lock);
+        ESP_LOGE(TAG, "Demasiadas tareas esperando en el reloj virtual");
+        abort();
+    }
+    slot->used = true;
+    slot->wake_us = virtual_now_us + (int64_t)ms * 1000;
+    slot->seq = next_seq++;
+    slot->notify_task = notify_task;
+    xSemaphoreGive(waiters_lock);
+    return slot;
+}
+
+void hal_clock_delay_ms(uint32_t ms)
+{
+    if (!virtual_mode) {
+        vTaskDelay(pdMS_TO_TICKS(ms));
+        return;
+    }
+
+    clock_waiter_t *slot = waiter_add(ms, NULL);
+    xSemaphoreTake(slot->wake, portMAX_DELAY);
+}
+
+uint32_t hal_clock_wait_notify_ms(uint32_t ms)
+{
+    uint32_t bits = 0;
+    if (!virtual_mode) {
+        xTaskNotifyWait(0, UINT32_MAX, &bits, pdMS_TO_TICKS(ms));
+        return bits & ~HAL_CLOCK_NOTIFY_RESERVED_BIT;
+    }
+
+    // Vence el plazo (el driver notifica con el bit reservado) o llega otra
+    // notificación antes: en ese caso la espera se retira del reloj
+    clock_waiter_t *slot = waiter_add(ms, xTaskGetCurrentTaskHandle());
+    xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY);
+    xSemaphoreTake(waiters_lock, portMAX_DELAY);
+    if (slot->used && slot->notify_task == xTaskGetCurrentTaskHandle()) {
+        slot->used = false;
+    }
+    xSemaphoreGive(waiters_lock);
+    return bits & ~HAL_CLOCK_NOTIFY_RESERVED_BIT;
+}
+
+// Corre solo cuando el resto de las tareas está bloqueado
+static void clock_driver_task(void *pvParameters)
+{
+    while (1) {
+        xSemaphoreTake(waiters_lock, portMAX_DELAY);
+        clock_waiter_t *next = NULL;
+        for (int i = 0; i < MOCK_CLOCK_MAX_WAITERS; i++) {
+            clock_waiter_t *w = &waiters[i];
+            if (w->used && (next == NULL || w->wake_us < next->wake_us ||
+                            (w->wake_us == next->wake_us && (int32_t)(w->seq - next->seq) < 0))) {
+                next = w;
+            }
+        }
+        if (next != NULL) {
+            if (next->wake_us > virtual_now_us) {
+                __atomic_store_n(&virtual_now_us, next->wake_us, __ATOMIC_SEQ_CST);
+            }
+            next->used = false;
+        }
+        TaskHandle_t notify_task = next != NULL ? next->notify_task : NULL;
+        xSemaphoreGive(waiters_lock);
+
+        if (notify_task != NULL) {
+            xTaskNotify(notify_task, HAL_CLOCK_NOTIFY_RESERVED_BIT, eSetBits);
+        } else if (next != NULL) {
+            xSemaphoreGive(next->wake);
+        } else {
+            vTaskDelay(1); // Nadie espera en el reloj: dejar correr las esperas reales
+        }
+    }
+}
+
+void mock_clock_use_virtual(uint32_t start_ms)
+{
+    if (virtual_mode) {
+        return;
+    }
+    waiters_lock = xSemaphoreCreateMutex();
+    for (int i = 0; i < MOCK_CLOCK_MAX_WAITERS; i++) {
+        waiters[i].wake = xSemaphoreCreateBinary();
+    }
+    virtual_now_us = (int64_t)start_ms * 1000;
+    virtual_mode = true;
+    xTaskCreate(clock_driver_task, "mock_clock", 2048, NULL, tskIDLE_PRIORITY, NULL);
+    ESP_LOGI(TAG, "⏩ Reloj virtual desde %lu ms", (unsigned long)start_ms);
+}
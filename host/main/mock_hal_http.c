@@ -0,0 +1,246 @@
+#include "hal_http.h"
+#include "hal_clock.h"
+#include "mock_hal.h"
+#include "host_net.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+// Mock de hal_http.h: backend simulado en proceso. Los GET devuelven la
+// configuración de los sensores (304 si coincide If-None-Match) y los POST un acuse; la latencia y los fallos
+// se controlan con mock_http_set_behavior(). Con HOST_BACKEND_HTTP las
+// peticiones van al backend local (host_net_http.c).
+
+static const char *TAG = "MOCK_HTTP";
+
+#define MOCK_HTTP_CONFIG_RESPONSE "{\"id_sensor\":8,\"description\":\"host\",\"interval_s\":5,\"state\":true}"
+#define MOCK_HTTP_POST_RESPONSE "{\"ok\":true}"
+// Configuración de todos los sensores (GET /sensors/config?serials=a,b): no cambia nunca
+#define MOCK_HTTP_CONFIG_SYNC_ETAG "\"host-1\""
+#define MOCK_HTTP_CONFIG_SYNC_ENTRY "{\"serial\":\"%.*s\",\"id_sensor\":%d,\"description\":\"host\",\"interval_s\":5,\"state\":true}"
+
+static mock_http_behavior_t behavior = {
+    .status_code = 201,
+    .latency_ms = 20,
+    .server_ms = 30,
+    .transport_error = ESP_OK,
+};
+static uint32_t request_count = 0;
+
+void mock_http_set_behavior(const mock_http_behavior_t *new_behavior)
+{
+    if (new_behavior != NULL) {
+        behavior = *new_behavior;
+    }
+}
+
+uint32_t mock_http_request_count(void)
+{
+    return __atomic_load_n(&request_count, __ATOMIC_RELAXED);
+}
+
+static void mock_http_delay(uint32_t ms)
+{
+    if (ms > 0) {
+        hal_clock_delay_ms(ms);
+    }
+}
+
+static const char *mock_http_request_header(const hal_http_request_t *request, const char *key)
+{
+    for (size_t i = 0; i < request->header_count; i++) {
+        if (strcasecmp(request->headers[i].key, key) == 0) {
+            return request->headers[i].value;
+        }
+    }
+    return NULL;
+}
+
+// Cuerpo de GET /sensors/config: una entrada por serial pedido, IDs desde 8
+static void mock_http_config_sync_body(const char *url, char *body, size_t body_size)
+{
+    const char *serials = strstr(url, "serials=");
+    serials = serials ? serials + strlen("serials=") : "";
+    int len = snprintf(body, body_size, "{\"sensors\":[");
+    for (int id = 8; *serials != '\0' && len > 0 && (size_t)len < body_size; id++) {
+        int serial_len = (int)strcspn(serials, ",");
+        len += snprintf(body + len, body_size - len, "%s" MOCK_HTTP_CONFIG_SYNC_ENTRY, id > 8 ? "," : "",
+                        serial_len, serials, id);
+        serials += serial_len + (serials[serial_len] == ',' ? 1 : 0);
+    }
+    if (len > 0 && (size_t)len < body_size) {
+        snprintf(body + len, body_size - len, "]}");
+    }
+}
+
+// Respuesta simulada según el método y el comportamiento vigente
+static void mock_http_fill_response(const hal_http_request_t *request, hal_http_response_t *response,
+                                    const mock_http_behavior_t *current)
+{
+    const char *body;
+    char sync_body[256];
+    if (request->method == HAL_HTTP_METHOD_GET) {
+        // Las consultas de configuración siempre responden 200 (o 304 si no cambió)
+        response->status_code = (current->status_code >= 200 && current->status_code < 300) ? 200 : current->status_code;
+        body = MOCK_HTTP_CONFIG_RESPONSE;
+        if (strstr(request->url, "/sensors/config") != NULL && response->status_code == 200) {
+            const char *if_none_match = mock_http_request_header(request, "If-None-Match");
+            hal_http_captures_store(request, "ETag", MOCK_HTTP_CONFIG_SYNC_ETAG, strlen(MOCK_HTTP_CONFIG_SYNC_ETAG));
+            if (if_none_match != NULL && strcmp(if_none_match, MOCK_HTTP_CONFIG_SYNC_ETAG) == 0) {
+                response->status_code = 304;
+                body = "";
+            } else {
+                mock_http_config_sync_body(request->url, sync_body, sizeof(sync_body));
+                body = sync_body;
+            }
+        }
+    } else {
+        response->status_code = current->status_code;
+        body = MOCK_HTTP_POST_RESPONSE;
+    }
+
+    if (request->response_buf != NULL && request->response_buf_size > 0) {
+        int written = snprintf(request->response_buf, request->response_buf_size, "%s", body);
+        if (written > 0) {
+            response->response_len = (size_t)written < request->response_buf_size ? (size_t)written : request->response_buf_size - 1;
+        }
+    }
+
+    ESP_LOGD(TAG, "%s %s -> %d (%u bytes)", request->method == HAL_HTTP_METHOD_POST ? "POST" : "GET",
+             request->url, response->status_code, (unsigned)request->body_len);
+}
+
+esp_err_t hal_http_perform(const hal_http_request_t *request, hal_http_response_t *response)
+{
+    if (request == NULL || response == NULL || request->url == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(response, 0, sizeof(*response));
+    if (request->response_buf != NULL && request->response_buf_size > 0) {
+        request->response_buf[0] = '\0';
+    }
+    hal_http_captures_reset(request);
+    __atomic_fetch_add(&request_count, 1, __ATOMIC_RELAXED);
+
+    if (host_net_http_enabled()) {
+        return host_net_http_perform(request, response);
+    }
+
+    mock_http_behavior_t current = behavior;
+
+    // Conexión + envío de headers
+    mock_http_delay(current.latency_ms);
+    if (current.transport_error != ESP_OK) {
+        ESP_LOGW(TAG, "Fallo de transporte simulado: %s %s", request->method == HAL_HTTP_METHOD_POST ? "POST" : "GET", request->url);
+        return current.transport_error;
+    }
+    if (request->sent_us != NULL) {
+        *request->sent_us = hal_clock_now_us();
+    }
+
+    // Procesamiento en el servidor
+    mock_http_delay(current.server_ms);
+
+    mock_http_fill_response(request, response, &current);
+    return ESP_OK;
+}
+
+// Petición no bloqueante: las mismas etapas que hal_http_perform(), medidas
+// contra el reloj en cada consulta en lugar de esperarlas
+struct hal_http_async {
+    const hal_http_request_t *request;
+    host_net_http_async_t *net;         // Con HOST_BACKEND_HTTP
+    mock_http_behavior_t behavior;      // Fijado al iniciar
+    uint32_t started_ms;
+    bool headers_sent;
+};
+
+esp_err_t hal_http_start(const hal_http_request_t *request, hal_http_async_t *handle)
+{
+    if (request == NULL || handle == NULL || request->url == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct hal_http_async *async = calloc(1, sizeof(*async));
+    if (async == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (request->response_buf != NULL && request->response_buf_size > 0) {
+        request->response_buf[0] = '\0';
+    }
+    hal_http_captures_reset(request);
+    __atomic_fetch_add(&request_count, 1, __ATOMIC_RELAXED);
+
+    if (host_net_http_enabled()) {
+        esp_err_t err = host_net_http_start(request, &async->net);
+        if (err != ESP_OK) {
+            free(async);
+            return err;
+        }
+    }
+    async->request = request;
+    async->behavior = behavior;
+    async->started_ms = hal_clock_now_ms();
+    *handle = async;
+    return ESP_OK;
+}
+
+bool hal_http_poll(hal_http_async_t handle, esp_err_t *result, hal_http_response_t *response)
+{
+    memset(response, 0, sizeof(*response));
+    if (handle->net != NULL) {
+        if (!host_net_http_poll(handle->net, result, response)) {
+            return false;
+        }
+        handle->net = NULL;     // Ya liberado por host_net_http_poll()
+        hal_http_abort(handle);
+        return true;
+    }
+
+    const hal_http_request_t *request = handle->request;
+    const mock_http_behavior_t *current = &handle->behavior;
+    uint32_t elapsed_ms = hal_clock_elapsed_ms(handle->started_ms);
+    uint32_t timeout_ms = request->timeout_ms > 0 ? (uint32_t)request->timeout_ms : UINT32_MAX;
+
+    // Conexión + envío de headers
+    if (elapsed_ms < current->latency_ms) {
+        if (elapsed_ms < timeout_ms) {
+            return false;
+        }
+        *result = ESP_ERR_TIMEOUT;
+    } else if (current->transport_error != ESP_OK) {
+        ESP_LOGW(TAG, "Fallo de transporte simulado: %s %s", request->method == HAL_HTTP_METHOD_POST ? "POST" : "GET", request->url);
+        *result = current->transport_error;
+    } else {
+        if (!handle->headers_sent) {
+            handle->headers_sent = true;
+            if (request->sent_us != NULL) {
+                *request->sent_us = hal_clock_now_us();
+            }
+        }
+        // Procesamiento en el servidor
+        if (elapsed_ms < current->latency_ms + current->server_ms) {
+            if (elapsed_ms < timeout_ms) {
+                return false;
+            }
+            *result = ESP_ERR_TIMEOUT;
+        } else {
+            mock_http_fill_response(request, response, current);
+            *result = ESP_OK;
+        }
+    }
+
+    hal_http_abort(handle);
+    return true;
+}
+
+void hal_http_abort(hal_http_async_t handle)
+{
+    if (handle != NULL) {
+        host_net_http_abort(handle->net);
+        free(handle);
+    }
+}
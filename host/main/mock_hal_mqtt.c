@@ -0,0 +1,114 @@
+#include "hal_mqtt.h"
+#include "mock_hal.h"
+#include "host_net.h"
+#include "esp_log.h"
+#include <string.h>
+
+// Mock de hal_mqtt.h: broker simulado. Los eventos se entregan en el
+// contexto de quien los provoca (start, subscribe o mock_mqtt_inject).
+// Con HOST_BACKEND_MQTT se conecta al broker local (host_net_mqtt.c).
+
+static const char *TAG = "MOCK_MQTT";
+
+static hal_mqtt_event_cb_t event_callback = NULL;
+static bool connected = false;
+static int next_msg_id = 1;
+static uint32_t published_count = 0;
+
+static void dispatch(const hal_mqtt_event_t *event)
+{
+    if (event_callback != NULL) {
+        event_callback(event);
+    }
+}
+
+esp_err_t hal_mqtt_start(const hal_mqtt_config_t *config, hal_mqtt_event_cb_t callback)
+{
+    if (config == NULL || callback == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (host_net_mqtt_enabled()) {
+        return host_net_mqtt_start(config, callback);
+    }
+    event_callback = callback;
+    ESP_LOGI(TAG, "Broker simulado (%s, client_id=%s)", config->uri, config->client_id ? config->client_id : "-");
+    mock_mqtt_set_connected(true);
+    return ESP_OK;
+}
+
+void mock_mqtt_set_connected(bool is_connected)
+{
+    if (connected == is_connected) {
+        return;
+    }
+    connected = is_connected;
+    hal_mqtt_event_t event = {
+        .id = is_connected ? HAL_MQTT_EVENT_CONNECTED : HAL_MQTT_EVENT_DISCONNECTED,
+    };
+    dispatch(&event);
+}
+
+int hal_mqtt_subscribe(const char *topic, int qos)
+{
+    if (host_net_mqtt_enabled()) {
+        return host_net_mqtt_subscribe(topic, qos);
+    }
+    if (!connected || topic == NULL) {
+        return -1;
+    }
+    hal_mqtt_event_t event = {
+        .id = HAL_MQTT_EVENT_SUBSCRIBED,
+        .msg_id = next_msg_id++,
+    };
+    dispatch(&event);
+    return event.msg_id;
+}
+
+int hal_mqtt_publish(const char *topic, const char *data, int len, int qos, int retain)
+{
+    if (host_net_mqtt_enabled()) {
+        int msg_id = host_net_mqtt_publish(topic, data, len, qos, retain);
+        if (msg_id >= 0) {
+            __atomic_fetch_add(&published_count, 1, __ATOMIC_RELAXED);
+        }
+        return msg_id;
+    }
+    if (!connected || topic == NULL || data == NULL) {
+        return -1;
+    }
+    if (len == 0) {
+        len = (int)strlen(data);
+    }
+    __atomic_fetch_add(&published_count, 1, __ATOMIC_RELAXED);
+    ESP_LOGD(TAG, "PUBLISH %s (%d bytes): %.*s", topic, len, len, data);
+    // QoS 0 no tiene msg_id ni confirmación
+    return qos > 0 ? next_msg_id++ : 0;
+}
+
+void hal_mqtt_set_reconnect_timeout(int reconnect_timeout_ms)
+{
+    // El broker en memoria no reconecta solo: lo decide mock_mqtt_set_connected()
+    if (host_net_mqtt_enabled()) {
+        host_net_mqtt_set_reconnect_timeout(reconnect_timeout_ms);
+    }
+}
+
+uint32_t mock_mqtt_published_count(void)
+{
+    return __atomic_load_n(&published_count, __ATOMIC_RELAXED);
+}
+
+void mock_mqtt_inject(const char *topic, const char *payload)
+{
+    if (!connected || topic == NULL || payload == NULL) {
+        return;
+    }
+    hal_mqtt_event_t event = {
+        .id = HAL_MQTT_EVENT_DATA,
+        .topic = topic,
+        .topic_len = (int)strlen(topic),
+        .data = payload,
+        .data_len = (int)strlen(payload),
+    };
+    dispatch(&event);
+}
@@ -0,0 +1,205 @@
+#include "hal_nvs.h"
+#include "mock_hal.h"
+#include <string.h>
+
+// Mock de hal_nvs.h: tabla clave/valor en memoria (se pierde al salir)
+
+#define MOCK_NVS_MAX_ENTRIES 64
+#define MOCK_NVS_MAX_NAMESPACES 8
+#define MOCK_NVS_NAME_LEN 16
+#define MOCK_NVS_STR_LEN 64
+
+typedef enum {
+    MOCK_NVS_TYPE_U8,
+    MOCK_NVS_TYPE_I32,
+    MOCK_NVS_TYPE_STR,
+    MOCK_NVS_TYPE_BLOB              // En str, con el largo en value
+} mock_nvs_type_t;
+
+typedef struct {
+    bool used;
+    hal_nvs_handle_t ns;
+    char key[MOCK_NVS_NAME_LEN];
+    mock_nvs_type_t type;
+    int32_t value;
+    char str[MOCK_NVS_STR_LEN];
+} mock_nvs_entry_t;
+
+static char namespaces[MOCK_NVS_MAX_NAMESPACES][MOCK_NVS_NAME_LEN];
+static mock_nvs_entry_t entries[MOCK_NVS_MAX_ENTRIES];
+
+void mock_nvs_reset(void)
+{
+    memset(namespaces, 0, sizeof(namespaces));
+    memset(entries, 0, sizeof(entries));
+}
+
+static mock_nvs_entry_t *find_entry(hal_nvs_handle_t handle, const char *key)
+{
+    for (int i = 0; i < MOCK_NVS_MAX_ENTRIES; i++) {
+        if (entries[i].used && entries[i].ns == handle && strcmp(entries[i].key, key) == 0) {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+static esp_err_t set_entry(hal_nvs_handle_t handle, const char *key, mock_nvs_type_t type,
+                           int32_t value, const char *str)
+{
+    if (strlen(key) >= MOCK_NVS_NAME_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    mock_nvs_entry_t *entry = find_entry(handle, key);
+    for (int i = 0; entry == NULL && i < MOCK_NVS_MAX_ENTRIES; i++) {
+        if (!entries[i].used) {
+            entry = &entries[i];
+        }
+    }
+    if (entry == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    entry->used = true;
+    entry->ns = handle;
+    strncpy(entry->key, key, sizeof(entry->key) - 1);
+    entry->type = type;
+    entry->value = value;
+    if (str != NULL) {
+        strncpy(entry->str, str, sizeof(entry->str) - 1);
+    }
+    return ESP_OK;
+}
+
+esp_err_t hal_nvs_open(const char *name_space, bool read_write, hal_nvs_handle_t *out_handle)
+{
+    if (name_space == NULL || strlen(name_space) >= MOCK_NVS_NAME_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < MOCK_NVS_MAX_NAMESPACES; i++) {
+        if (namespaces[i][0] != '\0' && strcmp(namespaces[i], name_space) == 0) {
+            *out_handle = (hal_nvs_handle_t)(i + 1);
+            return ESP_OK;
+        }
+    }
+    // Igual que NVS: un namespace inexistente no puede abrirse en solo lectura
+    if (!read_write) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    for (int i = 0; i < MOCK_NVS_MAX_NAMESPACES; i++) {
+        if (namespaces[i][0] == '\0') {
+            strncpy(namespaces[i], name_space, MOCK_NVS_NAME_LEN - 1);
+            *out_handle = (hal_nvs_handle_t)(i + 1);
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+void hal_nvs_close(hal_nvs_handle_t handle)
+{
+    (void)handle;
+}
+
+esp_err_t hal_nvs_commit(hal_nvs_handle_t handle)
+{
+    (void)handle;
+    return ESP_OK;
+}
+
+esp_err_t hal_nvs_get_u8(hal_nvs_handle_t handle, const char *key, uint8_t *out_value)
+{
+    mock_nvs_entry_t *entry = find_entry(handle, key);
+    if (entry == NULL || entry->type != MOCK_NVS_TYPE_U8) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    *out_value = (uint8_t)entry->value;
+    return ESP_OK;
+}
+
+esp_err_t hal_nvs_set_u8(hal_nvs_handle_t handle, const char *key, uint8_t value)
+{
+    return set_entry(handle, key, MOCK_NVS_TYPE_U8, value, NULL);
+}
+
+esp_err_t hal_nvs_get_i32(hal_nvs_handle_t handle, const char *key, int32_t *out_value)
+{
+    mock_nvs_entry_t *entry = find_entry(handle, key);
+    if (entry == NULL || entry->type != MOCK_NVS_TYPE_I32) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    *out_value = entry->value;
+    return ESP_OK;
+}
+
+esp_err_t hal_nvs_set_i32(hal_nvs_handle_t handle, const char *key, int32_t value)
+{
+    return set_entry(handle, key, MOCK_NVS_TYPE_I32, value, NULL);
+}
+
+esp_err_t hal_nvs_get_str(hal_nvs_handle_t handle, const char *key, char *out_value, size_t *length)
+{
+    mock_nvs_entry_t *entry = find_entry(handle, key);
+    if (entry == NULL || entry->type != MOCK_NVS_TYPE_STR) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    size_t needed = strlen(entry->str) + 1;
+    if (out_value == NULL) {
+        *length = needed;
+        return ESP_OK;
+    }
+    if (*length < needed) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(out_value, entry->str, needed);
+    *length = needed;
+    return ESP_OK;
+}
+
+esp_err_t hal_nvs_set_str(hal_nvs_handle_t handle, const char *key, const char *value)
+{
+    if (value == NULL || strlen(value) >= MOCK_NVS_STR_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return set_entry(handle, key, MOCK_NVS_TYPE_STR, 0, value);
+}
+
+esp_err_t hal_nvs_get_blob(hal_nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+    mock_nvs_entry_t *entry = find_entry(handle, key);
+    if (entry == NULL || entry->type != MOCK_NVS_TYPE_BLOB) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    size_t needed = (size_t)entry->value;
+    if (out_value == NULL) {
+        *length = needed;
+        return ESP_OK;
+    }
+    if (*length < needed) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    memcpy(out_value, entry->str, needed);
+    *length = needed;
+    return ESP_OK;
+}
+
+esp_err_t hal_nvs_set_blob(hal_nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    if (value == NULL || length > MOCK_NVS_STR_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t err = set_entry(handle, key, MOCK_NVS_TYPE_BLOB, (int32_t)length, NULL);
+    if (err == ESP_OK) {
+        memcpy(find_entry(handle, key)->str, value, length);
+    }
+    return err;
+}
+
+esp_err_t hal_nvs_erase_key(hal_nvs_handle_t handle, const char *key)
+{
+    mock_nvs_entry_t *entry = find_entry(handle, key);
+    if (entry == NULL) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    memset(entry, 0, sizeof(*entry));
+    return ESP_OK;
+}
@@ -0,0 +1,21 @@
+#include "hal_sntp.h"
+#include "host_net.h"
+#include "esp_log.h"
+
+// Mock de hal_sntp.h. Con HOST_NTP_SERVER consulta el servidor NTP del
+// backend local (host_net_sntp.c); sin ella nunca sincroniza y los datos
+// salen solo con uptime_ms y boot_id.
+
+static const char *TAG = "MOCK_SNTP";
+
+esp_err_t hal_sntp_start(const char *server, uint32_t interval_ms, hal_sntp_sync_cb_t callback)
+{
+    if (server == NULL || callback == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (host_net_sntp_enabled()) {
+        return host_net_sntp_start(interval_ms, callback);
+    }
+    ESP_LOGI(TAG, "Sin servidor NTP (HOST_NTP_SERVER): reloj sin sincronizar");
+    return ESP_OK;
+}
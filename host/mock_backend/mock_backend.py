@@ -0,0 +1,901 @@
+#!/usr/bin/env python3
+"""Backend local que reemplaza a ong-controller.vercel.app y al broker HiveMQ.
+
+Implementa el mismo contrato que usa el firmware:
+  POST /api/v1/process-data           tramas de lecturas ({"readings": [...], "seq", ...})
+  POST /api/v1/error-logs             errores del error_logger
+  GET  /api/v1/sensors/serial/{serial} configuración inicial del sensor
+  GET  /api/v1/sensors/config?serials=a,b  configuración de todos los sensores
+                                      del dispositivo, con ETag/Last-Modified
+                                      (304 si no cambió desde If-None-Match).
+                                      El backend de producción no lo tiene: una
+                                      regla {"path": "/sensors/config", "status": 404}
+                                      prueba la vuelta del firmware a /sensors/serial/
+  POST /api/update-sensor-config      igual que vercel_backend_example.js:
+                                      publica la config en ong/sensor/{serial}/config
+y un broker MQTT 3.1.1 mínimo (sin TLS) para los tópicos de configuración,
+estado y métricas.
+
+Las fallas se guionan con un escenario JSON (--scenario) de fases que se
+ejecutan en orden. Cada fase dura duration_s y tiene reglas que se aplican
+a las peticiones que coinciden (la primera que coincide y sale sorteada):
+
+  {"loop": false, "phases": [
+    {"name": "normal", "duration_s": 30},
+    {"name": "caida", "duration_s": 20,
+     "rules": [{"path": "/process-data", "status": 503}],
+     "mqtt": {"drop_clients": true, "refuse": true}},
+    {"name": "lento", "duration_s": 60,
+     "rules": [{"path": "*", "latency_ms": [200, 2000]},
+               {"path": "/error-logs", "action": "reset", "probability": 0.3},
+               {"path": "/sensors/serial/", "action": "drip", "drip_bytes_per_s": 20}]}
+  ]}
+
+Campos de una regla: path (prefijo sin /api/v1, "*" = todas), method,
+probability (0-1), latency_ms (n o [min, max]), status, y action:
+  respond  responder normalmente con status (por defecto)
+  reset    cerrar la conexión con RST sin responder
+  drip     enviar la respuesta completa a drip_bytes_per_s
+Opciones MQTT de una fase: drop_clients (cortar las conexiones al empezar),
+refuse (rechazar CONNECT con código 3), latency_ms (demora al reenviar).
+
+Control en tiempo de ejecución:
+  GET  /__mock/stats     estadísticas (JSON)
+  POST /__mock/scenario  reemplazar el escenario (mismo formato)
+  POST /__mock/reset     poner a cero las estadísticas
+
+Recuperación: al terminar una fase con fallas se mide, por dispositivo,
+cuánto tarda su primer POST exitoso a /process-data.
+
+Idempotencia: los POST con header Idempotency-Key ("<mac>-<boot_id>-<flujo>-<seq>",
+ver main/sequence.h) se guardan una sola vez; un reintento de una clave ya
+recibida responde 200 con "duplicate": true. Los huecos de seq por flujo y
+arranque se informan como muestras perdidas (uploads.lost en las estadísticas).
+
+Compresión: los POST con Content-Encoding deflate (zlib) o gzip se
+descomprimen antes de validarlos; bodies en las estadísticas compara los
+bytes recibidos por la red con los del JSON.
+
+Hora: con --ntp-port sirve SNTP por UDP (hora del sistema más
+--ntp-offset-ms y --ntp-drift-ppm, para probar la estimación de deriva de
+main/time_service.c). Los envíos que llegan sin timestamp (dispositivo sin
+sincronizar) traen uptime_ms y boot_id y se corrigen con el desfase de su
+arranque en cuanto llega uno con hora (time.corrected / time.pending).
+
+Uso:
+  mock_backend.py [--http-port 8080] [--mqtt-port 1883] [--ntp-port 12300]
+                  [--scenario fallas.json] [--stats-out stats.json] [--quiet]
+El build de host lo usa con HOST_BACKEND_HTTP=127.0.0.1:8080,
+HOST_BACKEND_MQTT=127.0.0.1:1883 y HOST_NTP_SERVER=127.0.0.1:12300; el de
+QEMU compilando con -DLOCAL_BACKEND_HOST=10.0.2.2 (ver main/config.h) y
+--ntp-port 123.
+"""
+import argparse
+import json
+import random
+import signal
+import socket
+import socketserver
+import struct
+import sys
+import threading
+import time
+import zlib
+from email.utils import formatdate, parsedate_to_datetime
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import parse_qs
+
+API_PREFIX = '/api/v1'
+
+# Sensores conocidos (los del firmware); el resto recibe ids a partir de 100
+KNOWN_SENSORS = {'0x001C': 8, '0x001D': 9}
+
+
+def now_ms():
+    return time.monotonic() * 1000.0
+
+
+def percentile(values, pct):
+    if not values:
+        return 0.0
+    ordered = sorted(values)
+    index = min(len(ordered) - 1, int(round(pct / 100.0 * (len(ordered) - 1))))
+    return ordered[index]
+
+
+# ============= ESCENARIO =============
+
+class Scenario:
+    """Fases de fallas guionadas; la fase activa depende del tiempo transcurrido."""
+
+    def __init__(self, data=None):
+        data = data or {}
+        self.phases = data.get('phases') or [{'name': 'normal', 'duration_s': 0}]
+        self.loop = bool(data.get('loop', False))
+        self.started_ms = now_ms()
+        self.listeners = []
+        self._last_index = None
+        self._lock = threading.Lock()
+
+    def _index_at(self, elapsed_s):
+        total = sum(p.get('duration_s', 0) for p in self.phases)
+        if self.loop and total > 0:
+            elapsed_s %= total
+        for i, phase in enumerate(self.phases):
+            duration = phase.get('duration_s', 0)
+            if duration <= 0 or elapsed_s < duration:
+                return i
+            elapsed_s -= duration
+        return len(self.phases) - 1
+
+    def current(self):
+        """Fase activa; avisa a los listeners cuando cambia."""
+        index = self._index_at((now_ms() - self.started_ms) / 1000.0)
+        with self._lock:
+            if index == self._last_index:
+                return self.phases[index]
+            previous = self.phases[self._last_index] if self._last_index is not None else None
+            self._last_index = index
+        for listener in self.listeners:
+            listener(previous, self.phases[index])
+        return self.phases[index]
+
+    def match(self, method, path):
+        """Primera regla de la fase activa que aplica a la petición (o None)."""
+        for rule in self.current().get('rules', []):
+            rule_path = rule.get('path', '*')
+            if rule_path != '*' and not path.startswith(rule_path):
+                continue
+            if rule.get('method') and rule['method'].upper() != method:
+                continue
+            if random.random() >= rule.get('probability', 1.0):
+                continue
+            return rule
+        return None
+
+
+def rule_latency_ms(rule):
+    latency = rule.get('latency_ms', 0) if rule else 0
+    if isinstance(latency, (list, tuple)):
+        return random.uniform(latency[0], latency[1])
+    return float(latency)
+
+
+def phase_has_faults(phase):
+    return bool(phase and (phase.get('rules') or phase.get('mqtt')))
+
+
+# ============= ESTADÍSTICAS =============
+
+class Stats:
+    RATE_WINDOW_S = 10
+
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.reset()
+
+    def reset(self):
+        with getattr(self, 'lock', threading.Lock()):
+            self.started_ms = now_ms()
+            self.endpoints = {}
+            self.recent = []                # Instantes de peticiones recientes (tasa)
+            self.devices = {}               # Último POST exitoso por dispositivo
+            self.recovery_start_ms = None
+            self.recovering = set()
+            self.recoveries_ms = []
+            self.mqtt = {'connects': 0, 'refused': 0, 'dropped': 0,
+                         'publish_in': 0, 'publish_out': 0, 'topics': {}}
+            self.phase_log = []
+            self.upload_seqs = {}           # Flujo ("<mac>-<boot_id>-<f|e>") -> seqs recibidas
+            self.upload_duplicates = 0
+            self.boot_offsets = {}          # (dispositivo, boot_id) -> timestamp - uptime_ms
+            self.unplaced = {}              # (dispositivo, boot_id) -> envíos sin hora a la espera
+            self.time_counts = {'synced': 0, 'unsynced': 0, 'corrected': 0}
+            self.ntp_requests = 0
+            self.reading_count = 0          # Lecturas recibidas dentro de las tramas de /process-data
+            self.bodies = {'wire_bytes': 0, 'json_bytes': 0, 'compressed': 0, 'plain': 0}
+
+    def record(self, endpoint, status, action, elapsed_ms, device=None):
+        t = now_ms()
+        with self.lock:
+            ep = self.endpoints.setdefault(endpoint, {
+                'requests': 0, 'status': {}, 'faults': {}, 'latency_ms': []})
+            ep['requests'] += 1
+            key = str(status) if status else 'sin_respuesta'
+            ep['status'][key] = ep['status'].get(key, 0) + 1
+            if action and action != 'respond':
+                ep['faults'][action] = ep['faults'].get(action, 0) + 1
+            ep['latency_ms'].append(elapsed_ms)
+            self.recent.append(t)
+            cutoff = t - self.RATE_WINDOW_S * 1000
+            while self.recent and self.recent[0] < cutoff:
+                self.recent.pop(0)
+
+            if device is not None and status and 200 <= status < 300:
+                self.devices[device] = t
+                if device in self.recovering:
+                    self.recovering.discard(device)
+                    self.recoveries_ms.append(t - self.recovery_start_ms)
+
+    def on_phase_change(self, previous, phase):
+        with self.lock:
+            self.phase_log.append({'t_s': round((now_ms() - self.started_ms) / 1000.0, 1),
+                                   'phase': phase.get('name', '?')})
+            # Fin de una fase con fallas: medir la recuperación de cada dispositivo
+            if phase_has_faults(previous) and not phase_has_faults(phase):
+                self.recovery_start_ms = now_ms()
+                self.recovering = set(self.devices.keys())
+
+    def upload(self, key):
+        """Registrar una clave de idempotencia; True si ya se había recibido."""
+        stream, _, seq = (key or '').rpartition('-')
+        if not stream or not seq.isdigit():
+            return False
+        with self.lock:
+            seqs = self.upload_seqs.setdefault(stream, set())
+            if int(seq) in seqs:
+                self.upload_duplicates += 1
+                return True
+            seqs.add(int(seq))
+            return False
+
+    def place(self, key, body):
+        """Ubicar un envío en la línea de tiempo de su arranque.
+
+        Los que llegan sin hora (reloj del dispositivo sin sincronizar) se
+        corrigen en cuanto un envío del mismo arranque trae timestamp y uptime_ms.
+        """
+        if not isinstance(body, dict) or 'uptime_ms' not in body or 'boot_id' not in body:
+            return
+        device = key.split('-', 1)[0] if key else body.get('device_serial', body.get('id_sensor'))
+        boot = (device, body['boot_id'])
+        with self.lock:
+            if 'timestamp' in body:
+                self.time_counts['synced'] += 1
+                if boot not in self.boot_offsets:
+                    self.boot_offsets[boot] = body['timestamp'] - body['uptime_ms']
+                    self.time_counts['corrected'] += self.unplaced.pop(boot, 0)
+                return
+            self.time_counts['unsynced'] += 1
+            if boot in self.boot_offsets:
+                self.time_counts['corrected'] += 1
+            else:
+                self.unplaced[boot] = self.unplaced.get(boot, 0) + 1
+
+    def body(self, wire_bytes, json_bytes, compressed):
+        """Bytes de un cuerpo recibido: en la red y ya descomprimido."""
+        with self.lock:
+            self.bodies['wire_bytes'] += wire_bytes
+            self.bodies['json_bytes'] += json_bytes
+            self.bodies['compressed' if compressed else 'plain'] += 1
+
+    def readings(self, count):
+        with self.lock:
+            self.reading_count += count
+
+    def ntp_inc(self):
+        with self.lock:
+            self.ntp_requests += 1
+
+    def mqtt_inc(self, key, topic=None):
+        with self.lock:
+            self.mqtt[key] += 1
+            if topic is not None:
+                self.mqtt['topics'][topic] = self.mqtt['topics'].get(topic, 0) + 1
+
+    def snapshot(self):
+        with self.lock:
+            elapsed_s = max((now_ms() - self.started_ms) / 1000.0, 0.001)
+            endpoints = {}
+            total = 0
+            for name, ep in self.endpoints.items():
+                total += ep['requests']
+                endpoints[name] = {
+                    'requests': ep['requests'],
+                    'status': dict(ep['status']),
+                    'faults': dict(ep['faults']),
+                    'p50_ms': round(percentile(ep['latency_ms'], 50), 1),
+                    'p99_ms': round(percentile(ep['latency_ms'], 99), 1),
+                    'max_ms': round(max(ep['latency_ms']) if ep['latency_ms'] else 0.0, 1),
+                }
+            return {
+                'elapsed_s': round(elapsed_s, 1),
+                'requests': total,
+                'rps_avg': round(total / elapsed_s, 2),
+                'rps_recent': round(len(self.recent) / float(self.RATE_WINDOW_S), 2),
+                'devices': len(self.devices),
+                'endpoints': endpoints,
+                'recovery': {
+                    'measured': len(self.recoveries_ms),
+                    'pending': len(self.recovering),
+                    'p50_ms': round(percentile(self.recoveries_ms, 50), 1),
+                    'p95_ms': round(percentile(self.recoveries_ms, 95), 1),
+                    'max_ms': round(max(self.recoveries_ms) if self.recoveries_ms else 0.0, 1),
+                },
+                # Pérdida exacta por flujo y arranque: huecos entre la menor y la mayor seq
+                'uploads': {
+                    'readings': self.reading_count,
+                    'unique': sum(len(seqs) for seqs in self.upload_seqs.values()),
+                    'duplicates': self.upload_duplicates,
+                    'lost': sum(max(seqs) - min(seqs) + 1 - len(seqs) for seqs in self.upload_seqs.values()),
+                    'streams': len(self.upload_seqs),
+                },
+                # Envíos sin hora: corregidos con el desfase de su arranque o todavía pendientes
+                'time': dict(self.time_counts, pending=sum(self.unplaced.values()),
+                             ntp_requests=self.ntp_requests),
+                'bodies': dict(self.bodies),
+                'mqtt': json.loads(json.dumps(self.mqtt)),
+                'phases': list(self.phase_log),
+            }
+
+
+# ============= BROKER MQTT =============
+
+class MqttBroker:
+    """Broker MQTT 3.1.1 mínimo: QoS 0/1, retain, comodines + y #."""
+
+    def __init__(self, state):
+        self.state = state
+        self.lock = threading.Lock()
+        self.sessions = []
+        self.retained = {}
+
+    @staticmethod
+    def topic_matches(topic_filter, topic):
+        f_parts = topic_filter.split('/')
+        t_parts = topic.split('/')
+        for i, part in enumerate(f_parts):
+            if part == '#':
+                return True
+            if i >= len(t_parts) or (part != '+' and part != t_parts[i]):
+                return False
+        return len(f_parts) == len(t_parts)
+
+    def register(self, session):
+        with self.lock:
+            self.sessions.append(session)
+
+    def unregister(self, session):
+        with self.lock:
+            if session in self.sessions:
+                self.sessions.remove(session)
+
+    def drop_all(self):
+        with self.lock:
+            sessions = list(self.sessions)
+        for session in sessions:
+            session.abort()
+            self.state.stats.mqtt_inc('dropped')
+
+    def publish(self, topic, payload, qos=0, retain=False):
+        if retain:
+            with self.lock:
+                if payload:
+                    self.retained[topic] = (payload, qos)
+                else:
+                    self.retained.pop(topic, None)
+        mqtt_rules = self.state.scenario.current().get('mqtt', {})
+        delay_ms = rule_latency_ms(mqtt_rules)
+        if delay_ms > 0:
+            time.sleep(delay_ms / 1000.0)
+        with self.lock:
+            targets = [(s, sub_qos) for s in self.sessions
+                       for f, sub_qos in s.subscriptions.items() if self.topic_matches(f, topic)]
+        for session, sub_qos in targets:
+            session.send_publish(topic, payload, min(qos, sub_qos), False)
+            self.state.stats.mqtt_inc('publish_out')
+        return len(targets)
+
+    def retained_for(self, topic_filter):
+        with self.lock:
+            return [(t, p, q) for t, (p, q) in self.retained.items() if self.topic_matches(topic_filter, t)]
+
+
+class MqttSession(socketserver.BaseRequestHandler):
+    def setup(self):
+        self.broker = self.server.state.broker
+        self.subscriptions = {}
+        self.send_lock = threading.Lock()
+        self.next_packet_id = 1
+        self.client_id = '?'
+
+    def abort(self):
+        try:
+            self.request.setsockopt(socket.SOL_SOCKET, socket.SO_LINGER, struct.pack('ii', 1, 0))
+            self.request.close()
+        except OSError:
+            pass
+
+    def _recv_exact(self, n):
+        data = b''
+        while len(data) < n:
+            chunk = self.request.recv(n - len(data))
+            if not chunk:
+                raise ConnectionError('conexión cerrada')
+            data += chunk
+        return data
+
+    def _read_packet(self):
+        header = self._recv_exact(1)[0]
+        length, multiplier = 0, 1
+        while True:
+            byte = self._recv_exact(1)[0]
+            length += (byte & 0x7F) * multiplier
+            if not byte & 0x80:
+                break
+            multiplier *= 128
+        return header, self._recv_exact(length) if length else b''
+
+    def _send(self, packet_type, flags, body):
+        length = len(body)
+        encoded = bytearray()
+        while True:
+            byte = length % 128
+            length //= 128
+            encoded.append(byte | (0x80 if length else 0))
+            if not length:
+                break
+        with self.send_lock:
+            self.request.sendall(bytes([(packet_type << 4) | flags]) + bytes(encoded) + body)
+
+    @staticmethod
+    def _utf8(data, offset):
+        (length,) = struct.unpack_from('!H', data, offset)
+        return data[offset + 2:offset + 2 + length], offset + 2 + length
+
+    def send_publish(self, topic, payload, qos, retain):
+        topic_bytes = topic.encode()
+        body = struct.pack('!H', len(topic_bytes)) + topic_bytes
+        if qos > 0:
+            with self.send_lock:
+                packet_id = self.next_packet_id
+                self.next_packet_id = self.next_packet_id % 0xFFFF + 1
+            body += struct.pack('!H', packet_id)
+        try:
+            self._send(3, (qos << 1) | (1 if retain else 0), body + payload)
+        except OSError:
+            pass
+
+    def handle(self):
+        state = self.server.state
+        try:
+            header, body = self._read_packet()
+            if header >> 4 != 1:
+                return
+            # CONNECT: nombre de protocolo, nivel, flags, keepalive, client_id
+            _, offset = self._utf8(body, 0)
+            offset += 4
+            client_id, _ = self._utf8(body, offset)
+            self.client_id = client_id.decode(errors='replace') or '?'
+
+            if state.scenario.current().get('mqtt', {}).get('refuse'):
+                state.stats.mqtt_inc('refused')
+                self._send(2, 0, bytes([0, 3]))     # Servidor no disponible
+                return
+            self._send(2, 0, bytes([0, 0]))
+            state.stats.mqtt_inc('connects')
+            self.broker.register(self)
+            state.log('MQTT', 'CONNECT %s' % self.client_id)
+
+            while True:
+                header, body = self._read_packet()
+                packet_type, flags = header >> 4, header & 0x0F
+                if packet_type == 3:                # PUBLISH
+                    qos = (flags >> 1) & 0x03
+                    topic, offset = self._utf8(body, 0)
+                    topic = topic.decode(errors='replace')
+                    if qos > 0:
+                        (packet_id,) = struct.unpack_from('!H', body, offset)
+                        offset += 2
+                        self._send(4, 0, struct.pack('!H', packet_id))
+                    state.stats.mqtt_inc('publish_in', topic)
+                    self.broker.publish(topic, body[offset:], qos, bool(flags & 0x01))
+                elif packet_type == 8:              # SUBSCRIBE
+                    (packet_id,) = struct.unpack_from('!H', body, 0)
+                    offset, granted, filters = 2, bytearray(), []
+                    while offset < len(body):
+                        topic_filter, offset = self._utf8(body, offset)
+                        qos = min(body[offset] & 0x03, 1)
+                        offset += 1
+                        topic_filter = topic_filter.decode(errors='replace')
+                        self.subscriptions[topic_filter] = qos
+                        granted.append(qos)
+                        filters.append(topic_filter)
+                    self._send(9, 0, struct.pack('!H', packet_id) + bytes(granted))
+                    for topic_filter in filters:
+                        for topic, payload, qos in self.broker.retained_for(topic_filter):
+                            self.send_publish(topic, payload, min(qos, self.subscriptions[topic_filter]), True)
+                elif packet_type == 10:             # UNSUBSCRIBE
+                    (packet_id,) = struct.unpack_from('!H', body, 0)
+                    offset = 2
+                    while offset < len(body):
+                        topic_filter, offset = self._utf8(body, offset)
+                        self.subscriptions.pop(topic_filter.decode(errors='replace'), None)
+                    self._send(11, 0, struct.pack('!H', packet_id))
+                elif packet_type == 12:             # PINGREQ
+                    self._send(13, 0, b'')
+                elif packet_type == 14:             # DISCONNECT
+                    return
+                # PUBACK (4) del cliente: no se reintenta nada, se ignora
+        except (ConnectionError, OSError, struct.error, IndexError):
+            pass
+        finally:
+            self.broker.unregister(self)
+            state.log('MQTT', 'DISCONNECT %s' % self.client_id)
+
+
+class MqttServer(socketserver.ThreadingTCPServer):
+    daemon_threads = True
+    allow_reuse_address = True
+
+
+# ============= HTTP =============
+
+class BackendState:
+    def __init__(self, scenario, quiet):
+        self.lock = threading.Lock()
+        self.stats = Stats()
+        self.quiet = quiet
+        self.sensor_ids = dict(KNOWN_SENSORS)
+        self.next_sensor_id = 100
+        self.sensor_configs = {}            # Serial -> configuración publicada por update-sensor-config
+        self.started_s = int(time.time())   # Last-Modified de los sensores sin cambios
+        self.broker = MqttBroker(self)
+        self.set_scenario(scenario)
+
+    def set_scenario(self, scenario):
+        scenario.listeners.append(self.stats.on_phase_change)
+        scenario.listeners.append(self._on_phase_change)
+        self.scenario = scenario
+        scenario.current()
+
+    def _on_phase_change(self, previous, phase):
+        self.log('FASE', '%s -> %s' % (previous.get('name', '?') if previous else '-', phase.get('name', '?')))
+        if phase.get('mqtt', {}).get('drop_clients'):
+            self.broker.drop_all()
+
+    def sensor_id(self, serial):
+        with self.lock:
+            if serial not in self.sensor_ids:
+                self.sensor_ids[serial] = self.next_sensor_id
+                self.next_sensor_id += 1
+            return self.sensor_ids[serial]
+
+    def sensor_config(self, serial):
+        """Configuración vigente de un sensor y su instante de modificación (s)."""
+        sensor_id = self.sensor_id(serial)
+        with self.lock:
+            stored = self.sensor_configs.get(serial)
+        if stored is not None:
+            return stored
+        return {'serial': serial, 'id_sensor': sensor_id, 'description': 'mock %s' % serial,
+                'interval_s': 5, 'state': True}, self.started_s
+
+    def set_sensor_config(self, serial, config):
+        entry = {'serial': serial, 'id_sensor': config['id_sensor'], 'description': 'mock %s' % serial,
+                 'interval_s': config['interval_seconds'], 'state': config['state'] in ('active', True)}
+        for key in ('max_value', 'min_value'):
+            if isinstance(config.get(key), (int, float)):
+                entry[key] = config[key]
+        with self.lock:
+            self.sensor_configs[serial] = (entry, int(time.time()))
+
+    def log(self, kind, message):
+        if not self.quiet:
+            print('[%8.1f] %-5s %s' % ((now_ms() - self.stats.started_ms) / 1000.0, kind, message), flush=True)
+
+
+class BackendHandler(BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+    server_version = 'ong-mock-backend/1.0'
+
+    def log_message(self, fmt, *args):
+        pass
+
+    def _read_json(self):
+        length = int(self.headers.get('Content-Length') or 0)
+        raw = self.rfile.read(length) if length > 0 else b''
+        encoding = (self.headers.get('Content-Encoding') or '').strip().lower()
+        try:
+            # Cuerpos comprimidos por main/http_compress.c (deflate = flujo zlib)
+            if encoding == 'deflate':
+                data = zlib.decompress(raw)
+            elif encoding == 'gzip':
+                data = zlib.decompress(raw, 16 + zlib.MAX_WBITS)
+            else:
+                data = raw
+            if not self.path.startswith('/__mock/'):
+                self.server.state.stats.body(len(raw), len(data), bool(encoding))
+            return json.loads(data.decode('utf-8')) if data else None
+        except (ValueError, UnicodeDecodeError, zlib.error):
+            return None
+
+    def _build_response(self, status, body):
+        # 304 sin cuerpo; headers extra (ETag, Last-Modified) de la ruta
+        payload = json.dumps(body).encode('utf-8') if status != 304 else b''
+        extra = ''.join('%s: %s\r\n' % item for item in getattr(self, 'response_headers', {}).items())
+        head = ('HTTP/1.1 %d %s\r\nContent-Type: application/json\r\nContent-Length: %d\r\n'
+                '%sConnection: close\r\nServer: %s\r\n\r\n' % (
+                    status, self.responses.get(status, ('',))[0], len(payload), extra, self.server_version))
+        return head.encode('ascii') + payload
+
+    def _sensors_config(self):
+        """GET /sensors/config?serials=a,b: todas las configuraciones, condicional."""
+        state = self.server.state
+        query = parse_qs(self.path.partition('?')[2])
+        serials = [s for s in ','.join(query.get('serials', [])).split(',') if s]
+        if not serials:
+            return 400, {'error': 'Parámetro requerido: serials'}, None
+        entries = [state.sensor_config(serial) for serial in serials]
+        body = {'sensors': [entry for entry, _ in entries]}
+        etag = '"%08x"' % zlib.crc32(json.dumps(body, sort_keys=True).encode('utf-8'))
+        modified_s = max(modified for _, modified in entries)
+        self.response_headers = {'ETag': etag, 'Last-Modified': formatdate(modified_s, usegmt=True)}
+
+        # If-None-Match manda sobre If-Modified-Since (RFC 9110, 13.2.2)
+        if_none_match = self.headers.get('If-None-Match')
+        if if_none_match is not None:
+            if etag in [tag.strip() for tag in if_none_match.split(',')] or if_none_match.strip() == '*':
+                return 304, None, None
+        elif self.headers.get('If-Modified-Since'):
+            try:
+                since_s = parsedate_to_datetime(self.headers['If-Modified-Since']).timestamp()
+            except (TypeError, ValueError):
+                since_s = None
+            if since_s is not None and modified_s <= since_s:
+                return 304, None, None
+        return 200, body, None
+
+    def _reset(self):
+        # SO_LINGER 0: close() envía RST en lugar de FIN
+        self.connection.setsockopt(socket.SOL_SOCKET, socket.SO_LINGER, struct.pack('ii', 1, 0))
+        self.connection.close()
+        self.close_connection = True
+
+    def _dispatch(self, method):
+        state = self.server.state
+        start_ms = now_ms()
+        path = self.path.split('?', 1)[0]
+        body = self._read_json() if method == 'POST' else None
+        self.response_headers = {}
+
+        if path.startswith('/__mock/'):
+            status, response = self._control(path, body)
+            self.wfile.write(self._build_response(status, response))
+            self.close_connection = True
+            return
+
+        api_path = path[len(API_PREFIX):] if path.startswith(API_PREFIX) else path
+        rule = state.scenario.match(method, api_path)
+        action = rule.get('action', 'respond') if rule else 'respond'
+        delay_ms = rule_latency_ms(rule)
+        if delay_ms > 0:
+            time.sleep(delay_ms / 1000.0)
+
+        status, response, device = self._route(method, api_path, body)
+        if rule and 'status' in rule:
+            status, response = rule['status'], {'error': 'Falla inyectada', 'status': rule['status']}
+            self.response_headers = {}
+        if status and 200 <= status < 300 and action != 'reset':
+            key = self.headers.get('Idempotency-Key')
+            if state.stats.upload(key):
+                # Reintento de algo ya guardado: se confirma sin volver a procesarlo
+                status, response = 200, {'success': True, 'duplicate': True}
+            else:
+                state.stats.place(key, body)
+                if api_path == '/process-data' and isinstance(body, dict):
+                    state.stats.readings(len(body.get('readings') or []))
+
+        try:
+            if action == 'reset':
+                self._reset()
+                status = None
+            elif action == 'drip':
+                rate = max(float(rule.get('drip_bytes_per_s', 10)), 1.0)
+                for byte in self._build_response(status, response):
+                    self.wfile.write(bytes([byte]))
+                    time.sleep(1.0 / rate)
+            else:
+                self.wfile.write(self._build_response(status, response))
+        except OSError:
+            status = None                       # El cliente abandonó (timeout)
+        self.close_connection = True
+
+        elapsed_ms = now_ms() - start_ms
+        state.stats.record('%s %s' % (method, self._endpoint_name(api_path)), status, action, elapsed_ms, device)
+        state.log('HTTP', '%s %s -> %s %s(%.0f ms)' % (
+            method, path, status if status else 'RST/abandono',
+            '' if action == 'respond' else '[%s] ' % action, elapsed_ms))
+
+    @staticmethod
+    def _endpoint_name(api_path):
+        if api_path.startswith('/sensors/serial/'):
+            return '/sensors/serial/{serial}'
+        return api_path
+
+    def _route(self, method, api_path, body):
+        """Contrato del backend: (status, cuerpo, dispositivo para recuperación)."""
+        state = self.server.state
+        if method == 'POST' and api_path == '/process-data':
+            # Trama de un ciclo de muestreo: una lectura por sensor con un solo timestamp
+            readings = body.get('readings') if isinstance(body, dict) else None
+            if not isinstance(readings, list) or not readings or not all(
+                    isinstance(r, dict) and 'value' in r and 'id_sensor' in r and 'serial' in r
+                    for r in readings):
+                return 400, {'error': 'Campos requeridos: readings[] con value, id_sensor y serial'}, None
+            return 201, {'success': True, 'readings': len(readings)}, 'sensor:%s' % readings[0]['id_sensor']
+
+        if method == 'POST' and api_path == '/error-logs':
+            if not isinstance(body, dict) or 'error_code' not in body:
+                return 400, {'error': 'Campo requerido: error_code'}, None
+            return 201, {'success': True}, None
+
+        if method == 'GET' and api_path.startswith('/sensors/serial/'):
+            serial = api_path[len('/sensors/serial/'):]
+            if not serial:
+                return 404, {'error': 'Sensor no encontrado'}, None
+            entry, _ = state.sensor_config(serial)
+            return 200, entry, None
+
+        if method == 'GET' and api_path == '/sensors/config':
+            return self._sensors_config()
+
+        if method == 'POST' and self.path.startswith('/api/update-sensor-config'):
+            if not isinstance(body, dict) or not body.get('serial') or not body.get('id_sensor'):
+                return 400, {'error': 'Campos requeridos: serial, id_sensor'}, None
+            config = {
+                'id_sensor': body['id_sensor'],
+                'interval_seconds': body.get('interval_seconds') or 20,
+                'max_value': body.get('max_value'),
+                'min_value': body.get('min_value'),
+                'state': body.get('state') or 'active',
+                'id_user_created': body.get('id_user_created'),
+                'created_at': body.get('created_at'),
+                'id_user_modified': body.get('id_user_modified'),
+                'modified_at': body.get('modified_at'),
+            }
+            if isinstance(body.get('pacing'), dict):
+                # Espaciado de envíos del dispositivo (main/pacing.h), se aplica en caliente
+                config['pacing'] = body['pacing']
+            state.set_sensor_config(body['serial'], config)
+            topic = 'ong/sensor/%s/config' % body['serial']
+            state.broker.publish(topic, json.dumps(config).encode('utf-8'), qos=1)
+            return 200, {'success': True, 'message': 'Configuración actualizada y publicada a MQTT',
+                         'serial': body['serial'], 'topic': topic, 'config': config}, None
+
+        return 404, {'error': 'Ruta no encontrada'}, None
+
+    def _control(self, path, body):
+        state = self.server.state
+        if path == '/__mock/stats':
+            return 200, state.stats.snapshot()
+        if path == '/__mock/reset':
+            state.stats.reset()
+            return 200, {'success': True}
+        if path == '/__mock/scenario':
+            if not isinstance(body, dict):
+                return 400, {'error': 'Escenario inválido'}
+            state.set_scenario(Scenario(body))
+            return 200, {'success': True, 'phases': len(state.scenario.phases)}
+        return 404, {'error': 'Ruta no encontrada'}
+
+    def do_GET(self):
+        self._dispatch('GET')
+
+    def do_POST(self):
+        self._dispatch('POST')
+
+
+class HttpServer(ThreadingHTTPServer):
+    daemon_threads = True
+    allow_reuse_address = True
+    request_queue_size = 1024
+
+
+# ============= NTP =============
+
+NTP_UNIX_EPOCH_DELTA_S = 2208988800
+
+
+def to_ntp(epoch_s):
+    """Segundos Unix a timestamp NTP de 64 bits."""
+    seconds = epoch_s + NTP_UNIX_EPOCH_DELTA_S
+    return (int(seconds) << 32) | int((seconds % 1) * (1 << 32))
+
+
+class NtpHandler(socketserver.BaseRequestHandler):
+    """SNTPv4 mínimo: responde a cada consulta de cliente (modo 3) con la hora de server.clock()."""
+
+    def handle(self):
+        data, sock = self.request
+        if len(data) < 48 or (data[0] & 0x07) != 3:
+            return
+        receive_s = self.server.clock()
+        reply = bytearray(48)
+        reply[0] = (4 << 3) | 4                 # LI 0, versión 4, modo 4 (servidor)
+        reply[1] = 2                            # Estrato
+        reply[2] = data[2]                      # Intervalo de consulta del cliente
+        reply[3] = 0xEC                         # Precisión ~1 µs (2^-20)
+        reply[12:16] = b'LOCL'
+        struct.pack_into('!Q', reply, 16, to_ntp(receive_s))
+        reply[24:32] = data[40:48]              # Originate = transmit del cliente
+        struct.pack_into('!Q', reply, 32, to_ntp(receive_s))
+        struct.pack_into('!Q', reply, 40, to_ntp(self.server.clock()))
+        sock.sendto(bytes(reply), self.client_address)
+        self.server.state.stats.ntp_inc()
+
+
+class NtpServer(socketserver.ThreadingUDPServer):
+    daemon_threads = True
+    allow_reuse_address = True
+
+    def __init__(self, address, offset_ms, drift_ppm):
+        super().__init__(address, NtpHandler)
+        self.offset_s = offset_ms / 1000.0
+        self.drift = drift_ppm / 1e6
+        self.base_s = time.time()
+        self.base_mono_s = time.monotonic()
+
+    def clock(self):
+        """Hora servida: la del sistema con desfase fijo y deriva (para probar la estimación)."""
+        elapsed_s = time.monotonic() - self.base_mono_s
+        return self.base_s + elapsed_s * (1.0 + self.drift) + self.offset_s
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Backend local con inyección de fallas')
+    parser.add_argument('--bind', default='0.0.0.0')
+    parser.add_argument('--http-port', type=int, default=8080)
+    parser.add_argument('--mqtt-port', type=int, default=1883)
+    parser.add_argument('--ntp-port', type=int, help='Servir SNTP por UDP en este puerto (123 para QEMU)')
+    parser.add_argument('--ntp-offset-ms', type=float, default=0.0, help='Desfase de la hora servida')
+    parser.add_argument('--ntp-drift-ppm', type=float, default=0.0, help='Deriva de la hora servida')
+    parser.add_argument('--scenario', help='Escenario de fallas (JSON)')
+    parser.add_argument('--stats-out', help='Escribir las estadísticas al terminar')
+    parser.add_argument('--seed', type=int, help='Semilla para que los sorteos sean reproducibles')
+    parser.add_argument('--quiet', action='store_true', help='No imprimir cada petición')
+    args = parser.parse_args()
+
+    if args.seed is not None:
+        random.seed(args.seed)
+    scenario_data = None
+    if args.scenario:
+        with open(args.scenario, encoding='utf-8') as f:
+            scenario_data = json.load(f)
+
+    state = BackendState(Scenario(scenario_data), args.quiet)
+    http_server = HttpServer((args.bind, args.http_port), BackendHandler)
+    http_server.state = state
+    mqtt_server = MqttServer((args.bind, args.mqtt_port), MqttSession)
+    mqtt_server.state = state
+
+    servers = [http_server, mqtt_server]
+    if args.ntp_port:
+        ntp_server = NtpServer((args.bind, args.ntp_port), args.ntp_offset_ms, args.ntp_drift_ppm)
+        ntp_server.state = state
+        servers.append(ntp_server)
+
+    for server in servers:
+        threading.Thread(target=server.serve_forever, daemon=True).start()
+    print('Backend local: HTTP en %s:%d, MQTT en %s:%d%s' % (
+        args.bind, args.http_port, args.bind, args.mqtt_port,
+        ', NTP en %s:%d' % (args.bind, args.ntp_port) if args.ntp_port else ''), flush=True)
+
+    stop = threading.Event()
+    signal.signal(signal.SIGINT, lambda *_: stop.set())
+    signal.signal(signal.SIGTERM, lambda *_: stop.set())
+    while not stop.wait(1.0):
+        state.scenario.current()            # Avanzar de fase aunque no haya tráfico
+
+    for server in servers:
+        server.shutdown()
+    snapshot = state.stats.snapshot()
+    if args.stats_out:
+        with open(args.stats_out, 'w', encoding='utf-8') as f:
+            json.dump(snapshot, f, indent=2)
+    print(json.dumps(snapshot, indent=2))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -1,6 +1,9 @@
 #include "adc_shared.h"
+#include "hal_adc.h"
+#include "hal_clock.h"
 #include "esp_log.h"
 #include "config.h"
+#include <stdio.h>
 
 static const char *TAG = "ADC_SHARED";
 
@@ -113,4 +116,27 @@ esp_err_t convert_adc_to_voltage(int raw_value, int *out_voltage_mv)
     }
 
     return ESP_OK;
-}
\ No newline at end of file
+}
+// ============= IMPLEMENTACIÓN ESP32 DE hal_adc.h =============
+
+esp_err_t hal_adc_read_raw(int channel, int *out_raw)
+{
+    esp_err_t ret = read_adc_channel((adc_channel_t)channel, out_raw);
+#if ADC_CAPTURE_ENABLED
+    // Volcado de la lectura cruda para reproducirla en el host (ver config.h)
+    if (ret == ESP_OK) {
+        printf("ADC_CAP,%lu,%d,%d\n", (unsigned long)hal_clock_now_ms(), channel, *out_raw);
+    }
+#endif
+    return ret;
+}
+
+esp_err_t hal_adc_raw_to_mv(int raw_value, int *out_voltage_mv)
+{
+    return convert_adc_to_voltage(raw_value, out_voltage_mv);
+}
+
+bool hal_adc_is_ready(void)
+{
+    return g_adc_handle != NULL;
+}
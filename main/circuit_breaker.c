@@ -0,0 +1,235 @@
+#include "circuit_breaker.h"
+#include "config.h"
+#include "metrics.h"
+#include "pacing.h"
+#include "hal_clock.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "BREAKER";
+
+typedef struct {
+    breaker_state_t state;
+    uint32_t consecutive_failures;
+    uint32_t outcomes;          // Bit 0 = última llamada; 1 = lenta o fallida
+    uint32_t outcome_count;     // Llamadas observadas desde el último cierre (tope: ventana)
+    uint32_t opened_at_ms;
+    uint32_t open_ms;           // Tiempo abierto vigente (0 = nunca abrió desde el último cierre)
+    bool probe_in_flight;
+    uint32_t probe_started_ms;
+} breaker_t;
+
+static const char *endpoint_names[BREAKER_ENDPOINT_MAX] = {
+    [BREAKER_ENDPOINT_PROCESS_DATA] = "process-data",
+    [BREAKER_ENDPOINT_ERROR_LOGS] = "error-logs",
+    [BREAKER_ENDPOINT_SENSOR_CONFIG] = "sensor-config",
+};
+
+static const char *state_names[] = {
+    [BREAKER_STATE_CLOSED] = "cerrado",
+    [BREAKER_STATE_OPEN] = "abierto",
+    [BREAKER_STATE_HALF_OPEN] = "medio abierto",
+};
+
+static breaker_t breakers[BREAKER_ENDPOINT_MAX];
+static SemaphoreHandle_t breaker_mutex = NULL;
+
+#define BREAKER_WINDOW_MASK ((1u << BREAKER_WINDOW_CALLS) - 1)
+
+static void breaker_lock(void)
+{
+    if (breaker_mutex != NULL) {
+        xSemaphoreTake(breaker_mutex, portMAX_DELAY);
+    }
+}
+
+static void breaker_unlock(void)
+{
+    if (breaker_mutex != NULL) {
+        xSemaphoreGive(breaker_mutex);
+    }
+}
+
+// Gauge con 2 bits de estado por endpoint (bits 0-1 = process-data, ...)
+static void publish_states_gauge(void)
+{
+    uint32_t packed = 0;
+    for (int i = 0; i < BREAKER_ENDPOINT_MAX; i++) {
+        packed |= (uint32_t)breakers[i].state << (2 * i);
+    }
+    metrics_gauge_set(METRIC_GAUGE_BREAKER_STATES, packed);
+}
+
+// Cambiar de estado, contar la transición y loguearla. Requiere breaker_lock().
+static void transition_locked(breaker_endpoint_t endpoint, breaker_state_t new_state)
+{
+    breaker_t *b = &breakers[endpoint];
+    breaker_state_t old_state = b->state;
+    b->state = new_state;
+    b->probe_in_flight = false;
+
+    switch (new_state) {
+        case BREAKER_STATE_OPEN:
+            b->open_ms = pacing_backoff_after_ms(PACING_CHANNEL_HTTP, b->open_ms);
+            b->opened_at_ms = hal_clock_now_ms();
+            metrics_counter_inc(METRIC_BREAKER_OPENED);
+            ESP_LOGW(TAG, "🔴 Breaker %s: %s -> abierto por %lu ms",
+                     endpoint_names[endpoint], state_names[old_state], (unsigned long)b->open_ms);
+            break;
+        case BREAKER_STATE_HALF_OPEN:
+            metrics_counter_inc(METRIC_BREAKER_HALF_OPENED);
+            ESP_LOGI(TAG, "🟡 Breaker %s: abierto -> medio abierto (petición de prueba)", endpoint_names[endpoint]);
+            break;
+        case BREAKER_STATE_CLOSED:
+            b->consecutive_failures = 0;
+            b->outcomes = 0;
+            b->outcome_count = 0;
+            b->open_ms = 0;
+            metrics_counter_inc(METRIC_BREAKER_CLOSED);
+            ESP_LOGI(TAG, "🟢 Breaker %s: %s -> cerrado", endpoint_names[endpoint], state_names[old_state]);
+            break;
+    }
+    publish_states_gauge();
+}
+
+// Abierto con el tiempo vencido pasa a medio abierto. Requiere breaker_lock().
+static void refresh_locked(breaker_endpoint_t endpoint)
+{
+    breaker_t *b = &breakers[endpoint];
+    if (b->state == BREAKER_STATE_OPEN && hal_clock_elapsed_ms(b->opened_at_ms) >= b->open_ms) {
+        transition_locked(endpoint, BREAKER_STATE_HALF_OPEN);
+    }
+    // Prueba sin resultado (el llamador no registró): liberar el turno
+    if (b->state == BREAKER_STATE_HALF_OPEN && b->probe_in_flight &&
+        hal_clock_elapsed_ms(b->probe_started_ms) > 2 * BREAKER_PROBE_BUDGET_MS + HTTP_TIMEOUT_MS) {
+        b->probe_in_flight = false;
+    }
+}
+
+esp_err_t circuit_breaker_init(void)
+{
+    if (breaker_mutex == NULL) {
+        breaker_mutex = xSemaphoreCreateMutex();
+        if (breaker_mutex == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    breaker_lock();
+    memset(breakers, 0, sizeof(breakers));
+    publish_states_gauge();
+    breaker_unlock();
+    return ESP_OK;
+}
+
+bool circuit_breaker_acquire(breaker_endpoint_t endpoint, uint32_t full_budget_ms, uint32_t *budget_ms)
+{
+    if (endpoint >= BREAKER_ENDPOINT_MAX) {
+        return false;
+    }
+
+    breaker_lock();
+    refresh_locked(endpoint);
+    breaker_t *b = &breakers[endpoint];
+    bool allowed = true;
+    uint32_t budget = full_budget_ms;
+
+    switch (b->state) {
+        case BREAKER_STATE_CLOSED:
+            // Cada fallo seguido reduce a la mitad el tiempo que se le concede al backend
+            for (uint32_t i = 0; i < b->consecutive_failures && budget > BREAKER_MIN_BUDGET_MS; i++) {
+                budget /= 2;
+            }
+            if (budget < BREAKER_MIN_BUDGET_MS) {
+                budget = full_budget_ms < BREAKER_MIN_BUDGET_MS ? full_budget_ms : BREAKER_MIN_BUDGET_MS;
+            }
+            break;
+        case BREAKER_STATE_HALF_OPEN:
+            if (b->probe_in_flight) {
+                allowed = false;
+            } else {
+                b->probe_in_flight = true;
+                b->probe_started_ms = hal_clock_now_ms();
+                budget = full_budget_ms < BREAKER_PROBE_BUDGET_MS ? full_budget_ms : BREAKER_PROBE_BUDGET_MS;
+            }
+            break;
+        case BREAKER_STATE_OPEN:
+            allowed = false;
+            break;
+    }
+    breaker_unlock();
+
+    if (!allowed) {
+        metrics_counter_inc(METRIC_BREAKER_REJECTED);
+        ESP_LOGD(TAG, "Breaker %s rechaza la petición", endpoint_names[endpoint]);
+    } else if (budget_ms != NULL) {
+        *budget_ms = budget;
+    }
+    return allowed;
+}
+
+void circuit_breaker_record(breaker_endpoint_t endpoint, bool success, uint32_t latency_ms)
+{
+    if (endpoint >= BREAKER_ENDPOINT_MAX) {
+        return;
+    }
+
+    bool slow = success && latency_ms > BREAKER_SLOW_CALL_MS;
+    if (slow) {
+        metrics_counter_inc(METRIC_BREAKER_SLOW_CALLS);
+    }
+
+    breaker_lock();
+    breaker_t *b = &breakers[endpoint];
+
+    if (b->state == BREAKER_STATE_HALF_OPEN) {
+        // Solo cuenta la prueba: una respuesta lenta tampoco alcanza para cerrar
+        if (success && !slow) {
+            transition_locked(endpoint, BREAKER_STATE_CLOSED);
+        } else {
+            transition_locked(endpoint, BREAKER_STATE_OPEN);
+        }
+        breaker_unlock();
+        return;
+    }
+    if (b->state == BREAKER_STATE_OPEN) {
+        breaker_unlock();   // Petición autorizada antes de abrir: ya no cambia nada
+        return;
+    }
+
+    b->consecutive_failures = success ? 0 : b->consecutive_failures + 1;
+    b->outcomes = ((b->outcomes << 1) | (success && !slow ? 0u : 1u)) & BREAKER_WINDOW_MASK;
+    if (b->outcome_count < BREAKER_WINDOW_CALLS) {
+        b->outcome_count++;
+    }
+
+    int bad_calls = __builtin_popcount(b->outcomes);
+    if (b->consecutive_failures >= BREAKER_FAILURE_THRESHOLD) {
+        ESP_LOGW(TAG, "Breaker %s: %lu fallos seguidos", endpoint_names[endpoint],
+                 (unsigned long)b->consecutive_failures);
+        transition_locked(endpoint, BREAKER_STATE_OPEN);
+    } else if (b->outcome_count >= BREAKER_WINDOW_CALLS && bad_calls >= BREAKER_WINDOW_TRIP_CALLS) {
+        ESP_LOGW(TAG, "Breaker %s: %d de las últimas %d llamadas lentas o fallidas",
+                 endpoint_names[endpoint], bad_calls, BREAKER_WINDOW_CALLS);
+        transition_locked(endpoint, BREAKER_STATE_OPEN);
+    }
+    breaker_unlock();
+}
+
+breaker_state_t circuit_breaker_state(breaker_endpoint_t endpoint)
+{
+    if (endpoint >= BREAKER_ENDPOINT_MAX) {
+        return BREAKER_STATE_CLOSED;
+    }
+    breaker_lock();
+    refresh_locked(endpoint);
+    breaker_state_t state = breakers[endpoint].state;
+    breaker_unlock();
+    return state;
+}
+
+const char *circuit_breaker_endpoint_name(breaker_endpoint_t endpoint)
+{
+    return endpoint < BREAKER_ENDPOINT_MAX ? endpoint_names[endpoint] : "?";
+}
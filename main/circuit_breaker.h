@@ -0,0 +1,62 @@
+#ifndef CIRCUIT_BREAKER_H
+#define CIRCUIT_BREAKER_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Circuit breaker por endpoint del backend. Cerrado: las peticiones pasan con
+// un presupuesto de tiempo que se achica con cada fallo seguido. Abierto: se
+// rechazan sin tocar la red (el llamador guarda el dato localmente). Medio
+// abierto: pasa una sola petición de prueba con presupuesto corto; si
+// responde a tiempo se cierra, si no vuelve a abrirse por más tiempo.
+// Umbrales en config.h (BREAKER_*); el tiempo abierto usa el canal HTTP de
+// pacing.c (jitter decorrelado).
+
+typedef enum {
+    BREAKER_ENDPOINT_PROCESS_DATA,   // POST /process-data
+    BREAKER_ENDPOINT_ERROR_LOGS,     // POST /error-logs
+    BREAKER_ENDPOINT_SENSOR_CONFIG,  // GET /sensors/config?serials=...
+    BREAKER_ENDPOINT_MAX
+} breaker_endpoint_t;
+
+typedef enum {
+    BREAKER_STATE_CLOSED,
+    BREAKER_STATE_OPEN,
+    BREAKER_STATE_HALF_OPEN,
+} breaker_state_t;
+
+/**
+ * @brief Inicializar los breakers (todos cerrados)
+ */
+esp_err_t circuit_breaker_init(void);
+
+/**
+ * @brief Pedir paso para una petición
+ *
+ * @param endpoint Endpoint de destino
+ * @param full_budget_ms Timeout de la petición con el backend sano
+ * @param[out] budget_ms Timeout a usar en esta petición
+ * @return false si el breaker está abierto (o ya hay una prueba en curso): no llamar a la red
+ */
+bool circuit_breaker_acquire(breaker_endpoint_t endpoint, uint32_t full_budget_ms, uint32_t *budget_ms);
+
+/**
+ * @brief Registrar el resultado de una petición autorizada por circuit_breaker_acquire()
+ *
+ * @param success true si hubo respuesta 2xx
+ * @param latency_ms Duración de la petición
+ */
+void circuit_breaker_record(breaker_endpoint_t endpoint, bool success, uint32_t latency_ms);
+
+/**
+ * @brief Estado actual de un breaker (pasa a medio abierto si venció el tiempo abierto)
+ */
+breaker_state_t circuit_breaker_state(breaker_endpoint_t endpoint);
+
+/**
+ * @brief Nombre corto de un endpoint (para logs)
+ */
+const char *circuit_breaker_endpoint_name(breaker_endpoint_t endpoint);
+
+#endif // CIRCUIT_BREAKER_H
@@ -5,20 +5,61 @@
 
 #define DEFAULT_WIFI_SSID "TeleCentro-5950"
 #define DEFAULT_WIFI_PASS "12345678"
-#define WIFI_MAXIMUM_RETRY 5
+#define WIFI_MAXIMUM_RETRY 5                // Reintentos inmediatos antes del backoff (PACING_WIFI_*)
+#define WIFI_EVENT_QUEUE_SIZE 8             // Eventos WiFi/IP pendientes para la tarea WiFi
+#define WIFI_CONNECT_TIMEOUT_MS 20000       // Intento sin IP ni desconexión: se corta
+#define WIFI_HEARTBEAT_INTERVAL_MS 30000    // Debe ser menor que WATCHDOG_DEADLINE_WIFI_MS
 
+// Backend local de pruebas (host/mock_backend/mock_backend.py, sin TLS):
+//   idf.py -DLOCAL_BACKEND_HOST=10.0.2.2 build   (10.0.2.2 = el host visto desde QEMU)
+// Sin TLS esp_http_client no admite peticiones asíncronas: cada POST/GET bloquea
+// la tarea HTTP hasta HAL_HTTP_PLAIN_TIMEOUT_MS (hal_http_esp.c)
+#ifdef LOCAL_BACKEND_HOST
+#define HTTP_SERVER_URL "http://" LOCAL_BACKEND_HOST ":8080/api/v1/process-data"
+#define HTTP_SERVER_BASE_URL "http://" LOCAL_BACKEND_HOST ":8080/api/v1"
+#define HTTP_CONFIG_URL "http://" LOCAL_BACKEND_HOST ":8080/api/v1/sensors/serial/"
+#else
 #define HTTP_SERVER_URL "https://ong-controller.vercel.app/api/v1/process-data"
 #define HTTP_SERVER_BASE_URL "https://ong-controller.vercel.app/api/v1"
 #define HTTP_CONFIG_URL "https://ong-controller.vercel.app/api/v1/sensors/serial/"
+#endif
+// Configuración de todos los sensores del dispositivo en una sola petición (config_sync.c).
+// Si el backend responde 404 se vuelve a HTTP_CONFIG_URL, un serial por petición.
+#define HTTP_CONFIG_SYNC_URL HTTP_SERVER_BASE_URL "/sensors/config?serials="
 #define HTTP_TIMEOUT_MS 20000
+// Header opcional con el contexto de traza de cada muestra en el POST de datos
+#define HTTP_TRACE_HEADER_ENABLED 1
+#define HTTP_TRACE_HEADER_NAME "X-Sample-Trace"
+// Espera máxima por la cola de sensores con un POST en curso (cada vuelta lo hace avanzar)
+#define HTTP_ASYNC_POLL_MS 20
+#ifdef HOST_DEVICE_IDENTITY
+// Build de host: identidad por instancia para simular una flota (host/main/host_identity.c)
+extern const char *host_device_serial_humidity;
+extern const char *host_device_serial_light;
+extern const char *host_mqtt_client_id;
+extern const char *host_mqtt_topic_config_humidity;
+extern const char *host_mqtt_topic_config_light;
+#define DEVICE_SERIAL_HUMIDITY host_device_serial_humidity
+#define DEVICE_SERIAL_LIGHT host_device_serial_light
+#else
 #define DEVICE_SERIAL_HUMIDITY "0x001C"
 #define DEVICE_SERIAL_LIGHT "0x001D"
+#endif
 
 // ============= CONFIGURACIÓN MQTT =============
-// Broker HiveMQ Cloud con TLS (puerto 8883)
+// Broker HiveMQ Cloud con TLS (puerto 8883), o el broker del backend local
+#ifdef LOCAL_BACKEND_HOST
+#define MQTT_BROKER_URL "mqtt://" LOCAL_BACKEND_HOST
+#define MQTT_BROKER_PORT 1883
+#else
 #define MQTT_BROKER_URL "mqtts://7b0acd8e8fb242379eb6c4983fc30401.s1.eu.hivemq.cloud"
 #define MQTT_BROKER_PORT 8883
+#endif
+#ifdef HOST_DEVICE_IDENTITY
+#define MQTT_CLIENT_ID host_mqtt_client_id
+#else
     #define MQTT_CLIENT_ID "7b0acd8e8fb242379eb6c4983fc30401"
+#endif
 #define MQTT_USERNAME "hivemq.webclient.1762137558937"
 #define MQTT_PASSWORD "0Ql>XrtWH*6wo8k9D$:M"
 #define MQTT_KEEPALIVE 120
@@ -26,22 +67,34 @@
 #define MQTT_RECONNECT_TIMEOUT_MS 5000
 
 // Tópicos MQTT (los placeholders {serial} se reemplazan en tiempo de ejecución)
+#ifdef HOST_DEVICE_IDENTITY
+#define MQTT_TOPIC_CONFIG_HUMIDITY host_mqtt_topic_config_humidity
+#define MQTT_TOPIC_CONFIG_LIGHT host_mqtt_topic_config_light
+#else
 #define MQTT_TOPIC_CONFIG_HUMIDITY "ong/sensor/0x001C/config"
 #define MQTT_TOPIC_CONFIG_LIGHT "ong/sensor/0x001D/config"
+#endif
 #define MQTT_TOPIC_STATUS "ong/sensor/status"
+#define MQTT_TOPIC_METRICS "ong/sensor/metrics"
 
 #define MQTT_MAX_TOPIC_LEN 128
 #define MQTT_MAX_PAYLOAD_LEN 1024
 
+// Trabajo diferido del manejador MQTT (task_mqtt.c): el manejador solo copia
+// el mensaje a un buffer del pool y la tarea worker lo aplica (JSON, NVS, logs)
+#define MQTT_WORKER_POOL_SIZE 3             // Mensajes en espera como máximo
+#define MQTT_WORKER_STACK 4096
+#define MQTT_WORKER_PRIORITY 2
+
 // ============= CONFIGURACIÓN ADC - XIAO ESP32-C3 =============
 // Sensor de Humedad de Suelo - GPIO2 (D0)
-#define SOIL_HUMIDITY_ADC_CHANNEL ADC_CHANNEL_2 // GPIO2 - D0
+#define SOIL_HUMIDITY_ADC_CHANNEL 2 // ADC_CHANNEL_2 - GPIO2 - D0
 #define SOIL_HUMIDITY_GPIO 2
 #define SOIL_HUMIDITY_DRY_VALUE 2800 // Valor ADC cuando está seco (0% humedad)
 #define SOIL_HUMIDITY_WET_VALUE 1200 // Valor ADC cuando está húmedo (100% humedad)
 
 // Sensor de Luz - GPIO3 (D1)
-#define LIGHT_SENSOR_ADC_CHANNEL ADC_CHANNEL_3 // GPIO3 - D1
+#define LIGHT_SENSOR_ADC_CHANNEL 3 // ADC_CHANNEL_3 - GPIO3 - D1
 #define LIGHT_SENSOR_GPIO 3
 #define LIGHT_SENSOR_DARK_VALUE 200    // Valor ADC en oscuridad (0 lux)
 #define LIGHT_SENSOR_BRIGHT_VALUE 3800 // Valor ADC con luz brillante (máximo lux)
@@ -60,8 +113,151 @@
 #define SENSOR_POST_INTERVAL_MS_DEFAULT 5000
 #define WATCHDOG_TIMEOUT_MS 30000
 
+// ============= WATCHDOG DE TAREAS (SUPERVISOR) =============
+// Plazo máximo entre alimentaciones de cada tarea antes de considerarla bloqueada
+#define WATCHDOG_DEADLINE_WIFI_MS 60000
+#define WATCHDOG_DEADLINE_SENSOR_MS 30000          // Lee cada 5 s
+// HTTP: una vuelta del loop dura a lo sumo 1,1 s (cola 1 s + pausa 100 ms) más el
+// inicio de un POST y de un GET de config_sync, que solo bloquean con http://
+// (HAL_HTTP_PLAIN_TIMEOUT_MS, 3 s c/u). La sincronización de config avanza en cada
+// vuelta con su propio plazo (HTTP_TIMEOUT_MS) y la aplica el writer de config_store.
+// El plazo cubre una sincronización entera sin alimentar, con margen ×3: 60 s
+#define WATCHDOG_DEADLINE_HTTP_MS (3 * HTTP_TIMEOUT_MS)
+#define WATCHDOG_DEADLINE_NVS_MS 30000
+#define WATCHDOG_DEADLINE_MQTT_MS 180000           // Loop de heartbeat cada 60 s
+#define WATCHDOG_DEADLINE_ERROR_LOGGER_MS 180000
+// Tiempo extra tras el plazo antes de reiniciar la tarea bloqueada
+#define WATCHDOG_RESTART_GRACE_MS 15000
+// Reinicios de una misma tarea antes de reiniciar el sistema completo
+#define WATCHDOG_MAX_TASK_RESTARTS 3
+// Período de verificación de plazos en el supervisor
+#define WATCHDOG_CHECK_INTERVAL_MS 1000
+
+// ============= ARRANQUE (task_main.c) =============
+// Las etapas arrancan en cuanto terminan sus dependencias: el muestreo no
+// espera a WiFi. Sin respuesta a tiempo, la configuración inicial reinicia
+// el equipo; WiFi y la configuración de sensores siguen con lo que haya.
+#define BOOT_POLL_MS 50                     // Revisión de etapas mientras dura el arranque
+#define BOOT_TIMEOUT_INITIAL_CONFIG_MS 10000
+#define BOOT_TIMEOUT_SENSOR_CONFIG_MS 15000
+#define BOOT_TIMEOUT_WIFI_MS 30000
+
+// ============= MÉTRICAS DE RUNTIME =============
+// Período de publicación del snapshot de métricas por MQTT
+#define METRICS_PUBLISH_INTERVAL_MS 60000
+// Tamaño del buffer estático del snapshot JSON
+#define METRICS_SNAPSHOT_MAX_LEN 3584
+
+// ============= ESPACIADO DE ENVÍOS Y RECONEXIONES (pacing.c) =============
+// Evita que una flota que arranca junta (corte de luz) golpee al backend en fase.
+// Todo se puede cambiar en runtime con el objeto "pacing" del mensaje de config MQTT.
+// 1 = desfasar el primer muestreo/envío un offset fijo por dispositivo (derivado de la MAC)
+#define PACING_PHASE_OFFSET_ENABLED 1
+// Token bucket de peticiones HTTP salientes (datos + logs de error); 0 = sin límite
+#define PACING_RATE_PER_MIN 40
+#define PACING_BURST 8
+// Backoff exponencial con jitter decorrelado: espera = min(tope, azar(base, 3 * anterior))
+// (en HTTP es el tiempo que un circuit breaker queda abierto, ver circuit_breaker.c)
+#define PACING_HTTP_BACKOFF_BASE_MS 5000
+#define PACING_HTTP_BACKOFF_CAP_MS (10 * 60 * 1000)
+#define PACING_WIFI_BACKOFF_BASE_MS 10000
+#define PACING_WIFI_BACKOFF_CAP_MS (5 * 60 * 1000)
+#define PACING_MQTT_BACKOFF_BASE_MS MQTT_RECONNECT_TIMEOUT_MS
+#define PACING_MQTT_BACKOFF_CAP_MS (5 * 60 * 1000)
+
+// ============= CIRCUIT BREAKER POR ENDPOINT (circuit_breaker.c) =============
+// Fallos seguidos (error de red o respuesta no 2xx) que abren el breaker
+#define BREAKER_FAILURE_THRESHOLD 3
+// Una respuesta 2xx más lenta que esto cuenta como llamada lenta
+#define BREAKER_SLOW_CALL_MS 5000
+// Últimas llamadas observadas y cuántas lentas o fallidas entre ellas abren el breaker
+#define BREAKER_WINDOW_CALLS 10
+#define BREAKER_WINDOW_TRIP_CALLS 5
+// Piso del presupuesto por petición (cada fallo seguido lo reduce a la mitad)
+#define BREAKER_MIN_BUDGET_MS 2000
+// Presupuesto de la petición de prueba en medio abierto
+#define BREAKER_PROBE_BUDGET_MS BREAKER_SLOW_CALL_MS
+// Tramas retenidas en RAM mientras el backend no responde (se envían al cerrar el breaker)
+#define HTTP_LOCAL_BUFFER_SIZE 32
+
+// ============= COMPRESIÓN DE CUERPOS HTTP (http_compress.c) =============
+// Content-Encoding de POST /process-data y /error-logs: 0 = sin comprimir, 1 = deflate, 2 = gzip.
+// No hay negociación: un backend que no decodifique el cuerpo responde 4xx a cada POST
+// y las tramas se pierden. Solo el backend local (mock_backend.py) decodifica deflate.
+#ifdef LOCAL_BACKEND_HOST
+#define HTTP_COMPRESS_ENCODING 1
+#else
+#define HTTP_COMPRESS_ENCODING 0
+#endif
+// Cuerpos más chicos que esto salen sin comprimir (no compensa el header ni la CPU)
+#define HTTP_COMPRESS_MIN_BYTES 256
+// Buffer fijo de salida por llamador; si el resultado no entra se envía sin comprimir
+#define HTTP_COMPRESS_BUFFER_SIZE 1536
+// Ventana LZ77 (potencia de 2), bits de la tabla de hash y candidatos revisados por posición.
+// Estado estático: 2 * (ventana + 2^bits) bytes
+#define HTTP_COMPRESS_WINDOW_SIZE 1024
+#define HTTP_COMPRESS_HASH_BITS 10
+#define HTTP_COMPRESS_MAX_CHAIN 8
+
+// ============= SINCRONIZACIÓN DE CONFIGURACIÓN (config_sync.c) =============
+// Respuesta de GET /sensors/config con todos los sensores del dispositivo
+#define CONFIG_SYNC_RESPONSE_MAX_LEN 1024
+// ETag y Last-Modified guardados en NVS para la consulta condicional (304 = sin cambios)
+#define CONFIG_SYNC_TAG_MAX_LEN 64
+// Vigencia de una sincronización (también entre reinicios, con la hora de SNTP)
+#define CONFIG_SYNC_TTL_S (24 * 60 * 60)
+// Sin endpoint por lotes (404, guardado en NVS) se consulta por serial; el
+// endpoint por lotes se vuelve a probar recién pasado este plazo
+#define CONFIG_SYNC_BATCH_RETRY_S (7 * 24 * 60 * 60)
+// Espera entre intentos fallidos
+#define CONFIG_SYNC_RETRY_MS (60 * 1000)
+// Sin hora SNTP no se sabe la antigüedad de la guardada: se revalida pasado este tiempo de arranque
+#define CONFIG_SYNC_UNSYNCED_WAIT_MS (10 * 60 * 1000)
+
+// ============= ALMACÉN DE CONFIGURACIÓN (config_store.c) =============
+// Los cambios que llegan dentro de esta ventana se escriben juntos, con un solo commit
+#define CONFIG_STORE_DEBOUNCE_MS 2000
+// Con cambios llegando sin pausa, demora máxima hasta escribirlos
+#define CONFIG_STORE_MAX_DELAY_MS 10000
+// Tarea escritora: por debajo de las de muestreo y envío. También parsea y aplica
+// las respuestas de config_sync.c (cJSON), de ahí el stack
+#define CONFIG_STORE_WRITER_STACK 4096
+#define CONFIG_STORE_WRITER_PRIORITY 1
+
+// ============= BUS DE CONFIGURACIÓN (config_bus.c) =============
+// Tareas que pueden suscribirse a una misma clave
+#define CONFIG_BUS_MAX_SUBSCRIBERS 4
+
+// ============= SECUENCIAS E IDEMPOTENCIA (sequence.c) =============
+// Números de secuencia reservados por escritura en NVS (un reinicio salta hasta este valor)
+#define SEQUENCE_PERSIST_BLOCK 64
+// Header con la clave de idempotencia de cada POST de datos y de errores
+#define HTTP_IDEMPOTENCY_HEADER_NAME "Idempotency-Key"
+
+// ============= BASE DE TIEMPO (time_service.c) =============
+// Servidor NTP. Con el backend local, el de mock_backend.py (--ntp-port 123:
+// el cliente SNTP de lwIP usa siempre el puerto 123)
+#ifdef LOCAL_BACKEND_HOST
+#define TIME_SNTP_SERVER LOCAL_BACKEND_HOST
+#else
+#define TIME_SNTP_SERVER "pool.ntp.org"
+#endif
+#define TIME_SNTP_INTERVAL_MS (60 * 60 * 1000)
+// Separación mínima entre sincronizaciones para medir la deriva del cristal
+#define TIME_DRIFT_MIN_INTERVAL_MS (10 * 60 * 1000)
+// Deriva máxima creíble del cristal; una medición mayor se descarta como ruido de red
+#define TIME_DRIFT_MAX_PPM 500
+// Corrección a partir de la cual se considera que la hora del servidor saltó
+#define TIME_STEP_THRESHOLD_MS 1000
+
+// ============= CAPTURA DE ADC =============
+// 1 = imprimir cada lectura cruda por consola como "ADC_CAP,<t_ms>,<canal>,<raw>",
+// el formato CSV que reproduce el build de host (HOST_REPLAY_FILE):
+//   grep -a ADC_CAP monitor.log | cut -d, -f2- > traza.csv
+#define ADC_CAPTURE_ENABLED 0
+
 // Colas - UNA SOLA COLA COMPARTIDA PARA AMBOS SENSORES
-#define SENSOR_QUEUE_SIZE 5 // Cola compartida para ambos sensores
+#define SENSOR_QUEUE_SIZE 5 // Cola de tramas (una por ciclo con ambos sensores)
 #define ERROR_QUEUE_SIZE 20 // Cola para supervisor de errores
 
 #endif
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "config_bus.h"
+#include "config.h"
+#include "hal_clock.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+
+static const char *TAG = "CONFIG_BUS";
+
+#define CONFIG_BUS_KEY_MASK ((1u << CONFIG_KEY_MAX) - 1)
+
+_Static_assert((CONFIG_BUS_KEY_MASK & HAL_CLOCK_NOTIFY_RESERVED_BIT) == 0,
+               "Las claves del bus no pueden usar el bit reservado del reloj");
+
+static SemaphoreHandle_t bus_mutex = NULL;
+static uint32_t versions[CONFIG_KEY_MAX];
+static TaskHandle_t subscribers[CONFIG_KEY_MAX][CONFIG_BUS_MAX_SUBSCRIBERS];
+
+static void bus_lock(void)
+{
+    if (bus_mutex != NULL) {
+        xSemaphoreTake(bus_mutex, portMAX_DELAY);
+    }
+}
+
+static void bus_unlock(void)
+{
+    if (bus_mutex != NULL) {
+        xSemaphoreGive(bus_mutex);
+    }
+}
+
+esp_err_t config_bus_init(void)
+{
+    if (bus_mutex == NULL) {
+        bus_mutex = xSemaphoreCreateMutex();
+        if (bus_mutex == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t config_bus_subscribe(config_key_t key)
+{
+    if (key >= CONFIG_KEY_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    esp_err_t result = ESP_ERR_NO_MEM;
+    bus_lock();
+    for (int i = 0; i < CONFIG_BUS_MAX_SUBSCRIBERS; i++) {
+        if (subscribers[key][i] == task) {
+            result = ESP_OK;
+            break;
+        }
+        if (subscribers[key][i] == NULL) {
+            subscribers[key][i] = task;
+            result = ESP_OK;
+            break;
+        }
+    }
+    bus_unlock();
+
+    if (result != ESP_OK) {
+        ESP_LOGE(TAG, "Sin lugar para otro suscriptor de la clave %d", (int)key);
+    }
+    return result;
+}
+
+uint32_t config_bus_publish(config_key_t key)
+{
+    if (key >= CONFIG_KEY_MAX) {
+        return 0;
+    }
+
+    uint32_t version = __atomic_add_fetch(&versions[key], 1, __ATOMIC_RELEASE);
+    bus_lock();
+    for (int i = 0; i < CONFIG_BUS_MAX_SUBSCRIBERS && subscribers[key][i] != NULL; i++) {
+        xTaskNotify(subscribers[key][i], CONFIG_BUS_BIT(key), eSetBits);
+    }
+    bus_unlock();
+    ESP_LOGD(TAG, "Clave %d publicada (v%lu)", (int)key, (unsigned long)version);
+    return version;
+}
+
+uint32_t config_bus_version(config_key_t key)
+{
+    return key < CONFIG_KEY_MAX ? __atomic_load_n(&versions[key], __ATOMIC_ACQUIRE) : 0;
+}
+
+uint32_t config_bus_wait(uint32_t timeout_ms)
+{
+    return hal_clock_wait_notify_ms(timeout_ms) & CONFIG_BUS_KEY_MASK;
+}
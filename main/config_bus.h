@@ -0,0 +1,53 @@
+#ifndef CONFIG_BUS_H
+#define CONFIG_BUS_H
+
+#include "esp_err.h"
+#include <stdint.h>
+
+// Avisos de cambio de configuración: cada clave tiene una versión monotónica
+// que sube con cada publicación, y las tareas suscritas reciben el bit de la
+// clave como notificación de tarea (xTaskNotify, eSetBits). El valor no viaja
+// por el bus: se lee del módulo dueño (p. ej. sensor_config_get_snapshot()).
+
+typedef enum {
+    CONFIG_KEY_SENSOR_HUMIDITY = 0,     // sensor_config_t (task_sensor_config.h)
+    CONFIG_KEY_SENSOR_LIGHT,
+    CONFIG_KEY_PACING,                  // pacing_config_t (pacing.h)
+    CONFIG_KEY_MAX
+} config_key_t;
+
+// Bit de notificación de una clave
+#define CONFIG_BUS_BIT(key) (1u << (key))
+
+/**
+ * @brief Crear el mutex de la tabla de suscriptores
+ */
+esp_err_t config_bus_init(void);
+
+/**
+ * @brief Suscribir la tarea actual a los cambios de una clave
+ *
+ * @return ESP_ERR_NO_MEM si la clave ya tiene CONFIG_BUS_MAX_SUBSCRIBERS
+ */
+esp_err_t config_bus_subscribe(config_key_t key);
+
+/**
+ * @brief Publicar un cambio: subir la versión y notificar a los suscriptores
+ *
+ * @return Versión nueva
+ */
+uint32_t config_bus_publish(config_key_t key);
+
+/**
+ * @brief Versión actual de una clave (0 = nunca publicada)
+ */
+uint32_t config_bus_version(config_key_t key);
+
+/**
+ * @brief Esperar cambios de las claves suscritas, como máximo timeout_ms (hal_clock)
+ *
+ * @return Bits CONFIG_BUS_BIT() de las claves que cambiaron, 0 si no hubo cambios
+ */
+uint32_t config_bus_wait(uint32_t timeout_ms);
+
+#endif // CONFIG_BUS_H
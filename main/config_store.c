@@ -0,0 +1,429 @@
+#include "config_store.h"
+#include "config.h"
+#include "metrics.h"
+#include "task_nvs.h"
+#include "hal_nvs.h"
+#include "hal_clock.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "CONFIG_STORE";
+
+#define CONFIG_STORE_NAMESPACE "sensor_cfg"
+#define CONFIG_STORE_VERSION 1
+
+// Notificaciones a la tarea escritora
+#define WRITER_NOTIFY_DIRTY (1u << 0)   // Hay cambios sin escribir
+#define WRITER_NOTIFY_JOB (1u << 1)     // Hay un trabajo de config_store_defer()
+
+#define BLOB_FLAG_STATE (1u << 0)
+#define BLOB_FLAG_HAS_MAX (1u << 1)
+#define BLOB_FLAG_HAS_MIN (1u << 2)
+
+// Formato en flash: si cambia, subir CONFIG_STORE_VERSION (el blob viejo se descarta)
+typedef struct {
+    uint8_t version;
+    uint8_t flags;                  // BLOB_FLAG_*
+    uint16_t reserved;
+    int32_t id_sensor;
+    int32_t interval_s;
+    float max_value;                // 0 sin límite
+    float min_value;
+    uint32_t crc;                   // CRC-32 de los campos anteriores
+} config_blob_t;
+
+_Static_assert(sizeof(config_blob_t) == 24, "config_blob_t no debe tener relleno");
+
+// Estado por sensor: stored es lo que hay en flash, pending lo que falta escribir
+typedef struct {
+    const char *key;                // Clave NVS (máx. 15 caracteres)
+    const char *legacy_prefix;      // Claves del formato anterior ("hum_id", ...)
+    const char *name;
+    bool stored_valid;
+    bool dirty;
+    bool legacy;                    // Migrado: borrar las claves viejas al escribir
+    config_blob_t stored;
+    config_blob_t pending;
+} store_slot_t;
+
+static SemaphoreHandle_t store_mutex = NULL;
+static TaskHandle_t writer_task = NULL;
+static config_store_job_t deferred_job = NULL;  // Trabajo pendiente para la tarea escritora
+static void *deferred_arg = NULL;
+static hal_nvs_handle_t store_handle;
+static bool store_opened = false;
+static store_slot_t slots[] = {
+    [SENSOR_TYPE_SOIL_HUMIDITY] = {.key = "hum_blob", .legacy_prefix = "hum_", .name = "HUMEDAD"},
+    [SENSOR_TYPE_LIGHT] = {.key = "light_blob", .legacy_prefix = "light_", .name = "LUZ"},
+};
+
+static void store_lock(void)
+{
+    if (store_mutex != NULL) {
+        xSemaphoreTake(store_mutex, portMAX_DELAY);
+    }
+}
+
+static void store_unlock(void)
+{
+    if (store_mutex != NULL) {
+        xSemaphoreGive(store_mutex);
+    }
+}
+
+static store_slot_t *slot_for(sensor_type_t sensor_type)
+{
+    if ((size_t)sensor_type >= sizeof(slots) / sizeof(slots[0])) {
+        return NULL;
+    }
+    return &slots[sensor_type];
+}
+
+static uint32_t blob_crc(const config_blob_t *blob)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)blob, offsetof(config_blob_t, crc));
+}
+
+// Con memset: el blob se compara byte a byte contra el guardado
+static void blob_from_config(const sensor_config_t *config, config_blob_t *blob)
+{
+    memset(blob, 0, sizeof(*blob));
+    blob->version = CONFIG_STORE_VERSION;
+    blob->flags = (config->state ? BLOB_FLAG_STATE : 0) |
+                  (config->has_max_value ? BLOB_FLAG_HAS_MAX : 0) |
+                  (config->has_min_value ? BLOB_FLAG_HAS_MIN : 0);
+    blob->id_sensor = config->id_sensor;
+    blob->interval_s = config->interval_s;
+    blob->max_value = config->has_max_value ? config->max_value : 0.0f;
+    blob->min_value = config->has_min_value ? config->min_value : 0.0f;
+    blob->crc = blob_crc(blob);
+}
+
+static void blob_to_config(const config_blob_t *blob, sensor_config_t *config)
+{
+    config->id_sensor = blob->id_sensor;
+    config->interval_s = blob->interval_s;
+    config->state = (blob->flags & BLOB_FLAG_STATE) != 0;
+    config->has_max_value = (blob->flags & BLOB_FLAG_HAS_MAX) != 0;
+    config->has_min_value = (blob->flags & BLOB_FLAG_HAS_MIN) != 0;
+    config->max_value = blob->max_value;
+    config->min_value = blob->min_value;
+    config->config_loaded = true;
+}
+
+// Abrir el namespace una sola vez. Requiere store_lock().
+static esp_err_t store_open_locked(void)
+{
+    if (store_opened) {
+        return ESP_OK;
+    }
+    esp_err_t err = hal_nvs_open(CONFIG_STORE_NAMESPACE, true, &store_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Error abriendo NVS %s: %s", CONFIG_STORE_NAMESPACE, esp_err_to_name(err));
+        return err;
+    }
+    store_opened = true;
+    return ESP_OK;
+}
+
+// Leer el blob de flash a stored. Requiere store_lock().
+// ESP_ERR_INVALID_CRC si existe pero no es válido (versión, largo o CRC).
+static esp_err_t read_slot_locked(store_slot_t *slot)
+{
+    esp_err_t err = store_open_locked();
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    config_blob_t blob;
+    size_t length = sizeof(blob);
+    err = hal_nvs_get_blob(store_handle, slot->key, &blob, &length);
+    if (err == ESP_ERR_NVS_INVALID_LENGTH ||
+        (err == ESP_OK && (length != sizeof(blob) || blob.version != CONFIG_STORE_VERSION || blob.crc != blob_crc(&blob)))) {
+        ESP_LOGW(TAG, "⚠ Configuración guardada de %s inválida, se descarta", slot->name);
+        return ESP_ERR_INVALID_CRC;
+    }
+    if (err == ESP_OK) {
+        slot->stored = blob;
+        slot->stored_valid = true;
+    }
+    return err;
+}
+
+// Borrar las claves del formato anterior (una por campo). Requiere store_lock().
+static void erase_legacy_locked(const store_slot_t *slot)
+{
+    static const char *const fields[] = {"id", "interval", "state", "max_val", "min_val", "loaded"};
+    char key[16];
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        snprintf(key, sizeof(key), "%s%s", slot->legacy_prefix, fields[i]);
+        hal_nvs_erase_key(store_handle, key);
+    }
+}
+
+static void run_deferred_job(void)
+{
+    store_lock();
+    config_store_job_t job = deferred_job;
+    void *arg = deferred_arg;
+    deferred_job = NULL;
+    store_unlock();
+    if (job != NULL) {
+        job(arg);
+    }
+}
+
+// Tarea escritora: cada cambio nuevo reinicia la ventana de debounce, hasta
+// CONFIG_STORE_MAX_DELAY_MS desde el primero. Un flush fallido se reintenta
+// en la ventana siguiente. Las ventanas se miden con hal_clock (reloj virtual
+// en el host). Un trabajo de config_store_defer() corta la ventana: lo
+// pendiente se escribe antes de correrlo.
+static void config_store_writer(void *args)
+{
+    (void)args;
+    uint32_t bits = 0;
+    while (1) {
+        if (bits == 0) {
+            xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY);
+        }
+        if (bits & WRITER_NOTIFY_JOB) {
+            bits &= ~WRITER_NOTIFY_JOB;
+            run_deferred_job();
+            continue;
+        }
+        if (!(bits & WRITER_NOTIFY_DIRTY)) {
+            bits = 0;
+            continue;
+        }
+        bits = 0;
+        uint32_t first_ms = hal_clock_now_ms();
+        uint32_t last_ms = first_ms;
+        while (hal_clock_elapsed_ms(first_ms) < CONFIG_STORE_MAX_DELAY_MS) {
+            uint32_t quiet_ms = hal_clock_elapsed_ms(last_ms);
+            if (quiet_ms >= CONFIG_STORE_DEBOUNCE_MS) {
+                break;
+            }
+            uint32_t received = hal_clock_wait_notify_ms(CONFIG_STORE_DEBOUNCE_MS - quiet_ms);
+            if (received & WRITER_NOTIFY_JOB) {
+                bits |= WRITER_NOTIFY_JOB;
+                break;
+            }
+            if (received & WRITER_NOTIFY_DIRTY) {
+                last_ms = hal_clock_now_ms();
+            }
+        }
+        if (config_store_flush() != ESP_OK) {
+            xTaskNotify(xTaskGetCurrentTaskHandle(), WRITER_NOTIFY_DIRTY, eSetBits);
+        }
+    }
+}
+
+esp_err_t config_store_init(void)
+{
+    if (store_mutex == NULL) {
+        store_mutex = xSemaphoreCreateMutex();
+        if (store_mutex == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    // Leer ambos blobs ahora: con el handle ya abierto, las cargas y los
+    // guardados posteriores comparan contra RAM sin tocar la flash
+    bool invalid = false;
+    store_lock();
+    esp_err_t err = store_open_locked();
+    for (size_t i = 0; err == ESP_OK && i < sizeof(slots) / sizeof(slots[0]); i++) {
+        if (!slots[i].stored_valid && !slots[i].dirty && read_slot_locked(&slots[i]) == ESP_ERR_INVALID_CRC) {
+            invalid = true;
+        }
+    }
+    store_unlock();
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (invalid) {
+        // Los validadores ya no describen la configuración guardada: la próxima consulta es incondicional
+        nvs_erase_config_validators();
+    }
+
+    if (writer_task == NULL &&
+        xTaskCreate(config_store_writer, "cfg_store", CONFIG_STORE_WRITER_STACK, NULL,
+                    CONFIG_STORE_WRITER_PRIORITY, &writer_task) != pdPASS) {
+        writer_task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t config_store_load(sensor_type_t sensor_type, sensor_config_t *config)
+{
+    store_slot_t *slot = slot_for(sensor_type);
+    if (slot == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    store_lock();
+    esp_err_t err = ESP_OK;
+    if (!slot->stored_valid && !slot->dirty) {
+        err = read_slot_locked(slot);
+    }
+    if (err == ESP_OK) {
+        blob_to_config(slot->dirty ? &slot->pending : &slot->stored, config);
+    }
+    store_unlock();
+
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "✅ Configuración del sensor %s: ID %d, intervalo %d s, %s", slot->name,
+                 config->id_sensor, config->interval_s, config->state ? "activo" : "inactivo");
+        return ESP_OK;
+    }
+    if (err != ESP_ERR_NVS_NOT_FOUND) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+
+    // Sin blob: puede haber configuración en el formato anterior
+    if (nvs_load_sensor_config(sensor_type, config) != ESP_OK) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    ESP_LOGI(TAG, "🔁 Migrando configuración del sensor %s a un solo blob", slot->name);
+    store_lock();
+    slot->legacy = true;
+    store_unlock();
+    config_store_save(sensor_type, config);
+    return ESP_OK;
+}
+
+esp_err_t config_store_save(sensor_type_t sensor_type, const sensor_config_t *config)
+{
+    store_slot_t *slot = slot_for(sensor_type);
+    if (slot == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    config_blob_t blob;
+    blob_from_config(config, &blob);
+
+    store_lock();
+    if (!slot->stored_valid && !slot->dirty) {
+        read_slot_locked(slot);
+    }
+    const config_blob_t *current = slot->dirty ? &slot->pending : (slot->stored_valid ? &slot->stored : NULL);
+    if (current != NULL && memcmp(current, &blob, sizeof(blob)) == 0) {
+        store_unlock();
+        metrics_counter_inc(METRIC_CONFIG_STORE_UNCHANGED);
+        ESP_LOGD(TAG, "Configuración del sensor %s sin cambios, no se escribe", slot->name);
+        return ESP_OK;
+    }
+    if (slot->dirty) {
+        metrics_counter_inc(METRIC_CONFIG_STORE_COALESCED);
+    }
+    slot->pending = blob;
+    // Volver a lo que ya está en flash cancela la escritura pendiente
+    slot->dirty = slot->legacy || !slot->stored_valid || memcmp(&slot->stored, &blob, sizeof(blob)) != 0;
+    TaskHandle_t writer = writer_task;
+    store_unlock();
+
+    if (writer == NULL) {
+        return config_store_flush();
+    }
+    xTaskNotify(writer, WRITER_NOTIFY_DIRTY, eSetBits);
+    return ESP_OK;
+}
+
+esp_err_t config_store_flush(void)
+{
+    esp_err_t result = ESP_OK;
+    bool written[sizeof(slots) / sizeof(slots[0])] = {false};
+    uint32_t written_count = 0;
+
+    store_lock();
+    for (size_t i = 0; i < sizeof(slots) / sizeof(slots[0]); i++) {
+        store_slot_t *slot = &slots[i];
+        if (!slot->dirty) {
+            continue;
+        }
+        esp_err_t err = store_open_locked();
+        if (err == ESP_OK) {
+            err = hal_nvs_set_blob(store_handle, slot->key, &slot->pending, sizeof(slot->pending));
+        }
+        if (err != ESP_OK) {
+            // Queda pendiente para el próximo flush
+            ESP_LOGE(TAG, "Error guardando configuración del sensor %s: %s", slot->name, esp_err_to_name(err));
+            result = err;
+            continue;
+        }
+        written[i] = true;
+        written_count++;
+    }
+
+    // El slot queda escrito recién con el commit: si falla sigue dirty y el
+    // próximo flush lo vuelve a escribir (las claves viejas siguen hasta entonces)
+    if (written_count > 0) {
+        esp_err_t err = hal_nvs_commit(store_handle);
+        if (err == ESP_OK) {
+            bool legacy_erased = false;
+            for (size_t i = 0; i < sizeof(slots) / sizeof(slots[0]); i++) {
+                store_slot_t *slot = &slots[i];
+                if (!written[i]) {
+                    continue;
+                }
+                slot->stored = slot->pending;
+                slot->stored_valid = true;
+                slot->dirty = false;
+                if (slot->legacy) {
+                    erase_legacy_locked(slot);
+                    legacy_erased = true;
+                }
+            }
+            // Sin este commit las claves viejas siguen en flash: legacy se mantiene
+            // y el próximo guardado del sensor las vuelve a borrar
+            if (legacy_erased && hal_nvs_commit(store_handle) == ESP_OK) {
+                for (size_t i = 0; i < sizeof(slots) / sizeof(slots[0]); i++) {
+                    if (written[i]) {
+                        slots[i].legacy = false;
+                    }
+                }
+            }
+            metrics_counter_add(METRIC_CONFIG_STORE_WRITES, written_count);
+            metrics_counter_inc(METRIC_CONFIG_STORE_COMMITS);
+            ESP_LOGI(TAG, "💾 Configuración de %lu sensor(es) guardada en NVS", (unsigned long)written_count);
+        } else {
+            ESP_LOGE(TAG, "Error en commit de configuración: %s", esp_err_to_name(err));
+            result = err;
+        }
+    }
+    store_unlock();
+    return result;
+}
+
+esp_err_t config_store_defer(config_store_job_t job, void *arg)
+{
+    if (job == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    store_lock();
+    TaskHandle_t writer = writer_task;
+    if (writer != NULL && deferred_job != NULL) {
+        store_unlock();
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (writer != NULL) {
+        deferred_job = job;
+        deferred_arg = arg;
+    }
+    store_unlock();
+
+    if (writer == NULL) {
+        job(arg);
+        return ESP_OK;
+    }
+    xTaskNotify(writer, WRITER_NOTIFY_JOB, eSetBits);
+    return ESP_OK;
+}
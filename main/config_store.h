@@ -0,0 +1,63 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include "esp_err.h"
+#include "task_sensor.h"
+#include "task_sensor_config.h"
+
+// Configuración persistente de los sensores: un blob binario por sensor
+// (versión + CRC) en el namespace "sensor_cfg", con el handle abierto una sola
+// vez y una copia en RAM de lo escrito. Guardar algo igual a lo que ya está no
+// toca la flash; los cambios se escriben desde una tarea de baja prioridad
+// tras CONFIG_STORE_DEBOUNCE_MS sin cambios nuevos, todos con un solo commit.
+//
+// La configuración de versiones anteriores (una clave por campo) se lee una
+// vez con nvs_load_sensor_config() y se migra al blob.
+
+/**
+ * @brief Crear el mutex, abrir el namespace y lanzar la tarea escritora
+ *
+ * Sin init (p. ej. en el bench) las escrituras son inmediatas.
+ */
+esp_err_t config_store_init(void);
+
+/**
+ * @brief Leer la configuración guardada de un sensor
+ *
+ * Solo toca los campos persistidos (id, intervalo, estado, límites) y marca
+ * config_loaded. Un blob con versión o CRC inválidos se descarta.
+ *
+ * @return ESP_OK si había configuración, ESP_ERR_NVS_NOT_FOUND si no
+ */
+esp_err_t config_store_load(sensor_type_t sensor_type, sensor_config_t *config);
+
+/**
+ * @brief Guardar la configuración de un sensor (escritura diferida)
+ *
+ * Si no cambió respecto de lo guardado o pendiente no hace nada.
+ *
+ * @return ESP_OK si quedó guardada o pendiente de escribir
+ */
+esp_err_t config_store_save(sensor_type_t sensor_type, const sensor_config_t *config);
+
+// Trabajo para la tarea escritora (config_store_defer)
+typedef void (*config_store_job_t)(void *arg);
+
+/**
+ * @brief Escribir ya los cambios pendientes (un commit para todos)
+ *
+ * Para cuando algo posterior depende de que la configuración esté en flash.
+ */
+esp_err_t config_store_flush(void);
+
+/**
+ * @brief Correr job(arg) en la tarea escritora, de baja prioridad
+ *
+ * Para aplicar configuración que escribe NVS sin frenar a quien la recibió
+ * (config_sync.c). Un trabajo pendiente a la vez; sin init corre en el llamador.
+ *
+ * @return ESP_ERR_INVALID_STATE si ya hay un trabajo pendiente
+ */
+esp_err_t config_store_defer(config_store_job_t job, void *arg);
+
+#endif // CONFIG_STORE_H
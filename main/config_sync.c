@@ -0,0 +1,523 @@
+#include "config_sync.h"
+#include "config.h"
+#include "metrics.h"
+#include "circuit_breaker.h"
+#include "time_service.h"
+#include "task_sensor.h"
+#include "task_sensor_config.h"
+#include "task_nvs.h"
+#include "config_store.h"
+#include "hal_http.h"
+#include "hal_clock.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "cJSON.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "CONFIG_SYNC";
+
+// Validadores de la configuración guardada ("" = consulta incondicional) y
+// vigencia de la última sincronización: epoch guardado en NVS para la primera
+// decisión tras el arranque, reloj monotónico una vez sincronizado en este arranque
+static SemaphoreHandle_t sync_mutex = NULL;
+static char etag[CONFIG_SYNC_TAG_MAX_LEN];
+static char last_modified[CONFIG_SYNC_TAG_MAX_LEN];
+static int32_t synced_at_s = 0;         // Epoch (s) de la última sincronización, 0 = desconocido
+static bool synced_this_boot = false;
+static uint32_t last_sync_ms = 0;       // Última sincronización exitosa (hal_clock)
+static uint32_t last_attempt_ms = 0;    // Último intento, exitoso o no (hal_clock)
+static bool attempted = false;
+
+// Sensores del dispositivo, en el orden de las consultas por serial
+typedef struct {
+    sensor_type_t type;
+    const char *name;
+    const char *registered_key;     // Clave NVS (máx. 15 caracteres)
+} sync_sensor_t;
+
+static const sync_sensor_t sync_sensors[] = {
+    {SENSOR_TYPE_SOIL_HUMIDITY, "Humedad", "hum_reg"},
+    {SENSOR_TYPE_LIGHT, "Luz", "light_reg"},
+};
+
+#define SYNC_SENSOR_COUNT ((int)(sizeof(sync_sensors) / sizeof(sync_sensors[0])))
+#define SYNC_BATCH (-1)                 // Petición por lotes (GET /sensors/config)
+
+// El backend de producción solo tiene GET /sensors/serial/{serial}: si el
+// endpoint por lotes responde 404 se consulta un serial por petición (sin
+// validadores, como antes de la consulta por lotes). El 404 queda en NVS y el
+// endpoint por lotes se vuelve a probar pasado CONFIG_SYNC_BATCH_RETRY_S.
+static bool batch_unsupported = false;
+static int32_t batch_missing_at_s = 0;  // Epoch (s) del 404, 0 = sin hora todavía
+static bool batch_state_dirty = false;  // batch_unsupported sin guardar en NVS
+static int next_serial = -1;            // Próximo serial de una sincronización por serial en curso
+
+// Sincronización en curso: petición, headers y buffers viven hasta que termina
+typedef struct {
+    bool active;
+    bool applying;                      // Respuesta en sync_apply() (tarea escritora de config_store)
+    int status_code;
+    int serial_index;                   // Índice en sync_sensors, o SYNC_BATCH
+    hal_http_async_t handle;
+    hal_http_request_t request;
+    hal_http_header_t headers[2];
+    hal_http_header_capture_t captures[2];
+    char url[256];
+    char new_etag[CONFIG_SYNC_TAG_MAX_LEN];
+    char new_last_modified[CONFIG_SYNC_TAG_MAX_LEN];
+    char *response_buffer;
+    uint32_t start_ms;
+} sync_request_t;
+
+static sync_request_t pending;
+
+static void sync_lock(void)
+{
+    if (sync_mutex != NULL) {
+        xSemaphoreTake(sync_mutex, portMAX_DELAY);
+    }
+}
+
+static void sync_unlock(void)
+{
+    if (sync_mutex != NULL) {
+        xSemaphoreGive(sync_mutex);
+    }
+}
+
+// Aplicar la entrada de un sensor de la respuesta a su copia de trabajo
+static void apply_sensor_entry(const cJSON *entry, sensor_config_t *config, const char *sensor_name)
+{
+    cJSON *id_sensor = cJSON_GetObjectItem(entry, "id_sensor");
+    cJSON *description = cJSON_GetObjectItem(entry, "description");
+    cJSON *interval_s = cJSON_GetObjectItem(entry, "interval_s");
+    cJSON *state = cJSON_GetObjectItem(entry, "state");
+    cJSON *max_value = cJSON_GetObjectItem(entry, "max_value");
+    cJSON *min_value = cJSON_GetObjectItem(entry, "min_value");
+
+    if (id_sensor && cJSON_IsNumber(id_sensor)) {
+        config->id_sensor = id_sensor->valueint;
+    }
+    if (description && cJSON_IsString(description)) {
+        strncpy(config->description, description->valuestring, sizeof(config->description) - 1);
+        config->description[sizeof(config->description) - 1] = '\0';
+    }
+    if (interval_s && cJSON_IsNumber(interval_s) && interval_s->valueint > 0) {
+        config->interval_s = interval_s->valueint;
+    }
+    if (state && cJSON_IsBool(state)) {
+        config->state = cJSON_IsTrue(state);
+    }
+    // Umbrales como en los mensajes MQTT: sin la clave se conserva el actual
+    // (p. ej. fijado por MQTT), null explícito lo quita
+    if (cJSON_IsNumber(max_value)) {
+        config->max_value = (float)max_value->valuedouble;
+        config->has_max_value = true;
+    } else if (cJSON_IsNull(max_value)) {
+        config->has_max_value = false;
+    }
+    if (cJSON_IsNumber(min_value)) {
+        config->min_value = (float)min_value->valuedouble;
+        config->has_min_value = true;
+    } else if (cJSON_IsNull(min_value)) {
+        config->has_min_value = false;
+    }
+    config->config_loaded = true;
+
+    ESP_LOGI(TAG, "✅ %s: id=%d, intervalo=%d s, %s", sensor_name, config->id_sensor, config->interval_s,
+             config->state ? "activo" : "inactivo");
+}
+
+// Serial de un sensor (con HOST_DEVICE_IDENTITY se resuelve en tiempo de ejecución)
+static const char *sync_serial(const sync_sensor_t *sensor)
+{
+    return sensor->type == SENSOR_TYPE_LIGHT ? DEVICE_SERIAL_LIGHT : DEVICE_SERIAL_HUMIDITY;
+}
+
+// Publicar la entrada de un sensor y dejarla pendiente de guardar (config_store)
+static esp_err_t store_sensor_entry(const sync_sensor_t *sensor, const cJSON *entry)
+{
+    sensor_config_t *config = sensor_config_begin_update(sensor->type);
+    apply_sensor_entry(entry, config, sensor->name);
+    esp_err_t err = config_store_save(sensor->type, config);
+    sensor_config_end_update(sensor->type);
+    return err;
+}
+
+// Respuesta 200 por lotes: {"sensors": [{"serial": ..., "id_sensor": ..., ...}, ...]}.
+// Devuelve ESP_OK si la configuración quedó aplicada y guardada en NVS.
+static esp_err_t apply_response(const char *response)
+{
+    cJSON *json = cJSON_Parse(response);
+    cJSON *sensors = json ? cJSON_GetObjectItem(json, "sensors") : NULL;
+    if (sensors == NULL || !cJSON_IsArray(sensors)) {
+        ESP_LOGE(TAG, "Respuesta de configuración inválida");
+        cJSON_Delete(json);
+        return ESP_FAIL;
+    }
+
+    // La configuración de NVS deja de corresponder a los validadores guardados
+    // hasta terminar de escribirla: si se corta a mitad, la próxima consulta es incondicional
+    nvs_erase_config_validators();
+
+    esp_err_t result = ESP_OK;
+    for (int i = 0; i < SYNC_SENSOR_COUNT; i++) {
+        const sync_sensor_t *sensor = &sync_sensors[i];
+        const cJSON *entry = NULL;
+        const cJSON *item;
+        cJSON_ArrayForEach(item, sensors) {
+            cJSON *serial = cJSON_GetObjectItem(item, "serial");
+            if (serial && cJSON_IsString(serial) && strcmp(serial->valuestring, sync_serial(sensor)) == 0) {
+                entry = item;
+                break;
+            }
+        }
+
+        // Resultado de la validación del serial: vale hasta que el backend cambie la respuesta
+        nvs_save_registered_flag(sensor->registered_key, entry != NULL);
+        if (entry == NULL) {
+            // Serial desconocido para el backend: se sigue con la configuración actual
+            ESP_LOGW(TAG, "⚠ %s [%s] sin configuración en el backend", sensor->name, sync_serial(sensor));
+            continue;
+        }
+        if (store_sensor_entry(sensor, entry) != ESP_OK) {
+            result = ESP_FAIL;
+        }
+    }
+
+    // Los validadores se guardan después: la configuración tiene que estar ya en flash
+    if (config_store_flush() != ESP_OK) {
+        result = ESP_FAIL;
+    }
+
+    cJSON_Delete(json);
+    return result;
+}
+
+// Respuesta de GET /sensors/serial/{serial}: el objeto del sensor, o 404 si el
+// backend no lo conoce (se sigue con la configuración actual)
+static esp_err_t apply_serial_response(const sync_sensor_t *sensor, int status_code, const char *response)
+{
+    nvs_save_registered_flag(sensor->registered_key, status_code != 404);
+    if (status_code == 404) {
+        ESP_LOGW(TAG, "⚠ %s [%s] sin configuración en el backend", sensor->name, sync_serial(sensor));
+        return ESP_OK;
+    }
+
+    cJSON *json = cJSON_Parse(response);
+    if (!cJSON_IsObject(json)) {
+        ESP_LOGE(TAG, "Respuesta de configuración de %s inválida", sensor->name);
+        cJSON_Delete(json);
+        return ESP_FAIL;
+    }
+    esp_err_t result = store_sensor_entry(sensor, json);
+    if (config_store_flush() != ESP_OK) {
+        result = ESP_FAIL;
+    }
+    cJSON_Delete(json);
+    return result;
+}
+
+// Reservar el breaker y armar en pending la petición por lotes (condicional)
+// o la de un serial. Requiere sync_lock().
+static esp_err_t sync_prepare_locked(int serial_index)
+{
+    // También cuenta como intento con el breaker abierto: se vuelve a probar en CONFIG_SYNC_RETRY_MS
+    attempted = true;
+    last_attempt_ms = hal_clock_now_ms();
+
+    uint32_t budget_ms;
+    if (!circuit_breaker_acquire(BREAKER_ENDPOINT_SENSOR_CONFIG, HTTP_TIMEOUT_MS, &budget_ms)) {
+        ESP_LOGW(TAG, "⛔ Breaker de sensor-config abierto, se sigue con la configuración actual");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    pending.response_buffer = malloc(CONFIG_SYNC_RESPONSE_MAX_LEN);
+    if (pending.response_buffer == NULL) {
+        ESP_LOGE(TAG, "Error asignando memoria para respuesta");
+        circuit_breaker_record(BREAKER_ENDPOINT_SENSOR_CONFIG, true, 0);   // Falla local, no del backend
+        return ESP_ERR_NO_MEM;
+    }
+
+    pending.serial_index = serial_index;
+    size_t header_count = 0;
+    if (serial_index == SYNC_BATCH) {
+        snprintf(pending.url, sizeof(pending.url), "%s%s,%s", HTTP_CONFIG_SYNC_URL, DEVICE_SERIAL_HUMIDITY, DEVICE_SERIAL_LIGHT);
+        if (etag[0] != '\0') {
+            pending.headers[header_count++] = (hal_http_header_t){"If-None-Match", etag};
+        }
+        if (last_modified[0] != '\0') {
+            pending.headers[header_count++] = (hal_http_header_t){"If-Modified-Since", last_modified};
+        }
+    } else {
+        snprintf(pending.url, sizeof(pending.url), "%s%s", HTTP_CONFIG_URL, sync_serial(&sync_sensors[serial_index]));
+    }
+    pending.captures[0] = (hal_http_header_capture_t){"ETag", pending.new_etag, sizeof(pending.new_etag)};
+    pending.captures[1] = (hal_http_header_capture_t){"Last-Modified", pending.new_last_modified,
+                                                      sizeof(pending.new_last_modified)};
+
+    pending.request = (hal_http_request_t){
+        .url = pending.url,
+        .method = HAL_HTTP_METHOD_GET,
+        .headers = pending.headers,
+        .header_count = header_count,
+        .timeout_ms = (int)budget_ms,
+        .response_buf = pending.response_buffer,
+        .response_buf_size = CONFIG_SYNC_RESPONSE_MAX_LEN,
+        .captures = pending.captures,
+        .capture_count = serial_index == SYNC_BATCH ? sizeof(pending.captures) / sizeof(pending.captures[0]) : 0,
+    };
+
+    ESP_LOGI(TAG, "🔄 Consultando configuración: %s%s", pending.url, header_count > 0 ? " (condicional)" : "");
+    pending.start_ms = hal_clock_now_ms();
+    return ESP_OK;
+}
+
+// Registrar que la configuración local está al día con el backend. Requiere sync_lock().
+// Devuelve true si hay que guardar synced_at_s en NVS (fuera del lock).
+static bool mark_synced_locked(void)
+{
+    synced_this_boot = true;
+    last_sync_ms = hal_clock_now_ms();
+    if (!time_service_is_synced()) {
+        return false;
+    }
+    synced_at_s = (int32_t)(time_service_now_epoch_ms() / 1000);
+    return true;
+}
+
+// Aplicar la respuesta de pending. Corre en la tarea escritora de config_store
+// (config_store_defer): el parseo y las escrituras en NVS no frenan el loop de
+// la tarea HTTP. Mientras tanto pending.applying impide otra consulta.
+static void sync_apply(void *arg)
+{
+    (void)arg;
+    int status_code = pending.status_code;
+    bool batch = pending.serial_index == SYNC_BATCH;
+    bool validators_saved = false;
+    esp_err_t err = ESP_OK;
+    if (!batch) {
+        err = apply_serial_response(&sync_sensors[pending.serial_index], status_code, pending.response_buffer);
+    } else if (status_code != 304) {
+        err = apply_response(pending.response_buffer);
+        // Los validadores se guardan recién con la configuración ya escrita
+        validators_saved = err == ESP_OK &&
+                           (pending.new_etag[0] != '\0' || pending.new_last_modified[0] != '\0') &&
+                           nvs_save_config_validators(pending.new_etag, pending.new_last_modified) == ESP_OK;
+    }
+    free(pending.response_buffer);
+    pending.response_buffer = NULL;
+
+    sync_lock();
+    if (batch && status_code != 304) {
+        // Sin validadores guardados la próxima consulta es incondicional
+        strcpy(etag, validators_saved ? pending.new_etag : "");
+        strcpy(last_modified, validators_saved ? pending.new_last_modified : "");
+    }
+    bool done = false;
+    if (err != ESP_OK) {
+        next_serial = -1;       // El próximo intento empieza la sincronización de nuevo
+    } else if (batch) {
+        done = true;
+    } else {
+        next_serial = pending.serial_index + 1 < SYNC_SENSOR_COUNT ? pending.serial_index + 1 : -1;
+        done = next_serial < 0;
+    }
+    bool save_time = done && mark_synced_locked();
+    int32_t epoch_s = synced_at_s;
+
+    // Estado del endpoint por lotes: se guarda con la hora del 404 (si no la
+    // había, la de esta sincronización) o en 0 si el endpoint volvió a responder
+    if (batch && err == ESP_OK && batch_unsupported) {
+        batch_unsupported = false;
+        batch_missing_at_s = 0;
+        batch_state_dirty = true;
+    } else if (done && batch_unsupported && batch_missing_at_s == 0 && time_service_is_synced()) {
+        batch_missing_at_s = (int32_t)(time_service_now_epoch_ms() / 1000);
+    }
+    bool save_batch = batch_state_dirty && (!batch_unsupported || batch_missing_at_s != 0);
+    int32_t batch_epoch_s = batch_missing_at_s;
+    if (save_batch) {
+        batch_state_dirty = false;
+    }
+    pending.applying = false;
+    sync_unlock();
+
+    if (save_time) {
+        nvs_save_config_sync_time(epoch_s);
+    }
+    if (save_batch) {
+        nvs_save_config_batch_missing(batch_epoch_s);
+    }
+}
+
+// Resultado de la petición de pending en la tarea HTTP: breaker y métricas.
+// Devuelve true si hay una respuesta para sync_apply(). Requiere sync_lock().
+static bool sync_finish_locked(esp_err_t err, const hal_http_response_t *response)
+{
+    // Un 4xx (serial o endpoint desconocido) es una respuesta válida: solo 5xx o red cuentan en contra
+    uint32_t get_ms = hal_clock_elapsed_ms(pending.start_ms);
+    circuit_breaker_record(BREAKER_ENDPOINT_SENSOR_CONFIG, err == ESP_OK && response->status_code < 500, get_ms);
+    metrics_counter_add(METRIC_HTTP_INFLIGHT_MS, get_ms);
+
+    bool batch = pending.serial_index == SYNC_BATCH;
+    bool success = err == ESP_OK && response->status_code >= 200 && response->status_code < 300;
+    bool apply = false;
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "❌ Error consultando configuración: %s", esp_err_to_name(err));
+        next_serial = -1;       // El próximo intento empieza la sincronización de nuevo
+    } else if (batch && response->status_code == 404) {
+        // Sin endpoint por lotes: se sigue por serial ya mismo, sin esperar CONFIG_SYNC_RETRY_MS
+        ESP_LOGW(TAG, "⚠ El backend no tiene /sensors/config, se consulta por serial");
+        batch_unsupported = true;
+        batch_missing_at_s = time_service_is_synced() ? (int32_t)(time_service_now_epoch_ms() / 1000) : 0;
+        batch_state_dirty = true;   // Se guarda en sync_apply(), fuera de la tarea HTTP
+        next_serial = 0;
+    } else if (batch && response->status_code == 304) {
+        metrics_counter_inc(METRIC_CONFIG_SYNC_NOT_MODIFIED);
+        ESP_LOGI(TAG, "✅ Configuración sin cambios (HTTP 304, %lu ms)", (unsigned long)get_ms);
+        apply = true;
+    } else if (success || (!batch && response->status_code == 404)) {
+        if (success) {
+            metrics_counter_inc(METRIC_CONFIG_SYNC_UPDATED);
+        }
+        ESP_LOGI(TAG, "📥 Configuración recibida (HTTP %d, %u bytes, %lu ms)", response->status_code,
+                 (unsigned)response->response_len, (unsigned long)get_ms);
+        apply = true;
+    } else {
+        ESP_LOGW(TAG, "⚠ Configuración no disponible (HTTP %d)", response->status_code);
+        next_serial = -1;
+    }
+
+    if (apply) {
+        // El buffer pasa a sync_apply(), que lo libera
+        pending.status_code = response->status_code;
+        pending.applying = true;
+        return true;
+    }
+    free(pending.response_buffer);
+    pending.response_buffer = NULL;
+    return false;
+}
+
+// Sin sincronizar en este arranque, la última vale según su epoch guardado
+// (sync_at), con o sin validadores.
+// Requiere sync_lock().
+static bool sync_due_locked(void)
+{
+    if (pending.active || pending.applying) {
+        return false;
+    }
+    if (attempted && hal_clock_elapsed_ms(last_attempt_ms) < CONFIG_SYNC_RETRY_MS) {
+        return false;
+    }
+    if (synced_this_boot) {
+        return hal_clock_elapsed_ms(last_sync_ms) >= (uint32_t)CONFIG_SYNC_TTL_S * 1000;
+    }
+    // Sin validadores la consulta sale sin headers condicionales, pero el plazo
+    // es el mismo: la consulta por serial (producción) nunca guarda validadores
+    if (synced_at_s == 0) {
+        return true;    // Nunca sincronizada (o configuración reescrita a medias)
+    }
+    if (time_service_is_synced()) {
+        int64_t age_s = time_service_now_epoch_ms() / 1000 - synced_at_s;
+        return age_s < 0 || age_s >= CONFIG_SYNC_TTL_S;
+    }
+    // Sin hora no se puede medir la antigüedad: se espera a SNTP un tiempo acotado
+    return hal_clock_now_ms() >= CONFIG_SYNC_UNSYNCED_WAIT_MS;
+}
+
+// Con el 404 del endpoint por lotes guardado, solo se lo vuelve a probar
+// pasado CONFIG_SYNC_BATCH_RETRY_S desde entonces. Requiere sync_lock().
+static bool sync_batch_allowed_locked(void)
+{
+    if (!batch_unsupported) {
+        return true;
+    }
+    if (batch_missing_at_s == 0 || !time_service_is_synced()) {
+        return false;   // Sin hora no se puede medir la antigüedad del 404
+    }
+    int64_t age_s = time_service_now_epoch_ms() / 1000 - batch_missing_at_s;
+    return age_s < 0 || age_s >= CONFIG_SYNC_BATCH_RETRY_S;
+}
+
+esp_err_t config_sync_init(void)
+{
+    if (sync_mutex == NULL) {
+        sync_mutex = xSemaphoreCreateMutex();
+        if (sync_mutex == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    sync_lock();
+    // Los validadores solo los da la consulta por lotes: la hora de la última
+    // sincronización y los seriales registrados valen también sin ellos
+    nvs_load_config_validators(etag, sizeof(etag), last_modified, sizeof(last_modified));
+    if (nvs_load_config_sync_time(&synced_at_s) != ESP_OK) {
+        synced_at_s = 0;
+    }
+    ESP_LOGI(TAG, "🏷 Configuración guardada: ETag %s, Last-Modified %s, sincronizada en %ld",
+             etag[0] ? etag : "-", last_modified[0] ? last_modified : "-", (long)synced_at_s);
+    int32_t missing_at_s = 0;
+    if (nvs_load_config_batch_missing(&missing_at_s) == ESP_OK && missing_at_s != 0) {
+        batch_unsupported = true;
+        batch_missing_at_s = missing_at_s;
+        ESP_LOGI(TAG, "🏷 Sin endpoint por lotes desde %ld: consulta por serial", (long)missing_at_s);
+    }
+
+    // Validación de seriales de la última respuesta: no hace falta repetirla para saberla
+    for (int i = 0; i < SYNC_SENSOR_COUNT; i++) {
+        bool registered = false;
+        if (nvs_get_registered_flag(sync_sensors[i].registered_key, &registered) == ESP_OK && !registered) {
+            ESP_LOGW(TAG, "⚠ %s [%s] no registrado en el backend (última validación)", sync_sensors[i].name,
+                     sync_serial(&sync_sensors[i]));
+        }
+    }
+    sync_unlock();
+    return ESP_OK;
+}
+
+void config_sync_service(bool can_start)
+{
+    bool apply = false;
+    sync_lock();
+    if (pending.applying) {
+        // Respuesta anterior todavía en la tarea escritora
+    } else if (!pending.active) {
+        // Una sincronización por serial en curso sigue con el próximo sin esperar
+        bool continuing = next_serial >= 0;
+        if (can_start && (continuing || sync_due_locked())) {
+            int serial_index = continuing ? next_serial : (sync_batch_allowed_locked() ? SYNC_BATCH : 0);
+            if (sync_prepare_locked(serial_index) != ESP_OK) {
+                next_serial = -1;   // Breaker abierto o sin memoria: se reintenta en CONFIG_SYNC_RETRY_MS
+            } else if (hal_http_start(&pending.request, &pending.handle) == ESP_OK) {
+                pending.active = true;
+            } else {
+                sync_finish_locked(ESP_FAIL, &(hal_http_response_t){0});
+            }
+        }
+    } else {
+        esp_err_t err;
+        hal_http_response_t response = {0};
+        if (hal_http_poll(pending.handle, &err, &response)) {
+            pending.active = false;
+            pending.handle = NULL;
+            apply = sync_finish_locked(err, &response);
+        }
+    }
+    sync_unlock();
+
+    // Fuera del lock: sin tarea escritora (p. ej. en el bench) corre aquí mismo
+    if (apply && config_store_defer(sync_apply, NULL) != ESP_OK) {
+        sync_apply(NULL);
+    }
+}
+
+bool config_sync_in_progress(void)
+{
+    return pending.active;
+}
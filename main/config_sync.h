@@ -0,0 +1,48 @@
+#ifndef CONFIG_SYNC_H
+#define CONFIG_SYNC_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+
+// Sincronización de la configuración de los sensores con el backend: un solo
+// GET /sensors/config?serials=<humedad>,<luz> para todos los sensores del
+// dispositivo, condicional con el ETag / Last-Modified de la última respuesta
+// (guardados en NVS junto con la configuración). Sin cambios el backend
+// responde 304 sin cuerpo: no se parsea nada ni se escribe NVS.
+//
+// Si el backend no tiene el endpoint por lotes (404, como el de producción)
+// se consulta GET /sensors/serial/{serial} uno por uno, sin validadores;
+// config_store no escribe lo que no cambió. El 404 se guarda en NVS: los
+// arranques siguientes van directo por serial y el endpoint por lotes se
+// vuelve a probar pasado CONFIG_SYNC_BATCH_RETRY_S.
+//
+// El resultado vale CONFIG_SYNC_TTL_S: tras un reinicio dentro de ese plazo
+// (medido con la hora guardada en NVS) no se consulta. La revalidación corre
+// sin bloquear desde la tarea HTTP (config_sync_service) y nunca delante de
+// los datos: hasta que responde se usa la configuración de NVS. Lo que
+// escribe NVS corre en la tarea escritora de config_store.
+
+/**
+ * @brief Crear el mutex y leer de NVS los validadores de la última configuración
+ */
+esp_err_t config_sync_init(void);
+
+/**
+ * @brief Revalidar sin bloquear si venció la última sincronización
+ *
+ * Llamar periódicamente: inicia la consulta cuando corresponde y después la
+ * hace avanzar en cada llamada (hal_http_start/poll). La respuesta (parseo,
+ * configuración, NVS y validadores) se aplica en la tarea escritora de
+ * config_store; la configuración nueva llega por sensor_config_end_update().
+ * Tras una falla espera CONFIG_SYNC_RETRY_MS antes de reintentar.
+ *
+ * @param can_start false para solo avanzar una consulta en curso (p. ej. con otra petición activa)
+ */
+void config_sync_service(bool can_start);
+
+/**
+ * @brief true mientras haya una consulta de config_sync_service() en curso
+ */
+bool config_sync_in_progress(void);
+
+#endif // CONFIG_SYNC_H
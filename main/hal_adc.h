@@ -0,0 +1,33 @@
+#ifndef HAL_ADC_H
+#define HAL_ADC_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+
+// Capa de abstracción del ADC de sensores: en el firmware usa el ADC
+// oneshot compartido (adc_shared.c), en el build de host un mock
+
+/**
+ * @brief Leer valor crudo (0-4095) de un canal ADC
+ *
+ * @param channel Número de canal (ver SOIL_HUMIDITY_ADC_CHANNEL / LIGHT_SENSOR_ADC_CHANNEL)
+ * @param out_raw Puntero donde almacenar el valor crudo
+ * @return ESP_OK si la lectura fue exitosa
+ */
+esp_err_t hal_adc_read_raw(int channel, int *out_raw);
+
+/**
+ * @brief Convertir valor crudo a voltaje en mV usando la calibración disponible
+ *
+ * @param raw_value Valor crudo ADC
+ * @param out_voltage_mv Puntero donde almacenar el voltaje en mV
+ * @return ESP_OK si la conversión fue exitosa
+ */
+esp_err_t hal_adc_raw_to_mv(int raw_value, int *out_voltage_mv);
+
+/**
+ * @brief Indica si el ADC está inicializado y listo para leer
+ */
+bool hal_adc_is_ready(void);
+
+#endif // HAL_ADC_H
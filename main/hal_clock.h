@@ -0,0 +1,53 @@
+#ifndef HAL_CLOCK_H
+#define HAL_CLOCK_H
+
+#include <stdint.h>
+
+// Servicio de reloj: toda medición de tiempo y espera periódica de la
+// aplicación pasa por aquí. En el firmware es esp_timer + vTaskDelay; en el
+// build de host puede ser un reloj virtual que avanza al instante hasta la
+// próxima espera, para simular días de operación en segundos.
+//
+// hal_clock_now_ms() da la vuelta cada ~49,7 días: los intervalos se miden
+// siempre con resta sin signo (hal_clock_elapsed_ms), nunca comparando instantes.
+
+/**
+ * @brief Tiempo monotónico en microsegundos desde el arranque
+ */
+int64_t hal_clock_now_us(void);
+
+/**
+ * @brief Bloquear la tarea actual durante ms milisegundos del reloj
+ */
+void hal_clock_delay_ms(uint32_t ms);
+
+// Bit de notificación de tarea reservado para el reloj (hal_clock_wait_notify_ms)
+#define HAL_CLOCK_NOTIFY_RESERVED_BIT (1u << 31)
+
+/**
+ * @brief Bloquear hasta ms milisegundos del reloj o hasta una notificación de tarea
+ *
+ * Consume las notificaciones pendientes (xTaskNotify con eSetBits). Puede
+ * volver antes sin bits: quien espera un plazo lo vuelve a medir.
+ *
+ * @return Bits recibidos, 0 si venció el plazo
+ */
+uint32_t hal_clock_wait_notify_ms(uint32_t ms);
+
+/**
+ * @brief Tiempo monotónico en milisegundos desde el arranque (32 bits, con vuelta)
+ */
+static inline uint32_t hal_clock_now_ms(void)
+{
+    return (uint32_t)(hal_clock_now_us() / 1000);
+}
+
+/**
+ * @brief Milisegundos transcurridos desde un instante de hal_clock_now_ms()
+ */
+static inline uint32_t hal_clock_elapsed_ms(uint32_t since_ms)
+{
+    return hal_clock_now_ms() - since_ms;
+}
+
+#endif // HAL_CLOCK_H
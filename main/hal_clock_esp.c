@@ -0,0 +1,24 @@
+#include "hal_clock.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+// Implementación ESP32 de hal_clock.h
+int64_t hal_clock_now_us(void)
+{
+    return esp_timer_get_time();
+}
+
+void hal_clock_delay_ms(uint32_t ms)
+{
+    vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+uint32_t hal_clock_wait_notify_ms(uint32_t ms)
+{
+    uint32_t bits = 0;
+    if (xTaskNotifyWait(0, UINT32_MAX, &bits, pdMS_TO_TICKS(ms)) != pdTRUE) {
+        return 0;
+    }
+    return bits & ~HAL_CLOCK_NOTIFY_RESERVED_BIT;
+}
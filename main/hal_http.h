@@ -0,0 +1,125 @@
+#ifndef HAL_HTTP_H
+#define HAL_HTTP_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+
+// Capa de abstracción HTTP: el firmware la implementa con esp_http_client
+// (hal_http_esp.c) y el build de host con un mock (host/main/mock_hal_http.c)
+
+typedef enum {
+    HAL_HTTP_METHOD_GET,
+    HAL_HTTP_METHOD_POST
+} hal_http_method_t;
+
+// Header adicional de la petición
+typedef struct {
+    const char *key;
+    const char *value;
+} hal_http_header_t;
+
+// Header de la respuesta a capturar: value queda "" si no vino (o no entra)
+typedef struct {
+    const char *key;                    // Sin distinguir mayúsculas
+    char *value;
+    size_t value_size;
+} hal_http_header_capture_t;
+
+// Petición HTTP completa
+typedef struct {
+    const char *url;
+    hal_http_method_t method;
+    const hal_http_header_t *headers;   // Opcional
+    size_t header_count;
+    const char *body;                   // Opcional (POST)
+    size_t body_len;
+    int timeout_ms;
+    char *response_buf;                 // Opcional: cuerpo de la respuesta (terminado en '\0')
+    size_t response_buf_size;
+    int64_t *sent_us;                   // Opcional: instante (hal_clock) en que se enviaron los headers
+    hal_http_header_capture_t *captures;    // Opcional: headers de la respuesta a copiar
+    size_t capture_count;
+} hal_http_request_t;
+
+// Resultado de la petición
+typedef struct {
+    int status_code;
+    size_t response_len;
+} hal_http_response_t;
+
+/**
+ * @brief Ejecutar una petición HTTP y esperar la respuesta
+ *
+ * @param request Petición a ejecutar
+ * @param response Código de estado y longitud del cuerpo recibido
+ * @return ESP_OK si hubo respuesta del servidor (cualquier código HTTP),
+ *         otro código si falló la conexión o el transporte
+ */
+esp_err_t hal_http_perform(const hal_http_request_t *request, hal_http_response_t *response);
+
+// Petición en curso en modo no bloqueante
+typedef struct hal_http_async *hal_http_async_t;
+
+/**
+ * @brief Iniciar una petición sin esperar la respuesta
+ *
+ * La petición avanza en cada hal_http_poll(). request (incluidos headers,
+ * body y response_buf) debe seguir vigente hasta que la petición termine.
+ * timeout_ms es el plazo de la petición completa.
+ *
+ * Solo las URLs https:// son no bloqueantes: con http:// (backend local)
+ * la implementación ESP-IDF resuelve la petición aquí mismo, con un plazo
+ * corto, y el primer hal_http_poll() entrega el resultado.
+ *
+ * @param[out] handle Petición en curso
+ */
+esp_err_t hal_http_start(const hal_http_request_t *request, hal_http_async_t *handle);
+
+/**
+ * @brief Avanzar una petición en curso sin bloquear (más allá de unos pocos ms)
+ *
+ * @param[out] result Mismo significado que el retorno de hal_http_perform()
+ * @param[out] response Código de estado y longitud del cuerpo recibido
+ * @return true si la petición terminó (result y response válidos, handle liberado)
+ */
+bool hal_http_poll(hal_http_async_t handle, esp_err_t *result, hal_http_response_t *response);
+
+/**
+ * @brief Cancelar una petición en curso y liberar el handle
+ */
+void hal_http_abort(hal_http_async_t handle);
+
+/**
+ * @brief Vaciar los headers a capturar antes de una petición (para las implementaciones)
+ */
+static inline void hal_http_captures_reset(const hal_http_request_t *request)
+{
+    for (size_t i = 0; i < request->capture_count; i++) {
+        if (request->captures[i].value != NULL && request->captures[i].value_size > 0) {
+            request->captures[i].value[0] = '\0';
+        }
+    }
+}
+
+/**
+ * @brief Guardar un header recibido si está entre los que pide la petición
+ *
+ * @param value_len Largo del valor (puede no estar terminado en '\0')
+ */
+static inline void hal_http_captures_store(const hal_http_request_t *request, const char *key,
+                                           const char *value, size_t value_len)
+{
+    for (size_t i = 0; i < request->capture_count; i++) {
+        hal_http_header_capture_t *capture = &request->captures[i];
+        if (strcasecmp(capture->key, key) == 0 && value_len < capture->value_size) {
+            memcpy(capture->value, value, value_len);
+            capture->value[value_len] = '\0';
+        }
+    }
+}
+
+#endif // HAL_HTTP_H
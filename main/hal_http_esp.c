@@ -0,0 +1,205 @@
+#include "hal_http.h"
+#include "hal_clock.h"
+#include "esp_log.h"
+#include "esp_http_client.h"
+#include "esp_crt_bundle.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "HAL_HTTP";
+
+// Estado de una petición en curso, accesible desde el callback de eventos
+typedef struct {
+    const hal_http_request_t *request;
+    size_t response_len;
+} hal_http_context_t;
+
+static esp_err_t hal_http_event_handler(esp_http_client_event_t *evt)
+{
+    hal_http_context_t *ctx = (hal_http_context_t *)evt->user_data;
+
+    switch (evt->event_id) {
+    case HTTP_EVENT_ERROR:
+        ESP_LOGW(TAG, "HTTP_EVENT_ERROR");
+        break;
+    case HTTP_EVENT_HEADER_SENT:
+        if (ctx->request->sent_us != NULL) {
+            *ctx->request->sent_us = hal_clock_now_us();
+        }
+        break;
+    case HTTP_EVENT_ON_HEADER:
+        ESP_LOGD(TAG, "HTTP_EVENT_ON_HEADER, key=%s, value=%s", evt->header_key, evt->header_value);
+        hal_http_captures_store(ctx->request, evt->header_key, evt->header_value, strlen(evt->header_value));
+        break;
+    case HTTP_EVENT_ON_DATA:
+        // Solo se captura el cuerpo de respuestas no fragmentadas
+        if (ctx->request->response_buf != NULL && !esp_http_client_is_chunked_response(evt->client)) {
+            if (evt->data_len > 0 && ctx->response_len + evt->data_len < ctx->request->response_buf_size) {
+                memcpy(ctx->request->response_buf + ctx->response_len, evt->data, evt->data_len);
+                ctx->response_len += evt->data_len;
+                ctx->request->response_buf[ctx->response_len] = '\0';
+            }
+        }
+        break;
+    default:
+        break;
+    }
+    return ESP_OK;
+}
+
+// Cliente configurado para request (headers y body incluidos)
+static esp_http_client_handle_t hal_http_client_create(const hal_http_request_t *request, hal_http_context_t *ctx,
+                                                      int timeout_ms, bool is_async)
+{
+    esp_http_client_config_t config = {
+        .url = request->url,
+        .method = request->method == HAL_HTTP_METHOD_POST ? HTTP_METHOD_POST : HTTP_METHOD_GET,
+        .event_handler = hal_http_event_handler,
+        .user_data = ctx,
+        .timeout_ms = timeout_ms,
+        .crt_bundle_attach = esp_crt_bundle_attach,
+        .is_async = is_async,
+    };
+
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    if (client == NULL) {
+        ESP_LOGE(TAG, "Error inicializando cliente HTTP");
+        return NULL;
+    }
+
+    for (size_t i = 0; i < request->header_count; i++) {
+        esp_http_client_set_header(client, request->headers[i].key, request->headers[i].value);
+    }
+
+    if (request->body != NULL) {
+        esp_http_client_set_post_field(client, request->body, (int)request->body_len);
+    }
+    return client;
+}
+
+esp_err_t hal_http_perform(const hal_http_request_t *request, hal_http_response_t *response)
+{
+    if (request == NULL || response == NULL || request->url == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    hal_http_context_t ctx = {
+        .request = request,
+        .response_len = 0,
+    };
+    memset(response, 0, sizeof(*response));
+    if (request->response_buf != NULL && request->response_buf_size > 0) {
+        request->response_buf[0] = '\0';
+    }
+    hal_http_captures_reset(request);
+
+    esp_http_client_handle_t client = hal_http_client_create(request, &ctx, request->timeout_ms, false);
+    if (client == NULL) {
+        return ESP_FAIL;
+    }
+
+    esp_err_t err = esp_http_client_perform(client);
+    response->status_code = esp_http_client_get_status_code(client);
+    response->response_len = ctx.response_len;
+
+    esp_http_client_cleanup(client);
+    return err;
+}
+
+// Modo asíncrono de esp_http_client: cada esp_http_client_perform() avanza
+// la conexión (TLS incluido) y devuelve ESP_ERR_HTTP_EAGAIN mientras falte.
+// Las lecturas esperan como máximo HAL_HTTP_ASYNC_SLICE_MS por llamada; el
+// plazo de la petición completa se controla aquí.
+#define HAL_HTTP_ASYNC_SLICE_MS 10
+// esp_http_client solo soporta is_async sobre TLS: con http:// (el backend
+// local de LOCAL_BACKEND_HOST) la petición se hace bloqueante dentro de
+// hal_http_start() con este plazo máximo, y hal_http_poll() solo la entrega
+#define HAL_HTTP_PLAIN_TIMEOUT_MS 3000
+
+struct hal_http_async {
+    esp_http_client_handle_t client;
+    hal_http_context_t ctx;
+    uint32_t started_ms;
+    bool completed;                     // Petición http:// ya resuelta en hal_http_start()
+    esp_err_t result;
+    int status_code;
+};
+
+static bool hal_http_url_is_tls(const char *url)
+{
+    return strncmp(url, "https://", 8) == 0;
+}
+
+esp_err_t hal_http_start(const hal_http_request_t *request, hal_http_async_t *handle)
+{
+    if (request == NULL || handle == NULL || request->url == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct hal_http_async *async = calloc(1, sizeof(*async));
+    if (async == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    async->ctx.request = request;
+    async->started_ms = hal_clock_now_ms();
+    if (request->response_buf != NULL && request->response_buf_size > 0) {
+        request->response_buf[0] = '\0';
+    }
+    hal_http_captures_reset(request);
+
+    if (!hal_http_url_is_tls(request->url)) {
+        int timeout_ms = request->timeout_ms < HAL_HTTP_PLAIN_TIMEOUT_MS ? request->timeout_ms
+                                                                          : HAL_HTTP_PLAIN_TIMEOUT_MS;
+        async->client = hal_http_client_create(request, &async->ctx, timeout_ms, false);
+        if (async->client == NULL) {
+            free(async);
+            return ESP_FAIL;
+        }
+        async->result = esp_http_client_perform(async->client);
+        async->status_code = esp_http_client_get_status_code(async->client);
+        async->completed = true;
+        *handle = async;
+        return ESP_OK;
+    }
+
+    async->client = hal_http_client_create(request, &async->ctx, HAL_HTTP_ASYNC_SLICE_MS, true);
+    if (async->client == NULL) {
+        free(async);
+        return ESP_FAIL;
+    }
+    *handle = async;
+    return ESP_OK;
+}
+
+bool hal_http_poll(hal_http_async_t handle, esp_err_t *result, hal_http_response_t *response)
+{
+    if (handle->completed) {
+        response->status_code = handle->status_code;
+        response->response_len = handle->ctx.response_len;
+        *result = handle->result;
+        hal_http_abort(handle);
+        return true;
+    }
+
+    esp_err_t err = esp_http_client_perform(handle->client);
+    if (err == ESP_ERR_HTTP_EAGAIN) {
+        if (hal_clock_elapsed_ms(handle->started_ms) < (uint32_t)handle->ctx.request->timeout_ms) {
+            return false;
+        }
+        err = ESP_ERR_TIMEOUT;
+    }
+
+    response->status_code = esp_http_client_get_status_code(handle->client);
+    response->response_len = handle->ctx.response_len;
+    *result = err;
+    hal_http_abort(handle);
+    return true;
+}
+
+void hal_http_abort(hal_http_async_t handle)
+{
+    if (handle != NULL) {
+        esp_http_client_cleanup(handle->client);
+        free(handle);
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef HAL_MQTT_H
+#define HAL_MQTT_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Capa de abstracción del cliente MQTT: en el firmware usa esp-mqtt
+// (hal_mqtt_esp.c), en el build de host un broker simulado en memoria
+
+typedef enum {
+    HAL_MQTT_EVENT_CONNECTED,
+    HAL_MQTT_EVENT_DISCONNECTED,
+    HAL_MQTT_EVENT_SUBSCRIBED,
+    HAL_MQTT_EVENT_PUBLISHED,
+    HAL_MQTT_EVENT_DATA,
+    HAL_MQTT_EVENT_ERROR
+} hal_mqtt_event_id_t;
+
+// Evento entregado al callback (los punteros solo son válidos durante la llamada)
+typedef struct {
+    hal_mqtt_event_id_t id;
+    int msg_id;
+    const char *topic;      // Solo HAL_MQTT_EVENT_DATA (no terminado en '\0')
+    int topic_len;
+    const char *data;       // Solo HAL_MQTT_EVENT_DATA (no terminado en '\0')
+    int data_len;
+    int error_type;         // Solo HAL_MQTT_EVENT_ERROR
+    bool transport_error;   // Error en la capa TCP/TLS
+} hal_mqtt_event_t;
+
+typedef void (*hal_mqtt_event_cb_t)(const hal_mqtt_event_t *event);
+
+// Parámetros de conexión al broker
+typedef struct {
+    const char *uri;
+    uint32_t port;
+    const char *client_id;
+    const char *username;
+    const char *password;
+    int keepalive_s;
+    int reconnect_timeout_ms;
+} hal_mqtt_config_t;
+
+/**
+ * @brief Crear el cliente MQTT y conectar al broker (reconexión automática)
+ *
+ * @param config Parámetros de conexión
+ * @param callback Función que recibe los eventos del cliente
+ * @return ESP_OK si el cliente se inició correctamente
+ */
+esp_err_t hal_mqtt_start(const hal_mqtt_config_t *config, hal_mqtt_event_cb_t callback);
+
+/**
+ * @brief Suscribirse a un tópico
+ *
+ * @return msg_id de la suscripción, o -1 si falló
+ */
+int hal_mqtt_subscribe(const char *topic, int qos);
+
+/**
+ * @brief Publicar un mensaje
+ *
+ * @param len Longitud de data (0 = calcular con strlen)
+ * @return msg_id del mensaje, o -1 si falló
+ */
+int hal_mqtt_publish(const char *topic, const char *data, int len, int qos, int retain);
+
+/**
+ * @brief Cambiar la espera antes de la próxima reconexión automática
+ *
+ * esp-mqtt fija la espera al cortarse la conexión, así que en el firmware el
+ * valor aplica a partir de la siguiente desconexión.
+ */
+void hal_mqtt_set_reconnect_timeout(int reconnect_timeout_ms);
+
+#endif // HAL_MQTT_H
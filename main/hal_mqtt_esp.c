@@ -0,0 +1,119 @@
+#include "hal_mqtt.h"
+#include "esp_log.h"
+#include "mqtt_client.h"
+#include "esp_crt_bundle.h"
+
+static const char *TAG = "HAL_MQTT";
+
+static esp_mqtt_client_handle_t mqtt_client = NULL;
+static hal_mqtt_event_cb_t event_callback = NULL;
+// Se conserva para reaplicarla con esp_mqtt_set_config() al cambiar la espera de reconexión
+static esp_mqtt_client_config_t mqtt_cfg;
+
+// Traducir eventos de esp-mqtt al formato de la HAL
+static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    esp_mqtt_event_handle_t event = (esp_mqtt_event_handle_t)event_data;
+    hal_mqtt_event_t hal_event = {
+        .msg_id = event->msg_id,
+    };
+
+    switch ((esp_mqtt_event_id_t)event_id) {
+        case MQTT_EVENT_CONNECTED:
+            hal_event.id = HAL_MQTT_EVENT_CONNECTED;
+            break;
+        case MQTT_EVENT_DISCONNECTED:
+            hal_event.id = HAL_MQTT_EVENT_DISCONNECTED;
+            break;
+        case MQTT_EVENT_SUBSCRIBED:
+            hal_event.id = HAL_MQTT_EVENT_SUBSCRIBED;
+            break;
+        case MQTT_EVENT_PUBLISHED:
+            hal_event.id = HAL_MQTT_EVENT_PUBLISHED;
+            break;
+        case MQTT_EVENT_DATA:
+            hal_event.id = HAL_MQTT_EVENT_DATA;
+            hal_event.topic = event->topic;
+            hal_event.topic_len = event->topic_len;
+            hal_event.data = event->data;
+            hal_event.data_len = event->data_len;
+            break;
+        case MQTT_EVENT_ERROR:
+            hal_event.id = HAL_MQTT_EVENT_ERROR;
+            hal_event.error_type = event->error_handle->error_type;
+            hal_event.transport_error = (event->error_handle->error_type == MQTT_ERROR_TYPE_TCP_TRANSPORT);
+            break;
+        default:
+            ESP_LOGD(TAG, "Evento MQTT no manejado: %ld", (long)event_id);
+            return;
+    }
+
+    if (event_callback != NULL) {
+        event_callback(&hal_event);
+    }
+}
+
+esp_err_t hal_mqtt_start(const hal_mqtt_config_t *config, hal_mqtt_event_cb_t callback)
+{
+    mqtt_cfg = (esp_mqtt_client_config_t){
+        .broker.address.uri = config->uri,
+        .broker.address.port = config->port,
+        .credentials.client_id = config->client_id,
+        .credentials.username = config->username,
+        .credentials.authentication.password = config->password,
+        .session.keepalive = config->keepalive_s,
+        .network.reconnect_timeout_ms = config->reconnect_timeout_ms,
+        .network.disable_auto_reconnect = false,
+        // Configuración TLS para mqtts:// usando bundle de certificados
+        .broker.verification.crt_bundle_attach = esp_crt_bundle_attach,
+    };
+
+    event_callback = callback;
+
+    mqtt_client = esp_mqtt_client_init(&mqtt_cfg);
+    if (mqtt_client == NULL) {
+        ESP_LOGE(TAG, "Error al inicializar cliente MQTT");
+        return ESP_FAIL;
+    }
+
+    esp_err_t ret = esp_mqtt_client_register_event(mqtt_client, ESP_EVENT_ANY_ID, mqtt_event_handler, NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error al registrar manejador de eventos MQTT");
+        return ret;
+    }
+
+    ret = esp_mqtt_client_start(mqtt_client);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error al iniciar cliente MQTT");
+        return ret;
+    }
+
+    return ESP_OK;
+}
+
+int hal_mqtt_subscribe(const char *topic, int qos)
+{
+    if (mqtt_client == NULL) {
+        return -1;
+    }
+    return esp_mqtt_client_subscribe(mqtt_client, topic, qos);
+}
+
+int hal_mqtt_publish(const char *topic, const char *data, int len, int qos, int retain)
+{
+    if (mqtt_client == NULL) {
+        return -1;
+    }
+    return esp_mqtt_client_publish(mqtt_client, topic, data, len, qos, retain);
+}
+
+void hal_mqtt_set_reconnect_timeout(int reconnect_timeout_ms)
+{
+    if (mqtt_client == NULL || reconnect_timeout_ms <= 0) {
+        return;
+    }
+    mqtt_cfg.network.reconnect_timeout_ms = reconnect_timeout_ms;
+    if (esp_mqtt_set_config(mqtt_client, &mqtt_cfg) != ESP_OK) {
+        ESP_LOGW(TAG, "No se pudo actualizar la espera de reconexión MQTT");
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef HAL_NVS_H
+#define HAL_NVS_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Capa de abstracción de almacenamiento clave/valor: en el firmware usa NVS
+// (hal_nvs_esp.c), en el build de host una tabla en memoria. Los códigos de
+// error son los de NVS (p. ej. ESP_ERR_NVS_NOT_FOUND) en ambos casos.
+
+typedef uint32_t hal_nvs_handle_t;
+
+#ifndef ESP_ERR_NVS_NOT_FOUND
+#define ESP_ERR_NVS_NOT_FOUND (ESP_ERR_NVS_BASE + 0x02) // Mismo valor que en nvs.h
+#endif
+#ifndef ESP_ERR_NVS_INVALID_LENGTH
+#define ESP_ERR_NVS_INVALID_LENGTH (ESP_ERR_NVS_BASE + 0x0c) // Mismo valor que en nvs.h
+#endif
+
+/**
+ * @brief Abrir un namespace
+ *
+ * @param name_space Nombre del namespace (máx. 15 caracteres)
+ * @param read_write true para lectura/escritura, false solo lectura
+ * @param out_handle Handle del namespace abierto
+ * @return ESP_OK si se abrió correctamente
+ */
+esp_err_t hal_nvs_open(const char *name_space, bool read_write, hal_nvs_handle_t *out_handle);
+
+/**
+ * @brief Cerrar un namespace abierto
+ */
+void hal_nvs_close(hal_nvs_handle_t handle);
+
+/**
+ * @brief Confirmar las escrituras pendientes
+ */
+esp_err_t hal_nvs_commit(hal_nvs_handle_t handle);
+
+esp_err_t hal_nvs_get_u8(hal_nvs_handle_t handle, const char *key, uint8_t *out_value);
+esp_err_t hal_nvs_set_u8(hal_nvs_handle_t handle, const char *key, uint8_t value);
+esp_err_t hal_nvs_get_i32(hal_nvs_handle_t handle, const char *key, int32_t *out_value);
+esp_err_t hal_nvs_set_i32(hal_nvs_handle_t handle, const char *key, int32_t value);
+esp_err_t hal_nvs_get_str(hal_nvs_handle_t handle, const char *key, char *out_value, size_t *length);
+esp_err_t hal_nvs_set_str(hal_nvs_handle_t handle, const char *key, const char *value);
+/**
+ * @brief Leer un valor binario
+ *
+ * @param out_value Buffer de salida (NULL para consultar solo el largo)
+ * @param length Entrada: tamaño de out_value; salida: largo del valor
+ * @return ESP_ERR_NVS_NOT_FOUND si no existe, ESP_ERR_NVS_INVALID_LENGTH si no entra
+ */
+esp_err_t hal_nvs_get_blob(hal_nvs_handle_t handle, const char *key, void *out_value, size_t *length);
+esp_err_t hal_nvs_set_blob(hal_nvs_handle_t handle, const char *key, const void *value, size_t length);
+esp_err_t hal_nvs_erase_key(hal_nvs_handle_t handle, const char *key);
+
+#endif // HAL_NVS_H
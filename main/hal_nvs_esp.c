@@ -0,0 +1,69 @@
+#include "nvs.h"
+#include "hal_nvs.h"
+
+// Implementación ESP32 de hal_nvs.h: traducción directa a la API de NVS
+
+esp_err_t hal_nvs_open(const char *name_space, bool read_write, hal_nvs_handle_t *out_handle)
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(name_space, read_write ? NVS_READWRITE : NVS_READONLY, &handle);
+    if (err == ESP_OK) {
+        *out_handle = (hal_nvs_handle_t)handle;
+    }
+    return err;
+}
+
+void hal_nvs_close(hal_nvs_handle_t handle)
+{
+    nvs_close((nvs_handle_t)handle);
+}
+
+esp_err_t hal_nvs_commit(hal_nvs_handle_t handle)
+{
+    return nvs_commit((nvs_handle_t)handle);
+}
+
+esp_err_t hal_nvs_get_u8(hal_nvs_handle_t handle, const char *key, uint8_t *out_value)
+{
+    return nvs_get_u8((nvs_handle_t)handle, key, out_value);
+}
+
+esp_err_t hal_nvs_set_u8(hal_nvs_handle_t handle, const char *key, uint8_t value)
+{
+    return nvs_set_u8((nvs_handle_t)handle, key, value);
+}
+
+esp_err_t hal_nvs_get_i32(hal_nvs_handle_t handle, const char *key, int32_t *out_value)
+{
+    return nvs_get_i32((nvs_handle_t)handle, key, out_value);
+}
+
+esp_err_t hal_nvs_set_i32(hal_nvs_handle_t handle, const char *key, int32_t value)
+{
+    return nvs_set_i32((nvs_handle_t)handle, key, value);
+}
+
+esp_err_t hal_nvs_get_str(hal_nvs_handle_t handle, const char *key, char *out_value, size_t *length)
+{
+    return nvs_get_str((nvs_handle_t)handle, key, out_value, length);
+}
+
+esp_err_t hal_nvs_set_str(hal_nvs_handle_t handle, const char *key, const char *value)
+{
+    return nvs_set_str((nvs_handle_t)handle, key, value);
+}
+
+esp_err_t hal_nvs_get_blob(hal_nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+    return nvs_get_blob((nvs_handle_t)handle, key, out_value, length);
+}
+
+esp_err_t hal_nvs_set_blob(hal_nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    return nvs_set_blob((nvs_handle_t)handle, key, value, length);
+}
+
+esp_err_t hal_nvs_erase_key(hal_nvs_handle_t handle, const char *key)
+{
+    return nvs_erase_key((nvs_handle_t)handle, key);
+}
@@ -0,0 +1,29 @@
+#ifndef HAL_SNTP_H
+#define HAL_SNTP_H
+
+#include "esp_err.h"
+#include <stdint.h>
+
+// Capa de abstracción del cliente SNTP: en el firmware usa esp_netif_sntp
+// (hal_sntp_esp.c), en el build de host un cliente UDP contra el servidor NTP
+// del backend local o ninguno (el reloj queda sin sincronizar).
+
+/**
+ * @brief Callback de sincronización
+ *
+ * @param epoch_us Hora UTC recibida del servidor (µs desde 1970)
+ * @param mono_us Instante de hal_clock_now_us() al que corresponde epoch_us
+ */
+typedef void (*hal_sntp_sync_cb_t)(int64_t epoch_us, int64_t mono_us);
+
+/**
+ * @brief Arrancar el cliente SNTP (reintenta solo hasta sincronizar)
+ *
+ * @param server Nombre o IP del servidor NTP
+ * @param interval_ms Período entre sincronizaciones una vez sincronizado
+ * @param callback Se llama en cada sincronización exitosa
+ * @return ESP_OK si el cliente quedó en marcha
+ */
+esp_err_t hal_sntp_start(const char *server, uint32_t interval_ms, hal_sntp_sync_cb_t callback);
+
+#endif // HAL_SNTP_H
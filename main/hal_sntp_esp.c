@@ -0,0 +1,39 @@
+#include "hal_sntp.h"
+#include "esp_log.h"
+#include "esp_netif_sntp.h"
+#include "esp_sntp.h"
+#include "esp_timer.h"
+#include <sys/time.h>
+
+static const char *TAG = "HAL_SNTP";
+
+static hal_sntp_sync_cb_t sync_callback = NULL;
+
+// Llamado por lwIP justo después de ajustar la hora del sistema con tv
+static void time_sync_handler(struct timeval *tv)
+{
+    int64_t mono_us = esp_timer_get_time();
+    if (sync_callback != NULL) {
+        sync_callback((int64_t)tv->tv_sec * 1000000 + tv->tv_usec, mono_us);
+    }
+}
+
+esp_err_t hal_sntp_start(const char *server, uint32_t interval_ms, hal_sntp_sync_cb_t callback)
+{
+    if (server == NULL || callback == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    sync_callback = callback;
+
+    esp_sntp_config_t config = ESP_NETIF_SNTP_DEFAULT_CONFIG(server);
+    config.sync_cb = time_sync_handler;
+    config.wait_for_sync = false;
+    esp_err_t err = esp_netif_sntp_init(&config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Error iniciando SNTP: %s", esp_err_to_name(err));
+        return err;
+    }
+    sntp_set_sync_interval(interval_ms);    // lwIP aplica un mínimo de 15 s
+    ESP_LOGI(TAG, "🕒 SNTP contra %s cada %lu s", server, (unsigned long)(interval_ms / 1000));
+    return ESP_OK;
+}
@@ -0,0 +1,313 @@
+#include "http_compress.h"
+#include "config.h"
+#include "metrics.h"
+#include "hal_clock.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "HTTP_COMPRESS";
+
+#define COMPRESS_HASH_SIZE (1u << HTTP_COMPRESS_HASH_BITS)
+#define COMPRESS_WINDOW_MASK (HTTP_COMPRESS_WINDOW_SIZE - 1)
+#define COMPRESS_MIN_MATCH 3
+#define COMPRESS_MAX_MATCH 258
+
+_Static_assert((HTTP_COMPRESS_WINDOW_SIZE & COMPRESS_WINDOW_MASK) == 0 && HTTP_COMPRESS_WINDOW_SIZE <= 32768,
+               "HTTP_COMPRESS_WINDOW_SIZE debe ser potencia de 2 y <= 32768");
+
+// Estado de búsqueda LZ77: última posición (+1, 0 = vacía) de cada hash de 3
+// bytes y, por posición dentro de la ventana, la anterior con el mismo hash
+static SemaphoreHandle_t compress_mutex = NULL;
+static uint16_t hash_head[COMPRESS_HASH_SIZE];
+static uint16_t hash_prev[HTTP_COMPRESS_WINDOW_SIZE];
+
+// Longitudes y distancias de DEFLATE (RFC 1951, 3.2.5)
+static const uint16_t length_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t length_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+typedef struct {
+    uint8_t *out;
+    size_t size;
+    size_t len;
+    uint32_t bits;
+    int count;
+    bool overflow;
+} bit_writer_t;
+
+static void compress_lock(void)
+{
+    if (compress_mutex != NULL) {
+        xSemaphoreTake(compress_mutex, portMAX_DELAY);
+    }
+}
+
+static void compress_unlock(void)
+{
+    if (compress_mutex != NULL) {
+        xSemaphoreGive(compress_mutex);
+    }
+}
+
+static void put_byte(bit_writer_t *writer, uint8_t value)
+{
+    if (writer->len < writer->size) {
+        writer->out[writer->len++] = value;
+    } else {
+        writer->overflow = true;
+    }
+}
+
+// Bits de datos y extras: el menos significativo primero
+static void put_bits(bit_writer_t *writer, uint32_t value, int count)
+{
+    writer->bits |= value << writer->count;
+    writer->count += count;
+    while (writer->count >= 8) {
+        put_byte(writer, (uint8_t)writer->bits);
+        writer->bits >>= 8;
+        writer->count -= 8;
+    }
+}
+
+// Códigos de Huffman: el más significativo primero
+static void put_code(bit_writer_t *writer, uint32_t code, int count)
+{
+    uint32_t reversed = 0;
+    for (int i = 0; i < count; i++) {
+        reversed = (reversed << 1) | ((code >> i) & 1);
+    }
+    put_bits(writer, reversed, count);
+}
+
+static void flush_bits(bit_writer_t *writer)
+{
+    if (writer->count > 0) {
+        put_byte(writer, (uint8_t)writer->bits);
+    }
+    writer->bits = 0;
+    writer->count = 0;
+}
+
+// Símbolo literal/longitud con el código Huffman fijo
+static void put_symbol(bit_writer_t *writer, uint32_t symbol)
+{
+    if (symbol < 144) {
+        put_code(writer, 0x30 + symbol, 8);
+    } else if (symbol < 256) {
+        put_code(writer, 0x190 + symbol - 144, 9);
+    } else if (symbol < 280) {
+        put_code(writer, symbol - 256, 7);
+    } else {
+        put_code(writer, 0xC0 + symbol - 280, 8);
+    }
+}
+
+static void put_match(bit_writer_t *writer, uint32_t length, uint32_t distance)
+{
+    int l = 28;
+    while (length_base[l] > length) {
+        l--;
+    }
+    put_symbol(writer, 257 + l);
+    put_bits(writer, length - length_base[l], length_extra[l]);
+
+    int d = 29;
+    while (dist_base[d] > distance) {
+        d--;
+    }
+    put_code(writer, d, 5);
+    put_bits(writer, distance - dist_base[d], dist_extra[d]);
+}
+
+static uint32_t hash3(const uint8_t *p)
+{
+    uint32_t v = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+    return (v * 2654435761u) >> (32 - HTTP_COMPRESS_HASH_BITS);
+}
+
+static void hash_insert(const uint8_t *in, size_t pos)
+{
+    uint32_t h = hash3(in + pos);
+    hash_prev[pos & COMPRESS_WINDOW_MASK] = hash_head[h];
+    hash_head[h] = (uint16_t)(pos + 1);
+}
+
+// Bloque DEFLATE final con Huffman fijo. Requiere compress_lock().
+static void deflate_block_locked(const uint8_t *in, size_t in_len, bit_writer_t *writer)
+{
+    memset(hash_head, 0, sizeof(hash_head));
+    put_bits(writer, 1, 1);     // BFINAL
+    put_bits(writer, 1, 2);     // BTYPE = 01 (Huffman fijo)
+
+    size_t pos = 0;
+    while (pos < in_len && !writer->overflow) {
+        uint32_t best_len = 0;
+        uint32_t best_dist = 0;
+        if (pos + COMPRESS_MIN_MATCH <= in_len) {
+            size_t max_len = in_len - pos < COMPRESS_MAX_MATCH ? in_len - pos : COMPRESS_MAX_MATCH;
+            uint32_t candidate = hash_head[hash3(in + pos)];
+            for (int chain = 0; candidate != 0 && chain < HTTP_COMPRESS_MAX_CHAIN; chain++) {
+                size_t match_pos = candidate - 1;
+                if (match_pos >= pos || pos - match_pos > HTTP_COMPRESS_WINDOW_SIZE) {
+                    break;
+                }
+                uint32_t len = 0;
+                while (len < max_len && in[match_pos + len] == in[pos + len]) {
+                    len++;
+                }
+                if (len > best_len) {
+                    best_len = len;
+                    best_dist = (uint32_t)(pos - match_pos);
+                    if (len == max_len) {
+                        break;
+                    }
+                }
+                candidate = hash_prev[match_pos & COMPRESS_WINDOW_MASK];
+            }
+            hash_insert(in, pos);
+        }
+
+        if (best_len >= COMPRESS_MIN_MATCH) {
+            put_match(writer, best_len, best_dist);
+            for (size_t i = pos + 1; i < pos + best_len && i + COMPRESS_MIN_MATCH <= in_len; i++) {
+                hash_insert(in, i);
+            }
+            pos += best_len;
+        } else {
+            put_symbol(writer, in[pos]);
+            pos++;
+        }
+    }
+
+    put_symbol(writer, 256);    // Fin de bloque
+    flush_bits(writer);
+}
+
+static uint32_t adler32(const uint8_t *data, size_t len)
+{
+    uint32_t a = 1;
+    uint32_t b = 0;
+    for (size_t i = 0; i < len; i++) {
+        a = (a + data[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+}
+
+// CRC-32 de gzip, bit a bit (sin tabla: los cuerpos son de unos cientos de bytes)
+static uint32_t crc32_gzip(const uint8_t *data, size_t len)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+esp_err_t http_compress_init(void)
+{
+    if (compress_mutex == NULL) {
+        compress_mutex = xSemaphoreCreateMutex();
+        if (compress_mutex == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    return ESP_OK;
+}
+
+size_t http_compress(const uint8_t *in, size_t in_len, uint8_t *out, size_t out_size,
+                     http_compress_encoding_t encoding)
+{
+    // Las posiciones del estado de búsqueda son de 16 bits
+    if (in == NULL || out == NULL || encoding == HTTP_COMPRESS_NONE || in_len >= UINT16_MAX) {
+        return 0;
+    }
+
+    bit_writer_t writer = {.out = out, .size = out_size};
+    if (encoding == HTTP_COMPRESS_GZIP) {
+        static const uint8_t gzip_header[10] = {0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 0xFF};
+        for (size_t i = 0; i < sizeof(gzip_header); i++) {
+            put_byte(&writer, gzip_header[i]);
+        }
+    } else {
+        put_byte(&writer, 0x78);    // CM = 8 (deflate), ventana de 32 KB
+        put_byte(&writer, 0x01);    // Sin diccionario, (CMF * 256 + FLG) % 31 == 0
+    }
+
+    compress_lock();
+    deflate_block_locked(in, in_len, &writer);
+    compress_unlock();
+
+    if (encoding == HTTP_COMPRESS_GZIP) {
+        uint32_t crc = crc32_gzip(in, in_len);
+        for (int i = 0; i < 4; i++) {
+            put_byte(&writer, (uint8_t)(crc >> (8 * i)));
+        }
+        for (int i = 0; i < 4; i++) {
+            put_byte(&writer, (uint8_t)(in_len >> (8 * i)));
+        }
+    } else {
+        uint32_t adler = adler32(in, in_len);
+        for (int i = 3; i >= 0; i--) {
+            put_byte(&writer, (uint8_t)(adler >> (8 * i)));
+        }
+    }
+    return writer.overflow ? 0 : writer.len;
+}
+
+const char *http_compress_encoding_name(http_compress_encoding_t encoding)
+{
+    switch (encoding) {
+        case HTTP_COMPRESS_DEFLATE:
+            return "deflate";
+        case HTTP_COMPRESS_GZIP:
+            return "gzip";
+        default:
+            return NULL;
+    }
+}
+
+const char *http_compress_body(const char *json, uint8_t *buffer, size_t buffer_size,
+                               const char **body, size_t *body_len)
+{
+    size_t json_len = strlen(json);
+    *body = json;
+    *body_len = json_len;
+    metrics_counter_add(METRIC_HTTP_BODY_RAW_BYTES, (uint32_t)json_len);
+
+    http_compress_encoding_t encoding = (http_compress_encoding_t)HTTP_COMPRESS_ENCODING;
+    size_t compressed_len = 0;
+    if (encoding != HTTP_COMPRESS_NONE && json_len >= HTTP_COMPRESS_MIN_BYTES) {
+        int64_t start_us = hal_clock_now_us();
+        compressed_len = http_compress((const uint8_t *)json, json_len, buffer, buffer_size, encoding);
+        metrics_counter_add(METRIC_HTTP_COMPRESS_US, (uint32_t)(hal_clock_now_us() - start_us));
+        metrics_counter_add(METRIC_HTTP_COMPRESS_IN_BYTES, (uint32_t)json_len);
+    }
+
+    if (compressed_len == 0 || compressed_len >= json_len) {
+        // Debajo del umbral, sin lugar en el buffer o incompresible: va como está
+        metrics_counter_add(METRIC_HTTP_BODY_SENT_BYTES, (uint32_t)json_len);
+        return NULL;
+    }
+
+    ESP_LOGD(TAG, "Cuerpo comprimido: %u -> %u bytes", (unsigned)json_len, (unsigned)compressed_len);
+    *body = (const char *)buffer;
+    *body_len = compressed_len;
+    metrics_counter_add(METRIC_HTTP_BODY_SENT_BYTES, (uint32_t)compressed_len);
+    return http_compress_encoding_name(encoding);
+}
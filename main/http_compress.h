@@ -0,0 +1,55 @@
+#ifndef HTTP_COMPRESS_H
+#define HTTP_COMPRESS_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Compresión de los cuerpos de POST /process-data y /error-logs
+// (Content-Encoding: deflate o gzip). Codificador DEFLATE de bloque único con
+// Huffman fijo y LZ77 sobre una ventana de HTTP_COMPRESS_WINDOW_SIZE bytes:
+// el estado de búsqueda es estático (unos pocos KB) y la salida se escribe en
+// un buffer fijo del llamador. Si no entra o no achica, se envía sin comprimir.
+// Umbrales en config.h (HTTP_COMPRESS_*).
+
+typedef enum {
+    HTTP_COMPRESS_NONE = 0,
+    HTTP_COMPRESS_DEFLATE = 1,      // "deflate" de HTTP: flujo zlib (RFC 1950)
+    HTTP_COMPRESS_GZIP = 2,         // RFC 1952
+} http_compress_encoding_t;
+
+/**
+ * @brief Crear el mutex del estado de búsqueda (sin él, un solo llamador a la vez)
+ */
+esp_err_t http_compress_init(void);
+
+/**
+ * @brief Comprimir un buffer completo en el formato de la codificación
+ *
+ * @param out Buffer de salida (tamaño fijo)
+ * @return Bytes escritos en out, o 0 si no entran o la codificación es NONE
+ */
+size_t http_compress(const uint8_t *in, size_t in_len, uint8_t *out, size_t out_size,
+                     http_compress_encoding_t encoding);
+
+/**
+ * @brief Valor del header Content-Encoding ("deflate", "gzip"; NULL sin comprimir)
+ */
+const char *http_compress_encoding_name(http_compress_encoding_t encoding);
+
+/**
+ * @brief Elegir el cuerpo de un POST: comprimido si supera el umbral y achica
+ *
+ * Suma los bytes originales, los enviados y el tiempo de CPU en las métricas.
+ *
+ * @param json Cuerpo original (terminado en '\0')
+ * @param buffer Buffer de salida: debe seguir vigente mientras dure la petición
+ * @param[out] body Cuerpo a enviar (json o buffer)
+ * @param[out] body_len Largo del cuerpo a enviar
+ * @return Valor del header Content-Encoding, o NULL si va sin comprimir
+ */
+const char *http_compress_body(const char *json, uint8_t *buffer, size_t buffer_size,
+                               const char **body, size_t *body_len);
+
+#endif // HTTP_COMPRESS_H
@@ -28,7 +28,7 @@ void app_main(void)
 
     // Crear colas de comunicación entre tareas
     ESP_LOGI(TAG, "Creando colas de comunicación...");
-    sensor_queue = xQueueCreate(SENSOR_QUEUE_SIZE, sizeof(sensor_data_t));
+    sensor_queue = xQueueCreate(SENSOR_QUEUE_SIZE, sizeof(sensor_frame_t));
     error_queue = xQueueCreate(ERROR_QUEUE_SIZE, sizeof(supervisor_message_t));
 
     if (sensor_queue == NULL || error_queue == NULL) {
@@ -52,8 +52,9 @@ void app_main(void)
 
     // Crear la tarea principal del supervisor (prioridad máxima)
     ESP_LOGI(TAG, "Creando tarea supervisor...");
+    // 6 KB: el watchdog del supervisor registra errores con error_logger_log_system()
     BaseType_t result = xTaskCreate(task_main_supervisor, "main_supervisor",
-                                   4096, &queues, 5, NULL);
+                                   6144, &queues, 5, NULL);
 
     if (result != pdPASS) {
         ESP_LOGE(TAG, "Error creando tarea supervisor");
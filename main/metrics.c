@@ -0,0 +1,418 @@
+#include "metrics.h"
+#include "task_main.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "hal_clock.h"
+#include "time_service.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#if CONFIG_IDF_TARGET_LINUX
+// Build de host: sin heap_caps ni RNG de hardware
+#include <stdlib.h>
+#define metrics_random() ((uint32_t)rand())
+#else
+#include "esp_heap_caps.h"
+#include "esp_random.h"
+#define metrics_random() esp_random()
+#endif
+
+static const char *TAG = "METRICS";
+
+// Todas las actualizaciones usan __atomic con orden relajado: los valores son
+// independientes entre sí y solo se leen para el snapshot. En el ESP32-C3
+// (sin extensión A) el compilador las emula enmascarando interrupciones unos
+// pocos ciclos, sin mutex ni cambio de contexto.
+
+typedef struct
+{
+    uint32_t buckets[METRICS_HIST_BUCKETS];
+    uint32_t count;
+    uint32_t sum_ms;
+    uint32_t max_ms;
+} metrics_histogram_data_t;
+
+const uint32_t metrics_hist_bounds_ms[METRICS_HIST_BUCKETS - 1] = {
+    50, 100, 250, 500, 1000, 2500, 5000, 10000, 20000};
+
+static const char *counter_names[METRIC_COUNTER_MAX] = {
+    [METRIC_HTTP_POSTS_OK] = "http_ok",
+    [METRIC_HTTP_POSTS_FAILED] = "http_fail",
+    [METRIC_SENSOR_SAMPLES] = "samples",
+    [METRIC_SENSOR_READ_ERRORS] = "read_err",
+    [METRIC_SENSOR_QUEUE_DROPS] = "sensor_q_drop",
+    [METRIC_ERRLOG_SENT] = "errlog_sent",
+    [METRIC_ERRLOG_FAILED] = "errlog_fail",
+    [METRIC_ERRLOG_DUPLICATES] = "errlog_dup",
+    [METRIC_ERRLOG_DROPS] = "errlog_drop",
+    [METRIC_MQTT_MESSAGES_RX] = "mqtt_rx",
+    [METRIC_MQTT_DISCONNECTS] = "mqtt_disc",
+    [METRIC_PACING_DEFERRED] = "pace_defer",
+    [METRIC_BREAKER_OPENED] = "brk_open",
+    [METRIC_BREAKER_HALF_OPENED] = "brk_half",
+    [METRIC_BREAKER_CLOSED] = "brk_close",
+    [METRIC_BREAKER_REJECTED] = "brk_reject",
+    [METRIC_BREAKER_SLOW_CALLS] = "brk_slow",
+    [METRIC_LOCAL_BUFFERED] = "buf_in",
+    [METRIC_LOCAL_BUFFER_DROPS] = "buf_drop",
+    [METRIC_LOCAL_BUFFER_SENT] = "buf_out",
+    [METRIC_HTTP_INFLIGHT_MS] = "http_fly_ms",
+    [METRIC_HTTP_BLOCKED_MS] = "http_blk_ms",
+    [METRIC_TIME_SYNCS] = "time_sync",
+    [METRIC_TIME_STEPS] = "time_step",
+    [METRIC_HTTP_BODY_RAW_BYTES] = "body_raw_b",
+    [METRIC_HTTP_BODY_SENT_BYTES] = "body_tx_b",
+    [METRIC_HTTP_COMPRESS_IN_BYTES] = "gz_in_b",
+    [METRIC_HTTP_COMPRESS_US] = "gz_us",
+    [METRIC_CONFIG_SYNC_UPDATED] = "cfg_200",
+    [METRIC_CONFIG_SYNC_NOT_MODIFIED] = "cfg_304",
+    [METRIC_CONFIG_STORE_WRITES] = "cfg_wr",
+    [METRIC_CONFIG_STORE_COMMITS] = "cfg_commit",
+    [METRIC_CONFIG_STORE_UNCHANGED] = "cfg_same",
+    [METRIC_CONFIG_STORE_COALESCED] = "cfg_merge",
+    [METRIC_MQTT_HANDLER_CALLS] = "mqtt_h_n",
+    [METRIC_MQTT_HANDLER_US] = "mqtt_h_us",
+    [METRIC_MQTT_WORKER_US] = "mqtt_w_us",
+    [METRIC_MQTT_WORK_DROPS] = "mqtt_w_drop",
+    [METRIC_WIFI_FAST_FALLBACKS] = "wifi_fallback",
+    [METRIC_WIFI_DISCONNECTS] = "wifi_disc",
+};
+
+static const char *gauge_names[METRIC_GAUGE_MAX] = {
+    [METRIC_GAUGE_HEAP_FREE] = "heap_free",
+    [METRIC_GAUGE_HEAP_MIN_FREE] = "heap_min",
+    [METRIC_GAUGE_HEAP_LARGEST_BLOCK] = "heap_largest",
+    [METRIC_GAUGE_SENSOR_QUEUE_DEPTH] = "sensor_q",
+    [METRIC_GAUGE_ERROR_QUEUE_DEPTH] = "error_q",
+    [METRIC_GAUGE_SUPERVISOR_QUEUE_DEPTH] = "supervisor_q",
+    [METRIC_GAUGE_BREAKER_STATES] = "brk_state",
+    [METRIC_GAUGE_LOCAL_BUFFER_DEPTH] = "buf_q",
+    [METRIC_GAUGE_MQTT_WORK_QUEUE_DEPTH] = "mqtt_q",
+    [METRIC_GAUGE_BOOT_HARDWARE_MS] = "boot_hw_ms",
+    [METRIC_GAUGE_BOOT_SERVICES_MS] = "boot_svc_ms",
+    [METRIC_GAUGE_BOOT_SENSOR_CONFIG_MS] = "boot_cfg_ms",
+    [METRIC_GAUGE_BOOT_SAMPLING_MS] = "boot_smp_ms",
+    [METRIC_GAUGE_BOOT_WIFI_MS] = "boot_wifi_ms",
+    [METRIC_GAUGE_BOOT_TIME_MS] = "boot_time_ms",
+    [METRIC_GAUGE_BOOT_CLOUD_MS] = "boot_cloud_ms",
+    [METRIC_GAUGE_BOOT_TOTAL_MS] = "boot_total_ms",
+    [METRIC_GAUGE_BOOT_FIRST_SAMPLE_MS] = "boot_1st_ms",
+};
+
+static const char *histogram_names[METRIC_HIST_MAX] = {
+    [METRIC_HIST_HTTP_POST_MS] = "http_post_ms",
+    [METRIC_HIST_ERRLOG_POST_MS] = "errlog_post_ms",
+    [METRIC_HIST_TRACE_ENQUEUE_MS] = "tr_enqueue_ms",
+    [METRIC_HIST_TRACE_QUEUE_MS] = "tr_queue_ms",
+    [METRIC_HIST_TRACE_SERIALIZE_MS] = "tr_serialize_ms",
+    [METRIC_HIST_TRACE_SEND_MS] = "tr_send_ms",
+    [METRIC_HIST_TRACE_ACK_MS] = "tr_ack_ms",
+    [METRIC_HIST_TRACE_END_TO_END_MS] = "tr_e2e_ms",
+    [METRIC_HIST_WIFI_CONNECT_FAST_MS] = "wifi_fast_ms",
+    [METRIC_HIST_WIFI_CONNECT_SCAN_MS] = "wifi_scan_ms",
+};
+
+static const char *task_type_names[TASK_TYPE_MAX] = {
+    [TASK_TYPE_INITIAL_CONFIG] = "initial_config",
+    [TASK_TYPE_WIFI] = "wifi",
+    [TASK_TYPE_SENSOR_CONFIG] = "sensor_config",
+    [TASK_TYPE_SENSOR] = "sensor",
+    [TASK_TYPE_HTTP] = "http",
+    [TASK_TYPE_NVS] = "nvs",
+    [TASK_TYPE_MQTT] = "mqtt",
+    [TASK_TYPE_ERROR_LOGGER] = "error_logger",
+};
+
+static uint32_t counters[METRIC_COUNTER_MAX];
+static uint32_t gauges[METRIC_GAUGE_MAX];
+static metrics_histogram_data_t histograms[METRIC_HIST_MAX];
+static QueueHandle_t watched_queues[METRIC_GAUGE_MAX];
+static uint32_t trace_sequence = 0;
+static uint32_t trace_boot_prefix = 0;
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+// Máximo de tareas reportadas en el snapshot
+#define METRICS_MAX_TASKS 20
+
+// Contadores de runtime del snapshot anterior, para calcular uso de CPU por intervalo
+typedef struct
+{
+    UBaseType_t task_number;
+    uint32_t run_time;
+} task_runtime_prev_t;
+
+static TaskStatus_t task_status_buf[METRICS_MAX_TASKS];
+static task_runtime_prev_t task_runtime_prev[METRICS_MAX_TASKS];
+static UBaseType_t task_runtime_prev_count = 0;
+static uint32_t total_runtime_prev = 0;
+#endif
+
+void metrics_counter_add(metric_counter_t counter, uint32_t delta)
+{
+    if (counter >= METRIC_COUNTER_MAX)
+        return;
+    __atomic_fetch_add(&counters[counter], delta, __ATOMIC_RELAXED);
+}
+
+uint32_t metrics_counter_get(metric_counter_t counter)
+{
+    if (counter >= METRIC_COUNTER_MAX)
+        return 0;
+    return __atomic_load_n(&counters[counter], __ATOMIC_RELAXED);
+}
+
+void metrics_gauge_set(metric_gauge_t gauge, uint32_t value)
+{
+    if (gauge >= METRIC_GAUGE_MAX)
+        return;
+    __atomic_store_n(&gauges[gauge], value, __ATOMIC_RELAXED);
+}
+
+void metrics_histogram_record(metric_histogram_t histogram, uint32_t value_ms)
+{
+    if (histogram >= METRIC_HIST_MAX)
+        return;
+
+    metrics_histogram_data_t *h = &histograms[histogram];
+    int bucket = METRICS_HIST_BUCKETS - 1;
+    for (int i = 0; i < METRICS_HIST_BUCKETS - 1; i++)
+    {
+        if (value_ms <= metrics_hist_bounds_ms[i])
+        {
+            bucket = i;
+            break;
+        }
+    }
+
+    __atomic_fetch_add(&h->buckets[bucket], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->sum_ms, value_ms, __ATOMIC_RELAXED);
+
+    uint32_t current_max = __atomic_load_n(&h->max_ms, __ATOMIC_RELAXED);
+    while (value_ms > current_max &&
+           !__atomic_compare_exchange_n(&h->max_ms, &current_max, value_ms, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+        // current_max se actualiza con el valor vigente y se reintenta
+    }
+}
+
+void metrics_watch_queue(metric_gauge_t gauge, QueueHandle_t queue)
+{
+    if (gauge >= METRIC_GAUGE_MAX)
+        return;
+    watched_queues[gauge] = queue;
+}
+
+void metrics_update_system_gauges(void)
+{
+#if !CONFIG_IDF_TARGET_LINUX
+    metrics_gauge_set(METRIC_GAUGE_HEAP_FREE, heap_caps_get_free_size(MALLOC_CAP_DEFAULT));
+    metrics_gauge_set(METRIC_GAUGE_HEAP_MIN_FREE, heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT));
+    metrics_gauge_set(METRIC_GAUGE_HEAP_LARGEST_BLOCK, heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT));
+#endif
+
+    for (int i = 0; i < METRIC_GAUGE_MAX; i++)
+    {
+        if (watched_queues[i] != NULL)
+        {
+            metrics_gauge_set((metric_gauge_t)i, uxQueueMessagesWaiting(watched_queues[i]));
+        }
+    }
+}
+
+void metrics_trace_begin(sample_trace_t *trace)
+{
+    if (trace == NULL)
+        return;
+
+    // El prefijo aleatorio distingue trazas de arranques distintos con la misma secuencia
+    if (trace_boot_prefix == 0)
+    {
+        trace_boot_prefix = (metrics_random() & 0xFFFF0000u) | 0x00010000u;
+    }
+
+    memset(trace, 0, sizeof(*trace));
+    uint32_t seq = __atomic_add_fetch(&trace_sequence, 1, __ATOMIC_RELAXED);
+    trace->trace_id = trace_boot_prefix | (seq & 0xFFFFu);
+    trace->sampled_us = hal_clock_now_us();
+}
+
+// Registrar la duración entre dos etapas si ambas fueron alcanzadas
+static void trace_record_stage(metric_histogram_t histogram, int64_t from_us, int64_t to_us)
+{
+    if (from_us > 0 && to_us >= from_us)
+    {
+        metrics_histogram_record(histogram, (uint32_t)((to_us - from_us) / 1000));
+    }
+}
+
+void metrics_trace_finish(const sample_trace_t *trace)
+{
+    if (trace == NULL)
+        return;
+
+    trace_record_stage(METRIC_HIST_TRACE_ENQUEUE_MS, trace->sampled_us, trace->enqueued_us);
+    trace_record_stage(METRIC_HIST_TRACE_QUEUE_MS, trace->enqueued_us, trace->dequeued_us);
+    trace_record_stage(METRIC_HIST_TRACE_SERIALIZE_MS, trace->dequeued_us, trace->serialized_us);
+    trace_record_stage(METRIC_HIST_TRACE_SEND_MS, trace->serialized_us, trace->sent_us);
+    trace_record_stage(METRIC_HIST_TRACE_ACK_MS, trace->sent_us, trace->acked_us);
+    trace_record_stage(METRIC_HIST_TRACE_END_TO_END_MS, trace->sampled_us, trace->acked_us);
+}
+
+// Escritor acumulativo sobre el buffer del snapshot
+typedef struct
+{
+    char *buf;
+    size_t len;
+    size_t pos;
+    bool overflow;
+} json_writer_t;
+
+static void jw_append(json_writer_t *w, const char *fmt, ...)
+{
+    if (w->overflow)
+        return;
+
+    va_list args;
+    va_start(args, fmt);
+    int written = vsnprintf(w->buf + w->pos, w->len - w->pos, fmt, args);
+    va_end(args);
+
+    if (written < 0 || (size_t)written >= w->len - w->pos)
+    {
+        w->overflow = true;
+        return;
+    }
+    w->pos += written;
+}
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+static uint32_t task_runtime_delta(UBaseType_t task_number, uint32_t run_time)
+{
+    for (UBaseType_t i = 0; i < task_runtime_prev_count; i++)
+    {
+        if (task_runtime_prev[i].task_number == task_number)
+        {
+            return run_time - task_runtime_prev[i].run_time;
+        }
+    }
+    return run_time; // Tarea nueva desde el último snapshot
+}
+
+static void append_task_stats(json_writer_t *w)
+{
+    uint32_t total_runtime = 0;
+    UBaseType_t task_count = uxTaskGetSystemState(task_status_buf, METRICS_MAX_TASKS, &total_runtime);
+    if (task_count == 0)
+    {
+        // El buffer no alcanza para todas las tareas: se omite la sección
+        ESP_LOGW(TAG, "⚠️ Más de %d tareas, se omite CPU por tarea", METRICS_MAX_TASKS);
+        return;
+    }
+
+    uint32_t total_delta = total_runtime - total_runtime_prev;
+
+    jw_append(w, ",\"tasks\":{");
+    for (UBaseType_t i = 0; i < task_count; i++)
+    {
+        TaskStatus_t *t = &task_status_buf[i];
+        uint32_t delta = task_runtime_delta(t->xTaskNumber, t->ulRunTimeCounter);
+        // Uso de CPU en décimas de porcentaje durante el último intervalo
+        uint32_t cpu_permille = total_delta > 0 ? (uint32_t)(((uint64_t)delta * 1000) / total_delta) : 0;
+        jw_append(w, "%s\"%s\":[%lu,%lu]", i ? "," : "", t->pcTaskName,
+                  (unsigned long)cpu_permille, (unsigned long)t->usStackHighWaterMark);
+    }
+    jw_append(w, "}");
+
+    for (UBaseType_t i = 0; i < task_count; i++)
+    {
+        task_runtime_prev[i].task_number = task_status_buf[i].xTaskNumber;
+        task_runtime_prev[i].run_time = task_status_buf[i].ulRunTimeCounter;
+    }
+    task_runtime_prev_count = task_count;
+    total_runtime_prev = total_runtime;
+}
+#endif
+
+static void append_watchdog_stats(json_writer_t *w)
+{
+    bool first = true;
+    jw_append(w, ",\"wdt\":{");
+    for (int i = 0; i < TASK_TYPE_MAX; i++)
+    {
+        task_watchdog_stats_t stats;
+        task_watchdog_get_stats((task_type_t)i, &stats);
+        if (!stats.monitored && stats.stall_count == 0)
+            continue;
+
+        // [edad última alimentación, bloqueos, reinicios, peor recuperación]
+        jw_append(w, "%s\"%s\":[%lu,%lu,%lu,%lu]", first ? "" : ",", task_type_names[i],
+                  (unsigned long)stats.last_feed_age_ms, (unsigned long)stats.stall_count,
+                  (unsigned long)stats.restart_count, (unsigned long)stats.max_recovery_ms);
+        first = false;
+    }
+    jw_append(w, "}");
+}
+
+int metrics_build_snapshot_json(char *buffer, size_t buffer_len)
+{
+    if (buffer == NULL || buffer_len == 0)
+        return -1;
+
+    json_writer_t w = {.buf = buffer, .len = buffer_len, .pos = 0, .overflow = false};
+
+    metrics_update_system_gauges();
+
+    jw_append(&w, "{\"uptime_s\":%lu,", (unsigned long)(hal_clock_now_us() / 1000000));
+    int64_t epoch_ms = time_service_now_epoch_ms();
+    if (epoch_ms > 0)
+    {
+        jw_append(&w, "\"timestamp\":%lld,", (long long)epoch_ms);
+    }
+    jw_append(&w, "\"c\":{");
+    for (int i = 0; i < METRIC_COUNTER_MAX; i++)
+    {
+        jw_append(&w, "%s\"%s\":%lu", i ? "," : "", counter_names[i],
+                  (unsigned long)metrics_counter_get((metric_counter_t)i));
+    }
+
+    jw_append(&w, "},\"g\":{");
+    for (int i = 0; i < METRIC_GAUGE_MAX; i++)
+    {
+        jw_append(&w, "%s\"%s\":%lu", i ? "," : "", gauge_names[i],
+                  (unsigned long)__atomic_load_n(&gauges[i], __ATOMIC_RELAXED));
+    }
+
+    // Histogramas: {"n":count,"sum":ms,"max":ms,"b":[buckets...]}
+    jw_append(&w, "},\"h\":{");
+    for (int i = 0; i < METRIC_HIST_MAX; i++)
+    {
+        metrics_histogram_data_t *h = &histograms[i];
+        jw_append(&w, "%s\"%s\":{\"n\":%lu,\"sum\":%lu,\"max\":%lu,\"b\":[", i ? "," : "", histogram_names[i],
+                  (unsigned long)__atomic_load_n(&h->count, __ATOMIC_RELAXED),
+                  (unsigned long)__atomic_load_n(&h->sum_ms, __ATOMIC_RELAXED),
+                  (unsigned long)__atomic_load_n(&h->max_ms, __ATOMIC_RELAXED));
+        for (int b = 0; b < METRICS_HIST_BUCKETS; b++)
+        {
+            jw_append(&w, "%s%lu", b ? "," : "",
+                      (unsigned long)__atomic_load_n(&h->buckets[b], __ATOMIC_RELAXED));
+        }
+        jw_append(&w, "]}");
+    }
+    jw_append(&w, "}");
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    append_task_stats(&w);
+#endif
+    append_watchdog_stats(&w);
+    jw_append(&w, "}");
+
+    if (w.overflow)
+    {
+        ESP_LOGW(TAG, "⚠️ Snapshot de métricas excede %u bytes", (unsigned)buffer_len);
+        return -1;
+    }
+    return (int)w.pos;
+}
@@ -0,0 +1,181 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "esp_err.h"
+#include "hal_clock.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// Contadores monotónicos (solo se incrementan)
+typedef enum {
+    METRIC_HTTP_POSTS_OK,
+    METRIC_HTTP_POSTS_FAILED,
+    METRIC_SENSOR_SAMPLES,
+    METRIC_SENSOR_READ_ERRORS,
+    METRIC_SENSOR_QUEUE_DROPS,       // Lecturas descartadas por cola de sensores llena
+    METRIC_ERRLOG_SENT,
+    METRIC_ERRLOG_FAILED,
+    METRIC_ERRLOG_DUPLICATES,
+    METRIC_ERRLOG_DROPS,             // Errores perdidos por cola llena (principal o reintentos)
+    METRIC_MQTT_MESSAGES_RX,
+    METRIC_MQTT_DISCONNECTS,
+    METRIC_PACING_DEFERRED,          // Peticiones HTTP diferidas por el token bucket (pacing.c)
+    // Circuit breakers (circuit_breaker.c), sumados sobre todos los endpoints
+    METRIC_BREAKER_OPENED,           // Transiciones a abierto
+    METRIC_BREAKER_HALF_OPENED,      // Transiciones a medio abierto
+    METRIC_BREAKER_CLOSED,           // Transiciones a cerrado (recuperación)
+    METRIC_BREAKER_REJECTED,         // Peticiones rechazadas sin tocar la red
+    METRIC_BREAKER_SLOW_CALLS,       // Respuestas 2xx por encima de BREAKER_SLOW_CALL_MS
+    // Buffer local de lecturas no enviadas (task_http.c)
+    METRIC_LOCAL_BUFFERED,
+    METRIC_LOCAL_BUFFER_DROPS,       // Lecturas más antiguas descartadas con el buffer lleno
+    METRIC_LOCAL_BUFFER_SENT,
+    // Tiempo de la tarea HTTP con peticiones en curso (ms acumulados): en vuelo
+    // frente a bloqueada dentro de hal_http. Con el POST no bloqueante la
+    // diferencia es tiempo en que la tarea siguió atendiendo la cola.
+    METRIC_HTTP_INFLIGHT_MS,
+    METRIC_HTTP_BLOCKED_MS,
+    // Base de tiempo (time_service.c)
+    METRIC_TIME_SYNCS,               // Sincronizaciones SNTP exitosas
+    METRIC_TIME_STEPS,               // Saltos de la hora del servidor (deriva descartada)
+    // Cuerpos de POST /process-data y /error-logs (http_compress.c)
+    METRIC_HTTP_BODY_RAW_BYTES,      // Bytes del JSON original
+    METRIC_HTTP_BODY_SENT_BYTES,     // Bytes efectivamente enviados (comprimidos o no)
+    METRIC_HTTP_COMPRESS_IN_BYTES,   // Bytes que pasaron por el compresor
+    METRIC_HTTP_COMPRESS_US,         // Tiempo de CPU comprimiendo (µs acumulados)
+    // Configuración de sensores (config_sync.c)
+    METRIC_CONFIG_SYNC_UPDATED,      // Respuestas 200: configuración nueva aplicada
+    METRIC_CONFIG_SYNC_NOT_MODIFIED, // Respuestas 304: sin cambios, sin parsear ni escribir NVS
+    // Almacén de configuración en NVS (config_store.c)
+    METRIC_CONFIG_STORE_WRITES,      // Blobs escritos en flash
+    METRIC_CONFIG_STORE_COMMITS,     // Commits (uno por ventana de debounce)
+    METRIC_CONFIG_STORE_UNCHANGED,   // Guardados descartados: igual a lo guardado o pendiente
+    METRIC_CONFIG_STORE_COALESCED,   // Guardados que reemplazaron a uno pendiente sin escribir
+    // Manejador de eventos MQTT y su worker (task_mqtt.c)
+    METRIC_MQTT_HANDLER_CALLS,       // Eventos atendidos en la tarea de esp-mqtt
+    METRIC_MQTT_HANDLER_US,          // Tiempo dentro del manejador (µs acumulados)
+    METRIC_MQTT_WORKER_US,           // Tiempo del worker aplicando mensajes (µs acumulados)
+    METRIC_MQTT_WORK_DROPS,          // Mensajes descartados con el pool lleno
+    METRIC_WIFI_FAST_FALLBACKS,      // Conexiones directas al último AP que terminaron en escaneo
+    METRIC_WIFI_DISCONNECTS,         // Cortes de WiFi estando conectado
+    METRIC_COUNTER_MAX
+} metric_counter_t;
+
+// Gauges (último valor observado)
+typedef enum {
+    METRIC_GAUGE_HEAP_FREE,
+    METRIC_GAUGE_HEAP_MIN_FREE,
+    METRIC_GAUGE_HEAP_LARGEST_BLOCK,
+    METRIC_GAUGE_SENSOR_QUEUE_DEPTH,
+    METRIC_GAUGE_ERROR_QUEUE_DEPTH,
+    METRIC_GAUGE_SUPERVISOR_QUEUE_DEPTH,
+    METRIC_GAUGE_BREAKER_STATES,     // 2 bits por endpoint (breaker_state_t), ver circuit_breaker.h
+    METRIC_GAUGE_LOCAL_BUFFER_DEPTH,
+    METRIC_GAUGE_MQTT_WORK_QUEUE_DEPTH,
+    // Arranque (task_main.c): duración de cada etapa en ms, de que arranca a que termina
+    METRIC_GAUGE_BOOT_HARDWARE_MS,
+    METRIC_GAUGE_BOOT_SERVICES_MS,
+    METRIC_GAUGE_BOOT_SENSOR_CONFIG_MS,
+    METRIC_GAUGE_BOOT_SAMPLING_MS,
+    METRIC_GAUGE_BOOT_WIFI_MS,
+    METRIC_GAUGE_BOOT_TIME_MS,
+    METRIC_GAUGE_BOOT_CLOUD_MS,
+    METRIC_GAUGE_BOOT_TOTAL_MS,          // Desde el arranque hasta la última etapa
+    METRIC_GAUGE_BOOT_FIRST_SAMPLE_MS,   // Desde el arranque hasta la primera trama muestreada
+    METRIC_GAUGE_MAX
+} metric_gauge_t;
+
+// Histogramas de buckets fijos (valores en ms)
+typedef enum {
+    METRIC_HIST_HTTP_POST_MS,        // Latencia de POST /process-data
+    METRIC_HIST_ERRLOG_POST_MS,      // Latencia de POST /error-logs
+    // Etapas de la traza de cada muestra (ver sample_trace_t)
+    METRIC_HIST_TRACE_ENQUEUE_MS,    // muestreada -> encolada
+    METRIC_HIST_TRACE_QUEUE_MS,      // encolada -> desencolada por HTTP
+    METRIC_HIST_TRACE_SERIALIZE_MS,  // desencolada -> JSON listo
+    METRIC_HIST_TRACE_SEND_MS,       // JSON listo -> petición enviada (conexión + TLS)
+    METRIC_HIST_TRACE_ACK_MS,        // petición enviada -> respuesta 2xx
+    METRIC_HIST_TRACE_END_TO_END_MS, // muestreada -> respuesta 2xx (frescura en el backend)
+    // Conexión WiFi hasta tener IP, por camino (task_wifi.c)
+    METRIC_HIST_WIFI_CONNECT_FAST_MS,   // Directo al último AP (BSSID + canal)
+    METRIC_HIST_WIFI_CONNECT_SCAN_MS,   // Escaneo completo
+    METRIC_HIST_MAX
+} metric_histogram_t;
+
+// Contexto de traza de una muestra: instante de cada etapa en µs desde el arranque
+// (hal_clock). Una etapa en 0 significa que la muestra no llegó a ella.
+typedef struct {
+    uint32_t trace_id;       // Aleatorio por arranque (16 bits altos) + secuencia
+    int64_t sampled_us;
+    int64_t enqueued_us;
+    int64_t dequeued_us;
+    int64_t serialized_us;
+    int64_t sent_us;
+    int64_t acked_us;
+} sample_trace_t;
+
+// Límites superiores de los buckets (el último bucket es "mayor que el último límite")
+#define METRICS_HIST_BUCKETS 10
+extern const uint32_t metrics_hist_bounds_ms[METRICS_HIST_BUCKETS - 1];
+
+/**
+ * @brief Incrementar un contador (seguro desde cualquier tarea, sin mutex)
+ */
+void metrics_counter_add(metric_counter_t counter, uint32_t delta);
+#define metrics_counter_inc(counter) metrics_counter_add((counter), 1)
+
+/**
+ * @brief Leer el valor actual de un contador
+ */
+uint32_t metrics_counter_get(metric_counter_t counter);
+
+/**
+ * @brief Fijar el valor de un gauge
+ */
+void metrics_gauge_set(metric_gauge_t gauge, uint32_t value);
+
+/**
+ * @brief Registrar una observación en un histograma
+ */
+void metrics_histogram_record(metric_histogram_t histogram, uint32_t value_ms);
+
+/**
+ * @brief Asociar una cola a un gauge de profundidad (se muestrea al generar el snapshot)
+ */
+void metrics_watch_queue(metric_gauge_t gauge, QueueHandle_t queue);
+
+/**
+ * @brief Actualizar gauges del sistema (heap y profundidad de colas observadas)
+ */
+void metrics_update_system_gauges(void);
+
+/**
+ * @brief Iniciar la traza de una muestra (asigna id y marca el instante de muestreo)
+ */
+void metrics_trace_begin(sample_trace_t *trace);
+
+/**
+ * @brief Marcar el instante actual en una etapa de la traza
+ */
+#define metrics_trace_mark(stage_us) ((stage_us) = hal_clock_now_us())
+
+/**
+ * @brief Registrar en los histogramas las etapas completas de una traza
+ */
+void metrics_trace_finish(const sample_trace_t *trace);
+
+/**
+ * @brief Generar un snapshot compacto en JSON de todas las métricas
+ *
+ * Incluye contadores, gauges, histogramas, CPU y stack por tarea y
+ * estadísticas del watchdog de tareas.
+ *
+ * @param buffer Buffer de salida
+ * @param buffer_len Tamaño del buffer
+ * @return Longitud escrita, o -1 si el buffer no alcanza
+ */
+int metrics_build_snapshot_json(char *buffer, size_t buffer_len);
+
+#endif // METRICS_H
@@ -0,0 +1,217 @@
+#include "net_config.h"
+#include "hal_nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "NET_CONFIG";
+
+#define NET_CONFIG_NAMESPACE "wifi"         // Mismo namespace que SSID y password
+#define NET_CONFIG_VERSION 1
+
+// Formatos en flash: si cambian, subir NET_CONFIG_VERSION (el blob viejo se descarta)
+typedef struct {
+    uint8_t version;
+    uint8_t channel;
+    uint8_t bssid[6];
+} ap_cache_blob_t;
+
+typedef struct {
+    uint8_t version;
+    uint8_t enabled;
+    uint16_t reserved;
+    uint32_t ip;
+    uint32_t netmask;
+    uint32_t gateway;
+    uint32_t dns;
+} static_ip_blob_t;
+
+_Static_assert(sizeof(ap_cache_blob_t) == 8, "ap_cache_blob_t no debe tener relleno");
+_Static_assert(sizeof(static_ip_blob_t) == 20, "static_ip_blob_t no debe tener relleno");
+
+static SemaphoreHandle_t net_mutex = NULL;
+static bool nvs_ready = false;
+static bool ap_cache_valid = false;
+static ap_cache_blob_t ap_cache;
+static static_ip_blob_t static_ip;
+
+static void net_lock(void)
+{
+    if (net_mutex != NULL) {
+        xSemaphoreTake(net_mutex, portMAX_DELAY);
+    }
+}
+
+static void net_unlock(void)
+{
+    if (net_mutex != NULL) {
+        xSemaphoreGive(net_mutex);
+    }
+}
+
+static esp_err_t blob_read(hal_nvs_handle_t handle, const char *key, void *blob, size_t size)
+{
+    size_t length = size;
+    esp_err_t err = hal_nvs_get_blob(handle, key, blob, &length);
+    if (err == ESP_OK && (length != size || *(const uint8_t *)blob != NET_CONFIG_VERSION)) {
+        ESP_LOGW(TAG, "⚠️ %s con formato desconocido, se ignora", key);
+        err = ESP_ERR_INVALID_VERSION;
+    }
+    return err;
+}
+
+// Una escritura y un commit por cambio: solo pasa al cambiar de AP o de IP
+static esp_err_t blob_write(const char *key, const void *blob, size_t size)
+{
+    if (!nvs_ready) {
+        return ESP_OK;
+    }
+    hal_nvs_handle_t handle;
+    esp_err_t err = hal_nvs_open(NET_CONFIG_NAMESPACE, true, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = hal_nvs_set_blob(handle, key, blob, size);
+    if (err == ESP_OK) {
+        err = hal_nvs_commit(handle);
+    }
+    hal_nvs_close(handle);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "⚠️ No se pudo guardar %s: %s", key, esp_err_to_name(err));
+    }
+    return err;
+}
+
+esp_err_t net_config_init(void)
+{
+    if (net_mutex == NULL) {
+        net_mutex = xSemaphoreCreateMutex();
+        if (net_mutex == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    hal_nvs_handle_t handle;
+    esp_err_t err = hal_nvs_open(NET_CONFIG_NAMESPACE, true, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "⚠️ No se pudo abrir NVS: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    net_lock();
+    nvs_ready = true;
+    ap_cache_valid = blob_read(handle, "ap_cache", &ap_cache, sizeof(ap_cache)) == ESP_OK;
+    if (blob_read(handle, "static_ip", &static_ip, sizeof(static_ip)) != ESP_OK) {
+        memset(&static_ip, 0, sizeof(static_ip));
+    }
+    if (ap_cache_valid) {
+        ESP_LOGI(TAG, "📶 Último AP: %02x:%02x:%02x:%02x:%02x:%02x canal %u",
+                 ap_cache.bssid[0], ap_cache.bssid[1], ap_cache.bssid[2],
+                 ap_cache.bssid[3], ap_cache.bssid[4], ap_cache.bssid[5], ap_cache.channel);
+    }
+    if (static_ip.enabled) {
+        const uint8_t *ip = (const uint8_t *)&static_ip.ip;
+        ESP_LOGI(TAG, "🌐 IP estática %u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+    }
+    net_unlock();
+
+    hal_nvs_close(handle);
+    return ESP_OK;
+}
+
+bool net_config_get_static_ip(net_static_ip_t *out)
+{
+    net_lock();
+    out->enabled = static_ip.enabled != 0;
+    out->ip = static_ip.ip;
+    out->netmask = static_ip.netmask;
+    out->gateway = static_ip.gateway;
+    out->dns = static_ip.dns;
+    net_unlock();
+    return out->enabled;
+}
+
+// "a.b.c.d" a orden de red (el primer octeto en el byte más bajo)
+static bool parse_ip4(const cJSON *item, uint32_t *out)
+{
+    unsigned int a, b, c, d;
+    char extra;
+    if (!cJSON_IsString(item) ||
+        sscanf(item->valuestring, "%u.%u.%u.%u%c", &a, &b, &c, &d, &extra) != 4 ||
+        a > 255 || b > 255 || c > 255 || d > 255) {
+        return false;
+    }
+    *out = (uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24);
+    return true;
+}
+
+esp_err_t net_config_apply_json(const cJSON *object)
+{
+    if (!cJSON_IsObject(object)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    static_ip_blob_t new_ip = {.version = NET_CONFIG_VERSION};
+    const cJSON *ip_item = cJSON_GetObjectItem(object, "static_ip");
+    if (cJSON_IsNull(ip_item)) {
+        new_ip.enabled = 0;
+    } else if (parse_ip4(ip_item, &new_ip.ip) &&
+               parse_ip4(cJSON_GetObjectItem(object, "netmask"), &new_ip.netmask) &&
+               parse_ip4(cJSON_GetObjectItem(object, "gateway"), &new_ip.gateway)) {
+        new_ip.enabled = 1;
+        const cJSON *dns_item = cJSON_GetObjectItem(object, "dns");
+        if (dns_item != NULL && !parse_ip4(dns_item, &new_ip.dns)) {
+            ESP_LOGW(TAG, "⚠️ DNS inválido, se rechaza la configuración de red");
+            return ESP_ERR_INVALID_ARG;
+        }
+    } else {
+        ESP_LOGW(TAG, "⚠️ Configuración de red inválida (static_ip, netmask y gateway como \"a.b.c.d\")");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    net_lock();
+    bool changed = memcmp(&new_ip, &static_ip, sizeof(new_ip)) != 0;
+    esp_err_t err = ESP_OK;
+    if (changed) {
+        static_ip = new_ip;
+        err = blob_write("static_ip", &static_ip, sizeof(static_ip));
+    }
+    net_unlock();
+
+    if (changed) {
+        ESP_LOGI(TAG, "🌐 %s: se usa desde la próxima conexión WiFi",
+                 new_ip.enabled ? "IP estática configurada" : "Vuelta a DHCP");
+    }
+    return err;
+}
+
+bool net_config_get_ap_cache(net_ap_cache_t *out)
+{
+    net_lock();
+    bool valid = ap_cache_valid;
+    if (valid) {
+        memcpy(out->bssid, ap_cache.bssid, sizeof(out->bssid));
+        out->channel = ap_cache.channel;
+    }
+    net_unlock();
+    return valid;
+}
+
+esp_err_t net_config_save_ap_cache(const net_ap_cache_t *cache)
+{
+    ap_cache_blob_t blob = {.version = NET_CONFIG_VERSION, .channel = cache->channel};
+    memcpy(blob.bssid, cache->bssid, sizeof(blob.bssid));
+
+    net_lock();
+    esp_err_t err = ESP_OK;
+    if (!ap_cache_valid || memcmp(&blob, &ap_cache, sizeof(blob)) != 0) {
+        ap_cache = blob;
+        ap_cache_valid = true;
+        err = blob_write("ap_cache", &ap_cache, sizeof(ap_cache));
+        ESP_LOGI(TAG, "📶 AP recordado: canal %u", blob.channel);
+    }
+    net_unlock();
+    return err;
+}
@@ -0,0 +1,63 @@
+#ifndef NET_CONFIG_H
+#define NET_CONFIG_H
+
+#include "esp_err.h"
+#include "cJSON.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Datos de red persistidos para acortar la conexión WiFi (namespace "wifi"):
+// - el último AP al que se conectó (BSSID y canal), para conectar directo sin
+//   escanear todos los canales;
+// - una IP estática opcional, configurable por MQTT, para no esperar DHCP.
+// task_wifi.c los lee antes de cada conexión; sin init todo queda en RAM.
+
+// Direcciones IPv4 en orden de red, igual que esp_ip4_addr_t.addr
+typedef struct {
+    bool enabled;               // false = DHCP
+    uint32_t ip;
+    uint32_t netmask;
+    uint32_t gateway;
+    uint32_t dns;               // 0 = el gateway
+} net_static_ip_t;
+
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t channel;
+} net_ap_cache_t;
+
+/**
+ * @brief Crear el mutex y leer de NVS la IP estática y el último AP
+ */
+esp_err_t net_config_init(void);
+
+/**
+ * @brief IP estática vigente
+ *
+ * @return true si hay IP estática configurada (out->enabled)
+ */
+bool net_config_get_static_ip(net_static_ip_t *out);
+
+/**
+ * @brief Aplicar el objeto "network" del mensaje de configuración MQTT
+ *
+ * Campos: static_ip, netmask, gateway, dns (texto "a.b.c.d"). static_ip null
+ * vuelve a DHCP. Se guarda en NVS y se usa desde la próxima conexión.
+ *
+ * @return ESP_ERR_INVALID_ARG si falta algún campo o una dirección no es válida
+ */
+esp_err_t net_config_apply_json(const cJSON *object);
+
+/**
+ * @brief Último AP al que se conectó
+ *
+ * @return false si no hay ninguno guardado
+ */
+bool net_config_get_ap_cache(net_ap_cache_t *out);
+
+/**
+ * @brief Recordar el AP actual (solo escribe NVS si cambió)
+ */
+esp_err_t net_config_save_ap_cache(const net_ap_cache_t *cache);
+
+#endif // NET_CONFIG_H
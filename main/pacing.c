@@ -0,0 +1,296 @@
+#include "pacing.h"
+#include "config.h"
+#include "metrics.h"
+#include "hal_clock.h"
+#include "config_bus.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "PACING";
+
+static pacing_config_t config = {
+    .phase_offset_enabled = PACING_PHASE_OFFSET_ENABLED,
+    .rate_per_min = PACING_RATE_PER_MIN,
+    .burst = PACING_BURST,
+    .backoff_base_ms = {
+        [PACING_CHANNEL_HTTP] = PACING_HTTP_BACKOFF_BASE_MS,
+        [PACING_CHANNEL_WIFI] = PACING_WIFI_BACKOFF_BASE_MS,
+        [PACING_CHANNEL_MQTT] = PACING_MQTT_BACKOFF_BASE_MS,
+    },
+    .backoff_cap_ms = {
+        [PACING_CHANNEL_HTTP] = PACING_HTTP_BACKOFF_CAP_MS,
+        [PACING_CHANNEL_WIFI] = PACING_WIFI_BACKOFF_CAP_MS,
+        [PACING_CHANNEL_MQTT] = PACING_MQTT_BACKOFF_CAP_MS,
+    },
+};
+
+static const char *channel_names[PACING_CHANNEL_MAX] = {
+    [PACING_CHANNEL_HTTP] = "http",
+    [PACING_CHANNEL_WIFI] = "wifi",
+    [PACING_CHANNEL_MQTT] = "mqtt",
+};
+
+static SemaphoreHandle_t pacing_mutex = NULL;
+static uint32_t device_hash = 0;
+static uint32_t rng_state = 1;
+static uint32_t last_backoff_ms[PACING_CHANNEL_MAX];     // 0 = sin fallos pendientes
+
+// Token bucket en milésimas de token para no perder la fracción entre recargas
+static uint32_t bucket_milli_tokens = PACING_BURST * 1000;
+static uint32_t bucket_refill_ms = 0;
+
+static void pacing_lock(void)
+{
+    if (pacing_mutex != NULL) {
+        xSemaphoreTake(pacing_mutex, portMAX_DELAY);
+    }
+}
+
+static void pacing_unlock(void)
+{
+    if (pacing_mutex != NULL) {
+        xSemaphoreGive(pacing_mutex);
+    }
+}
+
+// FNV-1a de 32 bits
+static uint32_t fnv1a(const uint8_t *data, size_t len, uint32_t hash)
+{
+    for (size_t i = 0; i < len; i++) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// xorshift32: suficiente para jitter, sin depender del RNG de hardware
+static uint32_t next_random(void)
+{
+    uint32_t x = rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    rng_state = x;
+    return x;
+}
+
+esp_err_t pacing_init(const uint8_t mac[6])
+{
+    if (mac == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (pacing_mutex == NULL) {
+        pacing_mutex = xSemaphoreCreateMutex();
+        if (pacing_mutex == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    pacing_lock();
+    device_hash = fnv1a(mac, 6, 2166136261u);
+    rng_state = device_hash ? device_hash : 1;
+    memset(last_backoff_ms, 0, sizeof(last_backoff_ms));
+    bucket_milli_tokens = config.burst * 1000;
+    bucket_refill_ms = hal_clock_now_ms();
+    pacing_unlock();
+
+    ESP_LOGI(TAG, "⏱️ Pacing listo (MAC %02x:%02x:%02x:%02x:%02x:%02x, %lu req/min, ráfaga %lu)",
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5],
+             (unsigned long)config.rate_per_min, (unsigned long)config.burst);
+    return ESP_OK;
+}
+
+void pacing_get_config(pacing_config_t *out_config)
+{
+    if (out_config == NULL) {
+        return;
+    }
+    pacing_lock();
+    *out_config = config;
+    pacing_unlock();
+}
+
+esp_err_t pacing_set_config(const pacing_config_t *new_config)
+{
+    if (new_config == NULL || new_config->burst == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < PACING_CHANNEL_MAX; i++) {
+        if (new_config->backoff_base_ms[i] == 0 ||
+            new_config->backoff_cap_ms[i] < new_config->backoff_base_ms[i]) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    pacing_lock();
+    config = *new_config;
+    uint32_t burst_milli = config.burst * 1000;
+    if (bucket_milli_tokens > burst_milli) {
+        bucket_milli_tokens = burst_milli;
+    }
+    pacing_unlock();
+
+    ESP_LOGI(TAG, "🔧 Pacing actualizado: fase=%s, %lu req/min, ráfaga %lu, backoff http %lu-%lu ms, "
+             "wifi %lu-%lu ms, mqtt %lu-%lu ms",
+             config.phase_offset_enabled ? "sí" : "no",
+             (unsigned long)config.rate_per_min, (unsigned long)config.burst,
+             (unsigned long)config.backoff_base_ms[PACING_CHANNEL_HTTP],
+             (unsigned long)config.backoff_cap_ms[PACING_CHANNEL_HTTP],
+             (unsigned long)config.backoff_base_ms[PACING_CHANNEL_WIFI],
+             (unsigned long)config.backoff_cap_ms[PACING_CHANNEL_WIFI],
+             (unsigned long)config.backoff_base_ms[PACING_CHANNEL_MQTT],
+             (unsigned long)config.backoff_cap_ms[PACING_CHANNEL_MQTT]);
+    config_bus_publish(CONFIG_KEY_PACING);
+    return ESP_OK;
+}
+
+esp_err_t pacing_apply_json(const cJSON *object)
+{
+    if (!cJSON_IsObject(object)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pacing_config_t new_config;
+    pacing_get_config(&new_config);
+
+    const cJSON *item = cJSON_GetObjectItem(object, "phase_offset");
+    if (cJSON_IsBool(item)) {
+        new_config.phase_offset_enabled = cJSON_IsTrue(item);
+    }
+    item = cJSON_GetObjectItem(object, "rate_per_min");
+    if (cJSON_IsNumber(item) && item->valuedouble >= 0) {
+        new_config.rate_per_min = (uint32_t)item->valuedouble;
+    }
+    item = cJSON_GetObjectItem(object, "burst");
+    if (cJSON_IsNumber(item) && item->valuedouble >= 0) {
+        new_config.burst = (uint32_t)item->valuedouble;
+    }
+
+    for (int i = 0; i < PACING_CHANNEL_MAX; i++) {
+        char key[32];
+        snprintf(key, sizeof(key), "%s_backoff_base_ms", channel_names[i]);
+        item = cJSON_GetObjectItem(object, key);
+        if (cJSON_IsNumber(item) && item->valuedouble >= 0) {
+            new_config.backoff_base_ms[i] = (uint32_t)item->valuedouble;
+        }
+        snprintf(key, sizeof(key), "%s_backoff_cap_ms", channel_names[i]);
+        item = cJSON_GetObjectItem(object, key);
+        if (cJSON_IsNumber(item) && item->valuedouble >= 0) {
+            new_config.backoff_cap_ms[i] = (uint32_t)item->valuedouble;
+        }
+    }
+
+    esp_err_t err = pacing_set_config(&new_config);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "⚠️ Configuración de pacing rechazada (tope menor que base o ráfaga 0)");
+    }
+    return err;
+}
+
+uint32_t pacing_phase_offset_ms(uint32_t interval_ms, uint32_t salt)
+{
+    if (!config.phase_offset_enabled || interval_ms == 0) {
+        return 0;
+    }
+    uint8_t salt_bytes[4] = {
+        (uint8_t)salt, (uint8_t)(salt >> 8), (uint8_t)(salt >> 16), (uint8_t)(salt >> 24),
+    };
+    uint32_t hash = fnv1a(salt_bytes, sizeof(salt_bytes), device_hash);
+    return hash % interval_ms;
+}
+
+// Jitter decorrelado: azar(base, 3 * anterior), acotado al tope. Cada
+// dispositivo se aleja de los demás en cada reintento en lugar de
+// converger a los mismos escalones fijos. Requiere pacing_lock().
+static uint32_t decorrelated_ms_locked(pacing_channel_t channel, uint32_t previous_ms)
+{
+    uint32_t base = config.backoff_base_ms[channel];
+    uint32_t cap = config.backoff_cap_ms[channel];
+    uint32_t previous = previous_ms ? previous_ms : base;
+
+    uint64_t upper = (uint64_t)previous * 3;
+    if (upper > cap) {
+        upper = cap;
+    }
+    uint32_t wait_ms = base;
+    if (upper > base) {
+        wait_ms = base + next_random() % (uint32_t)(upper - base + 1);
+    }
+    return wait_ms;
+}
+
+uint32_t pacing_next_backoff_ms(pacing_channel_t channel)
+{
+    if (channel >= PACING_CHANNEL_MAX) {
+        return 0;
+    }
+
+    pacing_lock();
+    uint32_t wait_ms = decorrelated_ms_locked(channel, last_backoff_ms[channel]);
+    last_backoff_ms[channel] = wait_ms;
+    pacing_unlock();
+
+    ESP_LOGD(TAG, "Backoff %s: %lu ms", channel_names[channel], (unsigned long)wait_ms);
+    return wait_ms;
+}
+
+uint32_t pacing_backoff_after_ms(pacing_channel_t channel, uint32_t previous_ms)
+{
+    if (channel >= PACING_CHANNEL_MAX) {
+        return 0;
+    }
+    pacing_lock();
+    uint32_t wait_ms = decorrelated_ms_locked(channel, previous_ms);
+    pacing_unlock();
+    return wait_ms;
+}
+
+void pacing_reset_backoff(pacing_channel_t channel)
+{
+    if (channel >= PACING_CHANNEL_MAX) {
+        return;
+    }
+    pacing_lock();
+    last_backoff_ms[channel] = 0;
+    pacing_unlock();
+}
+
+bool pacing_try_acquire(void)
+{
+    pacing_lock();
+    if (config.rate_per_min == 0) {
+        pacing_unlock();
+        return true;
+    }
+
+    // Recargar rate_per_min tokens por minuto = rate_per_min milésimas por 60 ms
+    uint32_t now_ms = hal_clock_now_ms();
+    uint32_t elapsed_ms = now_ms - bucket_refill_ms;
+    uint64_t refill = (uint64_t)elapsed_ms * config.rate_per_min / 60;
+    uint32_t burst_milli = config.burst * 1000;
+    if (refill > 0) {
+        uint64_t tokens = bucket_milli_tokens + refill;
+        if (tokens >= burst_milli) {
+            bucket_milli_tokens = burst_milli;
+            bucket_refill_ms = now_ms;
+        } else {
+            // Avanzar solo el tiempo ya convertido en tokens (conserva el resto)
+            bucket_milli_tokens = (uint32_t)tokens;
+            bucket_refill_ms += (uint32_t)(refill * 60 / config.rate_per_min);
+        }
+    }
+
+    bool granted = bucket_milli_tokens >= 1000;
+    if (granted) {
+        bucket_milli_tokens -= 1000;
+    }
+    pacing_unlock();
+
+    if (!granted) {
+        metrics_counter_inc(METRIC_PACING_DEFERRED);
+    }
+    return granted;
+}
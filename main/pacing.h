@@ -0,0 +1,102 @@
+#ifndef PACING_H
+#define PACING_H
+
+#include "esp_err.h"
+#include "cJSON.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Espaciado de la carga que el dispositivo genera sobre el backend: offset de
+// fase fijo por dispositivo, backoff con jitter decorrelado para reconexiones
+// y un token bucket de peticiones HTTP por minuto. Los valores por defecto
+// están en config.h (PACING_*).
+
+typedef enum {
+    PACING_CHANNEL_HTTP,     // Tiempo abierto de los circuit breakers HTTP
+    PACING_CHANNEL_WIFI,     // Reconexión periódica del monitor WiFi
+    PACING_CHANNEL_MQTT,     // Espera de reconexión del cliente MQTT
+    PACING_CHANNEL_MAX
+} pacing_channel_t;
+
+// Salts de pacing_phase_offset_ms(): cada uso se desfasa de forma independiente
+typedef enum {
+    PACING_PHASE_SENSOR_SAMPLING = 1,
+    PACING_PHASE_POST_DATA,
+} pacing_phase_salt_t;
+
+typedef struct {
+    bool phase_offset_enabled;
+    uint32_t rate_per_min;                       // 0 = sin límite
+    uint32_t burst;                              // Capacidad del token bucket
+    uint32_t backoff_base_ms[PACING_CHANNEL_MAX];
+    uint32_t backoff_cap_ms[PACING_CHANNEL_MAX];
+} pacing_config_t;
+
+/**
+ * @brief Inicializar el módulo con la identidad del dispositivo
+ *
+ * La MAC fija el offset de fase y la semilla del jitter: dos dispositivos
+ * distintos nunca comparten secuencia, y el mismo dispositivo repite la suya.
+ *
+ * @param mac MAC de la interfaz STA (6 bytes)
+ */
+esp_err_t pacing_init(const uint8_t mac[6]);
+
+/**
+ * @brief Copiar la configuración vigente
+ */
+void pacing_get_config(pacing_config_t *out_config);
+
+/**
+ * @brief Reemplazar la configuración (se aplica desde la próxima decisión)
+ *
+ * @return ESP_ERR_INVALID_ARG si algún tope es menor que su base o burst es 0
+ */
+esp_err_t pacing_set_config(const pacing_config_t *config);
+
+/**
+ * @brief Aplicar los campos presentes en un objeto JSON sobre la configuración vigente
+ *
+ * Campos (todos opcionales): phase_offset (bool), rate_per_min, burst,
+ * http_backoff_base_ms, http_backoff_cap_ms, wifi_backoff_base_ms,
+ * wifi_backoff_cap_ms, mqtt_backoff_base_ms, mqtt_backoff_cap_ms.
+ * Llega como objeto "pacing" del mensaje de configuración MQTT.
+ */
+esp_err_t pacing_apply_json(const cJSON *object);
+
+/**
+ * @brief Offset de fase del dispositivo dentro de un período
+ *
+ * Determinístico para (MAC, salt): distintos salt desfasan tareas distintas
+ * del mismo dispositivo.
+ *
+ * @return Valor en [0, interval_ms), o 0 si el desfase está deshabilitado
+ */
+uint32_t pacing_phase_offset_ms(uint32_t interval_ms, uint32_t salt);
+
+/**
+ * @brief Próxima espera de backoff de un canal (avanza su estado)
+ */
+uint32_t pacing_next_backoff_ms(pacing_channel_t channel);
+
+/**
+ * @brief Espera siguiente a previous_ms con la base y el tope de un canal, sin estado
+ *
+ * Para quien lleva su propia secuencia (un breaker por endpoint comparte la
+ * configuración del canal HTTP). previous_ms = 0 es el primer intento.
+ */
+uint32_t pacing_backoff_after_ms(pacing_channel_t channel, uint32_t previous_ms);
+
+/**
+ * @brief Volver el backoff de un canal a su base (tras un éxito)
+ */
+void pacing_reset_backoff(pacing_channel_t channel);
+
+/**
+ * @brief Tomar un token para una petición HTTP
+ *
+ * @return false si se superó el límite por minuto (la petición debe diferirse)
+ */
+bool pacing_try_acquire(void);
+
+#endif // PACING_H
@@ -0,0 +1,157 @@
+#include "sequence.h"
+#include "config.h"
+#include "hal_nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "SEQUENCE";
+
+#define SEQUENCE_NVS_NAMESPACE "sequence"
+#define SEQUENCE_NVS_BOOT_KEY "boot"
+
+static const char *stream_keys[SEQUENCE_STREAM_MAX] = {
+    [SEQUENCE_STREAM_FRAMES] = "seq_f",
+    [SEQUENCE_STREAM_ERRORS] = "seq_e",
+};
+
+// Letra del flujo en la clave de idempotencia
+static const char stream_tags[SEQUENCE_STREAM_MAX] = {
+    [SEQUENCE_STREAM_FRAMES] = 'f',
+    [SEQUENCE_STREAM_ERRORS] = 'e',
+};
+
+static SemaphoreHandle_t sequence_mutex = NULL;
+static bool nvs_available = false;
+static uint32_t boot_id = 0;
+static char device_id[13] = "000000000000";
+static uint32_t last_seq[SEQUENCE_STREAM_MAX];      // Último número asignado
+static uint32_t reserved_seq[SEQUENCE_STREAM_MAX];  // Fin del bloque persistido en NVS
+
+static void sequence_lock(void)
+{
+    if (sequence_mutex != NULL) {
+        xSemaphoreTake(sequence_mutex, portMAX_DELAY);
+    }
+}
+
+static void sequence_unlock(void)
+{
+    if (sequence_mutex != NULL) {
+        xSemaphoreGive(sequence_mutex);
+    }
+}
+
+// Guardar un contador en NVS (los valores se guardan como i32 sin signo)
+static esp_err_t sequence_persist(const char *key, uint32_t value)
+{
+    hal_nvs_handle_t handle;
+    esp_err_t err = hal_nvs_open(SEQUENCE_NVS_NAMESPACE, true, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = hal_nvs_set_i32(handle, key, (int32_t)value);
+    if (err == ESP_OK) {
+        err = hal_nvs_commit(handle);
+    }
+    hal_nvs_close(handle);
+    return err;
+}
+
+esp_err_t sequence_init(const uint8_t mac[6])
+{
+    if (mac == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (sequence_mutex == NULL) {
+        sequence_mutex = xSemaphoreCreateMutex();
+        if (sequence_mutex == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    sequence_lock();
+    snprintf(device_id, sizeof(device_id), "%02x%02x%02x%02x%02x%02x",
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    memset(last_seq, 0, sizeof(last_seq));
+    memset(reserved_seq, 0, sizeof(reserved_seq));
+    boot_id = 0;
+
+    hal_nvs_handle_t handle;
+    esp_err_t err = hal_nvs_open(SEQUENCE_NVS_NAMESPACE, false, &handle);
+    if (err == ESP_OK || err == ESP_ERR_NVS_NOT_FOUND) {
+        if (err == ESP_OK) {
+            int32_t value = 0;
+            if (hal_nvs_get_i32(handle, SEQUENCE_NVS_BOOT_KEY, &value) == ESP_OK) {
+                boot_id = (uint32_t)value;
+            }
+            for (int i = 0; i < SEQUENCE_STREAM_MAX; i++) {
+                value = 0;
+                if (hal_nvs_get_i32(handle, stream_keys[i], &value) == ESP_OK) {
+                    // Lo reservado en el arranque anterior pudo usarse entero
+                    last_seq[i] = (uint32_t)value;
+                    reserved_seq[i] = (uint32_t)value;
+                }
+            }
+            hal_nvs_close(handle);
+        }
+        boot_id++;
+        err = sequence_persist(SEQUENCE_NVS_BOOT_KEY, boot_id);
+    }
+    nvs_available = (err == ESP_OK);
+    if (!nvs_available) {
+        boot_id = 0;
+    }
+    sequence_unlock();
+
+    if (!nvs_available) {
+        ESP_LOGW(TAG, "⚠️ NVS no disponible (%s): secuencias solo en RAM, boot_id 0", esp_err_to_name(err));
+        return err;
+    }
+    ESP_LOGI(TAG, "🔢 Arranque %lu, secuencias desde f=%lu e=%lu",
+             (unsigned long)boot_id, (unsigned long)last_seq[SEQUENCE_STREAM_FRAMES],
+             (unsigned long)last_seq[SEQUENCE_STREAM_ERRORS]);
+    return ESP_OK;
+}
+
+uint32_t sequence_boot_id(void)
+{
+    return boot_id;
+}
+
+uint32_t sequence_next(sequence_stream_t stream)
+{
+    if (stream >= SEQUENCE_STREAM_MAX) {
+        return 0;
+    }
+
+    sequence_lock();
+    uint32_t seq = ++last_seq[stream];
+    if (seq == 0) {
+        seq = ++last_seq[stream];   // 0 queda reservado para "sin asignar"
+    }
+    if (nvs_available && seq > reserved_seq[stream]) {
+        // Bloque agotado: reservar el siguiente antes de usar este número
+        uint32_t reserve = seq + SEQUENCE_PERSIST_BLOCK;
+        esp_err_t err = sequence_persist(stream_keys[stream], reserve);
+        if (err == ESP_OK) {
+            reserved_seq[stream] = reserve;
+        } else {
+            ESP_LOGW(TAG, "⚠️ No se pudo reservar secuencia %s: %s", stream_keys[stream], esp_err_to_name(err));
+        }
+    }
+    sequence_unlock();
+    return seq;
+}
+
+int sequence_idempotency_key(sequence_stream_t stream, uint32_t seq, char *buffer, size_t buffer_len)
+{
+    if (stream >= SEQUENCE_STREAM_MAX || buffer == NULL) {
+        return -1;
+    }
+    int written = snprintf(buffer, buffer_len, "%s-%lu-%c-%lu", device_id, (unsigned long)boot_id,
+                           stream_tags[stream], (unsigned long)seq);
+    return (written < 0 || (size_t)written >= buffer_len) ? -1 : written;
+}
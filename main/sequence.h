@@ -0,0 +1,54 @@
+#ifndef SEQUENCE_H
+#define SEQUENCE_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Números de secuencia por flujo de datos e identificador de arranque.
+// Cada trama de lecturas enviada y cada error llevan (boot_id, seq): con el MAC forman
+// la clave de idempotencia (el backend descarta los reintentos duplicados) y
+// un hueco de seq dentro de un mismo boot_id es una muestra perdida.
+//
+// Para no escribir NVS en cada muestra se reserva un bloque de
+// SEQUENCE_PERSIST_BLOCK números por flujo. Tras un reinicio la secuencia
+// sigue desde el final del bloque reservado: el salto cae entre dos boot_id
+// y no se confunde con pérdida.
+
+typedef enum {
+    SEQUENCE_STREAM_FRAMES,      // Tramas de lecturas enviadas a /process-data
+    SEQUENCE_STREAM_ERRORS,      // Errores enviados a /error-logs
+    SEQUENCE_STREAM_MAX
+} sequence_stream_t;
+
+// Largo máximo de la clave de idempotencia, con el '\0'
+#define SEQUENCE_KEY_MAX_LEN 48
+
+/**
+ * @brief Cargar el estado persistido e incrementar el contador de arranques
+ *
+ * Sin NVS disponible las secuencias siguen en RAM desde 1 y boot_id es 0.
+ *
+ * @param mac MAC de la interfaz STA (identifica al dispositivo en la clave)
+ */
+esp_err_t sequence_init(const uint8_t mac[6]);
+
+/**
+ * @brief Identificador de este arranque (contador persistido, 1 el primero)
+ */
+uint32_t sequence_boot_id(void);
+
+/**
+ * @brief Asignar el próximo número de un flujo (nunca 0: 0 = sin asignar)
+ */
+uint32_t sequence_next(sequence_stream_t stream);
+
+/**
+ * @brief Clave de idempotencia "<mac>-<boot_id>-<flujo>-<seq>"
+ *
+ * @return Largo escrito (sin el '\0'), o -1 si el buffer no alcanza
+ */
+int sequence_idempotency_key(sequence_stream_t stream, uint32_t seq, char *buffer, size_t buffer_len);
+
+#endif // SEQUENCE_H
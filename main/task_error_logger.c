@@ -2,14 +2,21 @@
 #include "task_main.h"
 #include "task_sensor_config.h"
 #include "config.h"
+#include "metrics.h"
+#include "pacing.h"
+#include "circuit_breaker.h"
+#include "sequence.h"
+#include "time_service.h"
+#include "http_compress.h"
 #include "esp_log.h"
-#include "esp_http_client.h"
-#include "esp_crt_bundle.h"
+#include "hal_http.h"
+#include "hal_clock.h"
 #include "cJSON.h"
+#if !CONFIG_IDF_TARGET_LINUX
 #include "esp_netif.h"
+#endif
 #include "freertos/semphr.h"
-#include "nvs_flash.h"
-#include "nvs.h"
+#include "config_store.h"
 #include <string.h>
 
 static const char *TAG = "ERROR_LOGGER";
@@ -17,7 +24,9 @@ static const char *TAG = "ERROR_LOGGER";
 #define ERROR_LOGGER_QUEUE_SIZE 50
 #define ERROR_SEND_INTERVAL_MS 10000  // Intentar enviar cada 10 segundos
 #define ERROR_LOG_ENDPOINT "/error-logs"
+#define ERROR_LOG_TIMEOUT_MS 10000   // Timeout del POST con el backend sano (el breaker lo acota)
 #define MAX_ERROR_TYPES 20  // Máximo de tipos de error únicos a trackear
+#define DEDUP_WINDOW_MS 600000  // Un error repetido se vuelve a enviar pasados 10 minutos
 
 static QueueHandle_t error_queue = NULL;
 static SemaphoreHandle_t retry_semaphore = NULL; // Para forzar reintentos
@@ -29,74 +38,59 @@ typedef struct {
     char error_code[50];
     error_source_type_t source_type;
     int source_id;  // id_sensor, id_controller, o id_actuator
-    uint32_t last_sent_time;
+    uint32_t last_sent_time;    // hal_clock_now_ms() del último envío
     uint32_t occurrence_count;
 } error_dedup_entry_t;
 
 static error_dedup_entry_t error_dedup_table[MAX_ERROR_TYPES];
 static int error_dedup_count = 0;
 
-// Callback para manejar respuesta HTTP
-static esp_err_t http_event_handler(esp_http_client_event_t *evt)
+// Obtener la IP de la interfaz WiFi STA ("0.0.0.0" si no hay)
+static void get_station_ip(char *ip_address, size_t len)
 {
-    switch (evt->event_id) {
-    case HTTP_EVENT_ON_DATA:
-        if (!esp_http_client_is_chunked_response(evt->client)) {
-            if (evt->data_len > 0 && response_len + evt->data_len < sizeof(response_buffer) - 1) {
-                memcpy(response_buffer + response_len, evt->data, evt->data_len);
-                response_len += evt->data_len;
-                response_buffer[response_len] = '\0';
-            }
+#if CONFIG_IDF_TARGET_LINUX
+    // Build de host: no hay interfaz WiFi
+    snprintf(ip_address, len, "127.0.0.1");
+#else
+    esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+    if (netif != NULL) {
+        esp_netif_ip_info_t ip_info;
+        if (esp_netif_get_ip_info(netif, &ip_info) == ESP_OK) {
+            snprintf(ip_address, len, IPSTR, IP2STR(&ip_info.ip));
+            return;
         }
-        break;
-    default:
-        break;
     }
-    return ESP_OK;
+    snprintf(ip_address, len, "0.0.0.0");
+#endif
 }
 
-// Leer id_sensor desde NVS
+// Leer id_sensor de la configuración guardada (config_store.c, copia en RAM)
 static int32_t read_id_sensor_from_nvs(const char *device_serial)
 {
-    nvs_handle_t handle;
-    esp_err_t err = nvs_open("sensor_cfg", NVS_READONLY, &handle);
-    if (err != ESP_OK) {
-        ESP_LOGW(TAG, "No se pudo abrir NVS para leer id_sensor: %s", esp_err_to_name(err));
-        return -1;
-    }
-    
-    // Determinar el prefijo según el device_serial
-    const char *prefix = NULL;
+    sensor_type_t sensor_type;
     if (strcmp(device_serial, DEVICE_SERIAL_HUMIDITY) == 0) {
-        prefix = "hum_";
+        sensor_type = SENSOR_TYPE_SOIL_HUMIDITY;
     } else if (strcmp(device_serial, DEVICE_SERIAL_LIGHT) == 0) {
-        prefix = "light_";  // Cambiar de "luz_" a "light_"
+        sensor_type = SENSOR_TYPE_LIGHT;
     } else {
-        nvs_close(handle);
         ESP_LOGW(TAG, "device_serial desconocido: %s", device_serial);
         return -1;
     }
-    
-    // Leer id_sensor
-    char key[32];
-    snprintf(key, sizeof(key), "%sid", prefix);
-    int32_t id_sensor = -1;
-    err = nvs_get_i32(handle, key, &id_sensor);
-    
-    nvs_close(handle);
-    
-    if (err == ESP_OK && id_sensor > 0) {
-        ESP_LOGI(TAG, "✓ ID sensor leído de NVS: %ld (serial: %s, key: %s)", (long)id_sensor, device_serial, key);
-        return id_sensor;
+
+    sensor_config_t config = {0};
+    esp_err_t err = config_store_load(sensor_type, &config);
+    if (err == ESP_OK && config.id_sensor > 0) {
+        ESP_LOGI(TAG, "✓ ID sensor leído de NVS: %d (serial: %s)", config.id_sensor, device_serial);
+        return config.id_sensor;
     } else {
-        ESP_LOGW(TAG, "⚠ No se encontró id_sensor en NVS para serial: %s (key: %s, err: %s)", 
-                 device_serial, key, esp_err_to_name(err));
+        ESP_LOGW(TAG, "⚠ No se encontró id_sensor en NVS para serial: %s (err: %s)",
+                 device_serial, esp_err_to_name(err));
         return -1;
     }
 }
 
 // Verificar si un error es duplicado (ya fue enviado recientemente)
-static bool is_duplicate_error(const error_log_entry_t *error, uint32_t *occurrence_count)
+bool error_logger_dedup_check(const error_log_entry_t *error, uint32_t *occurrence_count)
 {
     int source_id = -1;
     if (error->source_type == ERROR_SOURCE_SENSOR) {
@@ -113,6 +107,11 @@ static bool is_duplicate_error(const error_log_entry_t *error, uint32_t *occurre
             error_dedup_table[i].source_type == error->source_type &&
             error_dedup_table[i].source_id == source_id) {
             
+            // Entrada vencida aunque la limpieza periódica aún no haya pasado
+            if (hal_clock_elapsed_ms(error_dedup_table[i].last_sent_time) > DEDUP_WINDOW_MS) {
+                return false;
+            }
+            
             // Encontrado - incrementar contador de ocurrencias
             error_dedup_table[i].occurrence_count++;
             *occurrence_count = error_dedup_table[i].occurrence_count;
@@ -127,7 +126,7 @@ static bool is_duplicate_error(const error_log_entry_t *error, uint32_t *occurre
 }
 
 // Marcar error como enviado (agregar a tabla de deduplicación)
-static void mark_error_as_sent(const error_log_entry_t *error)
+void error_logger_dedup_mark_sent(const error_log_entry_t *error)
 {
     int source_id = -1;
     if (error->source_type == ERROR_SOURCE_SENSOR) {
@@ -144,8 +143,8 @@ static void mark_error_as_sent(const error_log_entry_t *error)
             error_dedup_table[i].source_type == error->source_type &&
             error_dedup_table[i].source_id == source_id) {
             
-            // Ya existe, actualizar timestamp
-            error_dedup_table[i].last_sent_time = xTaskGetTickCount();
+            // Ya existe, actualizar instante de envío
+            error_dedup_table[i].last_sent_time = hal_clock_now_ms();
             return;
         }
     }
@@ -155,19 +154,20 @@ static void mark_error_as_sent(const error_log_entry_t *error)
         strncpy(error_dedup_table[error_dedup_count].error_code, error->error_code, sizeof(error_dedup_table[0].error_code) - 1);
         error_dedup_table[error_dedup_count].source_type = error->source_type;
         error_dedup_table[error_dedup_count].source_id = source_id;
-        error_dedup_table[error_dedup_count].last_sent_time = xTaskGetTickCount();
+        error_dedup_table[error_dedup_count].last_sent_time = hal_clock_now_ms();
         error_dedup_table[error_dedup_count].occurrence_count = 1;
         error_dedup_count++;
         
         ESP_LOGI(TAG, "➕ Nuevo tipo de error registrado: [%s] (total: %d)", error->error_code, error_dedup_count);
     } else {
-        // Tabla llena, reemplazar entrada más antigua
+        // Tabla llena, reemplazar entrada más antigua (mayor antigüedad, seguro ante la vuelta del reloj)
         int oldest_idx = 0;
-        uint32_t oldest_time = error_dedup_table[0].last_sent_time;
+        uint32_t oldest_age = hal_clock_elapsed_ms(error_dedup_table[0].last_sent_time);
         
         for (int i = 1; i < MAX_ERROR_TYPES; i++) {
-            if (error_dedup_table[i].last_sent_time < oldest_time) {
-                oldest_time = error_dedup_table[i].last_sent_time;
+            uint32_t age = hal_clock_elapsed_ms(error_dedup_table[i].last_sent_time);
+            if (age > oldest_age) {
+                oldest_age = age;
                 oldest_idx = i;
             }
         }
@@ -175,7 +175,7 @@ static void mark_error_as_sent(const error_log_entry_t *error)
         strncpy(error_dedup_table[oldest_idx].error_code, error->error_code, sizeof(error_dedup_table[0].error_code) - 1);
         error_dedup_table[oldest_idx].source_type = error->source_type;
         error_dedup_table[oldest_idx].source_id = source_id;
-        error_dedup_table[oldest_idx].last_sent_time = xTaskGetTickCount();
+        error_dedup_table[oldest_idx].last_sent_time = hal_clock_now_ms();
         error_dedup_table[oldest_idx].occurrence_count = 1;
     }
 }
@@ -183,12 +183,9 @@ static void mark_error_as_sent(const error_log_entry_t *error)
 // Limpiar tabla de deduplicación (errores antiguos pueden enviarse de nuevo)
 static void clear_old_dedup_entries(void)
 {
-    uint32_t current_time = xTaskGetTickCount();
-    uint32_t timeout = pdMS_TO_TICKS(600000); // 10 minutos
-    
     int i = 0;
     while (i < error_dedup_count) {
-        if ((current_time - error_dedup_table[i].last_sent_time) > timeout) {
+        if (hal_clock_elapsed_ms(error_dedup_table[i].last_sent_time) > DEDUP_WINDOW_MS) {
             // Remover entrada antigua
             ESP_LOGD(TAG, "🗑️ Removiendo entrada antigua: [%s]", error_dedup_table[i].error_code);
             
@@ -211,6 +208,7 @@ esp_err_t error_logger_init(void)
         ESP_LOGE(TAG, "❌ Error creando cola de errores");
         return ESP_FAIL;
     }
+    metrics_watch_queue(METRIC_GAUGE_ERROR_QUEUE_DEPTH, error_queue);
     
     retry_semaphore = xSemaphoreCreateBinary();
     if (retry_semaphore == NULL) {
@@ -233,10 +231,12 @@ esp_err_t error_logger_log(const error_log_entry_t *error)
     
     error_log_entry_t entry = *error;
     entry.pending = true;
-    entry.timestamp = xTaskGetTickCount();
+    entry.timestamp = hal_clock_now_ms();
+    entry.seq = 0;              // La asigna la tarea al enviarlo por primera vez
     
     if (xQueueSend(error_queue, &entry, pdMS_TO_TICKS(100)) != pdTRUE) {
         ESP_LOGW(TAG, "⚠️ Cola de errores llena, descartando error: %s", error->message);
+        metrics_counter_inc(METRIC_ERRLOG_DROPS);
         return ESP_ERR_NO_MEM;
     }
     
@@ -260,7 +260,7 @@ esp_err_t error_logger_log_sensor(
         .id_controller_station = -1,
         .id_actuator = -1,
         .severity = severity,
-        .timestamp = xTaskGetTickCount(),
+        .timestamp = hal_clock_now_ms(),
         .pending = true
     };
     
@@ -280,17 +280,7 @@ esp_err_t error_logger_log_sensor(
     }
     
     // Obtener IP address
-    esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
-    if (netif != NULL) {
-        esp_netif_ip_info_t ip_info;
-        if (esp_netif_get_ip_info(netif, &ip_info) == ESP_OK) {
-            snprintf(error.ip_address, sizeof(error.ip_address), IPSTR, IP2STR(&ip_info.ip));
-        } else {
-            strcpy(error.ip_address, "0.0.0.0");
-        }
-    } else {
-        strcpy(error.ip_address, "0.0.0.0");
-    }
+    get_station_ip(error.ip_address, sizeof(error.ip_address));
     
     return error_logger_log(&error);
 }
@@ -304,27 +294,19 @@ esp_err_t error_logger_log_system(
     const char *details_json
 )
 {
-    // Acceder a configuraciones de sensores
-    extern sensor_config_t g_sensor_humidity_config;
-    extern sensor_config_t g_sensor_light_config;
+    // Copia consistente de la configuración de cada sensor
+    sensor_config_t humidity_config;
+    sensor_config_t light_config;
+    sensor_config_get_snapshot(SENSOR_TYPE_SOIL_HUMIDITY, &humidity_config);
+    sensor_config_get_snapshot(SENSOR_TYPE_LIGHT, &light_config);
     
     // Obtener IP address una sola vez
     char ip_address[16];
-    esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
-    if (netif != NULL) {
-        esp_netif_ip_info_t ip_info;
-        if (esp_netif_get_ip_info(netif, &ip_info) == ESP_OK) {
-            snprintf(ip_address, sizeof(ip_address), IPSTR, IP2STR(&ip_info.ip));
-        } else {
-            strcpy(ip_address, "0.0.0.0");
-        }
-    } else {
-        strcpy(ip_address, "0.0.0.0");
-    }
+    get_station_ip(ip_address, sizeof(ip_address));
     
     // Leer id_sensor desde NVS (fallback si config global no está lista)
-    int32_t humidity_id = g_sensor_humidity_config.id_sensor;
-    int32_t light_id = g_sensor_light_config.id_sensor;
+    int32_t humidity_id = humidity_config.id_sensor;
+    int32_t light_id = light_config.id_sensor;
     
     ESP_LOGI(TAG, "🔍 Config global - Humedad id=%ld, Luz id=%ld", (long)humidity_id, (long)light_id);
     
@@ -353,12 +335,12 @@ esp_err_t error_logger_log_system(
         .id_controller_station = -1,
         .id_actuator = -1,
         .severity = severity,
-        .timestamp = xTaskGetTickCount(),
+        .timestamp = hal_clock_now_ms(),
         .pending = true
     };
     
     ESP_LOGI(TAG, "🔍 DEBUG - Humedad: id_sensor=%ld, state=%d, device_serial=%s", 
-             (long)error_humidity.id_sensor, g_sensor_humidity_config.state, DEVICE_SERIAL_HUMIDITY);
+             (long)error_humidity.id_sensor, humidity_config.state, DEVICE_SERIAL_HUMIDITY);
     
     strncpy(error_humidity.error_code, error_code, sizeof(error_humidity.error_code) - 1);
     strncpy(error_humidity.message, message, sizeof(error_humidity.message) - 1);
@@ -379,12 +361,12 @@ esp_err_t error_logger_log_system(
         .id_controller_station = -1,
         .id_actuator = -1,
         .severity = severity,
-        .timestamp = xTaskGetTickCount(),
+        .timestamp = hal_clock_now_ms(),
         .pending = true
     };
     
     ESP_LOGI(TAG, "🔍 DEBUG - Luz: id_sensor=%ld, state=%d, device_serial=%s", 
-             (long)error_light.id_sensor, g_sensor_light_config.state, DEVICE_SERIAL_LIGHT);
+             (long)error_light.id_sensor, light_config.state, DEVICE_SERIAL_LIGHT);
     
     strncpy(error_light.error_code, error_code, sizeof(error_light.error_code) - 1);
     strncpy(error_light.message, message, sizeof(error_light.message) - 1);
@@ -453,13 +435,9 @@ static const char* source_type_to_string(error_source_type_t type)
     }
 }
 
-// Enviar error al backend
-static esp_err_t send_error_to_backend(const error_log_entry_t *error, uint32_t occurrence_count)
+// Serializar un error al JSON de /error-logs (el llamador libera con free)
+char *error_logger_build_payload(const error_log_entry_t *error, uint32_t occurrence_count)
 {
-    // Construir URL completa
-    char url[256];
-    snprintf(url, sizeof(url), "%s%s", HTTP_SERVER_BASE_URL, ERROR_LOG_ENDPOINT);
-    
     // Crear JSON
     cJSON *root = cJSON_CreateObject();
     
@@ -512,10 +490,35 @@ static esp_err_t send_error_to_backend(const error_log_entry_t *error, uint32_t
         cJSON_AddStringToObject(root, "device_serial", error->device_serial);
     }
     
+    // Instante del error en UTC (corregido hacia atrás si ocurrió antes de sincronizar)
+    time_service_add_stamp_json(root, error->timestamp);
+    if (error->seq != 0) {
+        cJSON_AddNumberToObject(root, "seq", error->seq);
+    }
+    
     char *json_string = cJSON_Print(root);
+    cJSON_Delete(root);
+    return json_string;
+}
+    
+
+// Enviar error al backend.
+// ESP_ERR_INVALID_STATE: el breaker de /error-logs rechazó la petición sin tocar la red.
+static esp_err_t send_error_to_backend(const error_log_entry_t *error, uint32_t occurrence_count)
+{
+    uint32_t budget_ms;
+    if (!circuit_breaker_acquire(BREAKER_ENDPOINT_ERROR_LOGS, ERROR_LOG_TIMEOUT_MS, &budget_ms)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Construir URL completa
+    char url[256];
+    snprintf(url, sizeof(url), "%s%s", HTTP_SERVER_BASE_URL, ERROR_LOG_ENDPOINT);
+    
+    char *json_string = error_logger_build_payload(error, occurrence_count);
     if (json_string == NULL) {
         ESP_LOGE(TAG, "❌ Error creando JSON");
-        cJSON_Delete(root);
+        circuit_breaker_record(BREAKER_ENDPOINT_ERROR_LOGS, true, 0);   // Falla local, no del backend
         return ESP_FAIL;
     }
     
@@ -529,37 +532,50 @@ static esp_err_t send_error_to_backend(const error_log_entry_t *error, uint32_t
     response_len = 0;
     memset(response_buffer, 0, sizeof(response_buffer));
     
-    // Configurar cliente HTTP
-    esp_http_client_config_t config = {
-        .url = url,
-        .method = HTTP_METHOD_POST,
-        .event_handler = http_event_handler,
-        .timeout_ms = 10000,
-        .crt_bundle_attach = esp_crt_bundle_attach,
+    // Cuerpo comprimido si supera el umbral (la tarea envía un error a la vez)
+    static uint8_t body_buffer[HTTP_COMPRESS_BUFFER_SIZE];
+    const char *body;
+    size_t body_len;
+    const char *content_encoding = http_compress_body(json_string, body_buffer, sizeof(body_buffer), &body, &body_len);
+
+    // Configurar petición HTTP (la clave de idempotencia se repite en cada reintento)
+    hal_http_header_t headers[3] = {
+        {"Content-Type", "application/json"},
     };
-    
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    if (client == NULL) {
-        ESP_LOGE(TAG, "❌ Error inicializando cliente HTTP");
-        free(json_string);
-        cJSON_Delete(root);
-        return ESP_FAIL;
+    size_t header_count = 1;
+    if (content_encoding != NULL) {
+        headers[header_count++] = (hal_http_header_t){"Content-Encoding", content_encoding};
     }
-    
-    // Configurar headers
-    esp_http_client_set_header(client, "Content-Type", "application/json");
-    
-    // Configurar datos POST
-    esp_http_client_set_post_field(client, json_string, strlen(json_string));
+    char idempotency_key[SEQUENCE_KEY_MAX_LEN];
+    if (error->seq != 0 &&
+        sequence_idempotency_key(SEQUENCE_STREAM_ERRORS, error->seq, idempotency_key, sizeof(idempotency_key)) > 0) {
+        headers[header_count++] = (hal_http_header_t){HTTP_IDEMPOTENCY_HEADER_NAME, idempotency_key};
+    }
+    hal_http_request_t request = {
+        .url = url,
+        .method = HAL_HTTP_METHOD_POST,
+        .headers = headers,
+        .header_count = header_count,
+        .body = body,
+        .body_len = body_len,
+        .timeout_ms = (int)budget_ms,
+        .response_buf = response_buffer,
+        .response_buf_size = sizeof(response_buffer),
+    };
+    hal_http_response_t response = {0};
     
     // Realizar petición
-    esp_err_t err = esp_http_client_perform(client);
-    int status_code = esp_http_client_get_status_code(client);
+    int64_t post_start_us = hal_clock_now_us();
+    esp_err_t err = hal_http_perform(&request, &response);
+    uint32_t post_ms = (uint32_t)((hal_clock_now_us() - post_start_us) / 1000);
+    metrics_histogram_record(METRIC_HIST_ERRLOG_POST_MS, post_ms);
+    int status_code = response.status_code;
+    response_len = (int)response.response_len;
     
     // Limpiar
-    esp_http_client_cleanup(client);
     free(json_string);
-    cJSON_Delete(root);
+    circuit_breaker_record(BREAKER_ENDPOINT_ERROR_LOGS,
+                           err == ESP_OK && status_code >= 200 && status_code < 300, post_ms);
     
     if (err == ESP_OK && status_code >= 200 && status_code < 300) {
         ESP_LOGI(TAG, "✅ Error enviado exitosamente al backend (HTTP %d)", status_code);
@@ -577,21 +593,22 @@ void task_error_logger(void *pvParameters)
     
     if (error_queue == NULL) {
         ESP_LOGE(TAG, "❌ Cola no inicializada, abortando tarea");
+        task_watchdog_unregister(TASK_TYPE_ERROR_LOGGER);
         vTaskDelete(NULL);
         return;
     }
     
     error_log_entry_t error;
-    uint32_t sent_count = 0;
-    uint32_t failed_count = 0;
-    uint32_t duplicate_count = 0;
     
     // Cola temporal para reintentar errores fallidos
     QueueHandle_t retry_queue = xQueueCreate(ERROR_LOGGER_QUEUE_SIZE, sizeof(error_log_entry_t));
     
-    uint32_t last_cleanup = xTaskGetTickCount();
+    uint32_t last_cleanup = hal_clock_now_ms();
+    uint32_t last_stats = hal_clock_now_ms();
     
     while (1) {
+        task_feed_watchdog(TASK_TYPE_ERROR_LOGGER);
+        
         // Esperar por nuevo error O señal de reintento forzado
         bool force_retry = false;
         if (xSemaphoreTake(retry_semaphore, 0) == pdTRUE) {
@@ -607,19 +624,25 @@ void task_error_logger(void *pvParameters)
             
             // Verificar si es duplicado
             uint32_t occurrence_count = 1;
-            if (is_duplicate_error(&error, &occurrence_count)) {
-                duplicate_count++;
-                ESP_LOGD(TAG, "⏭️ Error duplicado ignorado (total: %lu)", (unsigned long)duplicate_count);
+            if (error_logger_dedup_check(&error, &occurrence_count)) {
+                metrics_counter_inc(METRIC_ERRLOG_DUPLICATES);
+                ESP_LOGD(TAG, "⏭️ Error duplicado ignorado (total: %lu)",
+                         (unsigned long)metrics_counter_get(METRIC_ERRLOG_DUPLICATES));
                 continue; // No enviar, continuar con el siguiente
             }
             
-            // Verificar conectividad ANTES de intentar enviar
+            // Secuencia asignada una sola vez: los reintentos reusan la misma
+            if (error.seq == 0) {
+                error.seq = sequence_next(SEQUENCE_STREAM_ERRORS);
+            }
+            
+            // Verificar conectividad ANTES de intentar enviar (sin conectividad va a reintentos)
             EventBits_t bits = xEventGroupWaitBits(
                 g_connectivity_event_group,
                 CONNECTIVITY_WIFI_CONNECTED_BIT,
                 pdFALSE,  // No clear bits
                 pdFALSE,  // Wait for any bit
-                portMAX_DELAY  // Esperar indefinidamente por conectividad
+                pdMS_TO_TICKS(ERROR_SEND_INTERVAL_MS)
             );
             
             if (!(bits & CONNECTIVITY_WIFI_CONNECTED_BIT)) {
@@ -628,20 +651,48 @@ void task_error_logger(void *pvParameters)
                 continue;
             }
             
+            // Backend en falla: sin esperar timeouts, el error queda para reintentos
+            if (circuit_breaker_state(BREAKER_ENDPOINT_ERROR_LOGS) == BREAKER_STATE_OPEN) {
+                ESP_LOGD(TAG, "⛔ Breaker de error-logs abierto, error diferido a reintentos");
+                if (xQueueSend(retry_queue, &error, 0) != pdTRUE) {
+                    ESP_LOGW(TAG, "⚠️ Cola de reintentos llena, error perdido");
+                    metrics_counter_inc(METRIC_ERRLOG_DROPS);
+                }
+                continue;
+            }
+            
+            // Comparte el límite de peticiones por minuto con los envíos de datos
+            if (!pacing_try_acquire()) {
+                ESP_LOGD(TAG, "⏳ Límite de peticiones alcanzado, error diferido a reintentos");
+                if (xQueueSend(retry_queue, &error, 0) != pdTRUE) {
+                    ESP_LOGW(TAG, "⚠️ Cola de reintentos llena, error perdido");
+                    metrics_counter_inc(METRIC_ERRLOG_DROPS);
+                }
+                continue;
+            }
+            
             // Intentar enviar al backend
             esp_err_t result = send_error_to_backend(&error, occurrence_count);
             
             if (result == ESP_OK) {
-                sent_count++;
-                mark_error_as_sent(&error);  // Marcar como enviado para deduplicación
-                ESP_LOGI(TAG, "✅ Error enviado correctamente (total: %lu)", (unsigned long)sent_count);
+                metrics_counter_inc(METRIC_ERRLOG_SENT);
+                error_logger_dedup_mark_sent(&error);  // Marcar como enviado para deduplicación
+                ESP_LOGI(TAG, "✅ Error enviado correctamente (total: %lu)",
+                         (unsigned long)metrics_counter_get(METRIC_ERRLOG_SENT));
+            } else if (result == ESP_ERR_INVALID_STATE) {
+                if (xQueueSend(retry_queue, &error, 0) != pdTRUE) {
+                    ESP_LOGW(TAG, "⚠️ Cola de reintentos llena, error perdido");
+                    metrics_counter_inc(METRIC_ERRLOG_DROPS);
+                }
             } else {
-                failed_count++;
-                ESP_LOGW(TAG, "⚠️ Error al enviar, reintentando más tarde (total fallos: %lu)", (unsigned long)failed_count);
+                metrics_counter_inc(METRIC_ERRLOG_FAILED);
+                ESP_LOGW(TAG, "⚠️ Error al enviar, reintentando más tarde (total fallos: %lu)",
+                         (unsigned long)metrics_counter_get(METRIC_ERRLOG_FAILED));
                 
                 // Agregar a cola de reintentos (no bloquear)
                 if (xQueueSend(retry_queue, &error, 0) != pdTRUE) {
                     ESP_LOGW(TAG, "⚠️ Cola de reintentos llena, error perdido");
+                    metrics_counter_inc(METRIC_ERRLOG_DROPS);
                 }
             }
         }
@@ -651,6 +702,7 @@ void task_error_logger(void *pvParameters)
         int retry_count = 0;
         
         while (retry_count < max_retries && xQueueReceive(retry_queue, &error, 0) == pdTRUE) {
+            task_feed_watchdog(TASK_TYPE_ERROR_LOGGER);
             ESP_LOGI(TAG, "🔄 Reintentando envío de error: [%s]", error.error_code);
             
             // Verificar conectividad antes de cada reintento
@@ -660,15 +712,25 @@ void task_error_logger(void *pvParameters)
                 xQueueSend(retry_queue, &error, 0);
                 break;  // Salir del loop de reintentos
             }
+            if (circuit_breaker_state(BREAKER_ENDPOINT_ERROR_LOGS) == BREAKER_STATE_OPEN ||
+                !pacing_try_acquire()) {
+                ESP_LOGD(TAG, "⏳ Breaker abierto o límite de peticiones alcanzado, reintentos pospuestos");
+                xQueueSend(retry_queue, &error, 0);
+                break;
+            }
             
             uint32_t occurrence_count = 1;
             esp_err_t result = send_error_to_backend(&error, occurrence_count);
             
             if (result == ESP_OK) {
-                sent_count++;
-                mark_error_as_sent(&error);
+                metrics_counter_inc(METRIC_ERRLOG_SENT);
+                error_logger_dedup_mark_sent(&error);
                 ESP_LOGI(TAG, "✅ Reintento exitoso");
+            } else if (result == ESP_ERR_INVALID_STATE) {
+                xQueueSend(retry_queue, &error, 0);
+                break;   // Prueba del breaker en curso: esperar su resultado
             } else {
+                metrics_counter_inc(METRIC_ERRLOG_FAILED);
                 // Volver a agregar a la cola de reintentos (al final)
                 xQueueSend(retry_queue, &error, 0);
                 
@@ -681,22 +743,22 @@ void task_error_logger(void *pvParameters)
         }
         
         // Limpieza periódica de tabla de deduplicación (cada 10 minutos)
-        uint32_t current_time = xTaskGetTickCount();
-        if ((current_time - last_cleanup) > pdMS_TO_TICKS(600000)) {
+        if (hal_clock_elapsed_ms(last_cleanup) > DEDUP_WINDOW_MS) {
             clear_old_dedup_entries();
-            last_cleanup = current_time;
+            last_cleanup = hal_clock_now_ms();
         }
         
         // Estadísticas cada 5 minutos
-        static uint32_t last_stats = 0;
-        if ((current_time - last_stats) > pdMS_TO_TICKS(300000)) {
+        if (hal_clock_elapsed_ms(last_stats) > 300000) {
             int pending = error_logger_get_pending_count();
             int retries = uxQueueMessagesWaiting(retry_queue);
             
             ESP_LOGI(TAG, "📊 Estadísticas - Enviados: %lu, Fallidos: %lu, Duplicados: %lu, Pendientes: %d, Reintentos: %d",
-                     (unsigned long)sent_count, (unsigned long)failed_count, (unsigned long)duplicate_count, pending, retries);
+                     (unsigned long)metrics_counter_get(METRIC_ERRLOG_SENT),
+                     (unsigned long)metrics_counter_get(METRIC_ERRLOG_FAILED),
+                     (unsigned long)metrics_counter_get(METRIC_ERRLOG_DUPLICATES), pending, retries);
             
-            last_stats = current_time;
+            last_stats = hal_clock_now_ms();
         }
     }
 }
@@ -34,7 +34,8 @@ typedef struct {
     char details_json[512];         // JSON string con detalles adicionales
     char ip_address[46];            // IPv6 max length
     char device_serial[32];
-    uint32_t timestamp;             // Timestamp cuando ocurrió el error
+    uint32_t timestamp;             // Instante en que ocurrió el error (ms, hal_clock; a UTC al enviar)
+    uint32_t seq;                   // Secuencia del flujo de errores (0 = sin asignar, ver sequence.h)
     bool pending;                   // true si aún no se ha enviado
 } error_log_entry_t;
 
@@ -85,6 +86,31 @@ int error_logger_get_pending_count(void);
  */
 void error_logger_trigger_retry(void);
 
+/**
+ * @brief Serializar un error al JSON que recibe /error-logs
+ *
+ * @param error Error a enviar
+ * @param occurrence_count Ocurrencias acumuladas (se agrega a details si es > 1)
+ * @return String JSON (liberar con free), o NULL si falla la memoria
+ */
+char *error_logger_build_payload(const error_log_entry_t *error, uint32_t occurrence_count);
+
+/**
+ * @brief Buscar un error en la tabla de deduplicación
+ *
+ * Si ya fue enviado recientemente incrementa su contador de ocurrencias.
+ *
+ * @param error Error a buscar
+ * @param occurrence_count Ocurrencias acumuladas (solo si es duplicado)
+ * @return true si el error es duplicado
+ */
+bool error_logger_dedup_check(const error_log_entry_t *error, uint32_t *occurrence_count);
+
+/**
+ * @brief Registrar un error como enviado en la tabla de deduplicación
+ */
+void error_logger_dedup_mark_sent(const error_log_entry_t *error);
+
 /**
  * @brief Tarea que procesa y envía errores al backend
  */
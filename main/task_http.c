@@ -7,9 +7,15 @@
 #include "config.h"
 #include "esp_log.h"
 #include "task_nvs.h"
-#include "esp_http_client.h"
-#include "esp_crt_bundle.h"
-#include "led_strip.h"
+#include "metrics.h"
+#include "pacing.h"
+#include "circuit_breaker.h"
+#include "sequence.h"
+#include "time_service.h"
+#include "http_compress.h"
+#include "config_sync.h"
+#include "hal_clock.h"
+#include "hal_http.h"
 #include "cJSON.h"
 #include <string.h>
 #include <math.h>
@@ -21,165 +27,181 @@ static int consecutive_failures = 0;
 static char response_buffer[1024];
 static int response_len = 0;
 
-// Callback para manejar la respuesta HTTP
-static esp_err_t http_event_handler(esp_http_client_event_t *evt)
+// Tramas que no se pudieron enviar (breaker abierto o petición fallida).
+// Anillo en RAM: con el buffer lleno se descarta la más antigua. Se drena
+// una por vuelta de la tarea mientras el breaker de /process-data esté cerrado.
+static sensor_frame_t local_buffer[HTTP_LOCAL_BUFFER_SIZE];
+static int local_buffer_head = 0;
+static int local_buffer_count = 0;
+
+static void local_buffer_push(const sensor_frame_t *frame)
 {
-    switch (evt->event_id)
-    {
-    case HTTP_EVENT_ERROR:
-        ESP_LOGW(TAG, "HTTP_EVENT_ERROR");
-        break;
-    case HTTP_EVENT_ON_CONNECTED:
-        ESP_LOGD(TAG, "HTTP_EVENT_ON_CONNECTED");
-        break;
-    case HTTP_EVENT_HEADER_SENT:
-        ESP_LOGD(TAG, "HTTP_EVENT_HEADER_SENT");
-        break;
-    case HTTP_EVENT_ON_HEADER:
-        ESP_LOGD(TAG, "HTTP_EVENT_ON_HEADER, key=%s, value=%s", evt->header_key, evt->header_value);
-        break;
-    case HTTP_EVENT_ON_DATA:
-        ESP_LOGD(TAG, "HTTP_EVENT_ON_DATA, len=%d", evt->data_len);
-        if (!esp_http_client_is_chunked_response(evt->client)) {
-            // Capturar respuesta en buffer global
-            if (evt->data_len > 0 && response_len + evt->data_len < sizeof(response_buffer) - 1) {
-                memcpy(response_buffer + response_len, evt->data, evt->data_len);
-                response_len += evt->data_len;
-                response_buffer[response_len] = '\0';
-                ESP_LOGD(TAG, "Respuesta HTTP capturada: %.*s", evt->data_len, (char*)evt->data);
-            }
-        }
-        break;
-    case HTTP_EVENT_ON_FINISH:
-        ESP_LOGD(TAG, "HTTP_EVENT_ON_FINISH");
-        break;
-    case HTTP_EVENT_DISCONNECTED:
-        ESP_LOGD(TAG, "HTTP_EVENT_DISCONNECTED");
-        break;
-    case HTTP_EVENT_REDIRECT:
-        ESP_LOGD(TAG, "HTTP_EVENT_REDIRECT");
-        break;
+    if (local_buffer_count == HTTP_LOCAL_BUFFER_SIZE) {
+        local_buffer_head = (local_buffer_head + 1) % HTTP_LOCAL_BUFFER_SIZE;
+        local_buffer_count--;
+        metrics_counter_inc(METRIC_LOCAL_BUFFER_DROPS);
     }
-    return ESP_OK;
+    int tail = (local_buffer_head + local_buffer_count) % HTTP_LOCAL_BUFFER_SIZE;
+    local_buffer[tail] = *frame;
+    local_buffer_count++;
+    metrics_counter_inc(METRIC_LOCAL_BUFFERED);
+    metrics_gauge_set(METRIC_GAUGE_LOCAL_BUFFER_DEPTH, local_buffer_count);
 }
 
-// Función para procesar respuesta del servidor y actualizar configuración
-static esp_err_t process_server_response(sensor_type_t sensor_type)
+// Devolver al frente una trama sacada del buffer cuyo reenvío falló
+static void local_buffer_requeue(const sensor_frame_t *frame)
 {
-    if (response_len == 0) {
-        ESP_LOGD(TAG, "No hay respuesta del servidor");
-        return ESP_OK;
+    if (local_buffer_count == HTTP_LOCAL_BUFFER_SIZE) {
+        metrics_counter_inc(METRIC_LOCAL_BUFFER_DROPS);     // Es la más antigua: se descarta
+        return;
     }
+    local_buffer_head = (local_buffer_head + HTTP_LOCAL_BUFFER_SIZE - 1) % HTTP_LOCAL_BUFFER_SIZE;
+    local_buffer[local_buffer_head] = *frame;
+    local_buffer_count++;
+    metrics_gauge_set(METRIC_GAUGE_LOCAL_BUFFER_DEPTH, local_buffer_count);
+}
 
-    ESP_LOGI(TAG, "📥 Procesando respuesta del servidor: %s", response_buffer);
-
-    // Parsear JSON de respuesta
-    cJSON *json = cJSON_Parse(response_buffer);
-    if (json == NULL) {
-        ESP_LOGW(TAG, "⚠ Respuesta no es JSON válido");
-        return ESP_FAIL;
+static void local_buffer_pop(void)
+{
+    if (local_buffer_count > 0) {
+        local_buffer_head = (local_buffer_head + 1) % HTTP_LOCAL_BUFFER_SIZE;
+        local_buffer_count--;
+        metrics_gauge_set(METRIC_GAUGE_LOCAL_BUFFER_DEPTH, local_buffer_count);
     }
+}
 
-    // Buscar objeto sensorConfig en la respuesta
-    cJSON *sensor_config = cJSON_GetObjectItem(json, "sensorConfig");
-    if (sensor_config != NULL && cJSON_IsObject(sensor_config)) {
-        ESP_LOGI(TAG, "🔧 Procesando configuración del sensor desde respuesta del servidor");
+// Tipo de sensor de un serial (SENSOR_TYPE_UNKNOWN si no es de este dispositivo)
+static sensor_type_t sensor_type_from_serial(const char *serial)
+{
+    if (serial != NULL && strcmp(serial, DEVICE_SERIAL_HUMIDITY) == 0) {
+        return SENSOR_TYPE_SOIL_HUMIDITY;
+    }
+    if (serial != NULL && strcmp(serial, DEVICE_SERIAL_LIGHT) == 0) {
+        return SENSOR_TYPE_LIGHT;
+    }
+    return SENSOR_TYPE_UNKNOWN;
+}
 
-        // NO LEER interval_seconds del backend - solo se configura por MQTT
-        // Comentado según requisito: "No leas el interval_seconds del backend"
-        /*
-        // Extraer interval_seconds del sensorConfig
-        cJSON *interval_item = cJSON_GetObjectItem(sensor_config, "interval_seconds");
-        if (cJSON_IsNumber(interval_item)) {
-            int new_interval = interval_item->valueint;
-            if (new_interval > 0) {
-                // Actualizar intervalo global
-                if (new_interval != (sensor_post_interval_ms / 1000)) {
-                    sensor_post_interval_ms = new_interval * 1000;
-                    ESP_LOGI(TAG, "🔄 Intervalo de posting actualizado desde servidor: %d segundos (%lu ms)", 
-                            new_interval, sensor_post_interval_ms);
-                }
-                
-                // Actualizar configuración específica del sensor
-                extern sensor_config_t g_sensor_humidity_config;
-                extern sensor_config_t g_sensor_light_config;
-                
-                switch (sensor_type) {
-                    case SENSOR_TYPE_SOIL_HUMIDITY:
-                        if (g_sensor_humidity_config.interval_s != new_interval) {
-                            g_sensor_humidity_config.interval_s = new_interval;
-                            ESP_LOGI(TAG, "💧 Intervalo sensor humedad actualizado: %d segundos", new_interval);
-                        }
-                        break;
-                    case SENSOR_TYPE_LIGHT:
-                        if (g_sensor_light_config.interval_s != new_interval) {
-                            g_sensor_light_config.interval_s = new_interval;
-                            ESP_LOGI(TAG, "💡 Intervalo sensor luz actualizado: %d segundos", new_interval);
-                        }
-                        break;
-                    default:
-                        break;
-                }
+// Aplicar un objeto sensorConfig de la respuesta del servidor a un sensor
+static void apply_sensor_config(sensor_type_t sensor_type, cJSON *sensor_config)
+{
+    ESP_LOGI(TAG, "🔧 Procesando configuración del sensor desde respuesta del servidor");
+
+    // NO LEER interval_seconds del backend - solo se configura por MQTT
+    // Comentado según requisito: "No leas el interval_seconds del backend"
+    /*
+    // Extraer interval_seconds del sensorConfig
+    cJSON *interval_item = cJSON_GetObjectItem(sensor_config, "interval_seconds");
+    if (cJSON_IsNumber(interval_item)) {
+        int new_interval = interval_item->valueint;
+        if (new_interval > 0) {
+            // Actualizar intervalo global
+            if (new_interval != (sensor_post_interval_ms / 1000)) {
+                sensor_post_interval_ms = new_interval * 1000;
+                ESP_LOGI(TAG, "🔄 Intervalo de posting actualizado desde servidor: %d segundos (%lu ms)", 
+                        new_interval, sensor_post_interval_ms);
             }
-        }
-        */
-
-        // Extraer id_sensor del sensorConfig
-        cJSON *id_item = cJSON_GetObjectItem(sensor_config, "id_sensor");
-        if (cJSON_IsNumber(id_item)) {
-            int server_id_sensor = id_item->valueint;
-            ESP_LOGI(TAG, "🆔 ID sensor recibido del servidor: %d", server_id_sensor);
             
-            // Actualizar ID del sensor correspondiente
+            // Actualizar configuración específica del sensor
             extern sensor_config_t g_sensor_humidity_config;
             extern sensor_config_t g_sensor_light_config;
             
             switch (sensor_type) {
                 case SENSOR_TYPE_SOIL_HUMIDITY:
-                    if (g_sensor_humidity_config.id_sensor != server_id_sensor) {
-                        g_sensor_humidity_config.id_sensor = server_id_sensor;
-                        ESP_LOGI(TAG, "💧 ID sensor humedad actualizado: %d", server_id_sensor);
+                    if (g_sensor_humidity_config.interval_s != new_interval) {
+                        g_sensor_humidity_config.interval_s = new_interval;
+                        ESP_LOGI(TAG, "💧 Intervalo sensor humedad actualizado: %d segundos", new_interval);
                     }
                     break;
                 case SENSOR_TYPE_LIGHT:
-                    if (g_sensor_light_config.id_sensor != server_id_sensor) {
-                        g_sensor_light_config.id_sensor = server_id_sensor;
-                        ESP_LOGI(TAG, "💡 ID sensor luz actualizado: %d", server_id_sensor);
+                    if (g_sensor_light_config.interval_s != new_interval) {
+                        g_sensor_light_config.interval_s = new_interval;
+                        ESP_LOGI(TAG, "💡 Intervalo sensor luz actualizado: %d segundos", new_interval);
                     }
                     break;
                 default:
                     break;
             }
         }
+    }
+    */
 
-        // Extraer state del sensorConfig
-        cJSON *state_item = cJSON_GetObjectItem(sensor_config, "state");
-        if (cJSON_IsBool(state_item)) {
-            bool sensor_state = cJSON_IsTrue(state_item);
-            ESP_LOGI(TAG, "📊 Estado del sensor recibido del servidor: %s", sensor_state ? "activo" : "inactivo");
-            
-            // Actualizar estado del sensor correspondiente
-            extern sensor_config_t g_sensor_humidity_config;
-            extern sensor_config_t g_sensor_light_config;
-            
-            switch (sensor_type) {
-                case SENSOR_TYPE_SOIL_HUMIDITY:
-                    if (g_sensor_humidity_config.state != sensor_state) {
-                        g_sensor_humidity_config.state = sensor_state;
-                        ESP_LOGI(TAG, "💧 Estado sensor humedad actualizado: %s", sensor_state ? "activo" : "inactivo");
-                    }
-                    break;
-                case SENSOR_TYPE_LIGHT:
-                    if (g_sensor_light_config.state != sensor_state) {
-                        g_sensor_light_config.state = sensor_state;
-                        ESP_LOGI(TAG, "💡 Estado sensor luz actualizado: %s", sensor_state ? "activo" : "inactivo");
-                    }
-                    break;
-                default:
-                    break;
-            }
+    // Los cambios se publican juntos al final (una versión nueva, sin estados intermedios)
+    sensor_config_t *config = sensor_config_begin_update(sensor_type);
+    if (config == NULL) {
+        return;
+    }
+    const char *icon = sensor_type == SENSOR_TYPE_LIGHT ? "💡" : "💧";
+    const char *sensor_name = sensor_type == SENSOR_TYPE_LIGHT ? "luz" : "humedad";
+
+    // Extraer id_sensor del sensorConfig
+    cJSON *id_item = cJSON_GetObjectItem(sensor_config, "id_sensor");
+    if (cJSON_IsNumber(id_item)) {
+        int server_id_sensor = id_item->valueint;
+        ESP_LOGI(TAG, "🆔 ID sensor recibido del servidor: %d", server_id_sensor);
+        
+        // Actualizar ID del sensor correspondiente
+        if (config->id_sensor != server_id_sensor) {
+            config->id_sensor = server_id_sensor;
+            ESP_LOGI(TAG, "%s ID sensor %s actualizado: %d", icon, sensor_name, server_id_sensor);
         }
+    }
+
+    // Extraer state del sensorConfig
+    cJSON *state_item = cJSON_GetObjectItem(sensor_config, "state");
+    if (cJSON_IsBool(state_item)) {
+        bool sensor_state = cJSON_IsTrue(state_item);
+        ESP_LOGI(TAG, "📊 Estado del sensor recibido del servidor: %s", sensor_state ? "activo" : "inactivo");
+        
+        // Actualizar estado del sensor correspondiente
+        if (config->state != sensor_state) {
+            config->state = sensor_state;
+            ESP_LOGI(TAG, "%s Estado sensor %s actualizado: %s", icon, sensor_name, sensor_state ? "activo" : "inactivo");
+        }
+    }
+    sensor_config_end_update(sensor_type);
+}
+
+// Función para procesar respuesta del servidor y actualizar configuración
+static esp_err_t process_server_response(const sensor_frame_t *frame)
+{
+    if (response_len == 0) {
+        ESP_LOGD(TAG, "No hay respuesta del servidor");
+        return ESP_OK;
+    }
+
+    ESP_LOGI(TAG, "📥 Procesando respuesta del servidor: %s", response_buffer);
+
+    // Parsear JSON de respuesta
+    cJSON *json = cJSON_Parse(response_buffer);
+    if (json == NULL) {
+        ESP_LOGW(TAG, "⚠ Respuesta no es JSON válido");
+        return ESP_FAIL;
+    }
 
+    // Una trama con varios sensores recibe sensorConfigs: un objeto por sensor con su serial
+    cJSON *sensor_configs = cJSON_GetObjectItem(json, "sensorConfigs");
+    cJSON *sensor_config = cJSON_GetObjectItem(json, "sensorConfig");
+    if (sensor_configs != NULL && cJSON_IsArray(sensor_configs)) {
+        cJSON *item = NULL;
+        cJSON_ArrayForEach(item, sensor_configs) {
+            cJSON *serial_item = cJSON_GetObjectItem(item, "serial");
+            sensor_type_t sensor_type = cJSON_IsString(serial_item) ?
+                                        sensor_type_from_serial(serial_item->valuestring) : SENSOR_TYPE_UNKNOWN;
+            if (!cJSON_IsObject(item) || sensor_type == SENSOR_TYPE_UNKNOWN) {
+                ESP_LOGW(TAG, "⚠ sensorConfig sin serial de este dispositivo, ignorado");
+                continue;
+            }
+            apply_sensor_config(sensor_type, item);
+        }
+    } else if (sensor_config != NULL && cJSON_IsObject(sensor_config)) {
+        // Respuesta de un solo sensor: solo se sabe a cuál corresponde si la trama tenía uno
+        if (frame->count == 1) {
+            apply_sensor_config(frame->readings[0].type, sensor_config);
+        } else {
+            ESP_LOGW(TAG, "⚠ sensorConfig sin serial para una trama de %u lecturas, ignorado",
+                     (unsigned)frame->count);
+        }
     } else {
         ESP_LOGD(TAG, "ℹ No se encontró objeto sensorConfig en la respuesta");
         
@@ -203,28 +225,69 @@ static esp_err_t process_server_response(sensor_type_t sensor_type)
     return ESP_OK;
 }
 
-// Función genérica para enviar datos de sensor al servidor
-static esp_err_t send_sensor_value(const sensor_data_t *sensor_data, int id_sensor, const char *device_serial)
+// Serial del sensor en el backend
+static const char *sensor_serial_for_type(sensor_type_t type)
+{
+    switch (type) {
+        case SENSOR_TYPE_LIGHT:
+            return DEVICE_SERIAL_LIGHT;
+        case SENSOR_TYPE_SOIL_HUMIDITY:
+        default:
+            return DEVICE_SERIAL_HUMIDITY; // fallback
+    }
+}
+
+// Configuración de cada sensor vista por esta tarea: copia local que se vuelve
+// a copiar solo cuando sube la versión publicada (task_sensor_config.h)
+static sensor_config_snapshot_t http_configs[2];
+
+// Configuración de un sensor (la de humedad para tipos desconocidos)
+static const sensor_config_t *http_sensor_config(sensor_type_t type)
+{
+    if (type != SENSOR_TYPE_LIGHT) {
+        type = SENSOR_TYPE_SOIL_HUMIDITY;
+    }
+    sensor_config_refresh_snapshot(type, &http_configs[type]);
+    return &http_configs[type].config;
+}
+
+// ID del sensor desde su configuración (1 por defecto si todavía no se conoce)
+static int sensor_id_for_type(sensor_type_t type)
+{
+    int id_sensor = 0;
+    switch (type) {
+        case SENSOR_TYPE_SOIL_HUMIDITY:
+        case SENSOR_TYPE_LIGHT:
+            id_sensor = http_sensor_config(type)->id_sensor;
+            break;
+        default:
+            break;
+    }
+    return id_sensor != 0 ? id_sensor : 1;
+}
+
+// Serializar una lectura de la trama (valor, unidad, tipo, serial e ID del sensor)
+static cJSON *build_reading_json(const sensor_reading_t *reading)
 {
     // Determinar valor, unidad y tipo según el tipo de sensor
     float value_to_send;
     const char *unit;
     const char *sensor_type;
 
-    switch (sensor_data->type) {
+    switch (reading->type) {
         case SENSOR_TYPE_SOIL_HUMIDITY:
-            value_to_send = sensor_data->converted_value; // HS%
+            value_to_send = reading->converted_value; // HS%
             unit = "HS%";
             sensor_type = "humidity";
             break;
         case SENSOR_TYPE_LIGHT:
-            value_to_send = sensor_data->converted_value; // LM%
+            value_to_send = reading->converted_value; // LM%
             unit = "LM%";
             sensor_type = "light";
             break;
         default:
             // Fallback para sensores desconocidos - enviar voltaje
-            value_to_send = sensor_data->adc_voltage;
+            value_to_send = reading->adc_voltage;
             unit = "mV";
             sensor_type = "voltage";
             break;
@@ -232,85 +295,121 @@ static esp_err_t send_sensor_value(const sensor_data_t *sensor_data, int id_sens
 
     // Redondear valor a 2 decimales (excepto para porcentaje que puede ser 1 decimal)
     float value_rounded;
-    if (sensor_data->type == SENSOR_TYPE_SOIL_HUMIDITY) {
+    if (reading->type == SENSOR_TYPE_SOIL_HUMIDITY) {
         value_rounded = roundf(value_to_send * 10.0f) / 10.0f; // 1 decimal para %
     } else {
         value_rounded = roundf(value_to_send * 100.0f) / 100.0f; // 2 decimales para otros
     }
 
-    // Crear JSON con los datos del sensor
-    cJSON *root = cJSON_CreateObject();
-
     // Formatear el valor como string
     char value_str[16];
-    if (sensor_data->type == SENSOR_TYPE_SOIL_HUMIDITY) {
+    if (reading->type == SENSOR_TYPE_SOIL_HUMIDITY) {
         snprintf(value_str, sizeof(value_str), "%.1f", value_rounded);
     } else {
         snprintf(value_str, sizeof(value_str), "%.2f", value_rounded);
     }
 
-    // Añadir campos al JSON
-    cJSON_AddStringToObject(root, "value", value_str);
-    cJSON_AddStringToObject(root, "unit", unit);
-    cJSON_AddStringToObject(root, "type", sensor_type);
-    cJSON_AddNumberToObject(root, "id_sensor", id_sensor);
-    cJSON_AddNumberToObject(root, "raw_value", sensor_data->raw_value);
-
-    // Obtener timestamp actual
-    uint32_t timestamp = xTaskGetTickCount() * portTICK_PERIOD_MS;
-    cJSON_AddNumberToObject(root, "timestamp", timestamp);
-
-    char *json_string = cJSON_Print(root);
-    if (json_string == NULL) {
-        ESP_LOGE(TAG, "Error creando JSON string");
-        cJSON_Delete(root);
-        return ESP_FAIL;
+    cJSON *item = cJSON_CreateObject();
+    if (item == NULL) {
+        return NULL;
     }
+    cJSON_AddStringToObject(item, "value", value_str);
+    cJSON_AddStringToObject(item, "unit", unit);
+    cJSON_AddStringToObject(item, "type", sensor_type);
+    cJSON_AddNumberToObject(item, "id_sensor", sensor_id_for_type(reading->type));
+    cJSON_AddStringToObject(item, "serial", sensor_serial_for_type(reading->type));
+    cJSON_AddNumberToObject(item, "raw_value", reading->raw_value);
+    return item;
+}
 
-    ESP_LOGI(TAG, "🚀 Enviando datos del sensor [%s]: %s", device_serial, json_string);
+// Serializar una trama al JSON de /process-data (el llamador libera con free)
+char *http_build_frame_payload(const sensor_frame_t *frame)
+{
+    cJSON *root = cJSON_CreateObject();
+    if (root == NULL) {
+        return NULL;
+    }
 
-    // Limpiar buffer de respuesta antes de nueva petición
-    response_len = 0;
-    memset(response_buffer, 0, sizeof(response_buffer));
+    // Todas las lecturas del ciclo en un mismo cuerpo, cada una con su serial e ID
+    cJSON *readings = cJSON_AddArrayToObject(root, "readings");
+    for (int i = 0; i < frame->count && readings != NULL; i++) {
+        cJSON *item = build_reading_json(&frame->readings[i]);
+        if (item == NULL) {
+            cJSON_Delete(root);
+            return NULL;
+        }
+        cJSON_AddItemToArray(readings, item);
+    }
 
-    // Configurar cliente HTTP
-    esp_http_client_config_t config = {
-        .url = HTTP_SERVER_URL,
-        .method = HTTP_METHOD_POST,
-        .event_handler = http_event_handler,
-        .timeout_ms = HTTP_TIMEOUT_MS,
-        .crt_bundle_attach = esp_crt_bundle_attach,
-    };
+    // Instante del ciclo en UTC, uno para toda la trama (las que salen del buffer local
+    // llegan tarde, no con otra hora; las tomadas antes de sincronizar se corrigen hacia atrás)
+    uint32_t timestamp = frame->timestamp ? frame->timestamp : hal_clock_now_ms();
+    time_service_add_stamp_json(root, timestamp);
 
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    if (client == NULL) {
-        ESP_LOGE(TAG, "Error inicializando cliente HTTP");
-        free(json_string);
-        cJSON_Delete(root);
-        return ESP_FAIL;
+    // Idempotencia y detección de pérdidas: huecos de seq dentro del mismo boot_id
+    if (frame->seq != 0) {
+        cJSON_AddNumberToObject(root, "seq", frame->seq);
     }
 
-    // Configurar headers
-    esp_http_client_set_header(client, "Content-Type", "application/json");
-
-    // Configurar datos POST
-    esp_http_client_set_post_field(client, json_string, strlen(json_string));
+    char *json_string = cJSON_Print(root);
+    cJSON_Delete(root);
+    return json_string;
+}
 
-    // Realizar petición
-    esp_err_t err = esp_http_client_perform(client);
-    int status_code = esp_http_client_get_status_code(client);
+// POST de datos en curso. Uno a la vez: mientras el backend responde, la
+// tarea sigue consumiendo la cola de sensores y la petición avanza con
+// hal_http_poll() en cada vuelta del loop (ver http_inflight_poll).
+typedef struct {
+    bool active;
+    bool from_buffer;                   // Trama tomada del buffer local
+    hal_http_async_t handle;
+    sensor_frame_t frame;
+    char *json_string;
+    uint8_t body_buffer[HTTP_COMPRESS_BUFFER_SIZE];    // Cuerpo comprimido (si conviene)
+    hal_http_header_t headers[4];
+    char trace_header[64];
+    char idempotency_key[SEQUENCE_KEY_MAX_LEN];
+    hal_http_request_t request;
+    sample_trace_t trace;               // Copia local: se completan envío y confirmación
+    int64_t start_us;
+} http_inflight_t;
+
+static http_inflight_t inflight;
+
+// Sumar el tiempo pasado dentro de hal_http (la tarea no atiende la cola mientras tanto)
+static void http_account_blocked(int64_t since_us)
+{
+    metrics_counter_add(METRIC_HTTP_BLOCKED_MS, (uint32_t)((hal_clock_now_us() - since_us) / 1000));
+}
 
-    // Limpiar cliente HTTP
-    esp_http_client_cleanup(client);
-    free(json_string);
-    cJSON_Delete(root);
+// Cerrar el POST en curso: breaker, métricas, traza y respuesta del servidor
+static esp_err_t send_frame_value_finish(esp_err_t err, const hal_http_response_t *response)
+{
+    const sensor_frame_t *frame = &inflight.frame;
+    uint32_t post_ms = (uint32_t)((hal_clock_now_us() - inflight.start_us) / 1000);
+    metrics_histogram_record(METRIC_HIST_HTTP_POST_MS, post_ms);
+    metrics_counter_add(METRIC_HTTP_INFLIGHT_MS, post_ms);
+    int status_code = response->status_code;
+    response_len = (int)response->response_len;
+
+    free(inflight.json_string);
+    inflight.json_string = NULL;
+    circuit_breaker_record(BREAKER_ENDPOINT_PROCESS_DATA,
+                           err == ESP_OK && status_code >= 200 && status_code < 300, post_ms);
+
+    if (err == ESP_OK && status_code >= 200 && status_code < 300) {
+        metrics_trace_mark(inflight.trace.acked_us);
+    }
+    metrics_trace_finish(&inflight.trace);
 
     if (err == ESP_OK) {
         if (status_code >= 200 && status_code < 300) {
-            ESP_LOGI(TAG, "✅ Datos del sensor [%s] enviados exitosamente (HTTP %d)", device_serial, status_code);
+            ESP_LOGI(TAG, "✅ Trama de %u lecturas enviada exitosamente (HTTP %d, traza %08lx, %lu ms desde la lectura)",
+                     (unsigned)frame->count, status_code, (unsigned long)inflight.trace.trace_id,
+                     (unsigned long)((inflight.trace.acked_us - inflight.trace.sampled_us) / 1000));
             
             // Procesar respuesta del servidor para actualizar configuración
-            esp_err_t config_result = process_server_response(sensor_data->type);
+            esp_err_t config_result = process_server_response(frame);
             if (config_result != ESP_OK) {
                 ESP_LOGW(TAG, "⚠ Error procesando configuración de respuesta");
             }
@@ -320,7 +419,6 @@ static esp_err_t send_sensor_value(const sensor_data_t *sensor_data, int id_sens
             memset(response_buffer, 0, sizeof(response_buffer));
             
             consecutive_failures = 0;
-            reset_http_backoff();
             return ESP_OK;
         } else {
             ESP_LOGW(TAG, "⚠ Servidor respondió con código HTTP %d", status_code);
@@ -331,9 +429,8 @@ static esp_err_t send_sensor_value(const sensor_data_t *sensor_data, int id_sens
             if (consecutive_failures >= 3) {
                 char details[256];
                 snprintf(details, sizeof(details), 
-                         "{\"http_code\": %d, \"consecutive_failures\": %d, \"sensor_type\": \"%s\"}",
-                         status_code, consecutive_failures, 
-                         sensor_data->type == SENSOR_TYPE_SOIL_HUMIDITY ? "humidity" : "light");
+                         "{\"http_code\": %d, \"consecutive_failures\": %d, \"readings\": %u}",
+                         status_code, consecutive_failures, (unsigned)frame->count);
                 error_logger_log_system(
                     "HTTP_SERVER_ERROR",
                     ERROR_SEVERITY_WARNING,
@@ -353,9 +450,8 @@ static esp_err_t send_sensor_value(const sensor_data_t *sensor_data, int id_sens
         if (consecutive_failures >= 3) {
             char details[256];
             snprintf(details, sizeof(details), 
-                     "{\"error_esp\": \"%s\", \"consecutive_failures\": %d, \"sensor_type\": \"%s\"}",
-                     esp_err_to_name(err), consecutive_failures,
-                     sensor_data->type == SENSOR_TYPE_SOIL_HUMIDITY ? "humidity" : "light");
+                     "{\"error_esp\": \"%s\", \"consecutive_failures\": %d, \"readings\": %u}",
+                     esp_err_to_name(err), consecutive_failures, (unsigned)frame->count);
             error_logger_log_system(
                 "HTTP_CONNECTION_ERROR",
                 ERROR_SEVERITY_ERROR,
@@ -368,144 +464,251 @@ static esp_err_t send_sensor_value(const sensor_data_t *sensor_data, int id_sens
     }
 }
 
-// Función para validar el dispositivo consultando el endpoint de sensores por serial (GET)
-esp_err_t validate_device_serial(const char *device_serial)
+// Iniciar el POST de una trama sin esperar la respuesta.
+// ESP_OK: petición en curso. ESP_ERR_INVALID_STATE: el breaker de
+// /process-data la rechazó sin tocar la red. ESP_FAIL: falló al iniciar.
+static esp_err_t send_frame_value_start(const sensor_frame_t *frame)
 {
-    ESP_LOGI(TAG, "🔍 Validando dispositivo con serial: %s", device_serial);
+    uint32_t budget_ms;
+    if (!circuit_breaker_acquire(BREAKER_ENDPOINT_PROCESS_DATA, HTTP_TIMEOUT_MS, &budget_ms)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    char *json_string = http_build_frame_payload(frame);
+    if (json_string == NULL) {
+        ESP_LOGE(TAG, "Error creando JSON string");
+        circuit_breaker_record(BREAKER_ENDPOINT_PROCESS_DATA, true, 0);   // Falla local, no del backend
+        return ESP_FAIL;
+    }
 
-    // Construir URL
-    char url[256];
-    snprintf(url, sizeof(url), "%s%s", HTTP_CONFIG_URL, device_serial);
+    inflight.frame = *frame;
+    inflight.json_string = json_string;
+    inflight.trace = frame->trace;
+    metrics_trace_mark(inflight.trace.serialized_us);
 
-    ESP_LOGI(TAG, "URL de validación: %s", url);
+    ESP_LOGI(TAG, "🚀 Enviando trama de %u lecturas: %s", (unsigned)frame->count, json_string);
 
-    // Configurar cliente HTTP
-    esp_http_client_config_t config = {
-        .url = url,
-        .method = HTTP_METHOD_GET,
-        .event_handler = http_event_handler,
-        .timeout_ms = HTTP_TIMEOUT_MS,
-        .crt_bundle_attach = esp_crt_bundle_attach,
+    // Limpiar buffer de respuesta antes de nueva petición
+    response_len = 0;
+    memset(response_buffer, 0, sizeof(response_buffer));
+
+    // Configurar headers
+    inflight.headers[0] = (hal_http_header_t){"Content-Type", "application/json"};
+    size_t header_count = 1;
+
+    const char *body;
+    size_t body_len;
+    const char *content_encoding = http_compress_body(json_string, inflight.body_buffer, sizeof(inflight.body_buffer),
+                                                      &body, &body_len);
+    if (content_encoding != NULL) {
+        inflight.headers[header_count++] = (hal_http_header_t){"Content-Encoding", content_encoding};
+    }
+
+    // Misma clave en cada reintento de esta trama: el backend descarta los duplicados
+    if (frame->seq != 0 &&
+        sequence_idempotency_key(SEQUENCE_STREAM_FRAMES, frame->seq, inflight.idempotency_key,
+                                 sizeof(inflight.idempotency_key)) > 0) {
+        inflight.headers[header_count++] = (hal_http_header_t){HTTP_IDEMPOTENCY_HEADER_NAME, inflight.idempotency_key};
+    }
+
+#if HTTP_TRACE_HEADER_ENABLED
+    // Contexto de traza: id y antigüedad de la muestra al serializar, para medir frescura en el backend
+    const sample_trace_t *trace = &inflight.trace;
+    snprintf(inflight.trace_header, sizeof(inflight.trace_header), "id=%08lx;age_ms=%lu;queue_ms=%lu",
+             (unsigned long)trace->trace_id,
+             (unsigned long)((trace->serialized_us - trace->sampled_us) / 1000),
+             (unsigned long)(trace->dequeued_us > trace->enqueued_us ? (trace->dequeued_us - trace->enqueued_us) / 1000 : 0));
+    inflight.headers[header_count++] = (hal_http_header_t){HTTP_TRACE_HEADER_NAME, inflight.trace_header};
+#endif
+
+    inflight.request = (hal_http_request_t){
+        .url = HTTP_SERVER_URL,
+        .method = HAL_HTTP_METHOD_POST,
+        .headers = inflight.headers,
+        .header_count = header_count,
+        .body = body,
+        .body_len = body_len,
+        .timeout_ms = (int)budget_ms,
+        .response_buf = response_buffer,
+        .response_buf_size = sizeof(response_buffer),
+        .sent_us = &inflight.trace.sent_us,
     };
 
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    if (client == NULL) {
-        ESP_LOGE(TAG, "Error inicializando cliente HTTP para validación");
+    // Se mide la latencia completa, incluido el handshake TLS
+    inflight.start_us = hal_clock_now_us();
+    esp_err_t err = hal_http_start(&inflight.request, &inflight.handle);
+    http_account_blocked(inflight.start_us);
+    if (err != ESP_OK) {
+        send_frame_value_finish(err, &(hal_http_response_t){0});
         return ESP_FAIL;
     }
+    inflight.active = true;
+    return ESP_OK;
+}
 
-    // Limpiar buffer de respuesta antes de la petición
-    response_len = 0;
-    memset(response_buffer, 0, sizeof(response_buffer));
+// Iniciar el envío de una trama al servidor (mismos códigos que send_frame_value_start)
+static esp_err_t send_frame_data_start(const sensor_frame_t *frame, bool from_buffer)
+{
+    ESP_LOGI(TAG, "=== ENVIANDO TRAMA DE SENSORES (%u lecturas) ===", (unsigned)frame->count);
+    for (int i = 0; i < frame->count; i++) {
+        const sensor_reading_t *reading = &frame->readings[i];
+        // Determinar qué mostrar en logs según el tipo de sensor
+        switch (reading->type) {
+            case SENSOR_TYPE_SOIL_HUMIDITY:
+                ESP_LOGI(TAG, "HS [%s]: %.1f%%, Voltaje: %.0f mV, Raw: %d", DEVICE_SERIAL_HUMIDITY,
+                        reading->converted_value, reading->adc_voltage, reading->raw_value);
+                break;
+            case SENSOR_TYPE_LIGHT:
+                ESP_LOGI(TAG, "Luz [%s]: %.0f LM%%, Voltaje: %.0f mV, Raw: %d", DEVICE_SERIAL_LIGHT,
+                        reading->converted_value, reading->adc_voltage, reading->raw_value);
+                break;
+            default:
+                ESP_LOGI(TAG, "Valor: %.2f, Voltaje: %.0f mV, Raw: %d", 
+                        reading->converted_value, reading->adc_voltage, reading->raw_value);
+                break;
+        }
+    }
 
-    // Realizar petición
-    esp_err_t err = esp_http_client_perform(client);
-    int status_code = esp_http_client_get_status_code(client);
+    inflight.from_buffer = from_buffer;
+    return send_frame_value_start(frame);
+}
 
-    // Mostrar respuesta del servidor para debugging
-    ESP_LOGI(TAG, "📥 Respuesta validación [%s]: HTTP %d, Error: %s", device_serial, status_code, esp_err_to_name(err));
-    if (response_len > 0) {
-        ESP_LOGI(TAG, "📄 Contenido respuesta: %s", response_buffer);
+// Resultado final de una trama: confirmada por el backend o de vuelta al buffer local
+static void frame_done(const sensor_frame_t *frame, bool from_buffer, esp_err_t result)
+{
+    if (result == ESP_OK) {
+        ESP_LOGI(TAG, "✅ Datos enviados exitosamente");
+        send_led_status(SYSTEM_STATE_HTTP_SEND, "Datos enviados");
+        metrics_counter_inc(METRIC_HTTP_POSTS_OK);
+        task_send_status(TASK_TYPE_HTTP, "Datos enviados OK");
+        if (from_buffer) {
+            metrics_counter_inc(METRIC_LOCAL_BUFFER_SENT);
+        }
+        return;
     }
 
-    esp_http_client_cleanup(client);
+    if (result == ESP_ERR_INVALID_STATE) {
+        // Breaker abierto: no se espera al backend
+        ESP_LOGW(TAG, "⛔ Backend en falla (breaker abierto), trama al buffer local");
+        send_led_status(SYSTEM_STATE_WARNING, "Backend no disponible");
+    } else {
+        ESP_LOGE(TAG, "❌ Error enviando datos");
+        send_led_status(SYSTEM_STATE_ERROR, "Error HTTP");
+        metrics_counter_inc(METRIC_HTTP_POSTS_FAILED);
+        task_report_error(TASK_TYPE_HTTP, TASK_ERROR_TIMEOUT, "HTTP send failed");
+    }
 
-    if (err == ESP_OK) {
-        if (status_code >= 200 && status_code < 300) {
-            ESP_LOGI(TAG, "✅ Dispositivo [%s] validado exitosamente (HTTP %d)", device_serial, status_code);
-            return ESP_OK;
-        } else {
-            ESP_LOGW(TAG, "⚠ Dispositivo [%s] no válido (HTTP %d) - pero continuando con envío de datos", device_serial, status_code);
-            // NO retornar ESP_FAIL aquí - permitir que el envío de datos funcione
-            return ESP_OK;
-        }
+    // La trama no se pierde: queda en RAM hasta que el backend responda
+    if (from_buffer) {
+        local_buffer_requeue(frame);
     } else {
-        ESP_LOGE(TAG, "❌ Error validando dispositivo [%s]: %s - pero continuando con envío de datos", device_serial, esp_err_to_name(err));
-        // NO retornar ESP_FAIL aquí - permitir que el envío de datos funcione
-        return ESP_OK;
+        local_buffer_push(frame);
     }
 }
 
-// Función para enviar datos del sensor al servidor
-esp_err_t send_sensor_data(const sensor_data_t *sensor_data)
+// Enviar una trama: queda en curso o, si no pudo salir, resuelta en el acto
+static void http_dispatch(const sensor_frame_t *frame, bool from_buffer)
 {
-    // Determinar qué mostrar en logs según el tipo de sensor
-    switch (sensor_data->type) {
-        case SENSOR_TYPE_SOIL_HUMIDITY:
-            ESP_LOGI(TAG, "=== ENVIANDO DATOS HUMEDAD SUELO ===");
-            ESP_LOGI(TAG, "HS: %.1f%%, Voltaje: %.0f mV, Raw: %d", 
-                    sensor_data->converted_value, sensor_data->adc_voltage, sensor_data->raw_value);
-            break;
-        case SENSOR_TYPE_LIGHT:
-            ESP_LOGI(TAG, "=== ENVIANDO DATOS LUZ ===");
-            ESP_LOGI(TAG, "Luz: %.0f LM%%, Voltaje: %.0f mV, Raw: %d", 
-                    sensor_data->converted_value, sensor_data->adc_voltage, sensor_data->raw_value);
-            break;
-        default:
-            ESP_LOGI(TAG, "=== ENVIANDO DATOS SENSOR ===");
-            ESP_LOGI(TAG, "Valor: %.2f, Voltaje: %.0f mV, Raw: %d", 
-                    sensor_data->converted_value, sensor_data->adc_voltage, sensor_data->raw_value);
-            break;
+    esp_err_t result = send_frame_data_start(frame, from_buffer);
+    if (result != ESP_OK) {
+        frame_done(frame, from_buffer, result);
     }
+}
 
-    // Obtener ID del sensor desde la configuración específica del sensor
-    extern sensor_config_t g_sensor_humidity_config;
-    extern sensor_config_t g_sensor_light_config;
-    
-    int id_sensor = 0;
-    switch (sensor_data->type) {
-        case SENSOR_TYPE_SOIL_HUMIDITY:
-            id_sensor = g_sensor_humidity_config.id_sensor;
-            break;
-        case SENSOR_TYPE_LIGHT:
-            id_sensor = g_sensor_light_config.id_sensor;
-            break;
-        default:
-            id_sensor = 1; // Valor por defecto
-            break;
+// Avanzar el POST en curso sin bloquear
+static void http_inflight_poll(void)
+{
+    if (!inflight.active) {
+        return;
     }
 
-    if (id_sensor == 0) {
-        ESP_LOGW(TAG, "⚠ ID de sensor no configurado para tipo %d, usando valor por defecto", sensor_data->type);
-        id_sensor = 1; // Valor por defecto
+    esp_err_t err;
+    hal_http_response_t response = {0};
+    int64_t poll_start_us = hal_clock_now_us();
+    bool done = hal_http_poll(inflight.handle, &err, &response);
+    http_account_blocked(poll_start_us);
+    if (!done) {
+        return;
     }
 
-    // Determinar el serial correcto según el tipo de sensor
-    const char *device_serial;
-    switch (sensor_data->type) {
+    inflight.active = false;
+    inflight.handle = NULL;
+    esp_err_t result = send_frame_value_finish(err, &response);
+    frame_done(&inflight.frame, inflight.from_buffer, result);
+}
+
+// Reintentar la trama más antigua del buffer local (una por llamada)
+static void local_buffer_drain_one(void)
+{
+    if (local_buffer_count == 0 || inflight.active ||
+        circuit_breaker_state(BREAKER_ENDPOINT_PROCESS_DATA) != BREAKER_STATE_CLOSED ||
+        !pacing_try_acquire()) {
+        return;
+    }
+
+    sensor_frame_t oldest = local_buffer[local_buffer_head];
+    local_buffer_pop();
+    ESP_LOGI(TAG, "📤 Reenviando trama del buffer local (%d pendientes, %lu ms de antigüedad)",
+             local_buffer_count, (unsigned long)hal_clock_elapsed_ms(oldest.timestamp));
+    http_dispatch(&oldest, true);
+}
+
+// Programación de envíos de un sensor: último envío
+typedef struct {
+    bool sent;              // Ya salió al menos una lectura de este sensor
+    uint32_t last_sent;     // Último envío (ms de hal_clock)
+} sensor_post_schedule_t;
+
+static sensor_post_schedule_t humidity_schedule;
+static sensor_post_schedule_t light_schedule;
+
+static sensor_post_schedule_t *schedule_for_type(sensor_type_t type)
+{
+    switch (type) {
         case SENSOR_TYPE_SOIL_HUMIDITY:
-            device_serial = DEVICE_SERIAL_HUMIDITY;
-            break;
+            return &humidity_schedule;
         case SENSOR_TYPE_LIGHT:
-            device_serial = DEVICE_SERIAL_LIGHT;
-            break;
+            return &light_schedule;
         default:
-            device_serial = DEVICE_SERIAL_HUMIDITY; // fallback
-            break;
+            return NULL;
     }
+}
 
-    // Enviar datos usando la nueva función genérica
-    esp_err_t result = send_sensor_value(sensor_data, id_sensor, device_serial);
+// Decidir si la lectura de un sensor entra en la trama a enviar
+static bool reading_is_due(const sensor_reading_t *reading, uint32_t current_time, uint32_t task_start_ms)
+{
+    sensor_post_schedule_t *schedule = schedule_for_type(reading->type);
+    if (schedule == NULL) {
+        return false;
+    }
+    const sensor_config_t *config = http_sensor_config(reading->type);
+    const char *sensor_name = reading->type == SENSOR_TYPE_LIGHT ? "Luz" : "Humedad";
+
+    // DEBUG: Mostrar configuración actual
+    ESP_LOGI(TAG, "🔧 Config %s actual: interval_s=%d, id_sensor=%d, state=%d", 
+             sensor_name, config->interval_s, config->id_sensor, config->state);
+
+    // Verificar si es tiempo de enviar datos de este sensor
+    uint32_t interval_ms = (uint32_t)config->interval_s * 1000;
+    uint32_t elapsed_ms = current_time - schedule->last_sent;
+
+    // Antes del primer envío se cuenta desde el arranque de la tarea más la fase.
+    // La fase es la misma para todos los sensores: con intervalos iguales vencen
+    // en la misma trama y salen en un solo POST.
+    if (!schedule->sent) {
+        interval_ms = pacing_phase_offset_ms(interval_ms, PACING_PHASE_POST_DATA);
+        elapsed_ms = hal_clock_elapsed_ms(task_start_ms);
+    }
 
-    if (result == ESP_OK) {
-        ESP_LOGI(TAG, "✅ Datos enviados exitosamente");
-        send_led_status(SYSTEM_STATE_HTTP_SEND, "Datos enviados");
-        return ESP_OK;
-    } else {
-        ESP_LOGE(TAG, "❌ Error enviando datos");
-        send_led_status(SYSTEM_STATE_ERROR, "Error HTTP");
-        
-        // Implementar backoff en caso de fallos consecutivos
-        if (consecutive_failures >= 3) {
-            ESP_LOGW(TAG, "⚠ Múltiples fallos HTTP (%d), activando backoff", consecutive_failures);
-            pause_all_tasks_with_backoff();
-            
-            // Delay local en esta tarea para espaciar reintentos
-            vTaskDelay(pdMS_TO_TICKS(30000)); // Esperar 30s antes de siguiente intento
-        }
-        
-        return ESP_FAIL;
+    ESP_LOGI(TAG, "⏱ %s - Tiempo desde último envío: %lu ms (necesita %lu ms)", 
+             sensor_name, (unsigned long)elapsed_ms, (unsigned long)interval_ms);
+
+    if (elapsed_ms >= interval_ms) {
+        ESP_LOGI(TAG, "✅ %s - TIEMPO CUMPLIDO, va en la trama", sensor_name);
+        return true;
     }
+    ESP_LOGI(TAG, "⏸ %s: esperando %lu ms para próximo envío", sensor_name, (unsigned long)(interval_ms - elapsed_ms));
+    return false;
 }
 
 // Tarea principal HTTP
@@ -513,205 +716,147 @@ void task_http_client(void *pvParameters)
 {
     ESP_LOGI(TAG, "=== INICIANDO TAREA HTTP CLIENT ===");
 
-    // NO validar dispositivos al inicio - se validarán cuando se reciba el primer dato de cada sensor
-    ESP_LOGI(TAG, "🔍 Validación de sensores se hará cuando se reciba el primer dato de cada uno");
+    // NO sincronizar al inicio: la primera trama sale con la configuración de NVS y la
+    // revalidación (solo si venció, ver config_sync.h) corre después sin bloquear
+    ESP_LOGI(TAG, "🔍 Sincronización de configuración después de la primera trama");
 
     QueueHandle_t sensor_queue = (QueueHandle_t)pvParameters;
-    sensor_data_t received_data;
-
-    // Variables para controlar validación por sensor
-    static bool humidity_sensor_validated = false;
-    static bool light_sensor_validated = false;
-
-    // Variables para controlar timing de envío por sensor
-    uint32_t last_sent_humidity = 0;
-    uint32_t last_sent_light = 0;
-
-    uint32_t successful_posts = 0;
-    uint32_t failed_posts = 0;
-    uint32_t last_activity_log = xTaskGetTickCount();
+    sensor_frame_t received_frame;
 
-    // Obtener configuraciones globales de sensores
-    extern sensor_config_t g_sensor_humidity_config;
-    extern sensor_config_t g_sensor_light_config;
+    uint32_t last_activity_log = hal_clock_now_ms();
+    // El primer envío de cada sensor espera su offset de fase (pacing.c)
+    uint32_t task_start_ms = hal_clock_now_ms();
+    bool first_frame_handled = false;
 
     ESP_LOGI(TAG, "Intervalo humedad: %d s, Intervalo luz: %d s", 
-             g_sensor_humidity_config.interval_s, g_sensor_light_config.interval_s);
+             http_sensor_config(SENSOR_TYPE_SOIL_HUMIDITY)->interval_s,
+             http_sensor_config(SENSOR_TYPE_LIGHT)->interval_s);
     ESP_LOGI(TAG, "✓ Tarea HTTP lista para recibir datos");
 
     while (1) {
-        // Esperar conectividad WiFi antes de procesar
-        EventBits_t bits = xEventGroupWaitBits(
-            g_connectivity_event_group,
-            CONNECTIVITY_WIFI_CONNECTED_BIT,
-            pdFALSE,  // No clear bits
-            pdFALSE,  // Wait for any bit
-            portMAX_DELAY  // Esperar indefinidamente
-        );
+        task_feed_watchdog(TASK_TYPE_HTTP);
+        http_inflight_poll();
         
-        if (!(bits & CONNECTIVITY_WIFI_CONNECTED_BIT)) {
-            ESP_LOGW(TAG, "⏸️ HTTP: Sin conectividad WiFi, esperando...");
-            vTaskDelay(pdMS_TO_TICKS(5000));
-            continue;
+        // Sin WiFi (p. ej. mientras arranca) las tramas se siguen atendiendo: las
+        // lecturas que vencen van al buffer local y salen cuando haya conexión
+        bool online = (xEventGroupGetBits(g_connectivity_event_group) & CONNECTIVITY_WIFI_CONNECTED_BIT) != 0;
+        if (!online) {
+            ESP_LOGD(TAG, "⏸️ HTTP: Sin conectividad WiFi, tramas al buffer local");
         }
         
-        // Recibir datos de sensores con timeout corto para no bloquear
-        if (xQueueReceive(sensor_queue, &received_data, pdMS_TO_TICKS(1000)) == pdTRUE) {
+        // Recibir tramas de sensores con timeout corto para no bloquear (más corto con un POST en curso)
+        bool network_busy = inflight.active || config_sync_in_progress();
+        TickType_t queue_wait = pdMS_TO_TICKS(network_busy ? HTTP_ASYNC_POLL_MS : 1000);
+        if (xQueueReceive(sensor_queue, &received_frame, queue_wait) == pdTRUE) {
+            metrics_trace_mark(received_frame.trace.dequeued_us);
             
-            // PROCESAR CADA DATO QUE LLEGA - NO descartar para evitar pérdida de datos
-            // Cada sensor envía datos a su propia velocidad de lectura (5s)
-            // La lógica de timing decide si enviar o no al backend
-            
-            // Verificar si los datos son válidos
-            if (received_data.valid) {
-                uint32_t current_time = xTaskGetTickCount();
-                bool should_send = false;
-                
-                // Log del tipo de dato recibido
-                const char *sensor_name = (received_data.type == SENSOR_TYPE_SOIL_HUMIDITY) ? "HUMEDAD" : 
-                                         (received_data.type == SENSOR_TYPE_LIGHT) ? "LUZ" : "DESCONOCIDO";
-                ESP_LOGI(TAG, "📥 Dato recibido: %s (tipo=%d)", sensor_name, received_data.type);
-
-                // Validar sensor si no ha sido validado aún
-                if (received_data.type == SENSOR_TYPE_SOIL_HUMIDITY) {
-                    if (!humidity_sensor_validated) {
-                        ESP_LOGI(TAG, "🔍 Validando sensor de humedad por primera vez...");
-                        esp_err_t validation_result = validate_device_serial(DEVICE_SERIAL_HUMIDITY);
-                        if (validation_result == ESP_OK) {
-                            ESP_LOGI(TAG, "✅ Sensor de humedad (0x001C) validado exitosamente");
-                        } else {
-                            ESP_LOGI(TAG, "ℹ Sensor de humedad (0x001C) - validación omitida, enviando datos de todos modos");
-                        }
-                        humidity_sensor_validated = true;
-                    }
-
-                    // DEBUG: Mostrar configuración actual
-                    ESP_LOGI(TAG, "🔧 Config humedad actual: interval_s=%d, id_sensor=%d, state=%d", 
-                             g_sensor_humidity_config.interval_s, 
-                             g_sensor_humidity_config.id_sensor,
-                             g_sensor_humidity_config.state);
-
-                    // Verificar si es tiempo de enviar datos de humedad
-                    uint32_t interval_ticks = pdMS_TO_TICKS(g_sensor_humidity_config.interval_s * 1000);
-                    uint32_t elapsed_ticks = current_time - last_sent_humidity;
-                    
-                    ESP_LOGI(TAG, "⏱ Humedad - Tiempo desde último envío: %lu ms (necesita %lu ms)", 
-                             (unsigned long)(elapsed_ticks * portTICK_PERIOD_MS),
-                             (unsigned long)(g_sensor_humidity_config.interval_s * 1000));
-                    
-                    if ((current_time - last_sent_humidity) >= interval_ticks || last_sent_humidity == 0) {
-                        should_send = true;
-                        ESP_LOGI(TAG, "✅ Humedad - TIEMPO CUMPLIDO, enviando...");
-                    } else {
-                        uint32_t remaining_ms = ((interval_ticks - (current_time - last_sent_humidity)) * portTICK_PERIOD_MS);
-                        ESP_LOGI(TAG, "⏸ Humedad: esperando %lu ms para próximo envío", remaining_ms);
-                    }
+            // PROCESAR CADA TRAMA QUE LLEGA - NO descartar para evitar pérdida de datos.
+            // La trama trae todas las lecturas del ciclo (cada 5s); la lógica de timing
+            // decide qué sensores van al backend, y los que van salen juntos en un POST.
+            uint32_t current_time = hal_clock_now_ms();
+            ESP_LOGI(TAG, "📥 Trama recibida: %u lecturas", (unsigned)received_frame.count);
+
+            sensor_frame_t frame_to_send = received_frame;
+            frame_to_send.count = 0;
+            for (int i = 0; i < received_frame.count && i < SENSOR_FRAME_MAX_READINGS; i++) {
+                if (reading_is_due(&received_frame.readings[i], current_time, task_start_ms)) {
+                    frame_to_send.readings[frame_to_send.count++] = received_frame.readings[i];
+                }
+            }
 
-                } else if (received_data.type == SENSOR_TYPE_LIGHT) {
-                    if (!light_sensor_validated) {
-                        ESP_LOGI(TAG, "🔍 Validando sensor de luz por primera vez...");
-                        esp_err_t validation_result = validate_device_serial(DEVICE_SERIAL_LIGHT);
-                        if (validation_result == ESP_OK) {
-                            ESP_LOGI(TAG, "✅ Sensor de luz (0x001D) validado exitosamente");
-                        } else {
-                            ESP_LOGI(TAG, "ℹ Sensor de luz (0x001D) - validación omitida, enviando datos de todos modos");
-                        }
-                        light_sensor_validated = true;
-                    }
+            // Límite de peticiones por minuto: si no hay token, la próxima trama reintenta.
+            // Con el breaker abierto la trama va directo al buffer local y no gasta token.
+            // Con un POST en curso tampoco: la trama espera su turno en el buffer local.
+            if (frame_to_send.count > 0 && online && !inflight.active &&
+                circuit_breaker_state(BREAKER_ENDPOINT_PROCESS_DATA) != BREAKER_STATE_OPEN &&
+                !pacing_try_acquire()) {
+                ESP_LOGW(TAG, "⏳ Trama: límite de peticiones por minuto alcanzado, envío diferido");
+                frame_to_send.count = 0;
+            }
 
-                    // DEBUG: Mostrar configuración actual
-                    ESP_LOGI(TAG, "🔧 Config luz actual: interval_s=%d, id_sensor=%d, state=%d", 
-                             g_sensor_light_config.interval_s, 
-                             g_sensor_light_config.id_sensor,
-                             g_sensor_light_config.state);
-
-                    // Verificar si es tiempo de enviar datos de luz
-                    uint32_t interval_ticks = pdMS_TO_TICKS(g_sensor_light_config.interval_s * 1000);
-                    uint32_t elapsed_ticks = current_time - last_sent_light;
-                    
-                    ESP_LOGI(TAG, "⏱ Luz - Tiempo desde último envío: %lu ms (necesita %lu ms)", 
-                             (unsigned long)(elapsed_ticks * portTICK_PERIOD_MS),
-                             (unsigned long)(g_sensor_light_config.interval_s * 1000));
-                    
-                    if ((current_time - last_sent_light) >= interval_ticks || last_sent_light == 0) {
-                        should_send = true;
-                        ESP_LOGI(TAG, "✅ Luz - TIEMPO CUMPLIDO, enviando...");
-                    } else {
-                        uint32_t remaining_ms = ((interval_ticks - (current_time - last_sent_light)) * portTICK_PERIOD_MS);
-                        ESP_LOGI(TAG, "⏸ Luz: esperando %lu ms para próximo envío", remaining_ms);
-                    }
+            // Enviar solo las lecturas de los sensores a los que les toca
+            if (frame_to_send.count > 0) {
+                // La secuencia se asigna a las tramas que se envían: un hueco es una trama perdida
+                frame_to_send.seq = sequence_next(SEQUENCE_STREAM_FRAMES);
+
+                // Enviar datos al servidor (la respuesta se procesa en http_inflight_poll)
+                if (!online) {
+                    ESP_LOGI(TAG, "📦 Sin WiFi, trama al buffer local");
+                    local_buffer_push(&frame_to_send);
+                } else if (inflight.active) {
+                    ESP_LOGI(TAG, "📦 POST anterior en curso, trama al buffer local");
+                    local_buffer_push(&frame_to_send);
+                } else {
+                    http_dispatch(&frame_to_send, false);
                 }
 
-                // Enviar solo si es tiempo para este sensor
-                if (should_send) {
-                    // Mostrar información del sensor según su tipo
-                    switch (received_data.type) {
-                        case SENSOR_TYPE_SOIL_HUMIDITY:
-                            ESP_LOGI(TAG, "📊 Enviando datos humedad - HS: %.1f%%, Voltaje: %.0f mV, Raw: %d",
-                                    received_data.converted_value, received_data.adc_voltage, received_data.raw_value);
-                            break;
-                        case SENSOR_TYPE_LIGHT:
-                            ESP_LOGI(TAG, "📊 Enviando datos luz - Luz: %.0f LM%%, Voltaje: %.0f mV, Raw: %d",
-                                    received_data.converted_value, received_data.adc_voltage, received_data.raw_value);
-                            break;
-                        default:
-                            ESP_LOGI(TAG, "📊 Enviando datos - Voltaje: %.0f mV, Raw: %d",
-                                    received_data.adc_voltage, received_data.raw_value);
-                            break;
-                    }
+                first_frame_handled = true;
 
-                    // Enviar datos al servidor
-                    esp_err_t send_result = send_sensor_data(&received_data);
-
-                    if (send_result == ESP_OK) {
-                        successful_posts++;
-                        task_send_status(TASK_TYPE_HTTP, "Datos enviados OK");
-
-                        // Actualizar timestamp de último envío exitoso
-                        if (received_data.type == SENSOR_TYPE_SOIL_HUMIDITY) {
-                            last_sent_humidity = current_time;
-                        } else if (received_data.type == SENSOR_TYPE_LIGHT) {
-                            last_sent_light = current_time;
-                        }
-                    } else {
-                        failed_posts++;
-                        task_report_error(TASK_TYPE_HTTP, TASK_ERROR_TIMEOUT, "HTTP send failed");
+                // En curso o guardada, la lectura de este período ya está atendida
+                for (int i = 0; i < frame_to_send.count; i++) {
+                    sensor_post_schedule_t *schedule = schedule_for_type(frame_to_send.readings[i].type);
+                    if (schedule != NULL) {
+                        schedule->last_sent = current_time;
+                        schedule->sent = true;
                     }
-                } else {
-                    ESP_LOGD(TAG, "⏸ Datos recibidos pero aún no es tiempo de enviar");
                 }
             } else {
-                ESP_LOGW(TAG, "⚠ Datos de sensor inválidos recibidos, descartando");
+                ESP_LOGD(TAG, "⏸ Trama recibida pero aún no es tiempo de enviar");
             }
         } else {
             // Timeout - no se recibieron datos
             ESP_LOGD(TAG, "⏱ Timeout esperando datos del sensor");
         }
 
+        if (online) {
+            local_buffer_drain_one();
+        }
+
+        // Revalidar la configuración fuera del camino de los datos: no antes de la
+        // primera trama, y sin iniciarla con un POST en curso (una conexión TLS a la vez)
+        if (first_frame_handled && online) {
+            int64_t sync_start_us = hal_clock_now_us();
+            config_sync_service(!inflight.active);
+            http_account_blocked(sync_start_us);
+        }
+
         // Reportar estadísticas cada 10 minutos
-        uint32_t current_time = xTaskGetTickCount();
-        if ((current_time - last_activity_log) > pdMS_TO_TICKS(600000)) { // 10 minutos
+        if (hal_clock_elapsed_ms(last_activity_log) > 600000) { // 10 minutos
+            uint32_t successful_posts = metrics_counter_get(METRIC_HTTP_POSTS_OK);
+            uint32_t failed_posts = metrics_counter_get(METRIC_HTTP_POSTS_FAILED);
             float success_rate = (successful_posts + failed_posts) > 0 ? 
                                 (successful_posts * 100.0f) / (successful_posts + failed_posts) : 0.0f;
             
             ESP_LOGI(TAG, "📈 Estadísticas HTTP - Exitosos: %lu, Fallidos: %lu (%.1f%% éxito)",
                     successful_posts, failed_posts, success_rate);
 
+            // Con peticiones bloqueantes la tarea quedaba bloqueada todo el tiempo en vuelo
+            uint32_t inflight_ms = metrics_counter_get(METRIC_HTTP_INFLIGHT_MS);
+            uint32_t blocked_ms = metrics_counter_get(METRIC_HTTP_BLOCKED_MS);
+            ESP_LOGI(TAG, "⏱️ Tiempo en red: %lu ms en vuelo, %lu ms bloqueada (%.1f%%)",
+                    (unsigned long)inflight_ms, (unsigned long)blocked_ms,
+                    inflight_ms > 0 ? (blocked_ms * 100.0f) / inflight_ms : 0.0f);
+            time_service_status_t time_status;
+            time_service_get_status(&time_status);
+            if (time_status.synced) {
+                ESP_LOGI(TAG, "🕒 Reloj: %lu sincronizaciones, última corrección %ld ms, deriva %ld ppb%s",
+                        (unsigned long)time_status.sync_count, (long)time_status.last_correction_ms,
+                        (long)time_status.drift_ppb, time_status.drift_valid ? "" : " (sin estimar)");
+            } else {
+                ESP_LOGW(TAG, "🕒 Reloj sin sincronizar: las lecturas salen con uptime_ms y boot_id");
+            }
+
             // Enviar heartbeat
             char heartbeat_msg[32];
             snprintf(heartbeat_msg, sizeof(heartbeat_msg), "HTTP %.1f%% OK", success_rate);
             task_send_heartbeat(TASK_TYPE_HTTP, heartbeat_msg);
 
-            last_activity_log = current_time;
-
-            // Reset contadores si son muy altos
-            if (successful_posts + failed_posts > 1000) {
-                successful_posts = successful_posts / 10;
-                failed_posts = failed_posts / 10;
-            }
+            last_activity_log = hal_clock_now_ms();
         }
 
-        // Pequeña pausa para evitar consumo excesivo de CPU
-        vTaskDelay(pdMS_TO_TICKS(100));
+        // Pequeña pausa para evitar consumo excesivo de CPU (con un POST en curso ya esperó en la cola)
+        if (!inflight.active && !config_sync_in_progress()) {
+            hal_clock_delay_ms(100);
+        }
     }
 }
\ No newline at end of file
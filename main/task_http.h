@@ -5,8 +5,20 @@
 #include "freertos/task.h"
 #include "freertos/queue.h"
 #include "config.h"
+#include "task_sensor.h"
 
 // Función principal de la tarea HTTP
 void task_http_client(void *pvParameters);
 
+/**
+ * @brief Serializar una trama al JSON que recibe /process-data
+ *
+ * Un arreglo "readings" con valor, serial e ID de cada sensor, y un solo
+ * timestamp/uptime_ms/boot_id/seq para toda la trama.
+ *
+ * @param frame Trama a enviar (los IDs salen de la configuración de cada sensor)
+ * @return String JSON (liberar con free), o NULL si falla la memoria
+ */
+char *http_build_frame_payload(const sensor_frame_t *frame);
+
 #endif // TASK_HTTP_H
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include "task_main.h"
 #include "esp_system.h"
 #include "adc_shared.h"
+#include "hal_clock.h"
 
 static const char *TAG = "INIT_CONFIG";
 
@@ -120,7 +121,7 @@ void task_initial_config(void *pvParameters)
     }
 
     // Pequeña pausa antes de verificar ADC
-    vTaskDelay(pdMS_TO_TICKS(100));
+    hal_clock_delay_ms(100);
 
     // Verificar configuración ADC (no inicializar completamente)
     ESP_LOGI(TAG, "Verificando configuración ADC...");
@@ -8,16 +8,16 @@
 #include "led_strip.h"
 #include "task_main.h"
 #include "config.h"
+#include "hal_clock.h"
 
 static const char *TAG = "TASK_LED_STATUS";
 
-// Duración en ms que el LED se fuerza a INIT (amarillo) al arrancar
-#define INIT_HOLD_MS 4000
+// LED Neopixel global compartido (inicializado en task_main.c)
+extern led_strip_handle_t g_led_strip;
+
 // Queue para recibir estados del sistema
 static QueueHandle_t led_status_queue = NULL;
 
-// Forzar INIT al arranque hasta forced_init_until (ms desde boot)
-static uint32_t forced_init_until = 0;
 // Colores asignados a cada estado del sistema (formato RGB: {R,G,B})
 // Nota: los índices deben coincidir con el enum 'system_state_t' en task_main.h
 static const uint8_t state_colors[SYSTEM_STATE_MAX][3] = {
@@ -83,13 +83,7 @@ static void apply_heartbeat_effect(system_state_t current_state)
         return; // LED no disponible
     }
 
-    uint32_t current_time = xTaskGetTickCount() * portTICK_PERIOD_MS;
-
-    // Si estamos en período de inicialización forzada
-    if (forced_init_until > 0 && current_time < forced_init_until)
-    {
-        current_state = SYSTEM_STATE_INIT;
-    }
+    uint32_t current_time = hal_clock_now_ms();
 
     // Validar estado
     if (current_state >= SYSTEM_STATE_MAX)
@@ -137,9 +131,6 @@ void task_led_status(void *pvParameters)
         return;
     }
 
-    // Configurar período de inicialización forzada
-    forced_init_until = (xTaskGetTickCount() * portTICK_PERIOD_MS) + INIT_HOLD_MS;
-
     led_status_message_t received_msg;
     system_state_t current_state = SYSTEM_STATE_INIT;
 
@@ -162,7 +153,7 @@ void task_led_status(void *pvParameters)
         apply_heartbeat_effect(current_state);
 
         // Controlar velocidad de actualización del efecto
-        vTaskDelay(pdMS_TO_TICKS(50)); // 20 FPS para suavidad del efecto
+        hal_clock_delay_ms(50); // 20 FPS para suavidad del efecto
     }
 }
 
@@ -190,7 +181,7 @@ void send_led_status(system_state_t state, const char *message)
     {
         led_status_message_t msg = {
             .state = state,
-            .timestamp = xTaskGetTickCount()};
+            .timestamp = hal_clock_now_ms()};
 
         // Copiar mensaje si se proporciona
         if (message != NULL)
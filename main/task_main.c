@@ -11,6 +11,20 @@
 #include "task_nvs.h"
 #include "task_mqtt.h"
 #include "task_error_logger.h"
+#include "metrics.h"
+#include "pacing.h"
+#include "circuit_breaker.h"
+#include "http_compress.h"
+#include "config_sync.h"
+#include "config_store.h"
+#include "config_bus.h"
+#include "net_config.h"
+#include "sequence.h"
+#include "time_service.h"
+#include "hal_clock.h"
+#include "esp_mac.h"
+#include "esp_task_wdt.h"
+#include "esp_attr.h"
 #include <string.h>
 
 static const char *TAG = "TASK_MAIN";
@@ -55,7 +69,7 @@ static void init_status_led(void)
     ESP_LOGI(TAG, "✓ LED de estado inicializado correctamente");
 }
 
-// Semáforos para sincronización de inicialización secuencial
+// Semáforos con los que las tareas de arranque avisan que terminaron (boot_step)
 SemaphoreHandle_t init_config_semaphore = NULL;
 SemaphoreHandle_t wifi_init_semaphore = NULL;
 SemaphoreHandle_t sensor_config_semaphore = NULL;
@@ -63,80 +77,257 @@ SemaphoreHandle_t system_ready_semaphore = NULL;
 
 // Handles de las tareas para poder controlarlas
 static TaskHandle_t task_handles[TASK_TYPE_MAX] = {NULL};
-// HTTP backoff stage: 0 == initial (5m), 1 == 10m, 2 == 30m, capped at max
-static int http_backoff_stage = 0;
 
-static uint32_t backoff_ms_for_stage(int stage)
+// Descriptor de cada tarea supervisada (necesario para poder recrearla)
+typedef struct {
+    TaskFunction_t function;
+    const char *name;
+    uint32_t stack_size;
+    UBaseType_t priority;
+    uint32_t deadline_ms;    // 0 = tarea de un solo uso, sin plazo
+    bool restartable;        // false = un bloqueo escala directo a reinicio del sistema
+} task_descriptor_t;
+
+static const task_descriptor_t task_descriptors[TASK_TYPE_MAX] = {
+    [TASK_TYPE_INITIAL_CONFIG] = { task_initial_config, "initial_config", 4096, 3, 0, false },
+    // WiFi no se puede recrear: wifi_init_sta() inicializa netif y el event loop una sola vez
+    [TASK_TYPE_WIFI] = { task_wifi_connection, "wifi_task", 6144, 3, WATCHDOG_DEADLINE_WIFI_MS, false },
+    [TASK_TYPE_SENSOR_CONFIG] = { task_sensor_config_init, "sensor_config", 4096, 3, 0, false },
+    [TASK_TYPE_SENSOR] = { task_sensors_unified_reading, "sensors_unified", 4096, 3, WATCHDOG_DEADLINE_SENSOR_MS, true },
+    // HTTP y el logger de errores no se pueden recrear: borrados desde afuera pueden quedar con
+    // el mutex de compresión, del breaker, de secuencias o de config_store tomado, y el cliente
+    // HTTP y el JSON en vuelo perdidos; quien pida después ese mutex se bloquea para siempre
+    [TASK_TYPE_HTTP] = { task_http_client, "http_task", 6144, 2, WATCHDOG_DEADLINE_HTTP_MS, false },
+    [TASK_TYPE_NVS] = { task_nvs_config, "nvs_task", 3072, 1, WATCHDOG_DEADLINE_NVS_MS, true },
+    // MQTT no se puede recrear: mqtt_client_init() crearía un segundo cliente esp-mqtt
+    [TASK_TYPE_MQTT] = { task_mqtt_client, "mqtt_task", 4096, 2, WATCHDOG_DEADLINE_MQTT_MS, false },
+    [TASK_TYPE_ERROR_LOGGER] = { task_error_logger, "error_logger", 4096, 1, WATCHDOG_DEADLINE_ERROR_LOGGER_MS, false },
+};
+
+// Estado del watchdog por tarea (instantes en ms de hal_clock). last_feed se escribe desde cada tarea (store de 32 bits)
+// y el resto solo lo modifica el supervisor.
+typedef struct {
+    volatile uint32_t last_feed;
+    void *param;
+    bool monitored;
+    watchdog_stage_t stage;
+    uint32_t stalled_since;
+    uint32_t restarted_at;
+    uint32_t stall_count;
+    uint32_t restart_count;
+    uint32_t last_recovery_ms;
+    uint32_t max_recovery_ms;
+} task_watchdog_entry_t;
+
+static task_watchdog_entry_t watchdog_entries[TASK_TYPE_MAX];
+
+// Sobrevive al reinicio por software para poder reportar qué tarea lo provocó
+#define WATCHDOG_REBOOT_MAGIC 0x57445447
+RTC_NOINIT_ATTR static uint32_t watchdog_reboot_magic;
+RTC_NOINIT_ATTR static uint32_t watchdog_reboot_task;
+
+static const char *task_type_name(task_type_t task_type)
 {
-    switch (stage) {
-        case 0: return 5 * 60 * 1000;   // 5 minutos
-        case 1: return 10 * 60 * 1000;  // 10 minutos
-        case 2: return 30 * 60 * 1000;  // 30 minutos
-        default: return 30 * 60 * 1000; // Cap at 30 minutos
+    if (task_type < TASK_TYPE_MAX && task_descriptors[task_type].name != NULL) {
+        return task_descriptors[task_type].name;
     }
+    return "desconocida";
 }
 
-// Pause tasks using progressive backoff. Each call increments the backoff stage
-// up to a cap. The backoff delay is applied via the connectivity event group,
-// not by suspending tasks directly (which causes panics).
-void pause_all_tasks_with_backoff(void)
+// Alimentar el watchdog desde la propia tarea (sin pasar por la cola del supervisor)
+void task_feed_watchdog(task_type_t task_type)
 {
-    uint32_t backoff_time = backoff_ms_for_stage(http_backoff_stage);
-    
-    ESP_LOGW(TAG, "⏸️ Backoff HTTP activo por %lu ms (stage %d)", backoff_time, http_backoff_stage);
-    ESP_LOGW(TAG, "Las tareas esperarán naturalmente por conectividad");
-    
-    // NO suspender tareas manualmente - causa stack overflow y panics
-    // Las tareas ya están esperando en el Event Group por conectividad
-    // Solo incrementamos el backoff stage para control de reintentos
-    
-    // Incrementar backoff stage
-    if (http_backoff_stage < 2) {
-        http_backoff_stage++;
+    if (task_type < TASK_TYPE_MAX) {
+        watchdog_entries[task_type].last_feed = hal_clock_now_ms();
     }
-    
-    // Agregar delay solo si se llama explícitamente desde HTTP task
-    // No bloquear aquí - dejar que las tareas manejen su propio timing
 }
 
-// Reset backoff stage to initial (called on successful HTTP communication)
-void reset_http_backoff(void)
+// Desarmar el plazo de una tarea que termina a propósito (p.ej. fallo de inicialización)
+void task_watchdog_unregister(task_type_t task_type)
 {
-    if (http_backoff_stage > 0) {
-        ESP_LOGI(TAG, "Reseteando HTTP backoff a nivel inicial");
-        http_backoff_stage = 0;
+    if (task_type < TASK_TYPE_MAX) {
+        watchdog_entries[task_type].monitored = false;
     }
 }
 
-// Cola para recibir mensajes del supervisor (errores, heartbeats, status)
-QueueHandle_t supervisor_queue_global = NULL;
+void task_watchdog_get_stats(task_type_t task_type, task_watchdog_stats_t *out_stats)
+{
+    memset(out_stats, 0, sizeof(*out_stats));
+    if (task_type >= TASK_TYPE_MAX) {
+        return;
+    }
 
-// Colas de comunicación entre tareas (compartidas)
-static QueueHandle_t shared_sensor_queue = NULL;
-static QueueHandle_t shared_error_queue = NULL;
+    const task_watchdog_entry_t *entry = &watchdog_entries[task_type];
+    out_stats->monitored = entry->monitored;
+    out_stats->stage = entry->stage;
+    out_stats->deadline_ms = task_descriptors[task_type].deadline_ms;
+    out_stats->last_feed_age_ms = hal_clock_elapsed_ms(entry->last_feed);
+    out_stats->stall_count = entry->stall_count;
+    out_stats->restart_count = entry->restart_count;
+    out_stats->last_recovery_ms = entry->last_recovery_ms;
+    out_stats->max_recovery_ms = entry->max_recovery_ms;
+}
+
+// Crear una tarea a partir de su descriptor y armar su plazo de watchdog
+static BaseType_t create_supervised_task(task_type_t task_type, void *param)
+{
+    const task_descriptor_t *desc = &task_descriptors[task_type];
+    task_watchdog_entry_t *entry = &watchdog_entries[task_type];
+
+    entry->param = param;
+    entry->last_feed = hal_clock_now_ms();
+
+    BaseType_t result = xTaskCreate(desc->function, desc->name, desc->stack_size,
+                                    param, desc->priority, &task_handles[task_type]);
+    if (result == pdPASS && desc->deadline_ms > 0) {
+        entry->monitored = true;
+    }
+    return result;
+}
+
+// Último escalón: dejar constancia de la tarea y reiniciar el sistema
+static void watchdog_restart_system(task_type_t task_type)
+{
+    ESP_LOGE(TAG, "🔥 Watchdog: tarea %s sigue bloqueada, reiniciando sistema", task_type_name(task_type));
+    send_led_status(SYSTEM_STATE_ERROR, "Watchdog reset");
+
+    watchdog_reboot_magic = WATCHDOG_REBOOT_MAGIC;
+    watchdog_reboot_task = task_type;
+
+    hal_clock_delay_ms(200); // Dar tiempo a vaciar el log
+    esp_restart();
+}
+
+// Reiniciar una tarea bloqueada. vTaskDelete() la corta en cualquier punto: solo se
+// recrean tareas que no toman locks compartidos ni guardan recursos entre ciclos.
+static bool watchdog_restart_task(task_type_t task_type)
+{
+    const task_descriptor_t *desc = &task_descriptors[task_type];
+    task_watchdog_entry_t *entry = &watchdog_entries[task_type];
 
-// Colas para actualización de configuración de sensores en tiempo real
-static QueueHandle_t humidity_config_queue = NULL;
-static QueueHandle_t light_config_queue = NULL;
+    if (!desc->restartable || entry->restart_count >= WATCHDOG_MAX_TASK_RESTARTS) {
+        return false;
+    }
+
+    ESP_LOGW(TAG, "🔁 Watchdog: reiniciando tarea %s (reinicio #%lu)",
+             desc->name, (unsigned long)(entry->restart_count + 1));
+
+    if (task_handles[task_type] != NULL) {
+        vTaskDelete(task_handles[task_type]);
+        task_handles[task_type] = NULL;
+    }
 
-// Funciones para acceder a las colas de configuración desde otras tareas
-QueueHandle_t get_humidity_config_queue(void) {
-    return humidity_config_queue;
+    if (create_supervised_task(task_type, entry->param) != pdPASS) {
+        ESP_LOGE(TAG, "Error recreando tarea %s", desc->name);
+        return false;
+    }
+
+    entry->restart_count++;
+    entry->restarted_at = hal_clock_now_ms();
+    entry->stage = WATCHDOG_STAGE_RESTARTED;
+    return true;
 }
 
-QueueHandle_t get_light_config_queue(void) {
-    return light_config_queue;
+// Revisar los plazos de todas las tareas y escalar: log -> reinicio de tarea -> reinicio de sistema
+static void watchdog_check_deadlines(void)
+{
+    uint32_t now = hal_clock_now_ms();
+
+    for (int i = 0; i < TASK_TYPE_MAX; i++) {
+        task_watchdog_entry_t *entry = &watchdog_entries[i];
+        const task_descriptor_t *desc = &task_descriptors[i];
+        if (!entry->monitored) {
+            continue;
+        }
+
+        uint32_t last_feed = entry->last_feed;
+        uint32_t silence = now - last_feed;
+
+        // Recuperada: volvió a alimentar después de vencer su plazo (o de ser recreada)
+        uint32_t reference = (entry->stage == WATCHDOG_STAGE_RESTARTED) ? entry->restarted_at : entry->stalled_since;
+        if (entry->stage != WATCHDOG_STAGE_OK && (int32_t)(last_feed - reference) > 0) {
+            entry->last_recovery_ms = last_feed - entry->stalled_since;
+            if (entry->last_recovery_ms > entry->max_recovery_ms) {
+                entry->max_recovery_ms = entry->last_recovery_ms;
+            }
+            ESP_LOGI(TAG, "✅ Watchdog: tarea %s recuperada en %lu ms",
+                     desc->name, (unsigned long)entry->last_recovery_ms);
+            entry->stage = WATCHDOG_STAGE_OK;
+            continue;
+        }
+
+        switch (entry->stage) {
+            case WATCHDOG_STAGE_OK:
+                if (silence > desc->deadline_ms) {
+                    entry->stage = WATCHDOG_STAGE_LATE;
+                    entry->stalled_since = now;
+                    entry->stall_count++;
+                    ESP_LOGW(TAG, "⏰ Watchdog: tarea %s sin alimentar hace %lu ms (plazo %lu ms)",
+                             desc->name, (unsigned long)silence,
+                             (unsigned long)desc->deadline_ms);
+                    send_led_status(SYSTEM_STATE_WARNING, "Tarea bloqueada");
+
+                    char details[96];
+                    snprintf(details, sizeof(details), "{\"task\": \"%s\", \"silence_ms\": %lu}",
+                             desc->name, (unsigned long)silence);
+                    error_logger_log_system("TASK_STALLED", ERROR_SEVERITY_WARNING,
+                                            "Tarea sin alimentar el watchdog", details);
+                }
+                break;
+
+            case WATCHDOG_STAGE_LATE:
+                if ((now - entry->stalled_since) > WATCHDOG_RESTART_GRACE_MS) {
+                    if (!watchdog_restart_task((task_type_t)i)) {
+                        watchdog_restart_system((task_type_t)i);
+                    }
+                }
+                break;
+
+            case WATCHDOG_STAGE_RESTARTED:
+                // La tarea recreada tiene un plazo completo para volver a alimentar
+                if ((now - entry->restarted_at) > desc->deadline_ms) {
+                    watchdog_restart_system((task_type_t)i);
+                }
+                break;
+        }
+    }
 }
 
+// Reportar (una sola vez) un reinicio provocado por el watchdog en el arranque anterior
+static void watchdog_report_previous_reboot(void)
+{
+    if (watchdog_reboot_magic != WATCHDOG_REBOOT_MAGIC) {
+        return;
+    }
+    watchdog_reboot_magic = 0;
+
+    const char *name = task_type_name((task_type_t)watchdog_reboot_task);
+    ESP_LOGW(TAG, "⚠ El arranque anterior terminó por watchdog (tarea %s)", name);
+
+    char details[64];
+    snprintf(details, sizeof(details), "{\"task\": \"%s\"}", name);
+    error_logger_log_system("WATCHDOG_SYSTEM_RESTART", ERROR_SEVERITY_ERROR,
+                            "Sistema reiniciado por tarea bloqueada", details);
+}
+
+// Cola para recibir mensajes del supervisor (errores, heartbeats, status)
+QueueHandle_t supervisor_queue_global = NULL;
+
+// Colas de comunicación entre tareas (compartidas)
+static QueueHandle_t shared_sensor_queue = NULL;
+static QueueHandle_t shared_error_queue = NULL;
+
 // Función para enviar heartbeat al supervisor
 void task_send_heartbeat(task_type_t task_type, const char *message)
 {
+    task_feed_watchdog(task_type);
+    
     if (supervisor_queue_global != NULL) {
         supervisor_message_t msg = {
             .type = SUPERVISOR_MSG_HEARTBEAT,
             .task_type = task_type,
             .error_code = TASK_ERROR_NONE,
-            .timestamp = xTaskGetTickCount(),
+            .timestamp = hal_clock_now_ms(),
             .task_free_stack = uxTaskGetStackHighWaterMark(NULL),
             .heap_free = esp_get_free_heap_size()
         };
@@ -155,7 +346,7 @@ void task_report_error(task_type_t task_type, task_error_t error_code, const cha
             .type = SUPERVISOR_MSG_ERROR_REPORT,
             .task_type = task_type,
             .error_code = error_code,
-            .timestamp = xTaskGetTickCount(),
+            .timestamp = hal_clock_now_ms(),
             .task_free_stack = uxTaskGetStackHighWaterMark(NULL),
             .heap_free = esp_get_free_heap_size()
         };
@@ -174,7 +365,7 @@ void task_send_status(task_type_t task_type, const char *message)
             .type = SUPERVISOR_MSG_STATUS_UPDATE,
             .task_type = task_type,
             .error_code = TASK_ERROR_NONE,
-            .timestamp = xTaskGetTickCount(),
+            .timestamp = hal_clock_now_ms(),
             .task_free_stack = uxTaskGetStackHighWaterMark(NULL),
             .heap_free = esp_get_free_heap_size()
         };
@@ -185,6 +376,240 @@ void task_send_status(task_type_t task_type, const char *message)
     }
 }
 
+// ===== ARRANQUE POR ETAPAS =====
+// Cada etapa arranca apenas terminan sus dependencias, así que el muestreo (con
+// la configuración de NVS) y el buffer local corren mientras WiFi y TLS todavía
+// se están levantando. Una etapa termina cuando su tarea entrega el semáforo o,
+// si no tiene, cuando vuelve start().
+
+typedef enum {
+    BOOT_STAGE_HARDWARE = 0,      // NVS flash, verificación del sistema y ADC
+    BOOT_STAGE_SERVICES,          // Módulos sin tarea propia (pacing, breakers, almacén...)
+    BOOT_STAGE_SENSOR_CONFIG,     // Configuración de sensores desde NVS
+    BOOT_STAGE_SAMPLING,          // Tareas de sensores y HTTP
+    BOOT_STAGE_WIFI,
+    BOOT_STAGE_TIME,              // SNTP (necesita netif)
+    BOOT_STAGE_CLOUD,             // MQTT, NVS y error logger (esperan WiFi por su cuenta)
+    BOOT_STAGE_MAX
+} boot_stage_t;
+
+#define BOOT_BIT(stage) (1u << (stage))
+
+typedef struct {
+    const char *name;
+    uint32_t depends_on;          // BOOT_BIT() de las etapas previas
+    void (*start)(void);
+    SemaphoreHandle_t *done;      // NULL = termina al volver start()
+    uint32_t timeout_ms;          // 0 = sin límite
+    bool restart_on_timeout;      // false = se da por terminada y se sigue
+    const char *timeout_led;      // Mensaje de LED de error al vencer (NULL = ninguno)
+    metric_gauge_t gauge;
+} boot_stage_descriptor_t;
+
+static void boot_start_hardware(void)
+{
+    ESP_LOGI(TAG, "Creando tarea de configuración inicial...");
+    if (create_supervised_task(TASK_TYPE_INITIAL_CONFIG, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Error creando tarea de configuración inicial");
+        esp_restart();
+    }
+}
+
+static void boot_start_services(void)
+{
+    // Pacing de envíos y reconexiones: fase y jitter propios de este dispositivo
+    uint8_t mac[6] = {0};
+    esp_read_mac(mac, ESP_MAC_WIFI_STA);
+    if (pacing_init(mac) != ESP_OK) {
+        ESP_LOGW(TAG, "⚠ Error inicializando pacing, se usan valores sin desfase");
+    }
+    if (sequence_init(mac) != ESP_OK) {
+        ESP_LOGW(TAG, "⚠ Secuencias sin persistencia en NVS, los reintentos tras reinicio pueden duplicarse");
+    }
+    if (circuit_breaker_init() != ESP_OK) {
+        ESP_LOGW(TAG, "⚠ Error inicializando circuit breakers, se usan sin mutex");
+    }
+    if (http_compress_init() != ESP_OK) {
+        ESP_LOGW(TAG, "⚠ Error inicializando compresión HTTP, se usa sin mutex");
+    }
+    // Antes de config_sync: un blob inválido invalida los validadores guardados
+    if (config_store_init() != ESP_OK) {
+        ESP_LOGW(TAG, "⚠ Error inicializando almacén de configuración, se escribe NVS sin diferir");
+    }
+    if (config_sync_init() != ESP_OK) {
+        ESP_LOGW(TAG, "⚠ Error inicializando sincronización de configuración, se usa sin mutex");
+    }
+    // Antes de WiFi: último AP e IP estática para la primera conexión
+    if (net_config_init() != ESP_OK) {
+        ESP_LOGW(TAG, "⚠ Error leyendo configuración de red, se conecta con escaneo y DHCP");
+    }
+    
+    // Inicializar sistema de logging de errores ANTES de WiFi
+    ESP_LOGI(TAG, "Inicializando sistema de logging de errores...");
+    if (error_logger_init() != ESP_OK) {
+        ESP_LOGW(TAG, "⚠ Error inicializando sistema de logs, continuando sin él");
+    } else {
+        ESP_LOGI(TAG, "✓ Sistema de error logging inicializado");
+        watchdog_report_previous_reboot();
+    }
+}
+
+static void boot_start_sensor_config(void)
+{
+    ESP_LOGI(TAG, "Creando tarea de configuración de sensores...");
+    send_led_status(SYSTEM_STATE_CONFIG, "Config sensores");
+    if (create_supervised_task(TASK_TYPE_SENSOR_CONFIG, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Error creando tarea de configuración de sensores");
+        esp_restart();
+    }
+}
+
+static void boot_start_sampling(void)
+{
+    ESP_LOGI(TAG, "Creando tarea unificada de sensores...");
+    ESP_LOGI(TAG, "  - Lectura cada %d ms", SENSOR_READING_INTERVAL_MS);
+    ESP_LOGI(TAG, "  - Envío HTTP según interval_seconds (configurado por MQTT)");
+    if (create_supervised_task(TASK_TYPE_SENSOR, shared_sensor_queue) != pdPASS) {
+        ESP_LOGE(TAG, "Error creando tarea unificada de sensores");
+        esp_restart();
+    }
+    ESP_LOGI(TAG, "✓ Tarea unificada de sensores creada");
+    
+    // Sin WiFi la tarea HTTP guarda las tramas en el buffer local
+    ESP_LOGI(TAG, "Creando tarea HTTP...");
+    if (create_supervised_task(TASK_TYPE_HTTP, shared_sensor_queue) != pdPASS) {
+        ESP_LOGE(TAG, "Error creando tarea HTTP");
+        esp_restart();
+    }
+}
+
+static void boot_start_wifi(void)
+{
+    ESP_LOGI(TAG, "Creando tarea WiFi...");
+    send_led_status(SYSTEM_STATE_WIFI, "Conectando WiFi");
+    if (create_supervised_task(TASK_TYPE_WIFI, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Error creando tarea WiFi");
+        esp_restart();
+    }
+}
+
+static void boot_start_time(void)
+{
+    // Hora UTC por SNTP (netif ya inicializado; reintenta solo si todavía no hay IP)
+    if (time_service_init() != ESP_OK) {
+        ESP_LOGW(TAG, "⚠ SNTP no disponible, los datos salen con uptime_ms y boot_id");
+    }
+}
+
+static void boot_start_cloud(void)
+{
+    ESP_LOGI(TAG, "Creando tarea MQTT...");
+    if (create_supervised_task(TASK_TYPE_MQTT, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Error creando tarea MQTT");
+        // No reiniciar, MQTT es complementario
+    } else {
+        ESP_LOGI(TAG, "✓ Tarea MQTT creada exitosamente");
+    }
+    
+    ESP_LOGI(TAG, "Creando tarea NVS...");
+    if (create_supervised_task(TASK_TYPE_NVS, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Error creando tarea NVS");
+        esp_restart();
+    }
+    
+    // La inicialización del error logger ya se hizo en BOOT_STAGE_SERVICES
+    ESP_LOGI(TAG, "Creando tarea de error logger...");
+    if (create_supervised_task(TASK_TYPE_ERROR_LOGGER, NULL) != pdPASS) {
+        ESP_LOGW(TAG, "⚠ Error creando tarea de error logger");
+    } else {
+        ESP_LOGI(TAG, "✓ Tarea de error logger creada");
+    }
+}
+
+static const boot_stage_descriptor_t boot_stages[BOOT_STAGE_MAX] = {
+    [BOOT_STAGE_HARDWARE] = { "hardware", 0, boot_start_hardware,
+        &init_config_semaphore, BOOT_TIMEOUT_INITIAL_CONFIG_MS, true, "Config timeout",
+        METRIC_GAUGE_BOOT_HARDWARE_MS },
+    // NVS flash se inicializa en la etapa de hardware
+    [BOOT_STAGE_SERVICES] = { "servicios", BOOT_BIT(BOOT_STAGE_HARDWARE), boot_start_services,
+        NULL, 0, false, NULL, METRIC_GAUGE_BOOT_SERVICES_MS },
+    [BOOT_STAGE_SENSOR_CONFIG] = { "config sensores", BOOT_BIT(BOOT_STAGE_SERVICES), boot_start_sensor_config,
+        &sensor_config_semaphore, BOOT_TIMEOUT_SENSOR_CONFIG_MS, false, NULL,
+        METRIC_GAUGE_BOOT_SENSOR_CONFIG_MS },
+    [BOOT_STAGE_SAMPLING] = { "muestreo", BOOT_BIT(BOOT_STAGE_SENSOR_CONFIG), boot_start_sampling,
+        NULL, 0, false, NULL, METRIC_GAUGE_BOOT_SAMPLING_MS },
+    [BOOT_STAGE_WIFI] = { "wifi", BOOT_BIT(BOOT_STAGE_SERVICES), boot_start_wifi,
+        &wifi_init_semaphore, BOOT_TIMEOUT_WIFI_MS, false, "WiFi timeout",
+        METRIC_GAUGE_BOOT_WIFI_MS },
+    [BOOT_STAGE_TIME] = { "hora", BOOT_BIT(BOOT_STAGE_WIFI), boot_start_time,
+        NULL, 0, false, NULL, METRIC_GAUGE_BOOT_TIME_MS },
+    [BOOT_STAGE_CLOUD] = { "nube", BOOT_BIT(BOOT_STAGE_SERVICES), boot_start_cloud,
+        NULL, 0, false, NULL, METRIC_GAUGE_BOOT_CLOUD_MS },
+};
+
+#define BOOT_ALL_STAGES (BOOT_BIT(BOOT_STAGE_MAX) - 1)
+
+static uint32_t boot_started = 0;
+static uint32_t boot_done = 0;
+static uint32_t boot_stage_start_ms[BOOT_STAGE_MAX];
+
+static void boot_finish_stage(boot_stage_t stage)
+{
+    uint32_t duration_ms = hal_clock_elapsed_ms(boot_stage_start_ms[stage]);
+    boot_done |= BOOT_BIT(stage);
+    metrics_gauge_set(boot_stages[stage].gauge, duration_ms);
+    ESP_LOGI(TAG, "⏱️ Etapa de arranque '%s' lista en %lu ms", boot_stages[stage].name,
+             (unsigned long)duration_ms);
+}
+
+// Avanzar el arranque sin bloquear: lanzar las etapas listas y cerrar las
+// terminadas. Devuelve true cuando ya terminaron todas.
+static bool boot_step(void)
+{
+    bool progress = true;
+    while (progress && boot_done != BOOT_ALL_STAGES) {
+        progress = false;
+        for (int i = 0; i < BOOT_STAGE_MAX; i++) {
+            const boot_stage_descriptor_t *stage = &boot_stages[i];
+            if (boot_done & BOOT_BIT(i)) {
+                continue;
+            }
+            
+            if (!(boot_started & BOOT_BIT(i))) {
+                if ((stage->depends_on & boot_done) != stage->depends_on) {
+                    continue;
+                }
+                boot_started |= BOOT_BIT(i);
+                boot_stage_start_ms[i] = hal_clock_now_ms();
+                stage->start();
+                if (stage->done == NULL) {
+                    boot_finish_stage((boot_stage_t)i);
+                }
+                progress = true;
+                continue;
+            }
+            
+            if (xSemaphoreTake(*stage->done, 0) == pdTRUE) {
+                boot_finish_stage((boot_stage_t)i);
+                progress = true;
+            } else if (stage->timeout_ms > 0 &&
+                       hal_clock_elapsed_ms(boot_stage_start_ms[i]) >= stage->timeout_ms) {
+                if (stage->timeout_led != NULL) {
+                    send_led_status(SYSTEM_STATE_ERROR, stage->timeout_led);
+                }
+                if (stage->restart_on_timeout) {
+                    ESP_LOGE(TAG, "Timeout en etapa de arranque '%s'", stage->name);
+                    esp_restart();
+                }
+                ESP_LOGW(TAG, "⚠ Timeout en etapa de arranque '%s', se sigue sin esperarla", stage->name);
+                boot_finish_stage((boot_stage_t)i);
+                progress = true;
+            }
+        }
+    }
+    return boot_done == BOOT_ALL_STAGES;
+}
+
 // Tarea principal del supervisor
 void task_main_supervisor(void *pvParameters)
 {
@@ -206,20 +631,18 @@ void task_main_supervisor(void *pvParameters)
         esp_restart();
     }
     
-    // Crear colas de actualización de configuración de sensores (tamaño 1)
-    humidity_config_queue = xQueueCreate(1, sizeof(config_update_message_t));
-    if (humidity_config_queue == NULL) {
-        ESP_LOGE(TAG, "Error creando cola de config de humedad");
-        esp_restart();
-    }
+    // Profundidad de colas expuesta en el snapshot de métricas
+    metrics_watch_queue(METRIC_GAUGE_SENSOR_QUEUE_DEPTH, shared_sensor_queue);
+    metrics_watch_queue(METRIC_GAUGE_SUPERVISOR_QUEUE_DEPTH, supervisor_queue_global);
     
-    light_config_queue = xQueueCreate(1, sizeof(config_update_message_t));
-    if (light_config_queue == NULL) {
-        ESP_LOGE(TAG, "Error creando cola de config de luz");
+    // Configuración de sensores: las tareas ven los cambios por versión, sin colas
+    if (sensor_config_snapshot_init() != ESP_OK) {
+        ESP_LOGE(TAG, "Error creando mutex de configuración de sensores");
         esp_restart();
     }
-    
-    ESP_LOGI(TAG, "✓ Colas de configuración creadas (tamaño: 1)");
+    if (config_bus_init() != ESP_OK) {
+        ESP_LOGW(TAG, "⚠️ Bus de configuración sin mutex");
+    }
     
     // Inicializar LED de estado
     init_status_led();
@@ -253,134 +676,31 @@ void task_main_supervisor(void *pvParameters)
         esp_restart();
     }
     
-    // Crear tarea de configuración inicial
-    ESP_LOGI(TAG, "Creando tarea de configuración inicial...");
-    result = xTaskCreate(task_initial_config, "initial_config",
-                        4096, NULL, 3, &task_handles[TASK_TYPE_INITIAL_CONFIG]);
-    if (result != pdPASS) {
-        ESP_LOGE(TAG, "Error creando tarea de configuración inicial");
-        esp_restart();
-    }
-    
-    // Esperar que termine la configuración inicial
-    ESP_LOGI(TAG, "Esperando finalización de configuración inicial...");
-    if (xSemaphoreTake(init_config_semaphore, pdMS_TO_TICKS(10000)) != pdTRUE) {
-        ESP_LOGE(TAG, "Timeout esperando configuración inicial");
-        send_led_status(SYSTEM_STATE_ERROR, "Config timeout");
-        esp_restart();
-    }
-    ESP_LOGI(TAG, "✓ Configuración inicial completada");
+    // Las etapas de arranque avanzan desde el loop del supervisor (boot_step)
+    bool boot_complete = boot_step();
     
-    // Inicializar sistema de logging de errores ANTES de WiFi
-    ESP_LOGI(TAG, "Inicializando sistema de logging de errores...");
-    if (error_logger_init() != ESP_OK) {
-        ESP_LOGW(TAG, "⚠ Error inicializando sistema de logs, continuando sin él");
-    } else {
-        ESP_LOGI(TAG, "✓ Sistema de error logging inicializado");
-    }
-    
-    // Crear tarea WiFi
-    ESP_LOGI(TAG, "Creando tarea WiFi...");
-    send_led_status(SYSTEM_STATE_WIFI, "Conectando WiFi");
-    result = xTaskCreate(task_wifi_connection, "wifi_task",
-                        6144, NULL, 3, &task_handles[TASK_TYPE_WIFI]);  // Aumentado de 4096 a 6144
-    if (result != pdPASS) {
-        ESP_LOGE(TAG, "Error creando tarea WiFi");
-        esp_restart();
-    }
-    
-    // Esperar conexión WiFi
-    ESP_LOGI(TAG, "Esperando conexión WiFi...");
-    if (xSemaphoreTake(wifi_init_semaphore, pdMS_TO_TICKS(30000)) != pdTRUE) {
-        ESP_LOGE(TAG, "Timeout conectando WiFi");
-        send_led_status(SYSTEM_STATE_ERROR, "WiFi timeout");
-        // No reiniciar, seguir intentando
-    } else {
-        ESP_LOGI(TAG, "✓ WiFi conectado exitosamente");
-    }
-    
-    // Crear tarea de configuración de sensores
-    ESP_LOGI(TAG, "Creando tarea de configuración de sensores...");
-    send_led_status(SYSTEM_STATE_CONFIG, "Config sensores");
-    result = xTaskCreate(task_sensor_config_init, "sensor_config",
-                        4096, NULL, 3, &task_handles[TASK_TYPE_SENSOR_CONFIG]);
-    if (result != pdPASS) {
-        ESP_LOGE(TAG, "Error creando tarea de configuración de sensores");
-        esp_restart();
-    }
-    
-    // Esperar configuración de sensores
-    ESP_LOGI(TAG, "Esperando configuración de sensores...");
-    if (xSemaphoreTake(sensor_config_semaphore, pdMS_TO_TICKS(15000)) != pdTRUE) {
-        ESP_LOGW(TAG, "Timeout configurando sensores, usando valores por defecto");
-    } else {
-        ESP_LOGI(TAG, "✓ Sensores configurados exitosamente");
-    }
-    
-    // Crear tarea unificada de sensores
-    ESP_LOGI(TAG, "Creando tarea unificada de sensores...");
-    ESP_LOGI(TAG, "  - Lectura cada %d ms", SENSOR_READING_INTERVAL_MS);
-    ESP_LOGI(TAG, "  - Envío HTTP según interval_seconds (configurado por MQTT)");
-    
-    result = xTaskCreate(task_sensors_unified_reading, "sensors_unified",
-                        4096, shared_sensor_queue, 3, &task_handles[TASK_TYPE_SENSOR]);
-    if (result != pdPASS) {
-        ESP_LOGE(TAG, "Error creando tarea unificada de sensores");
-        esp_restart();
-    }
-    ESP_LOGI(TAG, "✓ Tarea unificada de sensores creada");
-    
-    // Crear tarea HTTP
-    ESP_LOGI(TAG, "Creando tarea HTTP...");
-    result = xTaskCreate(task_http_client, "http_task",
-                        6144, shared_sensor_queue, 2, &task_handles[TASK_TYPE_HTTP]);
-    if (result != pdPASS) {
-        ESP_LOGE(TAG, "Error creando tarea HTTP");
-        esp_restart();
-    }
-    
-    // Crear tarea MQTT
-    ESP_LOGI(TAG, "Creando tarea MQTT...");
-    result = xTaskCreate(task_mqtt_client, "mqtt_task",
-                        4096, NULL, 2, NULL);
-    if (result != pdPASS) {
-        ESP_LOGE(TAG, "Error creando tarea MQTT");
-        // No reiniciar, MQTT es complementario
-    } else {
-        ESP_LOGI(TAG, "✓ Tarea MQTT creada exitosamente");
-    }
-    
-    // Crear tarea NVS
-    ESP_LOGI(TAG, "Creando tarea NVS...");
-    result = xTaskCreate(task_nvs_config, "nvs_task",
-                        3072, NULL, 1, &task_handles[TASK_TYPE_NVS]);
-    if (result != pdPASS) {
-        ESP_LOGE(TAG, "Error creando tarea NVS");
-        esp_restart();
-    }
-    
-    // Crear tarea de error logger (la inicialización ya se hizo antes de WiFi)
-    ESP_LOGI(TAG, "Creando tarea de error logger...");
-    result = xTaskCreate(task_error_logger, "error_logger",
-                        4096, NULL, 1, NULL);
-    if (result != pdPASS) {
-        ESP_LOGW(TAG, "⚠ Error creando tarea de error logger");
+    // Suscribir el supervisor al Task WDT del sistema: si el supervisor se cuelga
+    // nadie más vigila a las tareas, así que en ese caso se provoca un panic/reset.
+    esp_task_wdt_config_t twdt_config = {
+        .timeout_ms = WATCHDOG_TIMEOUT_MS,
+        .idle_core_mask = (1 << 0),
+        .trigger_panic = true,
+    };
+    if (esp_task_wdt_reconfigure(&twdt_config) != ESP_OK || esp_task_wdt_add(NULL) != ESP_OK) {
+        ESP_LOGW(TAG, "⚠ No se pudo suscribir el supervisor al Task WDT");
     } else {
-        ESP_LOGI(TAG, "✓ Tarea de error logger creada");
+        ESP_LOGI(TAG, "✓ Supervisor suscrito al Task WDT (%d ms)", WATCHDOG_TIMEOUT_MS);
     }
     
-    // Sistema listo
-    ESP_LOGI(TAG, "✓ Sistema completamente inicializado");
-    send_led_status(SYSTEM_STATE_READY, "Sistema listo");
-    xSemaphoreGive(system_ready_semaphore);
-    
     // Loop principal del supervisor
     supervisor_message_t received_msg;
-    uint32_t last_heartbeat_check = xTaskGetTickCount();
+    uint32_t last_heartbeat_check = hal_clock_now_ms();
     
     while (1) {
-        // Procesar mensajes con timeout
-        if (xQueueReceive(supervisor_queue_global, &received_msg, pdMS_TO_TICKS(5000)) == pdTRUE) {
+        // Procesar mensajes con timeout (corto para revisar plazos del watchdog a tiempo,
+        // y más corto todavía mientras quedan etapas de arranque)
+        TickType_t wait = pdMS_TO_TICKS(boot_complete ? WATCHDOG_CHECK_INTERVAL_MS : BOOT_POLL_MS);
+        if (xQueueReceive(supervisor_queue_global, &received_msg, wait) == pdTRUE) {
             // Procesar mensaje recibido
             switch (received_msg.type) {
                 case SUPERVISOR_MSG_ERROR_REPORT:
@@ -408,18 +728,30 @@ void task_main_supervisor(void *pvParameters)
             }
         }
         
+        if (!boot_complete && (boot_complete = boot_step())) {
+            metrics_gauge_set(METRIC_GAUGE_BOOT_TOTAL_MS, hal_clock_now_ms());
+            ESP_LOGI(TAG, "✓ Sistema completamente inicializado en %lu ms", (unsigned long)hal_clock_now_ms());
+            send_led_status(SYSTEM_STATE_READY, "Sistema listo");
+            xSemaphoreGive(system_ready_semaphore);
+        }
+        
+        // Verificar plazos de las tareas supervisadas y alimentar el Task WDT
+        watchdog_check_deadlines();
+        esp_task_wdt_reset();
+        
         // Watchdog periódico cada 30 segundos
-        uint32_t current_time = xTaskGetTickCount();
-        if ((current_time - last_heartbeat_check) > pdMS_TO_TICKS(30000)) {
+        if (hal_clock_elapsed_ms(last_heartbeat_check) > 30000) {
             ESP_LOGI(TAG, "Supervisor activo - Heap libre: %lu bytes", 
                     (unsigned long)esp_get_free_heap_size());
-            last_heartbeat_check = current_time;
+            last_heartbeat_check = hal_clock_now_ms();
             
             // Enviar estado Ready si no hay errores (volver a verde después de actividad)
             send_led_status(SYSTEM_STATE_READY, "Sistema OK");
         }
         
-        // Yield para otras tareas
-        vTaskDelay(pdMS_TO_TICKS(100));
+        // Yield para otras tareas (durante el arranque ya esperó en la cola)
+        if (boot_complete) {
+            hal_clock_delay_ms(100);
+        }
     }
 }
\ No newline at end of file
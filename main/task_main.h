@@ -6,16 +6,12 @@
 #include "freertos/queue.h"
 #include "freertos/semphr.h"
 #include "freertos/event_groups.h"
-#include "led_strip.h"
 
 // Event Group para estado de conectividad
 extern EventGroupHandle_t g_connectivity_event_group;
 #define CONNECTIVITY_WIFI_CONNECTED_BIT BIT0
 #define CONNECTIVITY_INTERNET_AVAILABLE_BIT BIT1
 
-// LED Neopixel global compartido entre tareas
-extern led_strip_handle_t g_led_strip;
-
 // Estados del sistema para el LED de estado
 typedef enum
 {
@@ -36,7 +32,7 @@ typedef enum
 typedef struct
 {
     system_state_t state;
-    uint32_t timestamp;
+    uint32_t timestamp;          // ms desde el arranque (hal_clock)
     char message[32];
 } led_status_message_t;
 
@@ -61,9 +57,32 @@ typedef enum
     TASK_TYPE_SENSOR,
     TASK_TYPE_HTTP,
     TASK_TYPE_NVS,
+    TASK_TYPE_MQTT,
+    TASK_TYPE_ERROR_LOGGER,
     TASK_TYPE_MAX
 } task_type_t;
 
+// Etapas de escalamiento del watchdog de tareas
+typedef enum
+{
+    WATCHDOG_STAGE_OK,          // Tarea alimentando dentro de su plazo
+    WATCHDOG_STAGE_LATE,        // Plazo vencido, registrado en el log
+    WATCHDOG_STAGE_RESTARTED    // Tarea reiniciada, esperando que vuelva a alimentar
+} watchdog_stage_t;
+
+// Estadísticas de vida de una tarea supervisada
+typedef struct
+{
+    bool monitored;              // Si la tarea tiene plazo activo
+    watchdog_stage_t stage;      // Etapa actual de escalamiento
+    uint32_t deadline_ms;        // Plazo configurado
+    uint32_t last_feed_age_ms;   // Tiempo desde la última alimentación
+    uint32_t stall_count;        // Veces que venció el plazo
+    uint32_t restart_count;      // Veces que se reinició la tarea
+    uint32_t last_recovery_ms;   // Tiempo desde el bloqueo hasta la recuperación (último)
+    uint32_t max_recovery_ms;    // Peor tiempo de recuperación observado
+} task_watchdog_stats_t;
+
 // Tipos de mensajes que pueden enviarse al supervisor
 typedef enum
 {
@@ -95,7 +114,7 @@ typedef struct
     supervisor_msg_type_t type;
     task_type_t task_type;
     task_error_t error_code;
-    uint32_t timestamp;
+    uint32_t timestamp;          // ms desde el arranque (hal_clock)
     char message[64];
     uint32_t task_free_stack;
     uint32_t heap_free;
@@ -115,15 +134,12 @@ void task_send_heartbeat(task_type_t task_type, const char *message);
 void task_report_error(task_type_t task_type, task_error_t error_code, const char *message);
 void task_send_status(task_type_t task_type, const char *message);
 
-// Funciones de control de backoff HTTP
-void pause_all_tasks_with_backoff(void);
-void reset_http_backoff(void);
+// Watchdog de tareas: cada tarea supervisada debe alimentar antes de su plazo
+void task_feed_watchdog(task_type_t task_type);
+void task_watchdog_get_stats(task_type_t task_type, task_watchdog_stats_t *out_stats);
+void task_watchdog_unregister(task_type_t task_type); // La tarea termina voluntariamente
 
 // Cola global del supervisor
 extern QueueHandle_t supervisor_queue_global;
 
-// Funciones para acceder a colas de configuración de sensores
-QueueHandle_t get_humidity_config_queue(void);
-QueueHandle_t get_light_config_queue(void);
-
 #endif // TASK_MAIN_H
\ No newline at end of file
@@ -3,25 +3,23 @@
 #include "task_sensor_config.h"
 #include "task_main.h"
 #include "task_sensor.h"
-#include "task_nvs.h"
+#include "config_store.h"
 #include "task_error_logger.h"
+#include "metrics.h"
+#include "pacing.h"
+#include "net_config.h"
 #include "esp_log.h"
-#include "mqtt_client.h"
+#include "hal_mqtt.h"
 #include "cJSON.h"
-#include "esp_crt_bundle.h"
+#include "hal_clock.h"
+#include "freertos/queue.h"
 #include <string.h>
 
 static const char *TAG = "MQTT";
-static esp_mqtt_client_handle_t mqtt_client = NULL;
 static bool mqtt_connected = false;
 
-/**
- * @brief Procesa el mensaje JSON de configuración recibido
- * 
- * @param serial Número de serie del sensor
- * @param json_data Datos JSON recibidos
- */
-static void process_sensor_config_message(const char *serial, const char *json_data)
+// Procesa el mensaje JSON de configuración recibido
+void mqtt_process_sensor_config(const char *serial, const char *json_data)
 {
     ESP_LOGI(TAG, "Procesando configuración para sensor %s", serial);
     ESP_LOGI(TAG, "JSON recibido: %s", json_data);
@@ -33,12 +31,12 @@ static void process_sensor_config_message(const char *serial, const char *json_d
     }
     
     // Determinar qué sensor actualizar basándose en el serial
-    sensor_config_t *config = NULL;
+    sensor_type_t sensor_type;
     if (strcmp(serial, DEVICE_SERIAL_HUMIDITY) == 0) {
-        config = &g_sensor_humidity_config;
+        sensor_type = SENSOR_TYPE_SOIL_HUMIDITY;
         ESP_LOGI(TAG, "Actualizando configuración del sensor de HUMEDAD");
     } else if (strcmp(serial, DEVICE_SERIAL_LIGHT) == 0) {
-        config = &g_sensor_light_config;
+        sensor_type = SENSOR_TYPE_LIGHT;
         ESP_LOGI(TAG, "Actualizando configuración del sensor de LUZ");
     } else {
         ESP_LOGE(TAG, "Serial desconocido: %s", serial);
@@ -46,6 +44,18 @@ static void process_sensor_config_message(const char *serial, const char *json_d
         return;
     }
     
+    // Espaciado de envíos y reconexiones (opcional, común a ambos sensores; no se persiste)
+    cJSON *pacing_obj = cJSON_GetObjectItem(root, "pacing");
+    if (pacing_obj != NULL) {
+        pacing_apply_json(pacing_obj);
+    }
+    
+    // IP estática o DHCP (opcional, común a ambos sensores; se usa desde la próxima conexión)
+    cJSON *network_obj = cJSON_GetObjectItem(root, "network");
+    if (network_obj != NULL) {
+        net_config_apply_json(network_obj);
+    }
+    
     // Extraer el objeto sensorConfig si existe (estructura anidada)
     cJSON *sensor_config_obj = cJSON_GetObjectItem(root, "sensorConfig");
     cJSON *data_source = (sensor_config_obj != NULL) ? sensor_config_obj : root;
@@ -56,7 +66,9 @@ static void process_sensor_config_message(const char *serial, const char *json_d
         ESP_LOGI(TAG, "📄 Usando estructura plana (root)");
     }
     
-    // Parsear campos del JSON
+    // Parsear campos del JSON sobre una copia de trabajo: los lectores siguen
+    // viendo la configuración anterior hasta que se publica completa
+    sensor_config_t *config = sensor_config_begin_update(sensor_type);
     cJSON *id_sensor = cJSON_GetObjectItem(data_source, "id_sensor");
     if (cJSON_IsNumber(id_sensor)) {
         config->id_sensor = id_sensor->valueint;
@@ -132,85 +144,237 @@ static void process_sensor_config_message(const char *serial, const char *json_d
     ESP_LOGI(TAG, "✓ Configuración actualizada exitosamente para sensor %s", serial);
     
     // ===== GUARDAR EN NVS PARA PERSISTENCIA =====
-    sensor_type_t sensor_type;
-    if (strcmp(serial, DEVICE_SERIAL_HUMIDITY) == 0) {
-        sensor_type = SENSOR_TYPE_SOIL_HUMIDITY;
-    } else if (strcmp(serial, DEVICE_SERIAL_LIGHT) == 0) {
-        sensor_type = SENSOR_TYPE_LIGHT;
-    } else {
-        sensor_type = SENSOR_TYPE_UNKNOWN;
+    // Escritura diferida y solo si cambió (config_store.c)
+    esp_err_t nvs_result = config_store_save(sensor_type, config);
+    if (nvs_result != ESP_OK) {
+        ESP_LOGW(TAG, "⚠️ No se pudo guardar configuración en NVS: %s", esp_err_to_name(nvs_result));
     }
     
-    if (sensor_type != SENSOR_TYPE_UNKNOWN) {
-        esp_err_t nvs_result = nvs_save_sensor_config(sensor_type, config);
-        if (nvs_result == ESP_OK) {
-            ESP_LOGI(TAG, "💾 Configuración guardada en NVS");
-        } else {
-            ESP_LOGW(TAG, "⚠️ No se pudo guardar configuración en NVS: %s", esp_err_to_name(nvs_result));
-        }
+    // ===== PUBLICAR PARA LAS TAREAS =====
+    // La tarea de sensores y la HTTP ven la versión nueva en su próximo ciclo
+    if (sensor_config_end_update(sensor_type)) {
+        ESP_LOGI(TAG, "📨 Configuración publicada (v%lu)", (unsigned long)sensor_config_version(sensor_type));
     }
     
-    // ===== ENVIAR MENSAJE A COLA PARA ACTUALIZACIÓN EN TIEMPO REAL =====
-    config_update_message_t update_msg = {
-        .new_interval_s = config->interval_s,
-        .update_interval = true
-    };
-    
-    QueueHandle_t target_queue = NULL;
-    if (strcmp(serial, DEVICE_SERIAL_HUMIDITY) == 0) {
-        update_msg.type = SENSOR_TYPE_SOIL_HUMIDITY;
-        target_queue = get_humidity_config_queue();
-        ESP_LOGI(TAG, "📨 Enviando actualización de intervalo (%d seg) a tarea de HUMEDAD", update_msg.new_interval_s);
-    } else if (strcmp(serial, DEVICE_SERIAL_LIGHT) == 0) {
-        update_msg.type = SENSOR_TYPE_LIGHT;
-        target_queue = get_light_config_queue();
-        ESP_LOGI(TAG, "📨 Enviando actualización de intervalo (%d seg) a tarea de LUZ", update_msg.new_interval_s);
+    cJSON_Delete(root);
+}
+
+// ===== TRABAJO DIFERIDO =====
+// El manejador corre en la tarea de esp-mqtt: si se bloquea (parseo, commit
+// de NVS, log de errores) se atrasan los keepalive y los mensajes entrantes.
+// Solo copia el mensaje a un buffer del pool y la tarea worker lo aplica.
+
+typedef enum {
+    MQTT_JOB_SENSOR_CONFIG,   // serial + payload JSON
+    MQTT_JOB_LOG_SYSTEM,      // error_logger_log_system() con data como detalles
+} mqtt_job_type_t;
+
+typedef struct {
+    mqtt_job_type_t type;
+    char serial[16];
+    const char *error_code;   // Literales: no hace falta copiarlos
+    const char *message;
+    error_severity_t severity;
+    char data[MQTT_MAX_PAYLOAD_LEN];
+} mqtt_job_t;
+
+// Índice que indica "sin worker: aplicar en el manejador"
+#define MQTT_JOB_INLINE 0xFF
+// Índice sin buffer: hay cambios de conexión en connection_events
+#define MQTT_JOB_CONNECTION 0xFE
+
+// Cambios de conexión pendientes para el worker. Se acumulan en bits: un solo
+// aviso en la cola aunque el broker se caiga y vuelva varias veces seguidas.
+#define MQTT_CONN_EVENT_CONNECTED    (1u << 0)
+#define MQTT_CONN_EVENT_DISCONNECTED (1u << 1)
+static uint32_t connection_events = 0;
+
+static mqtt_job_t job_pool[MQTT_WORKER_POOL_SIZE];
+static mqtt_job_t inline_job;               // Solo desde el manejador, sin worker
+static QueueHandle_t free_jobs = NULL;      // Índices libres del pool
+static QueueHandle_t pending_jobs = NULL;   // Índices listos para el worker
+
+static void mqtt_job_run(mqtt_job_t *job)
+{
+    switch (job->type) {
+        case MQTT_JOB_SENSOR_CONFIG:
+            mqtt_process_sensor_config(job->serial, job->data);
+            break;
+        case MQTT_JOB_LOG_SYSTEM:
+            error_logger_log_system(job->error_code, job->severity, job->message, job->data);
+            break;
     }
-    
-    if (target_queue != NULL) {
-        if (xQueueSend(target_queue, &update_msg, pdMS_TO_TICKS(100)) == pdTRUE) {
-            ESP_LOGI(TAG, "✓ Mensaje de actualización enviado correctamente");
-        } else {
-            ESP_LOGW(TAG, "⚠ No se pudo enviar mensaje de actualización (cola llena)");
+}
+
+// Conexión establecida: el backoff vuelve a la base y se anuncia el estado
+static void mqtt_on_connected(void)
+{
+    pacing_reset_backoff(PACING_CHANNEL_MQTT);
+    hal_mqtt_set_reconnect_timeout(pacing_next_backoff_ms(PACING_CHANNEL_MQTT));
+    mqtt_publish_status("online");
+}
+
+// Cada caída seguida alarga la espera de reconexión (jitter decorrelado)
+static void mqtt_on_disconnected(void)
+{
+    hal_mqtt_set_reconnect_timeout(pacing_next_backoff_ms(PACING_CHANNEL_MQTT));
+}
+
+// hal_mqtt_set_reconnect_timeout() reaplica toda la configuración del cliente
+// y publicar espera el lock de esp-mqtt: ninguno va en el manejador
+static void mqtt_run_connection_events(uint32_t events)
+{
+    // Con los dos bits, el estado actual dice cuál pasó último
+    if ((events & MQTT_CONN_EVENT_DISCONNECTED) && mqtt_connected) {
+        mqtt_on_disconnected();
+        events &= ~MQTT_CONN_EVENT_DISCONNECTED;
+    }
+    if (events & MQTT_CONN_EVENT_CONNECTED) {
+        mqtt_on_connected();
+    }
+    if (events & MQTT_CONN_EVENT_DISCONNECTED) {
+        mqtt_on_disconnected();
+    }
+}
+
+static void mqtt_worker(void *pvParameters)
+{
+    uint8_t index;
+    while (1) {
+        if (xQueueReceive(pending_jobs, &index, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        int64_t start_us = hal_clock_now_us();
+        if (index == MQTT_JOB_CONNECTION) {
+            mqtt_run_connection_events(__atomic_exchange_n(&connection_events, 0, __ATOMIC_ACQ_REL));
+            metrics_counter_add(METRIC_MQTT_WORKER_US, (uint32_t)(hal_clock_now_us() - start_us));
+            continue;
         }
+        mqtt_job_run(&job_pool[index]);
+        metrics_counter_add(METRIC_MQTT_WORKER_US, (uint32_t)(hal_clock_now_us() - start_us));
+        xQueueSend(free_jobs, &index, 0);
     }
-    
-    cJSON_Delete(root);
+}
+
+// Crear el pool y la tarea worker. Si falla, los mensajes se aplican en el manejador como antes.
+static void mqtt_worker_init(void)
+{
+    free_jobs = xQueueCreate(MQTT_WORKER_POOL_SIZE, sizeof(uint8_t));
+    pending_jobs = xQueueCreate(MQTT_WORKER_POOL_SIZE + 1, sizeof(uint8_t));   // + el aviso de conexión
+    if (free_jobs == NULL || pending_jobs == NULL ||
+        xTaskCreate(mqtt_worker, "mqtt_worker", MQTT_WORKER_STACK, NULL,
+                    MQTT_WORKER_PRIORITY, NULL) != pdPASS) {
+        ESP_LOGW(TAG, "⚠️ Sin worker MQTT: los mensajes se aplican en el manejador");
+        if (free_jobs != NULL) {
+            vQueueDelete(free_jobs);
+        }
+        if (pending_jobs != NULL) {
+            vQueueDelete(pending_jobs);
+        }
+        free_jobs = NULL;
+        pending_jobs = NULL;
+        return;
+    }
+
+    for (uint8_t i = 0; i < MQTT_WORKER_POOL_SIZE; i++) {
+        xQueueSend(free_jobs, &i, 0);
+    }
+    metrics_watch_queue(METRIC_GAUGE_MQTT_WORK_QUEUE_DEPTH, pending_jobs);
+}
+
+// Tomar un buffer libre sin esperar (NULL si el pool está lleno)
+static mqtt_job_t *mqtt_job_acquire(mqtt_job_type_t type, uint8_t *index)
+{
+    mqtt_job_t *job;
+    if (free_jobs == NULL) {
+        *index = MQTT_JOB_INLINE;
+        job = &inline_job;
+    } else if (xQueueReceive(free_jobs, index, 0) == pdTRUE) {
+        job = &job_pool[*index];
+    } else {
+        metrics_counter_inc(METRIC_MQTT_WORK_DROPS);
+        ESP_LOGW(TAG, "⚠️ Worker MQTT ocupado: mensaje descartado");
+        return NULL;
+    }
+    job->type = type;
+    return job;
+}
+
+static void mqtt_job_submit(uint8_t index)
+{
+    if (index == MQTT_JOB_INLINE) {
+        mqtt_job_run(&inline_job);
+        return;
+    }
+    // No puede fallar: la cola tiene lugar para todo el pool y el aviso de conexión
+    xQueueSend(pending_jobs, &index, 0);
+}
+
+// Avisar al worker de un cambio de conexión (sin worker, se aplica aquí)
+static void mqtt_post_connection_event(uint32_t event)
+{
+    if (pending_jobs == NULL) {
+        mqtt_run_connection_events(event);
+        return;
+    }
+    // Solo el primer bit encola el aviso; el worker los toma todos juntos
+    if (__atomic_fetch_or(&connection_events, event, __ATOMIC_ACQ_REL) == 0) {
+        uint8_t index = MQTT_JOB_CONNECTION;
+        xQueueSend(pending_jobs, &index, 0);
+    }
+}
+
+// Diferir error_logger_log_system(): puede leer NVS y encolar en la tarea de errores
+static void mqtt_defer_log_system(const char *error_code, error_severity_t severity,
+                                  const char *message, const char *details_json)
+{
+    uint8_t index;
+    mqtt_job_t *job = mqtt_job_acquire(MQTT_JOB_LOG_SYSTEM, &index);
+    if (job == NULL) {
+        return;
+    }
+    job->error_code = error_code;
+    job->severity = severity;
+    job->message = message;
+    snprintf(job->data, sizeof(job->data), "%s", details_json);
+    mqtt_job_submit(index);
 }
 
 /**
- * @brief Manejador de eventos MQTT
+ * @brief Despachar un evento MQTT (corre en la tarea de esp-mqtt)
  */
-static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data)
+static void mqtt_dispatch_event(const hal_mqtt_event_t *event)
 {
-    esp_mqtt_event_handle_t event = (esp_mqtt_event_handle_t)event_data;
-    
-    switch ((esp_mqtt_event_id_t)event_id) {
-        case MQTT_EVENT_CONNECTED:
+    switch (event->id) {
+        case HAL_MQTT_EVENT_CONNECTED:
             ESP_LOGI(TAG, "✓ Conectado al broker MQTT");
             mqtt_connected = true;
             
             // Suscribirse a los topics de configuración
             int msg_id;
-            msg_id = esp_mqtt_client_subscribe(mqtt_client, MQTT_TOPIC_CONFIG_HUMIDITY, MQTT_QOS);
+            msg_id = hal_mqtt_subscribe(MQTT_TOPIC_CONFIG_HUMIDITY, MQTT_QOS);
             ESP_LOGI(TAG, "Suscrito a %s, msg_id=%d", MQTT_TOPIC_CONFIG_HUMIDITY, msg_id);
             
-            msg_id = esp_mqtt_client_subscribe(mqtt_client, MQTT_TOPIC_CONFIG_LIGHT, MQTT_QOS);
+            msg_id = hal_mqtt_subscribe(MQTT_TOPIC_CONFIG_LIGHT, MQTT_QOS);
             ESP_LOGI(TAG, "Suscrito a %s, msg_id=%d", MQTT_TOPIC_CONFIG_LIGHT, msg_id);
             
-            // Publicar estado online
-            mqtt_publish_status("online");
+            // Reset del backoff y estado online (en el worker)
+            mqtt_post_connection_event(MQTT_CONN_EVENT_CONNECTED);
             break;
             
-        case MQTT_EVENT_DISCONNECTED:
+        case HAL_MQTT_EVENT_DISCONNECTED:
             ESP_LOGW(TAG, "Desconectado del broker MQTT");
             mqtt_connected = false;
+            metrics_counter_inc(METRIC_MQTT_DISCONNECTS);
             send_led_status(SYSTEM_STATE_WARNING, "MQTT desconectado");
             
+            // Alargar la espera de reconexión (en el worker)
+            mqtt_post_connection_event(MQTT_CONN_EVENT_DISCONNECTED);
+            
             // Log de desconexión MQTT
             char details_disc[128];
             snprintf(details_disc, sizeof(details_disc), "{\"broker\": \"%s\"}", MQTT_BROKER_URL);
-            error_logger_log_system(
+            mqtt_defer_log_system(
                 "MQTT_DISCONNECTED",
                 ERROR_SEVERITY_WARNING,
                 "Desconectado del broker MQTT",
@@ -218,22 +382,18 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
             );
             break;
             
-        case MQTT_EVENT_SUBSCRIBED:
+        case HAL_MQTT_EVENT_SUBSCRIBED:
             ESP_LOGI(TAG, "Suscripción exitosa, msg_id=%d", event->msg_id);
             break;
             
-        case MQTT_EVENT_UNSUBSCRIBED:
-            ESP_LOGI(TAG, "Cancelada suscripción, msg_id=%d", event->msg_id);
-            break;
-            
-        case MQTT_EVENT_PUBLISHED:
+        case HAL_MQTT_EVENT_PUBLISHED:
             ESP_LOGI(TAG, "Mensaje publicado, msg_id=%d", event->msg_id);
             break;
             
-        case MQTT_EVENT_DATA:
-            ESP_LOGI(TAG, "Mensaje MQTT recibido:");
-            ESP_LOGI(TAG, "  TOPIC=%.*s", event->topic_len, event->topic);
-            ESP_LOGI(TAG, "  DATA=%.*s", event->data_len, event->data);
+        case HAL_MQTT_EVENT_DATA:
+            metrics_counter_inc(METRIC_MQTT_MESSAGES_RX);
+            ESP_LOGI(TAG, "Mensaje MQTT recibido: TOPIC=%.*s (%d bytes)",
+                     event->topic_len, event->topic, event->data_len);
             
             // Extraer serial del topic (formato: ong/sensor/{serial}/config)
             char topic[MQTT_MAX_TOPIC_LEN];
@@ -244,28 +404,29 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
                 serial_start += strlen("ong/sensor/");
                 char *serial_end = strchr(serial_start, '/');
                 if (serial_end != NULL) {
-                    char serial[16];
-                    int serial_len = serial_end - serial_start;
-                    if (serial_len < sizeof(serial)) {
-                        strncpy(serial, serial_start, serial_len);
-                        serial[serial_len] = '\0';
-                        
-                        // Crear string null-terminated del payload
-                        char payload[MQTT_MAX_PAYLOAD_LEN];
-                        snprintf(payload, sizeof(payload), "%.*s", event->data_len, event->data);
+                    size_t serial_len = (size_t)(serial_end - serial_start);
+                    uint8_t index;
+                    mqtt_job_t *job = NULL;
+                    if (serial_len < sizeof(job->serial)) {
+                        job = mqtt_job_acquire(MQTT_JOB_SENSOR_CONFIG, &index);
+                    }
+                    if (job != NULL) {
+                        memcpy(job->serial, serial_start, serial_len);
+                        job->serial[serial_len] = '\0';
                         
-                        // Procesar configuración
-                        process_sensor_config_message(serial, payload);
+                        // Payload null-terminated (el parseo y la persistencia van en el worker)
+                        snprintf(job->data, sizeof(job->data), "%.*s", event->data_len, event->data);
+                        mqtt_job_submit(index);
                     }
                 }
             }
             break;
             
-        case MQTT_EVENT_ERROR:
+        case HAL_MQTT_EVENT_ERROR:
             ESP_LOGE(TAG, "Error MQTT");
             send_led_status(SYSTEM_STATE_ERROR, "Error MQTT");
             
-            if (event->error_handle->error_type == MQTT_ERROR_TYPE_TCP_TRANSPORT) {
+            if (event->transport_error) {
                 ESP_LOGE(TAG, "Error de transporte TCP reportado");
             }
             
@@ -273,8 +434,8 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
             char details_err[256];
             snprintf(details_err, sizeof(details_err), 
                      "{\"error_type\": %d, \"broker\": \"%s\"}",
-                     event->error_handle->error_type, MQTT_BROKER_URL);
-            error_logger_log_system(
+                     event->error_type, MQTT_BROKER_URL);
+            mqtt_defer_log_system(
                 "MQTT_ERROR",
                 ERROR_SEVERITY_ERROR,
                 "Error en conexión MQTT",
@@ -283,41 +444,42 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
             break;
             
         default:
-            ESP_LOGD(TAG, "Evento MQTT no manejado: %d", event_id);
+            ESP_LOGD(TAG, "Evento MQTT no manejado: %d", event->id);
             break;
     }
 }
 
+/**
+ * @brief Manejador de eventos MQTT
+ */
+static void mqtt_event_handler(const hal_mqtt_event_t *event)
+{
+    int64_t start_us = hal_clock_now_us();
+    mqtt_dispatch_event(event);
+    uint32_t elapsed_us = (uint32_t)(hal_clock_now_us() - start_us);
+    
+    metrics_counter_inc(METRIC_MQTT_HANDLER_CALLS);
+    metrics_counter_add(METRIC_MQTT_HANDLER_US, elapsed_us);
+    ESP_LOGD(TAG, "Evento %d atendido en %lu µs", event->id, (unsigned long)elapsed_us);
+}
+
 esp_err_t mqtt_client_init(void)
 {
     ESP_LOGI(TAG, "Inicializando cliente MQTT...");
     
-    const esp_mqtt_client_config_t mqtt_cfg = {
-        .broker.address.uri = MQTT_BROKER_URL,
-        .broker.address.port = MQTT_BROKER_PORT,
-        .credentials.client_id = MQTT_CLIENT_ID,
-        .credentials.username = MQTT_USERNAME,
-        .credentials.authentication.password = MQTT_PASSWORD,
-        .session.keepalive = MQTT_KEEPALIVE,
-        .network.reconnect_timeout_ms = MQTT_RECONNECT_TIMEOUT_MS,
-        .network.disable_auto_reconnect = false,
-        // Configuración TLS para mqtts:// usando bundle de certificados
-        .broker.verification.crt_bundle_attach = esp_crt_bundle_attach,
-    };
-    
-    mqtt_client = esp_mqtt_client_init(&mqtt_cfg);
-    if (mqtt_client == NULL) {
-        ESP_LOGE(TAG, "Error al inicializar cliente MQTT");
-        return ESP_FAIL;
-    }
+    mqtt_worker_init();
     
-    esp_err_t ret = esp_mqtt_client_register_event(mqtt_client, ESP_EVENT_ANY_ID, mqtt_event_handler, NULL);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Error al registrar manejador de eventos MQTT");
-        return ret;
-    }
+    const hal_mqtt_config_t mqtt_cfg = {
+        .uri = MQTT_BROKER_URL,
+        .port = MQTT_BROKER_PORT,
+        .client_id = MQTT_CLIENT_ID,
+        .username = MQTT_USERNAME,
+        .password = MQTT_PASSWORD,
+        .keepalive_s = MQTT_KEEPALIVE,
+        .reconnect_timeout_ms = (int)pacing_next_backoff_ms(PACING_CHANNEL_MQTT),
+    };
     
-    ret = esp_mqtt_client_start(mqtt_client);
+    esp_err_t ret = hal_mqtt_start(&mqtt_cfg, mqtt_event_handler);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Error al iniciar cliente MQTT");
         return ret;
@@ -339,7 +501,7 @@ esp_err_t mqtt_publish_status(const char *status)
              "{\"client_id\":\"%s\",\"status\":\"%s\",\"humidity_serial\":\"%s\",\"light_serial\":\"%s\"}",
              MQTT_CLIENT_ID, status, DEVICE_SERIAL_HUMIDITY, DEVICE_SERIAL_LIGHT);
     
-    int msg_id = esp_mqtt_client_publish(mqtt_client, MQTT_TOPIC_STATUS, payload, 0, MQTT_QOS, 0);
+    int msg_id = hal_mqtt_publish(MQTT_TOPIC_STATUS, payload, 0, MQTT_QOS, 0);
     if (msg_id < 0) {
         ESP_LOGE(TAG, "Error al publicar estado");
         return ESP_FAIL;
@@ -349,6 +511,31 @@ esp_err_t mqtt_publish_status(const char *status)
     return ESP_OK;
 }
 
+esp_err_t mqtt_publish_metrics(void)
+{
+    if (!mqtt_connected) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    // Buffer estático: solo se publica desde la tarea MQTT
+    static char payload[METRICS_SNAPSHOT_MAX_LEN];
+    int len = metrics_build_snapshot_json(payload, sizeof(payload));
+    if (len < 0) {
+        ESP_LOGE(TAG, "Error generando snapshot de métricas");
+        return ESP_FAIL;
+    }
+    
+    // QoS 0: un snapshot perdido se reemplaza con el siguiente
+    int msg_id = hal_mqtt_publish(MQTT_TOPIC_METRICS, payload, len, 0, 0);
+    if (msg_id < 0) {
+        ESP_LOGE(TAG, "Error al publicar métricas");
+        return ESP_FAIL;
+    }
+    
+    ESP_LOGI(TAG, "📊 Métricas publicadas (%d bytes)", len);
+    return ESP_OK;
+}
+
 bool mqtt_is_connected(void)
 {
     return mqtt_connected;
@@ -360,31 +547,42 @@ void task_mqtt_client(void *pvParameters)
     
     // Esperar conectividad WiFi antes de inicializar MQTT
     ESP_LOGI(TAG, "⏳ MQTT: Esperando conectividad WiFi...");
-    xEventGroupWaitBits(
-        g_connectivity_event_group,
-        CONNECTIVITY_WIFI_CONNECTED_BIT,
-        pdFALSE,  // No clear bits
-        pdFALSE,  // Wait for any bit
-        portMAX_DELAY  // Esperar indefinidamente
-    );
+    while (!(xEventGroupWaitBits(
+                 g_connectivity_event_group,
+                 CONNECTIVITY_WIFI_CONNECTED_BIT,
+                 pdFALSE,  // No clear bits
+                 pdFALSE,  // Wait for any bit
+                 pdMS_TO_TICKS(10000)) & CONNECTIVITY_WIFI_CONNECTED_BIT)) {
+        task_feed_watchdog(TASK_TYPE_MQTT);
+    }
     
     ESP_LOGI(TAG, "✅ WiFi conectado, inicializando cliente MQTT");
     
     esp_err_t ret = mqtt_client_init();
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Error al inicializar MQTT, abortando tarea");
+        task_watchdog_unregister(TASK_TYPE_MQTT);
         vTaskDelete(NULL);
         return;
     }
     
+    uint32_t last_metrics = hal_clock_now_ms();
+    
     // Loop de heartbeat
     while (1) {
+        task_feed_watchdog(TASK_TYPE_MQTT);
+        
         // Verificar conectividad antes de intentar publicar
         EventBits_t bits = xEventGroupGetBits(g_connectivity_event_group);
         
         if (bits & CONNECTIVITY_WIFI_CONNECTED_BIT) {
             if (mqtt_connected) {
                 mqtt_publish_status("online");
+                
+                if (hal_clock_elapsed_ms(last_metrics) >= METRICS_PUBLISH_INTERVAL_MS) {
+                    mqtt_publish_metrics();
+                    last_metrics = hal_clock_now_ms();
+                }
             } else {
                 ESP_LOGW(TAG, "MQTT desconectado, esperando reconexión automática...");
             }
@@ -392,6 +590,6 @@ void task_mqtt_client(void *pvParameters)
             ESP_LOGW(TAG, "⏸️ MQTT: Sin conectividad WiFi");
         }
         
-        vTaskDelay(pdMS_TO_TICKS(60000)); // Cada 60 segundos
+        hal_clock_delay_ms(60000); // Cada 60 segundos
     }
 }
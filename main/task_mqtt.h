@@ -26,6 +26,28 @@ esp_err_t mqtt_client_init(void);
  */
 esp_err_t mqtt_publish_status(const char *status);
 
+/**
+ * @brief Publica el snapshot de métricas de runtime
+ * 
+ * Envía contadores, gauges, histogramas y uso de CPU/stack por tarea
+ * al tópico MQTT_TOPIC_METRICS
+ * 
+ * @return ESP_OK si se publicó correctamente
+ */
+esp_err_t mqtt_publish_metrics(void);
+
+/**
+ * @brief Aplica un mensaje de configuración recibido por MQTT
+ * 
+ * Actualiza la configuración del sensor, la guarda en NVS y notifica
+ * el nuevo intervalo a la tarea de sensores. El manejador de eventos no la
+ * llama directamente: la aplica la tarea worker de MQTT.
+ * 
+ * @param serial Número de serie del sensor
+ * @param json_data Datos JSON recibidos
+ */
+void mqtt_process_sensor_config(const char *serial, const char *json_data);
+
 /**
  * @brief Verifica si el cliente MQTT está conectado
  * 
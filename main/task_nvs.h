@@ -3,14 +3,13 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "nvs.h"
-#include "nvs_flash.h"
+#include "hal_nvs.h"
 #include "task_sensor.h"
 #include "task_sensor_config.h"
 
 // Global variables for NVS handles
-extern nvs_handle_t my_handle;
-extern nvs_handle_t my_handle_pass;
+extern hal_nvs_handle_t my_handle;
+extern hal_nvs_handle_t my_handle_pass;
 
 // Flags for writing
 extern bool flag_write_flash;
@@ -40,10 +39,22 @@ esp_err_t nvs_get_sensor_id(const char *key, int32_t *out_id);
 esp_err_t nvs_save_registered_flag(const char *key, bool value);
 esp_err_t nvs_get_registered_flag(const char *key, bool *out_value);
 
-// Sensor configuration persistence
-esp_err_t nvs_save_sensor_config(sensor_type_t sensor_type, sensor_config_t *config);
+// Configuración de sensores en el formato anterior (una clave por campo): solo
+// la lee config_store.c para migrarla a su blob
 esp_err_t nvs_load_sensor_config(sensor_type_t sensor_type, sensor_config_t *config);
 
+// Validadores HTTP (ETag, Last-Modified) de la configuración guardada en NVS.
+// Viven en el mismo namespace: sin configuración guardada no hay validadores.
+esp_err_t nvs_save_config_validators(const char *etag, const char *last_modified);
+esp_err_t nvs_load_config_validators(char *etag, size_t etag_size, char *last_modified, size_t last_modified_size);
+esp_err_t nvs_erase_config_validators(void);
+// Epoch (s) de la última sincronización de configuración confirmada por el backend
+esp_err_t nvs_save_config_sync_time(int32_t epoch_s);
+esp_err_t nvs_load_config_sync_time(int32_t *epoch_s);
+// Epoch (s) del último 404 de GET /sensors/config (0 = el endpoint por lotes responde)
+esp_err_t nvs_save_config_batch_missing(int32_t epoch_s);
+esp_err_t nvs_load_config_batch_missing(int32_t *epoch_s);
+
 // Task
 void task_nvs_config(void *args);
 
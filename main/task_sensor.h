@@ -4,6 +4,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
+#include "metrics.h"
 
 // Tipo de sensor
 typedef enum {
@@ -22,12 +23,26 @@ typedef struct {
     bool valid;             // Si la lectura es válida
 } sensor_data_t;
 
-// Estructura para actualización de configuración en tiempo real vía MQTT
+// Sensores que entran en una trama (humedad y luz)
+#define SENSOR_FRAME_MAX_READINGS 2
+
+// Lectura de un sensor dentro de una trama
+typedef struct {
+    sensor_type_t type;     // Tipo de sensor
+    float adc_voltage;      // Voltaje leído del ADC en mV
+    int raw_value;          // Valor crudo del ADC (0-4095)
+    float converted_value;  // Valor convertido (HS% para humedad, LM% para luz)
+} sensor_reading_t;
+
+// Lecturas de todos los sensores tomadas en un mismo ciclo de muestreo.
+// Viajan juntas por la cola y salen en un solo POST a /process-data.
 typedef struct {
-    sensor_type_t type;     // Tipo de sensor afectado
-    int new_interval_s;     // Nuevo intervalo de lectura en segundos
-    bool update_interval;   // true = actualizar intervalo de lectura
-} config_update_message_t;
+    uint32_t timestamp;     // Instante del ciclo (ms, hal_clock; a UTC al enviar, ver time_service.h)
+    uint32_t seq;           // Secuencia de tramas al elegirla para envío (0 = sin asignar, ver sequence.h)
+    uint8_t count;          // Lecturas válidas en readings
+    sensor_reading_t readings[SENSOR_FRAME_MAX_READINGS];
+    sample_trace_t trace;   // Traza de latencia por etapa (muestreo -> confirmación del backend)
+} sensor_frame_t;
 
 /**
  * @brief Tarea de lectura de sensores ADC
@@ -2,207 +2,157 @@
 #include "task_main.h"
 #include "config.h"
 #include "esp_log.h"
-#include "task_nvs.h"
-#include "esp_http_client.h"
-#include "esp_crt_bundle.h"
-#include "cJSON.h"
+#include "config_store.h"
+#include "config_bus.h"
+#include "freertos/semphr.h"
 #include <string.h>
 
-// Declaración externa de la función de validación
-extern esp_err_t validate_device_serial(const char *device_serial);
-
 static const char *TAG = "SENSOR_CONFIG";
 
-// Variables globales para las configuraciones de cada sensor
-sensor_config_t g_sensor_humidity_config = {
-    .id_sensor = 0,
-    .description = "Soil Humidity Sensor",
-    .interval_s = 5,
-    .state = true,
-    .config_loaded = false,
-    .max_value = 0.0f,
-    .min_value = 0.0f,
-    .has_max_value = false,
-    .has_min_value = false,
-    .id_user_created = 0,
-    .id_user_modified = 0,
-    .created_at = "",
-    .modified_at = ""
+// Configuración publicada de cada sensor. seq es impar mientras se copia una
+// versión nueva (versión = seq / 2); staging es la copia de trabajo del escritor.
+typedef struct {
+    uint32_t seq;
+    sensor_config_t config;
+    sensor_config_t staging;
+} sensor_config_slot_t;
+
+static SemaphoreHandle_t writer_mutex = NULL;
+// La publicación va en sección crítica: un lector de mayor prioridad nunca
+// queda reintentando contra un escritor desalojado a mitad de la copia
+static portMUX_TYPE publish_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static sensor_config_slot_t config_slots[] = {
+    [SENSOR_TYPE_SOIL_HUMIDITY] = {
+        .seq = 2,
+        .config = {
+            .id_sensor = 0,
+            .description = "Soil Humidity Sensor",
+            .interval_s = 5,
+            .state = true,
+            .config_loaded = false,
+            .max_value = 0.0f,
+            .min_value = 0.0f,
+            .has_max_value = false,
+            .has_min_value = false,
+            .id_user_created = 0,
+            .id_user_modified = 0,
+            .created_at = "",
+            .modified_at = ""
+        },
+    },
+    [SENSOR_TYPE_LIGHT] = {
+        .seq = 2,
+        .config = {
+            .id_sensor = 0,
+            .description = "Light Sensor",
+            .interval_s = 5,
+            .state = true,
+            .config_loaded = false,
+            .max_value = 0.0f,
+            .min_value = 0.0f,
+            .has_max_value = false,
+            .has_min_value = false,
+            .id_user_created = 0,
+            .id_user_modified = 0,
+            .created_at = "",
+            .modified_at = ""
+        },
+    },
 };
 
-sensor_config_t g_sensor_light_config = {
-    .id_sensor = 0,
-    .description = "Light Sensor",
-    .interval_s = 5,
-    .state = true,
-    .config_loaded = false,
-    .max_value = 0.0f,
-    .min_value = 0.0f,
-    .has_max_value = false,
-    .has_min_value = false,
-    .id_user_created = 0,
-    .id_user_modified = 0,
-    .created_at = "",
-    .modified_at = ""
-};
+static sensor_config_slot_t *slot_for(sensor_type_t sensor_type)
+{
+    if ((size_t)sensor_type >= sizeof(config_slots) / sizeof(config_slots[0])) {
+        return NULL;
+    }
+    return &config_slots[sensor_type];
+}
 
-// Callback para manejar la respuesta HTTP
-static esp_err_t config_http_event_handler(esp_http_client_event_t *evt)
+esp_err_t sensor_config_snapshot_init(void)
 {
-    switch (evt->event_id)
-    {
-    case HTTP_EVENT_ON_DATA:
-        if (!esp_http_client_is_chunked_response(evt->client)) {
-            if (evt->data_len > 0) {
-                // Log de la respuesta para debug
-                char *response_data = malloc(evt->data_len + 1);
-                if (response_data) {
-                    memcpy(response_data, evt->data, evt->data_len);
-                    response_data[evt->data_len] = '\0';
-                    ESP_LOGD(TAG, "Respuesta config: %s", response_data);
-                    free(response_data);
-                }
-            }
+    if (writer_mutex == NULL) {
+        writer_mutex = xSemaphoreCreateMutex();
+        if (writer_mutex == NULL) {
+            return ESP_ERR_NO_MEM;
         }
-        break;
-    default:
-        break;
     }
     return ESP_OK;
 }
 
-// Función para obtener configuración del sensor desde el servidor
-static esp_err_t fetch_sensor_config(const char *serial_number, sensor_config_t *config, const char *sensor_type, const char *nvs_key_prefix)
+uint32_t sensor_config_version(sensor_type_t sensor_type)
 {
-    ESP_LOGI(TAG, "=== OBTENIENDO CONFIGURACIÓN SENSOR %s ===", sensor_type);
-    ESP_LOGI(TAG, "Número de serie: %s", serial_number);
-
-    // Construir URL: https://ong-controller.vercel.app/api/v1/sensors/serial/0x001C
-    char url[256];
-    snprintf(url, sizeof(url), "%s%s", HTTP_CONFIG_URL, serial_number);
-
-    ESP_LOGI(TAG, "URL: %s", url);
+    sensor_config_slot_t *slot = slot_for(sensor_type);
+    return slot != NULL ? __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) / 2 : 0;
+}
 
-    // Buffer para almacenar la respuesta
-    char *response_buffer = NULL;
-    int response_len = 0;
+uint32_t sensor_config_get_snapshot(sensor_type_t sensor_type, sensor_config_t *out)
+{
+    sensor_config_slot_t *slot = slot_for(sensor_type);
+    if (slot == NULL) {
+        return 0;
+    }
 
-    // Configurar cliente HTTP con soporte HTTPS
-    esp_http_client_config_t http_config = {
-        .url = url,
-        .method = HTTP_METHOD_GET,
-        .event_handler = config_http_event_handler,
-        .timeout_ms = HTTP_TIMEOUT_MS,
-        .crt_bundle_attach = esp_crt_bundle_attach,
-    };
+    uint32_t seq_before;
+    uint32_t seq_after;
+    do {
+        seq_before = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        memcpy(out, &slot->config, sizeof(*out));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        seq_after = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+    } while ((seq_before & 1) != 0 || seq_before != seq_after);
+    return seq_before / 2;
+}
 
-    esp_http_client_handle_t client = esp_http_client_init(&http_config);
-    if (client == NULL) {
-        ESP_LOGE(TAG, "Error inicializando cliente HTTP");
-        return ESP_FAIL;
+bool sensor_config_refresh_snapshot(sensor_type_t sensor_type, sensor_config_snapshot_t *snapshot)
+{
+    if (sensor_config_version(sensor_type) == snapshot->version) {
+        return false;
     }
+    snapshot->version = sensor_config_get_snapshot(sensor_type, &snapshot->config);
+    return true;
+}
 
-    // Realizar petición GET
-    esp_err_t err = esp_http_client_open(client, 0);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Error abriendo conexión HTTP: %s", esp_err_to_name(err));
-        esp_http_client_cleanup(client);
-        return err;
+sensor_config_t *sensor_config_begin_update(sensor_type_t sensor_type)
+{
+    sensor_config_slot_t *slot = slot_for(sensor_type);
+    if (slot == NULL) {
+        return NULL;
     }
-
-    // Obtener longitud del contenido
-    int content_length = esp_http_client_fetch_headers(client);
-    int status_code = esp_http_client_get_status_code(client);
-
-    ESP_LOGI(TAG, "HTTP Status: %d, Content-Length: %d", status_code, content_length);
-
-    if (status_code >= 200 && status_code < 300) {
-        // Leer respuesta
-        if (content_length > 0) {
-            response_buffer = malloc(content_length + 1);
-            if (response_buffer != NULL) {
-                response_len = esp_http_client_read_response(client, response_buffer, content_length);
-                response_buffer[response_len] = '\0';
-                
-                ESP_LOGI(TAG, "Respuesta recibida (%d bytes): %s", response_len, response_buffer);
-                
-                // Parsear JSON
-                cJSON *json = cJSON_Parse(response_buffer);
-                if (json != NULL) {
-                    // Extraer campos del JSON
-                    cJSON *id_sensor = cJSON_GetObjectItem(json, "id_sensor");
-                    cJSON *description = cJSON_GetObjectItem(json, "description");
-                    cJSON *interval_s = cJSON_GetObjectItem(json, "interval_s");
-                    cJSON *state = cJSON_GetObjectItem(json, "state");
-
-                    if (id_sensor && cJSON_IsNumber(id_sensor)) {
-                        config->id_sensor = id_sensor->valueint;
-                        ESP_LOGI(TAG, "ID Sensor: %d", config->id_sensor);
-                    }
-
-                    if (description && cJSON_IsString(description)) {
-                        strncpy(config->description, description->valuestring, sizeof(config->description) - 1);
-                        config->description[sizeof(config->description) - 1] = '\0';
-                        ESP_LOGI(TAG, "Descripción: %s", config->description);
-                    }
-
-                    if (interval_s && cJSON_IsNumber(interval_s)) {
-                        config->interval_s = interval_s->valueint;
-                        ESP_LOGI(TAG, "Intervalo: %d segundos", config->interval_s);
-                    }
-
-                    if (state && cJSON_IsBool(state)) {
-                        config->state = cJSON_IsTrue(state);
-                        ESP_LOGI(TAG, "Estado: %s", config->state ? "activo" : "inactivo");
-                    }
-
-                    config->config_loaded = true;
-                    ESP_LOGI(TAG, "✅ Configuración de %s cargada exitosamente", sensor_type);
-
-                    // Guardar ID en NVS con prefijo específico
-                    char id_key[32];
-                    char reg_key[32];
-                    snprintf(id_key, sizeof(id_key), "%s_id", nvs_key_prefix);
-                    snprintf(reg_key, sizeof(reg_key), "%s_registered", nvs_key_prefix);
-                    
-                    nvs_save_sensor_id(id_key, config->id_sensor);
-                    nvs_save_registered_flag(reg_key, true);
-
-                    cJSON_Delete(json);
-                    err = ESP_OK;
-                } else {
-                    ESP_LOGE(TAG, "Error parseando JSON de configuración");
-                    err = ESP_FAIL;
-                }
-                
-                free(response_buffer);
-            } else {
-                ESP_LOGE(TAG, "Error asignando memoria para respuesta");
-                err = ESP_ERR_NO_MEM;
-            }
-        } else {
-            ESP_LOGW(TAG, "Respuesta vacía del servidor");
-            err = ESP_FAIL;
-        }
-    } else {
-        ESP_LOGE(TAG, "Error HTTP: %d", status_code);
-        err = ESP_FAIL;
+    if (writer_mutex != NULL) {
+        xSemaphoreTake(writer_mutex, portMAX_DELAY);
     }
+    // Con el mutex nadie más escribe: config se puede leer directamente.
+    // memcpy (no asignación) para que el memcmp de end_update vea también el relleno igual
+    memcpy(&slot->staging, &slot->config, sizeof(slot->staging));
+    return &slot->staging;
+}
 
-    esp_http_client_close(client);
-    esp_http_client_cleanup(client);
+bool sensor_config_end_update(sensor_type_t sensor_type)
+{
+    sensor_config_slot_t *slot = slot_for(sensor_type);
+    if (slot == NULL) {
+        return false;
+    }
 
-    if (err != ESP_OK) {
-        ESP_LOGW(TAG, "⚠ Error obteniendo configuración, usando valores por defecto");
-        // Cargar valores por defecto
-        config->id_sensor = 1; // ID por defecto
-        snprintf(config->description, sizeof(config->description), "%s Default", sensor_type);
-        config->interval_s = 5;
-        config->state = true;
-        config->config_loaded = false; // Marcar como no cargado desde servidor
+    bool changed = memcmp(&slot->staging, &slot->config, sizeof(slot->config)) != 0;
+    if (changed) {
+        portENTER_CRITICAL(&publish_mux);
+        __atomic_store_n(&slot->seq, slot->seq + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        memcpy(&slot->config, &slot->staging, sizeof(slot->config));
+        __atomic_store_n(&slot->seq, slot->seq + 1, __ATOMIC_RELEASE);
+        portEXIT_CRITICAL(&publish_mux);
     }
 
-    return err;
+    if (writer_mutex != NULL) {
+        xSemaphoreGive(writer_mutex);
+    }
+    if (changed) {
+        // Las tareas suscritas se despiertan ya, sin esperar a su próximo ciclo
+        config_bus_publish(sensor_type == SENSOR_TYPE_LIGHT ? CONFIG_KEY_SENSOR_LIGHT : CONFIG_KEY_SENSOR_HUMIDITY);
+    }
+    return changed;
 }
 
 // Tarea de configuración de sensores
@@ -214,62 +164,70 @@ void task_sensor_config_init(void *pvParameters)
     ESP_LOGI(TAG, "📝 Cargando configuración del sensor de humedad...");
     
     // 1. Intentar cargar desde NVS primero
-    esp_err_t nvs_result = nvs_load_sensor_config(SENSOR_TYPE_SOIL_HUMIDITY, &g_sensor_humidity_config);
+    sensor_config_t *humidity = sensor_config_begin_update(SENSOR_TYPE_SOIL_HUMIDITY);
+    esp_err_t nvs_result = config_store_load(SENSOR_TYPE_SOIL_HUMIDITY, humidity);
     
     if (nvs_result == ESP_OK) {
         ESP_LOGI(TAG, "✅ Configuración de humedad cargada desde NVS");
     } else {
         ESP_LOGW(TAG, "⚠️ No hay configuración en NVS, usando valores por defecto");
         // Valores por defecto definidos en config.h
-        g_sensor_humidity_config.id_sensor = 8; // ID por defecto
-        g_sensor_humidity_config.interval_s = 5;
-        g_sensor_humidity_config.state = true;
-        g_sensor_humidity_config.config_loaded = true; // Marcar como cargado con defaults
-        strncpy(g_sensor_humidity_config.description, "Sensor Humedad Suelo", sizeof(g_sensor_humidity_config.description) - 1);
+        humidity->id_sensor = 8; // ID por defecto
+        humidity->interval_s = 5;
+        humidity->state = true;
+        humidity->config_loaded = true; // Marcar como cargado con defaults
+        strncpy(humidity->description, "Sensor Humedad Suelo", sizeof(humidity->description) - 1);
         
         ESP_LOGI(TAG, "📋 Valores por defecto aplicados:");
-        ESP_LOGI(TAG, "  - ID: %d", g_sensor_humidity_config.id_sensor);
-        ESP_LOGI(TAG, "  - Intervalo: %d seg", g_sensor_humidity_config.interval_s);
-        ESP_LOGI(TAG, "  - Estado: %s", g_sensor_humidity_config.state ? "activo" : "inactivo");
+        ESP_LOGI(TAG, "  - ID: %d", humidity->id_sensor);
+        ESP_LOGI(TAG, "  - Intervalo: %d seg", humidity->interval_s);
+        ESP_LOGI(TAG, "  - Estado: %s", humidity->state ? "activo" : "inactivo");
     }
+    sensor_config_end_update(SENSOR_TYPE_SOIL_HUMIDITY);
 
     // ========== SENSOR DE LUZ ==========
     ESP_LOGI(TAG, "📝 Cargando configuración del sensor de luz...");
     
     // 1. Intentar cargar desde NVS primero
-    nvs_result = nvs_load_sensor_config(SENSOR_TYPE_LIGHT, &g_sensor_light_config);
+    sensor_config_t *light = sensor_config_begin_update(SENSOR_TYPE_LIGHT);
+    nvs_result = config_store_load(SENSOR_TYPE_LIGHT, light);
     
     if (nvs_result == ESP_OK) {
         ESP_LOGI(TAG, "✅ Configuración de luz cargada desde NVS");
     } else {
         ESP_LOGW(TAG, "⚠️ No hay configuración en NVS, usando valores por defecto");
         // Valores por defecto definidos en config.h
-        g_sensor_light_config.id_sensor = 9; // ID por defecto
-        g_sensor_light_config.interval_s = 5;
-        g_sensor_light_config.state = true;
-        g_sensor_light_config.config_loaded = true; // Marcar como cargado con defaults
-        strncpy(g_sensor_light_config.description, "Sensor de Luz", sizeof(g_sensor_light_config.description) - 1);
+        light->id_sensor = 9; // ID por defecto
+        light->interval_s = 5;
+        light->state = true;
+        light->config_loaded = true; // Marcar como cargado con defaults
+        strncpy(light->description, "Sensor de Luz", sizeof(light->description) - 1);
         
         ESP_LOGI(TAG, "📋 Valores por defecto aplicados:");
-        ESP_LOGI(TAG, "  - ID: %d", g_sensor_light_config.id_sensor);
-        ESP_LOGI(TAG, "  - Intervalo: %d seg", g_sensor_light_config.interval_s);
-        ESP_LOGI(TAG, "  - Estado: %s", g_sensor_light_config.state ? "activo" : "inactivo");
+        ESP_LOGI(TAG, "  - ID: %d", light->id_sensor);
+        ESP_LOGI(TAG, "  - Intervalo: %d seg", light->interval_s);
+        ESP_LOGI(TAG, "  - Estado: %s", light->state ? "activo" : "inactivo");
     }
+    sensor_config_end_update(SENSOR_TYPE_LIGHT);
 
     // Mostrar configuración final de ambos sensores
     ESP_LOGI(TAG, "=== CONFIGURACIÓN FINAL SENSORES ===");
+    sensor_config_t humidity_final;
+    sensor_config_t light_final;
+    sensor_config_get_snapshot(SENSOR_TYPE_SOIL_HUMIDITY, &humidity_final);
+    sensor_config_get_snapshot(SENSOR_TYPE_LIGHT, &light_final);
     
     ESP_LOGI(TAG, "Sensor Humedad:");
-    ESP_LOGI(TAG, "  ID: %d", g_sensor_humidity_config.id_sensor);
-    ESP_LOGI(TAG, "  Descripción: %s", g_sensor_humidity_config.description);
-    ESP_LOGI(TAG, "  Intervalo: %d segundos", g_sensor_humidity_config.interval_s);
-    ESP_LOGI(TAG, "  Estado: %s", g_sensor_humidity_config.state ? "activo" : "inactivo");
+    ESP_LOGI(TAG, "  ID: %d", humidity_final.id_sensor);
+    ESP_LOGI(TAG, "  Descripción: %s", humidity_final.description);
+    ESP_LOGI(TAG, "  Intervalo: %d segundos", humidity_final.interval_s);
+    ESP_LOGI(TAG, "  Estado: %s", humidity_final.state ? "activo" : "inactivo");
     
     ESP_LOGI(TAG, "Sensor Luz:");
-    ESP_LOGI(TAG, "  ID: %d", g_sensor_light_config.id_sensor);
-    ESP_LOGI(TAG, "  Descripción: %s", g_sensor_light_config.description);
-    ESP_LOGI(TAG, "  Intervalo: %d segundos", g_sensor_light_config.interval_s);
-    ESP_LOGI(TAG, "  Estado: %s", g_sensor_light_config.state ? "activo" : "inactivo");
+    ESP_LOGI(TAG, "  ID: %d", light_final.id_sensor);
+    ESP_LOGI(TAG, "  Descripción: %s", light_final.description);
+    ESP_LOGI(TAG, "  Intervalo: %d segundos", light_final.interval_s);
+    ESP_LOGI(TAG, "  Estado: %s", light_final.state ? "activo" : "inactivo");
 
     // Notificar al supervisor que la configuración está completa
     ESP_LOGI(TAG, "✅ Configuración de sensores completada");
@@ -280,24 +238,3 @@ void task_sensor_config_init(void *pvParameters)
     vTaskDelete(NULL);
 }
 
-// Public function to refresh sensor configs on-demand. Returns ESP_OK when sensors loaded.
-esp_err_t sensor_config_refresh(void)
-{
-    ESP_LOGI(TAG, "=== REFRESCANDO CONFIGURACIÓN DE SENSORES ===");
-
-    esp_err_t result_humidity = fetch_sensor_config(DEVICE_SERIAL_HUMIDITY, &g_sensor_humidity_config, "HUMEDAD", "humidity");
-    esp_err_t result_light = fetch_sensor_config(DEVICE_SERIAL_LIGHT, &g_sensor_light_config, "LUZ", "light");
-
-    bool humidity_ok = (result_humidity == ESP_OK && g_sensor_humidity_config.config_loaded);
-    bool light_ok = (result_light == ESP_OK && g_sensor_light_config.config_loaded);
-
-    if (humidity_ok || light_ok) {
-        ESP_LOGI(TAG, "✅ Configuración de sensores refrescada exitosamente");
-        if (humidity_ok) ESP_LOGI(TAG, "  ✓ Humedad: OK");
-        if (light_ok) ESP_LOGI(TAG, "  ✓ Luz: OK");
-        return ESP_OK;
-    } else {
-        ESP_LOGW(TAG, "⚠ Error refrescando configuración de sensores");
-        return ESP_FAIL;
-    }
-}
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_err.h"
+#include "task_sensor.h"
 
 // Estructura para almacenar la configuración de un sensor individual
 typedef struct {
@@ -24,9 +25,60 @@ typedef struct {
     char modified_at[32];    // Timestamp de modificación (ISO 8601)
 } sensor_config_t;
 
-// Configuraciones para cada sensor
-extern sensor_config_t g_sensor_humidity_config;  // Configuración sensor humedad
-extern sensor_config_t g_sensor_light_config;     // Configuración sensor luz
+// Configuración publicada de cada sensor (seqlock): los lectores copian sin
+// bloquear y reintentan si la copia se cruzó con una escritura; los escritores
+// se serializan con un mutex y publican el cambio de una vez, subiendo la
+// versión. Quien necesita enterarse de cambios compara la versión: no hay cola.
+
+// Copia local de la configuración de un sensor con la versión copiada
+typedef struct {
+    uint32_t version;           // 0 = todavía sin copiar
+    sensor_config_t config;
+} sensor_config_snapshot_t;
+
+/**
+ * @brief Crear el mutex de los escritores (sin él, un solo escritor a la vez)
+ */
+esp_err_t sensor_config_snapshot_init(void);
+
+/**
+ * @brief Versión publicada (sube con cada cambio; una sola lectura atómica)
+ */
+uint32_t sensor_config_version(sensor_type_t sensor_type);
+
+/**
+ * @brief Copiar la configuración publicada de un sensor
+ *
+ * @param[out] out Copia consistente (nunca mezcla dos versiones)
+ * @return Versión copiada, 0 si el tipo no existe
+ */
+uint32_t sensor_config_get_snapshot(sensor_type_t sensor_type, sensor_config_t *out);
+
+/**
+ * @brief Actualizar una copia local solo si cambió la versión publicada
+ *
+ * Para el camino caliente: sin cambios cuesta leer y comparar la versión.
+ *
+ * @return true si la copia cambió
+ */
+bool sensor_config_refresh_snapshot(sensor_type_t sensor_type, sensor_config_snapshot_t *snapshot);
+
+/**
+ * @brief Empezar a modificar la configuración de un sensor
+ *
+ * Devuelve una copia de trabajo de la configuración publicada, reservada para
+ * este escritor hasta sensor_config_end_update(). No tomar dos a la vez.
+ *
+ * @return Copia a modificar, NULL si el tipo no existe
+ */
+sensor_config_t *sensor_config_begin_update(sensor_type_t sensor_type);
+
+/**
+ * @brief Publicar la copia de trabajo y liberarla
+ *
+ * @return true si la configuración cambió (y con ella la versión)
+ */
+bool sensor_config_end_update(sensor_type_t sensor_type);
 
 /**
  * @brief Tarea de configuración de sensores
@@ -40,8 +92,4 @@ extern sensor_config_t g_sensor_light_config;     // Configuración sensor luz
  */
 void task_sensor_config_init(void *pvParameters);
 
-// Refresh sensor configuration from backend on-demand.
-// Returns ESP_OK if sensor config was loaded successfully.
-esp_err_t sensor_config_refresh(void);
-
 #endif // TASK_SENSOR_CONFIG_H
\ No newline at end of file
@@ -2,15 +2,20 @@
 #include "esp_log.h"
 #include "config.h"
 #include "task_main.h"
-#include "adc_shared.h"
+#include "hal_adc.h"
 #include "task_sensor_config.h"
 #include "task_sensor.h"
 #include "task_error_logger.h"
+#include "metrics.h"
+#include "pacing.h"
+#include "hal_clock.h"
+#include "config_bus.h"
+#include <string.h>
 
 static const char *TAG = "SENSORS_UNIFIED";
 
 // Convertir valor ADC a porcentaje de humedad de suelo
-static float convert_to_humidity_percent(int raw_value)
+float convert_to_humidity_percent(int raw_value)
 {
     float humidity_percent;
     
@@ -32,7 +37,7 @@ static float convert_to_humidity_percent(int raw_value)
 }
 
 // Convertir valor ADC a porcentaje de luminosidad (0-100%)
-static float convert_to_light_percentage(int raw_value)
+float convert_to_light_percentage(int raw_value)
 {
     float percentage;
 
@@ -53,6 +58,19 @@ static float convert_to_light_percentage(int raw_value)
     return percentage;
 }
 
+// Cambios publicados por MQTT, la sincronización o la respuesta del backend
+static void refresh_configs(sensor_config_snapshot_t *humidity, sensor_config_snapshot_t *light)
+{
+    if (sensor_config_refresh_snapshot(SENSOR_TYPE_SOIL_HUMIDITY, humidity)) {
+        ESP_LOGI(TAG, "🔧 Configuración de humedad v%lu: ID=%d, %s", (unsigned long)humidity->version,
+                 humidity->config.id_sensor, humidity->config.state ? "activo" : "inactivo");
+    }
+    if (sensor_config_refresh_snapshot(SENSOR_TYPE_LIGHT, light)) {
+        ESP_LOGI(TAG, "🔧 Configuración de luz v%lu: ID=%d, %s", (unsigned long)light->version,
+                 light->config.id_sensor, light->config.state ? "activo" : "inactivo");
+    }
+}
+
 // Tarea unificada de lectura de sensores
 void task_sensors_unified_reading(void *pvParameters)
 {
@@ -63,70 +81,104 @@ void task_sensors_unified_reading(void *pvParameters)
     if (sensor_queue == NULL) {
         ESP_LOGE(TAG, "Error: Cola de sensores es NULL");
         task_report_error(TASK_TYPE_SENSOR, TASK_ERROR_QUEUE_FULL, "Cola NULL");
+        task_watchdog_unregister(TASK_TYPE_SENSOR);
         vTaskDelete(NULL);
         return;
     }
     
     // Verificar que el ADC compartido esté inicializado
-    if (g_adc_handle == NULL) {
+    if (!hal_adc_is_ready()) {
         ESP_LOGE(TAG, "Error: ADC compartido no inicializado");
         task_report_error(TASK_TYPE_SENSOR, TASK_ERROR_HARDWARE, "ADC shared not initialized");
+        task_watchdog_unregister(TASK_TYPE_SENSOR);
         vTaskDelete(NULL);
         return;
     }
     
+    // Los cambios de configuración despiertan la espera entre lecturas
+    config_bus_subscribe(CONFIG_KEY_SENSOR_HUMIDITY);
+    config_bus_subscribe(CONFIG_KEY_SENSOR_LIGHT);
+
+    // Copias locales de la configuración: se vuelven a copiar solo cuando sube
+    // la versión publicada (sensor_config_refresh_snapshot)
+    sensor_config_snapshot_t humidity = {0};
+    sensor_config_snapshot_t light = {0};
+
     // Esperar a que las configuraciones estén listas
-    while (!g_sensor_humidity_config.config_loaded || !g_sensor_light_config.config_loaded) {
+    while (1) {
+        sensor_config_refresh_snapshot(SENSOR_TYPE_SOIL_HUMIDITY, &humidity);
+        sensor_config_refresh_snapshot(SENSOR_TYPE_LIGHT, &light);
+        if (humidity.config.config_loaded && light.config.config_loaded) {
+            break;
+        }
         ESP_LOGI(TAG, "Esperando configuración de sensores...");
-        vTaskDelay(pdMS_TO_TICKS(1000));
+        task_feed_watchdog(TASK_TYPE_SENSOR);
+        config_bus_wait(1000);
     }
     
     ESP_LOGI(TAG, "✓ Configuraciones cargadas:");
     ESP_LOGI(TAG, "  - Humedad: ID=%d, Intervalo=%ds", 
-             g_sensor_humidity_config.id_sensor, g_sensor_humidity_config.interval_s);
+             humidity.config.id_sensor, humidity.config.interval_s);
     ESP_LOGI(TAG, "  - Luz: ID=%d, Intervalo=%ds", 
-             g_sensor_light_config.id_sensor, g_sensor_light_config.interval_s);
+             light.config.id_sensor, light.config.interval_s);
     ESP_LOGI(TAG, "✓ Lectura cada %d ms", SENSOR_READING_INTERVAL_MS);
     
+    // Desfase propio del dispositivo: tras un corte de luz general cada equipo
+    // muestrea (y por lo tanto envía) en un instante distinto del período
+    uint32_t phase_ms = pacing_phase_offset_ms(SENSOR_READING_INTERVAL_MS, PACING_PHASE_SENSOR_SAMPLING);
+    if (phase_ms > 0) {
+        ESP_LOGI(TAG, "⏱️ Desfase inicial de muestreo: %lu ms", (unsigned long)phase_ms);
+        hal_clock_delay_ms(phase_ms);
+        task_feed_watchdog(TASK_TYPE_SENSOR);
+    }
+    
     uint32_t read_count = 0;
-    sensor_data_t data;
+    sensor_frame_t frame;
     int raw_value, voltage_mv;
     
     while (1) {
         read_count++;
         
+        refresh_configs(&humidity, &light);
+        
         ESP_LOGI(TAG, "📖 Ciclo de lectura #%lu", (unsigned long)read_count);
         
+        // Una trama por ciclo: todas las lecturas comparten instante y traza
+        // (seq queda en 0: la asigna la tarea HTTP al enviar)
+        memset(&frame, 0, sizeof(frame));
+        metrics_trace_begin(&frame.trace);
+        frame.timestamp = hal_clock_now_ms();
+        
+        // Tiempo hasta la primera muestra desde el arranque (no desde un reinicio de la tarea)
+        static bool first_sample_recorded = false;
+        if (!first_sample_recorded) {
+            first_sample_recorded = true;
+            metrics_gauge_set(METRIC_GAUGE_BOOT_FIRST_SAMPLE_MS, frame.timestamp);
+            ESP_LOGI(TAG, "⏱️ Primera muestra a los %lu ms del arranque", (unsigned long)frame.timestamp);
+        }
+        
         // ========== LEER SENSOR DE HUMEDAD ==========
-        if (g_sensor_humidity_config.state) {
-            esp_err_t ret = read_adc_channel(SOIL_HUMIDITY_ADC_CHANNEL, &raw_value);
+        if (humidity.config.state) {
+            esp_err_t ret = hal_adc_read_raw(SOIL_HUMIDITY_ADC_CHANNEL, &raw_value);
             
             if (ret == ESP_OK) {
-                ret = convert_adc_to_voltage(raw_value, &voltage_mv);
+                ret = hal_adc_raw_to_mv(raw_value, &voltage_mv);
                 if (ret != ESP_OK) {
                     voltage_mv = raw_value; // Fallback
                 }
                 
-                data.type = SENSOR_TYPE_SOIL_HUMIDITY;
-                data.raw_value = raw_value;
-                data.adc_voltage = (float)voltage_mv;
-                data.converted_value = convert_to_humidity_percent(raw_value);
-                data.timestamp = xTaskGetTickCount();
-                data.valid = true;
+                sensor_reading_t *reading = &frame.readings[frame.count++];
+                reading->type = SENSOR_TYPE_SOIL_HUMIDITY;
+                reading->raw_value = raw_value;
+                reading->adc_voltage = (float)voltage_mv;
+                reading->converted_value = convert_to_humidity_percent(raw_value);
+                metrics_counter_inc(METRIC_SENSOR_SAMPLES);
                 
                 ESP_LOGI(TAG, "💧 Humedad: %.1f%% (Raw=%d, V=%.0fmV)", 
-                         data.converted_value, data.raw_value, data.adc_voltage);
-                
-                // Enviar a cola (reemplazar si está llena)
-                if (xQueueSend(sensor_queue, &data, 0) != pdTRUE) {
-                    sensor_data_t dummy;
-                    xQueueReceive(sensor_queue, &dummy, 0);
-                    if (xQueueSend(sensor_queue, &data, 0) != pdTRUE) {
-                        ESP_LOGW(TAG, "⚠ No se pudo enviar datos de humedad a cola");
-                    }
-                }
+                         reading->converted_value, reading->raw_value, reading->adc_voltage);
             } else {
                 ESP_LOGE(TAG, "❌ Error leyendo sensor de humedad: %s", esp_err_to_name(ret));
+                metrics_counter_inc(METRIC_SENSOR_READ_ERRORS);
                 task_report_error(TASK_TYPE_SENSOR, TASK_ERROR_SENSOR_READ, "Humidity read failed");
                 send_led_status(SYSTEM_STATE_ERROR, "Error sensor humedad");
                 
@@ -136,7 +188,7 @@ void task_sensors_unified_reading(void *pvParameters)
                          "{\"error_esp\": \"%s\", \"sensor_type\": \"humidity\", \"attempts\": 1}",
                          esp_err_to_name(ret));
                 error_logger_log_sensor(
-                    g_sensor_humidity_config.id_sensor,
+                    humidity.config.id_sensor,
                     "SENSOR_READ_ERROR",
                     ERROR_SEVERITY_ERROR,
                     "Fallo al leer sensor de humedad",
@@ -149,35 +201,27 @@ void task_sensors_unified_reading(void *pvParameters)
         }
         
         // ========== LEER SENSOR DE LUZ ==========
-        if (g_sensor_light_config.state) {
-            esp_err_t ret = read_adc_channel(LIGHT_SENSOR_ADC_CHANNEL, &raw_value);
+        if (light.config.state) {
+            esp_err_t ret = hal_adc_read_raw(LIGHT_SENSOR_ADC_CHANNEL, &raw_value);
             
             if (ret == ESP_OK) {
-                ret = convert_adc_to_voltage(raw_value, &voltage_mv);
+                ret = hal_adc_raw_to_mv(raw_value, &voltage_mv);
                 if (ret != ESP_OK) {
                     voltage_mv = raw_value; // Fallback
                 }
                 
-                data.type = SENSOR_TYPE_LIGHT;
-                data.raw_value = raw_value;
-                data.adc_voltage = (float)voltage_mv;
-                data.converted_value = convert_to_light_percentage(raw_value);
-                data.timestamp = xTaskGetTickCount();
-                data.valid = true;
+                sensor_reading_t *reading = &frame.readings[frame.count++];
+                reading->type = SENSOR_TYPE_LIGHT;
+                reading->raw_value = raw_value;
+                reading->adc_voltage = (float)voltage_mv;
+                reading->converted_value = convert_to_light_percentage(raw_value);
+                metrics_counter_inc(METRIC_SENSOR_SAMPLES);
                 
                 ESP_LOGI(TAG, "💡 Luz: %.0f LM%% (Raw=%d, V=%.0fmV)", 
-                         data.converted_value, data.raw_value, data.adc_voltage);
-                
-                // Enviar a cola (reemplazar si está llena)
-                if (xQueueSend(sensor_queue, &data, 0) != pdTRUE) {
-                    sensor_data_t dummy;
-                    xQueueReceive(sensor_queue, &dummy, 0);
-                    if (xQueueSend(sensor_queue, &data, 0) != pdTRUE) {
-                        ESP_LOGW(TAG, "⚠ No se pudo enviar datos de luz a cola");
-                    }
-                }
+                         reading->converted_value, reading->raw_value, reading->adc_voltage);
             } else {
                 ESP_LOGE(TAG, "❌ Error leyendo sensor de luz: %s", esp_err_to_name(ret));
+                metrics_counter_inc(METRIC_SENSOR_READ_ERRORS);
                 task_report_error(TASK_TYPE_SENSOR, TASK_ERROR_SENSOR_READ, "Light read failed");
                 send_led_status(SYSTEM_STATE_ERROR, "Error sensor luz");
                 
@@ -187,7 +231,7 @@ void task_sensors_unified_reading(void *pvParameters)
                          "{\"error_esp\": \"%s\", \"sensor_type\": \"light\", \"attempts\": 1}",
                          esp_err_to_name(ret));
                 error_logger_log_sensor(
-                    g_sensor_light_config.id_sensor,
+                    light.config.id_sensor,
                     "SENSOR_READ_ERROR",
                     ERROR_SEVERITY_ERROR,
                     "Fallo al leer sensor de luz",
@@ -199,11 +243,31 @@ void task_sensors_unified_reading(void *pvParameters)
             ESP_LOGD(TAG, "⏸ Sensor de luz deshabilitado");
         }
         
+        // Enviar la trama a la cola (reemplazar la más antigua si está llena)
+        if (frame.count > 0) {
+            metrics_trace_mark(frame.trace.enqueued_us);
+            if (xQueueSend(sensor_queue, &frame, 0) != pdTRUE) {
+                sensor_frame_t dummy;
+                xQueueReceive(sensor_queue, &dummy, 0);
+                metrics_counter_inc(METRIC_SENSOR_QUEUE_DROPS);
+                if (xQueueSend(sensor_queue, &frame, 0) != pdTRUE) {
+                    ESP_LOGW(TAG, "⚠ No se pudo enviar la trama de lecturas a cola");
+                }
+            }
+        }
+        
         // Enviar heartbeat
         task_send_heartbeat(TASK_TYPE_SENSOR, "Sensores OK");
         
-        // Esperar intervalo de lectura fijo (5 segundos)
+        // Esperar intervalo de lectura fijo (5 segundos); un cambio de
+        // configuración se aplica al despertar, sin alargar el intervalo
         ESP_LOGD(TAG, "⏳ Esperando %d ms hasta próxima lectura", SENSOR_READING_INTERVAL_MS);
-        vTaskDelay(pdMS_TO_TICKS(SENSOR_READING_INTERVAL_MS));
+        uint32_t wait_start_ms = hal_clock_now_ms();
+        uint32_t waited_ms;
+        while ((waited_ms = hal_clock_elapsed_ms(wait_start_ms)) < SENSOR_READING_INTERVAL_MS) {
+            if (config_bus_wait(SENSOR_READING_INTERVAL_MS - waited_ms) != 0) {
+                refresh_configs(&humidity, &light);
+            }
+        }
     }
 }
@@ -15,4 +15,14 @@
  */
 void task_sensors_unified_reading(void *pvParameters);
 
+/**
+ * @brief Convertir valor ADC crudo a porcentaje de humedad de suelo (0-100%)
+ */
+float convert_to_humidity_percent(int raw_value);
+
+/**
+ * @brief Convertir valor ADC crudo a porcentaje de luminosidad (0-100%)
+ */
+float convert_to_light_percentage(int raw_value);
+
 #endif // TASK_SENSORS_UNIFIED_H
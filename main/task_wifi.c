@@ -4,9 +4,14 @@
 #include "esp_log.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
+#include "freertos/queue.h"
 #include "config.h"
 #include "nvs.h"
 #include "nvs_flash.h"
+#include "hal_clock.h"
+#include "pacing.h"
+#include "net_config.h"
+#include "metrics.h"
 
 static const char *TAG = "WIFI_TASK";
 
@@ -73,61 +78,186 @@ static esp_err_t save_wifi_credentials_to_nvs(const char *ssid, const char *pass
     return err;
 }
 
-// Event Groups
-#define WIFI_CONNECTED_BIT BIT0
-#define WIFI_FAIL_BIT      BIT1
+// ===== MÁQUINA DE ESTADOS =====
+// El manejador de eventos (tarea sys_evt) solo actualiza los bits de
+// conectividad, para que las demás tareas se enteren en el acto, y pasa el
+// evento a la tarea WiFi por una cola. La tarea duerme en esa cola y decide
+// reintentos, logs y LED; solo despierta sin eventos al vencer una espera de
+// reconexión, el plazo de un intento o el heartbeat. Al despertar sin eventos
+// compara state con los bits de conectividad (wifi_reconcile): un evento
+// descartado con la cola llena no deja la máquina de estados colgada.
 
-static EventGroupHandle_t s_wifi_event_group;
-static int s_retry_num = 0;
+typedef enum {
+    WIFI_STATE_CONNECTING,      // Intento en curso, esperando IP o desconexión
+    WIFI_STATE_CONNECTED,       // Con IP
+    WIFI_STATE_WAIT_RETRY,      // Esperando el próximo intento (backoff)
+} wifi_state_t;
+
+typedef enum {
+    WIFI_MSG_STA_START,
+    WIFI_MSG_DISCONNECTED,
+    WIFI_MSG_GOT_IP,
+    WIFI_MSG_LOST_IP,
+} wifi_msg_type_t;
+
+typedef struct {
+    wifi_msg_type_t type;
+    uint8_t reason;             // WIFI_MSG_DISCONNECTED: wifi_err_reason_t
+} wifi_msg_t;
+
+static QueueHandle_t s_wifi_queue = NULL;
 static esp_netif_t *sta_netif = NULL; // Guardar referencia al netif
 
-// Manejador de eventos WiFi
+// Conexión rápida: primero directo al último AP (BSSID + canal, net_config.c),
+// y si falla, escaneo completo con la configuración base
+static wifi_config_t s_wifi_config;         // SSID y password, sin AP fijo
+static bool s_fast_path = false;            // El intento en curso va directo al AP guardado
+static uint32_t s_connect_start_ms = 0;
+
+// Fijar el AP destino: directo al guardado, o cualquiera con el SSID (escaneo)
+static void wifi_set_target(const net_ap_cache_t *cache)
+{
+    wifi_config_t config = s_wifi_config;
+    if (cache != NULL) {
+        memcpy(config.sta.bssid, cache->bssid, sizeof(config.sta.bssid));
+        config.sta.bssid_set = true;
+        config.sta.channel = cache->channel;
+    }
+    esp_err_t err = esp_wifi_set_config(WIFI_IF_STA, &config);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "⚠️ No se pudo fijar el AP destino: %s", esp_err_to_name(err));
+    }
+}
+
+// IP estática (net_config.c) o DHCP. Solo con la estación desconectada.
+static void wifi_apply_ip_config(void)
+{
+    net_static_ip_t static_ip;
+    if (!net_config_get_static_ip(&static_ip)) {
+        esp_netif_dhcpc_start(sta_netif);   // ESP_ERR_ESP_NETIF_DHCP_ALREADY_STARTED es normal
+        return;
+    }
+
+    esp_netif_dhcpc_stop(sta_netif);
+    esp_netif_ip_info_t ip_info = {
+        .ip.addr = static_ip.ip,
+        .netmask.addr = static_ip.netmask,
+        .gw.addr = static_ip.gateway,
+    };
+    esp_err_t err = esp_netif_set_ip_info(sta_netif, &ip_info);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "⚠️ IP estática rechazada (%s), se usa DHCP", esp_err_to_name(err));
+        esp_netif_dhcpc_start(sta_netif);
+        return;
+    }
+    esp_netif_dns_info_t dns = {
+        .ip.type = ESP_IPADDR_TYPE_V4,
+        .ip.u_addr.ip4.addr = static_ip.dns != 0 ? static_ip.dns : static_ip.gateway,
+    };
+    esp_netif_set_dns_info(sta_netif, ESP_NETIF_DNS_MAIN, &dns);
+}
+
+// Iniciar un intento de conexión: por el camino rápido si hay AP guardado
+static void wifi_begin_connect(void)
+{
+    net_ap_cache_t cache;
+    s_fast_path = net_config_get_ap_cache(&cache);
+    wifi_set_target(s_fast_path ? &cache : NULL);
+    wifi_apply_ip_config();
+
+    s_connect_start_ms = hal_clock_now_ms();
+    esp_wifi_connect();
+    if (s_fast_path) {
+        ESP_LOGI(TAG, "⚡ Conexión directa al último AP (canal %u)", cache.channel);
+    }
+}
+
+// Recordar el AP al que quedó conectado (NVS solo si cambió)
+static void wifi_remember_ap(const wifi_ap_record_t *ap_info)
+{
+    net_ap_cache_t cache = {.channel = ap_info->primary};
+    memcpy(cache.bssid, ap_info->bssid, sizeof(cache.bssid));
+    net_config_save_ap_cache(&cache);
+}
+
+// Motivos en los que reintentar enseguida no sirve (clave incorrecta, AP
+// apagado): se pasa directo al backoff en vez de gastar los reintentos rápidos
+static bool reason_needs_backoff(uint8_t reason)
+{
+    switch (reason) {
+        case WIFI_REASON_AUTH_FAIL:
+        case WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT:
+        case WIFI_REASON_HANDSHAKE_TIMEOUT:
+        case WIFI_REASON_NO_AP_FOUND:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Manejador de eventos WiFi (tarea sys_evt: poco stack, nada de NVS ni error_logger)
 static void event_handler(void* arg, esp_event_base_t event_base,
                          int32_t event_id, void* event_data)
 {
+    wifi_msg_t msg = {0};
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
-        esp_wifi_connect();
-        ESP_LOGI(TAG, "WiFi iniciado, intentando conectar...");
+        msg.type = WIFI_MSG_STA_START;
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
         wifi_event_sta_disconnected_t* disconnected = (wifi_event_sta_disconnected_t*) event_data;
-        
-        if (s_retry_num < WIFI_MAXIMUM_RETRY) {
-            esp_wifi_connect();
-            s_retry_num++;
-            ESP_LOGI(TAG, "Reintentando conexión WiFi (%d/%d)", s_retry_num, WIFI_MAXIMUM_RETRY);
-            send_led_status(SYSTEM_STATE_ESPERANDO_WIFI, "Reintentando");
-        } else {
-            xEventGroupSetBits(s_wifi_event_group, WIFI_FAIL_BIT);
-            ESP_LOGE(TAG, "Conexión WiFi falló después de %d intentos", WIFI_MAXIMUM_RETRY);
-            send_led_status(SYSTEM_STATE_ERROR, "WiFi falló");
-            
-            // Notificar pérdida de conectividad
-            xEventGroupClearBits(g_connectivity_event_group, CONNECTIVITY_WIFI_CONNECTED_BIT);
-            ESP_LOGW(TAG, "⚠️ Conectividad perdida - Tareas pausadas");
-            
-            // NO llamar error_logger aquí - causa stack overflow en sys_evt task
-            // El loop de monitoreo detectará y loggeará el error
-        }
+        msg.type = WIFI_MSG_DISCONNECTED;
+        msg.reason = disconnected->reason;
+        xEventGroupClearBits(g_connectivity_event_group, CONNECTIVITY_WIFI_CONNECTED_BIT);
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
         ESP_LOGI(TAG, "Dirección IP obtenida:" IPSTR, IP2STR(&event->ip_info.ip));
-        s_retry_num = 0;
-        xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
-        send_led_status(SYSTEM_STATE_WIFI, "WiFi conectado");
-        
-        // Notificar conectividad global
+        msg.type = WIFI_MSG_GOT_IP;
         xEventGroupSetBits(g_connectivity_event_group, CONNECTIVITY_WIFI_CONNECTED_BIT);
-        ESP_LOGI(TAG, "✅ Conectividad establecida - Tareas reanudadas");
-        
-        // NO LLAMAR error_logger aquí - causa stack overflow en sys_evt
-        // El log se enviará desde el loop principal de la tarea WiFi
+    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_LOST_IP) {
+        msg.type = WIFI_MSG_LOST_IP;
+        xEventGroupClearBits(g_connectivity_event_group, CONNECTIVITY_WIFI_CONNECTED_BIT);
+    } else {
+        return;
+    }
+
+    if (xQueueSend(s_wifi_queue, &msg, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "⚠️ Cola de eventos WiFi llena, evento %d descartado", msg.type);
     }
 }
 
+// Evento descartado con la cola llena: los bits de conectividad (el manejador
+// los actualiza antes de encolar) dicen el estado real. Con la cola vacía, si
+// no coinciden con state se arma el evento que falta en msg.
+static bool wifi_reconcile(wifi_state_t state, wifi_msg_t *msg)
+{
+    if (uxQueueMessagesWaiting(s_wifi_queue) > 0) {
+        return false;       // Quedan eventos por procesar: todavía no se puede comparar
+    }
+
+    bool has_ip = (xEventGroupGetBits(g_connectivity_event_group) & CONNECTIVITY_WIFI_CONNECTED_BIT) != 0;
+    *msg = (wifi_msg_t){0};
+    if (state == WIFI_STATE_CONNECTED && !has_ip) {
+        // Todavía asociado: se perdió la IP; si no, la conexión
+        wifi_ap_record_t ap_info;
+        if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
+            msg->type = WIFI_MSG_LOST_IP;
+        } else {
+            msg->type = WIFI_MSG_DISCONNECTED;
+            msg->reason = WIFI_REASON_UNSPECIFIED;
+        }
+    } else if (state != WIFI_STATE_CONNECTED && has_ip) {
+        msg->type = WIFI_MSG_GOT_IP;
+    } else {
+        return false;
+    }
+    ESP_LOGW(TAG, "⚠️ Evento WiFi perdido, se reconcilia el estado (evento %d)", msg->type);
+    return true;
+}
+
 // Inicialización WiFi
 static void wifi_init_sta(void)
 {
-    s_wifi_event_group = xEventGroupCreate();
+    s_wifi_queue = xQueueCreate(WIFI_EVENT_QUEUE_SIZE, sizeof(wifi_msg_t));
+    assert(s_wifi_queue);
 
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
@@ -140,6 +270,7 @@ static void wifi_init_sta(void)
 
     esp_event_handler_instance_t instance_any_id;
     esp_event_handler_instance_t instance_got_ip;
+    esp_event_handler_instance_t instance_lost_ip;
     ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT,
                                                         ESP_EVENT_ANY_ID,
                                                         &event_handler,
@@ -150,11 +281,16 @@ static void wifi_init_sta(void)
                                                         &event_handler,
                                                         NULL,
                                                         &instance_got_ip));
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT,
+                                                        IP_EVENT_STA_LOST_IP,
+                                                        &event_handler,
+                                                        NULL,
+                                                        &instance_lost_ip));
 
     // Leer credenciales de NVS
     read_wifi_credentials_from_nvs();
 
-    wifi_config_t wifi_config = {
+    s_wifi_config = (wifi_config_t){
         .sta = {
             .threshold.authmode = WIFI_AUTH_WPA2_PSK,
             .pmf_cfg = {
@@ -165,178 +301,242 @@ static void wifi_init_sta(void)
     };
     
     // Copiar SSID y password
-    strncpy((char*)wifi_config.sta.ssid, wifi_ssid, sizeof(wifi_config.sta.ssid) - 1);
-    strncpy((char*)wifi_config.sta.password, wifi_pass, sizeof(wifi_config.sta.password) - 1);
+    strncpy((char*)s_wifi_config.sta.ssid, wifi_ssid, sizeof(s_wifi_config.sta.ssid) - 1);
+    strncpy((char*)s_wifi_config.sta.password, wifi_pass, sizeof(s_wifi_config.sta.password) - 1);
 
+    // El AP destino y la IP se fijan en cada intento (wifi_begin_connect)
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
+    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &s_wifi_config));
     ESP_ERROR_CHECK(esp_wifi_start());
 
     ESP_LOGI(TAG, "WiFi inicializado. Conectando a %s...", wifi_ssid);
 }
 
-// Tarea de conexión y monitoreo WiFi (se mantiene ejecutándose)
-void task_wifi_connection(void *pvParameters)
+// Primera conexión o reconexión: IP obtenida
+static void wifi_on_connected(bool first_connection)
 {
-    ESP_LOGI(TAG, "=== INICIANDO CONEXIÓN WIFI ===");
-    
-    // Inicializar WiFi
-    wifi_init_sta();
-    
-    // Esperar conexión o fallo
-    EventBits_t bits = xEventGroupWaitBits(s_wifi_event_group,
-                                          WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
-                                          pdFALSE,
-                                          pdFALSE,
-                                          portMAX_DELAY);
-
-    if (bits & WIFI_CONNECTED_BIT) {
-        ESP_LOGI(TAG, "✓ Conectado exitosamente a WiFi SSID: %s", wifi_ssid);
-        
-        // Obtener información de la conexión
-        wifi_ap_record_t ap_info;
-        if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
-            ESP_LOGI(TAG, "  - RSSI: %d dBm", ap_info.rssi);
-            ESP_LOGI(TAG, "  - Canal: %d", ap_info.primary);
-        }
-        
-        // Obtener IP
-        esp_netif_ip_info_t ip_info;
-        if (esp_netif_get_ip_info(sta_netif, &ip_info) == ESP_OK) {
-            // Usar un solo log para reducir uso de stack
-            ESP_LOGI(TAG, "  - IP: " IPSTR " | Mask: " IPSTR " | GW: " IPSTR,
-                     IP2STR(&ip_info.ip), IP2STR(&ip_info.netmask), IP2STR(&ip_info.gw));
-            
-            // Enviar log INFO de primera conexión exitosa (AQUÍ SÍ HAY STACK SUFICIENTE)
-            static bool first_connection = true;
-            if (first_connection) {
-                first_connection = false;
-                char details[128];
-                snprintf(details, sizeof(details), 
-                         "{\"ip\":\""IPSTR"\",\"ssid\":\"%s\"}", 
-                         IP2STR(&ip_info.ip), wifi_ssid);
-                error_logger_log_system(
-                    "WIFI_CONNECTED",
-                    ERROR_SEVERITY_INFO,
-                    "Conexión WiFi establecida exitosamente",
-                    details
-                );
-            }
-        }
+    uint32_t connect_ms = hal_clock_elapsed_ms(s_connect_start_ms);
+    metrics_histogram_record(s_fast_path ? METRIC_HIST_WIFI_CONNECT_FAST_MS : METRIC_HIST_WIFI_CONNECT_SCAN_MS,
+                             connect_ms);
+    pacing_reset_backoff(PACING_CHANNEL_WIFI);
+    send_led_status(SYSTEM_STATE_WIFI, "WiFi conectado");
+    ESP_LOGI(TAG, "✓ Conectado a WiFi SSID: %s en %lu ms (%s)", wifi_ssid, (unsigned long)connect_ms,
+             s_fast_path ? "directo" : "escaneo");
+
+    wifi_ap_record_t ap_info = {0};
+    if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
+        ESP_LOGI(TAG, "  - RSSI: %d dBm", ap_info.rssi);
+        ESP_LOGI(TAG, "  - Canal: %d", ap_info.primary);
+        wifi_remember_ap(&ap_info);
+    }
+
+    char details[128];
+    if (first_connection) {
+        esp_netif_ip_info_t ip_info = {0};
+        esp_netif_get_ip_info(sta_netif, &ip_info);
+        ESP_LOGI(TAG, "  - IP: " IPSTR " | Mask: " IPSTR " | GW: " IPSTR,
+                 IP2STR(&ip_info.ip), IP2STR(&ip_info.netmask), IP2STR(&ip_info.gw));
+        snprintf(details, sizeof(details),
+                 "{\"ip\":\""IPSTR"\",\"ssid\":\"%s\"}",
+                 IP2STR(&ip_info.ip), wifi_ssid);
+        error_logger_log_system(
+            "WIFI_CONNECTED",
+            ERROR_SEVERITY_INFO,
+            "Conexión WiFi establecida exitosamente",
+            details
+        );
         
         // Notificar al supervisor
         task_send_status(TASK_TYPE_WIFI, "WiFi conectado exitosamente");
         xSemaphoreGive(wifi_init_semaphore);
+    } else {
+        ESP_LOGI(TAG, "▶️ Conectividad restablecida - Tareas reanudadas");
         
-    } else if (bits & WIFI_FAIL_BIT) {
-        ESP_LOGE(TAG, "✗ Fallo conectando a WiFi SSID: %s", wifi_ssid);
-        task_report_error(TASK_TYPE_WIFI, TASK_ERROR_WIFI_CONNECTION_FAILED, "WiFi connection failed");
+        // Forzar reintento de errores pendientes
+        error_logger_trigger_retry();
         
-        // Log de fallo de conexión inicial (aquí sí tenemos stack suficiente)
-        char details[128];
-        snprintf(details, sizeof(details), 
-                 "{\"attempts\": %d, \"ssid\": \"%s\"}", 
-                 WIFI_MAXIMUM_RETRY, wifi_ssid);
+        snprintf(details, sizeof(details), "{\"ssid\": \"%s\", \"rssi\": %d}",
+                 wifi_ssid, ap_info.rssi);
         error_logger_log_system(
-            "WIFI_CONNECTION_FAILED",
-            ERROR_SEVERITY_CRITICAL,
-            "WiFi desconectado tras múltiples intentos",
+            "WIFI_RECONNECTED",
+            ERROR_SEVERITY_INFO,
+            "WiFi reconectado exitosamente",
             details
         );
-        
-        // NO bloqueamos aquí - continuamos al loop de monitoreo que reintentará periódicamente
-        ESP_LOGW(TAG, "⏭️ Continuando al loop de monitoreo - reintentará cada 60s");
-        
-        // No damos el semáforo en caso de fallo inicial
-    } else {
-        ESP_LOGE(TAG, "✗ Evento WiFi inesperado");
     }
+}
+
+// Tarea de conexión y supervisión WiFi (se mantiene ejecutándose)
+void task_wifi_connection(void *pvParameters)
+{
+    ESP_LOGI(TAG, "=== INICIANDO CONEXIÓN WIFI ===");
+    
+    // Inicializar WiFi (el intento arranca con WIFI_EVENT_STA_START)
+    wifi_init_sta();
     
-    // Loop de monitoreo WiFi - maneja reconexiones periódicas
-    uint32_t last_reconnect_attempt = xTaskGetTickCount();
-    uint32_t last_status_check = xTaskGetTickCount();
-    bool was_connected = (bits & WIFI_CONNECTED_BIT) != 0;
+    wifi_state_t state = WIFI_STATE_CONNECTING;
+    bool ever_connected = false;
+    bool failure_reported = false;      // Un log de fallo por corte, no uno por intento
+    int quick_retries = 0;              // Reintentos inmediatos del corte actual
+    uint32_t state_since_ms = hal_clock_now_ms();
+    uint32_t wait_ms = WIFI_CONNECT_TIMEOUT_MS;
+    uint32_t last_heartbeat_ms = hal_clock_now_ms();
+    s_connect_start_ms = state_since_ms;
     
     while (1) {
-        // Verificar estado cada 30 segundos
-        if ((xTaskGetTickCount() - last_status_check) > pdMS_TO_TICKS(30000)) {
-            wifi_ap_record_t ap_info;
-            esp_err_t ret = esp_wifi_sta_get_ap_info(&ap_info);
-            
-            if (ret == ESP_OK) {
-                // Conectado
-                if (!was_connected) {
-                    ESP_LOGI(TAG, "✅ WiFi reconectado exitosamente");
-                    send_led_status(SYSTEM_STATE_WIFI, "WiFi OK");
-                    s_retry_num = 0; // Resetear contador de reintentos
-                    was_connected = true;
-                    
-                    // Notificar reconexión
-                    xEventGroupSetBits(g_connectivity_event_group, CONNECTIVITY_WIFI_CONNECTED_BIT);
-                    ESP_LOGI(TAG, "▶️ Conectividad restablecida - Tareas reanudadas");
+        task_feed_watchdog(TASK_TYPE_WIFI);
+        
+        // Dormir hasta el próximo evento, el plazo del estado o el heartbeat
+        uint32_t sleep_ms = WIFI_HEARTBEAT_INTERVAL_MS;
+        if (state != WIFI_STATE_CONNECTED) {
+            uint32_t elapsed_ms = hal_clock_elapsed_ms(state_since_ms);
+            uint32_t remaining_ms = elapsed_ms < wait_ms ? wait_ms - elapsed_ms : 0;
+            if (remaining_ms < sleep_ms) {
+                sleep_ms = remaining_ms;
+            }
+        }
+        
+        wifi_msg_t msg;
+        if (xQueueReceive(s_wifi_queue, &msg, pdMS_TO_TICKS(sleep_ms)) == pdTRUE ||
+            wifi_reconcile(state, &msg)) {
+            switch (msg.type) {
+                case WIFI_MSG_STA_START:
+                    wifi_begin_connect();
+                    state = WIFI_STATE_CONNECTING;
+                    state_since_ms = hal_clock_now_ms();
+                    wait_ms = WIFI_CONNECT_TIMEOUT_MS;
+                    break;
                     
-                    // Forzar reintento de errores pendientes
-                    error_logger_trigger_retry();
+                case WIFI_MSG_GOT_IP:
+                    if (state != WIFI_STATE_CONNECTED) {
+                        wifi_on_connected(!ever_connected);
+                        ever_connected = true;
+                        failure_reported = false;
+                        quick_retries = 0;
+                        state = WIFI_STATE_CONNECTED;
+                    }
+                    break;
                     
-                    // Registrar recuperación de conexión
-                    char details[128];
-                    snprintf(details, sizeof(details), "{\"ssid\": \"%s\", \"rssi\": %d}", 
-                             wifi_ssid, ap_info.rssi);
-                    error_logger_log_system(
-                        "WIFI_RECONNECTED",
-                        ERROR_SEVERITY_INFO,
-                        "WiFi reconectado exitosamente",
-                        details
-                    );
-                }
-                
-                // Enviar heartbeat con información de señal
-                char heartbeat_msg[32];
-                snprintf(heartbeat_msg, sizeof(heartbeat_msg), "WiFi RSSI %d dBm", ap_info.rssi);
-                task_send_heartbeat(TASK_TYPE_WIFI, heartbeat_msg);
-                
-            } else {
-                // Desconectado - reintentar cada 60 segundos
-                if (was_connected) {
-                    // Primera vez que detectamos desconexión
-                    ESP_LOGW(TAG, "⚠ WiFi desconectado, comenzando reintentos periódicos...");
-                    send_led_status(SYSTEM_STATE_ESPERANDO_WIFI, "Reconectando");
-                    was_connected = false;
+                case WIFI_MSG_LOST_IP:
+                    // Asociado pero sin IP: se espera la renovación de DHCP un intento completo
+                    ESP_LOGW(TAG, "⏸️ IP perdida - Tareas pausadas");
+                    if (state == WIFI_STATE_CONNECTED) {
+                        state = WIFI_STATE_CONNECTING;
+                        state_since_ms = hal_clock_now_ms();
+                        s_connect_start_ms = state_since_ms;
+                        wait_ms = WIFI_CONNECT_TIMEOUT_MS;
+                    }
+                    break;
                     
-                    // Notificar pérdida de conectividad
-                    xEventGroupClearBits(g_connectivity_event_group, CONNECTIVITY_WIFI_CONNECTED_BIT);
-                    ESP_LOGW(TAG, "⏸️ Conectividad perdida - Tareas pausadas");
+                case WIFI_MSG_DISCONNECTED:
+                    if (state == WIFI_STATE_CONNECTED) {
+                        // Corte durante la operación: reintento inmediato
+                        ESP_LOGW(TAG, "⚠ WiFi desconectado (motivo %d) - Tareas pausadas", msg.reason);
+                        metrics_counter_inc(METRIC_WIFI_DISCONNECTS);
+                        send_led_status(SYSTEM_STATE_ESPERANDO_WIFI, "Reconectando");
+                        
+                        char details[128];
+                        snprintf(details, sizeof(details), "{\"ssid\": \"%s\", \"reason\": %d}",
+                                 wifi_ssid, msg.reason);
+                        error_logger_log_system(
+                            "WIFI_DISCONNECTED",
+                            ERROR_SEVERITY_WARNING,
+                            "WiFi desconectado durante operación normal",
+                            details
+                        );
+                        
+                        wifi_begin_connect();
+                        state = WIFI_STATE_CONNECTING;
+                        state_since_ms = hal_clock_now_ms();
+                        wait_ms = WIFI_CONNECT_TIMEOUT_MS;
+                        break;
+                    }
+                    if (state != WIFI_STATE_CONNECTING) {
+                        break;      // Eco de un intento ya abandonado
+                    }
                     
-                    // Log de desconexión WiFi durante monitoreo
-                    char details[128];
-                    snprintf(details, sizeof(details), "{\"ssid\": \"%s\"}", wifi_ssid);
-                    error_logger_log_system(
-                        "WIFI_DISCONNECTED",
-                        ERROR_SEVERITY_WARNING,
-                        "WiFi desconectado durante operación normal",
-                        details
-                    );
+                    if (s_fast_path) {
+                        // El AP guardado no respondió (otro canal, otro router): escaneo
+                        // completo sin gastar un reintento
+                        ESP_LOGW(TAG, "⚠️ Conexión directa falló (motivo %d), escaneo completo", msg.reason);
+                        metrics_counter_inc(METRIC_WIFI_FAST_FALLBACKS);
+                        s_fast_path = false;
+                        wifi_set_target(NULL);
+                        s_connect_start_ms = hal_clock_now_ms();
+                        esp_wifi_connect();
+                        state_since_ms = s_connect_start_ms;
+                        break;
+                    }
                     
-                    // Primer intento de reconexión
-                    s_retry_num = 0;
-                    esp_wifi_connect();
-                    last_reconnect_attempt = xTaskGetTickCount();
-                } else {
-                    // Ya sabíamos que estaba desconectado - reintentar cada 60s
-                    uint32_t time_since_last_attempt = xTaskGetTickCount() - last_reconnect_attempt;
-                    if (time_since_last_attempt > pdMS_TO_TICKS(60000)) {
-                        ESP_LOGI(TAG, "🔄 Reintentando conexión WiFi periódica...");
-                        s_retry_num = 0;
-                        xEventGroupClearBits(s_wifi_event_group, WIFI_FAIL_BIT);
+                    // Backoff adaptativo: primero reintentos inmediatos (cortes breves),
+                    // después esperas crecientes con jitter (pacing.c) hasta reconectar
+                    if (quick_retries < WIFI_MAXIMUM_RETRY && !reason_needs_backoff(msg.reason)) {
+                        quick_retries++;
+                        ESP_LOGI(TAG, "Reintentando conexión WiFi (%d/%d, motivo %d)",
+                                 quick_retries, WIFI_MAXIMUM_RETRY, msg.reason);
+                        send_led_status(SYSTEM_STATE_ESPERANDO_WIFI, "Reintentando");
                         esp_wifi_connect();
-                        last_reconnect_attempt = xTaskGetTickCount();
+                        state_since_ms = hal_clock_now_ms();
+                        break;
                     }
-                }
+                    
+                    wait_ms = pacing_next_backoff_ms(PACING_CHANNEL_WIFI);
+                    state = WIFI_STATE_WAIT_RETRY;
+                    state_since_ms = hal_clock_now_ms();
+                    ESP_LOGW(TAG, "⏱️ WiFi sin conexión (motivo %d), próximo intento en %lu ms",
+                             msg.reason, (unsigned long)wait_ms);
+                    
+                    if (!failure_reported) {
+                        failure_reported = true;
+                        ESP_LOGE(TAG, "✗ Fallo conectando a WiFi SSID: %s", wifi_ssid);
+                        send_led_status(SYSTEM_STATE_ERROR, "WiFi falló");
+                        task_report_error(TASK_TYPE_WIFI, TASK_ERROR_WIFI_CONNECTION_FAILED, "WiFi connection failed");
+                        
+                        char details[128];
+                        snprintf(details, sizeof(details),
+                                 "{\"attempts\": %d, \"ssid\": \"%s\", \"reason\": %d}",
+                                 quick_retries + 1, wifi_ssid, msg.reason);
+                        error_logger_log_system(
+                            "WIFI_CONNECTION_FAILED",
+                            ERROR_SEVERITY_CRITICAL,
+                            "WiFi desconectado tras múltiples intentos",
+                            details
+                        );
+                    }
+                    break;
             }
-            
-            last_status_check = xTaskGetTickCount();
+        } else if (state == WIFI_STATE_WAIT_RETRY &&
+                   hal_clock_elapsed_ms(state_since_ms) >= wait_ms) {
+            ESP_LOGI(TAG, "🔄 Reintentando conexión WiFi...");
+            wifi_begin_connect();
+            state = WIFI_STATE_CONNECTING;
+            state_since_ms = hal_clock_now_ms();
+            wait_ms = WIFI_CONNECT_TIMEOUT_MS;
+        } else if (state == WIFI_STATE_CONNECTING &&
+                   hal_clock_elapsed_ms(state_since_ms) >= wait_ms) {
+            // Intento colgado (sin IP ni desconexión): cortarlo; el
+            // WIFI_EVENT_STA_DISCONNECTED resultante sigue el camino normal
+            ESP_LOGW(TAG, "⏱️ Intento de conexión sin respuesta en %d ms, se corta", WIFI_CONNECT_TIMEOUT_MS);
+            esp_wifi_disconnect();
+            state_since_ms = hal_clock_now_ms();
         }
         
-        vTaskDelay(pdMS_TO_TICKS(5000)); // Verificar cada 5 segundos
+        // Heartbeat con información de señal (también alimenta el plazo del supervisor)
+        if (state == WIFI_STATE_CONNECTED &&
+            hal_clock_elapsed_ms(last_heartbeat_ms) >= WIFI_HEARTBEAT_INTERVAL_MS) {
+            wifi_ap_record_t ap_info;
+            if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
+                char heartbeat_msg[32];
+                snprintf(heartbeat_msg, sizeof(heartbeat_msg), "WiFi RSSI %d dBm", ap_info.rssi);
+                task_send_heartbeat(TASK_TYPE_WIFI, heartbeat_msg);
+            } else {
+                // Sin AP asociado: la desconexión se perdió; la próxima vuelta la reconcilia
+                ESP_LOGW(TAG, "⚠️ Heartbeat sin AP asociado, se trata como desconexión");
+                xEventGroupClearBits(g_connectivity_event_group, CONNECTIVITY_WIFI_CONNECTED_BIT);
+                wifi_msg_t lost = {.type = WIFI_MSG_DISCONNECTED, .reason = WIFI_REASON_UNSPECIFIED};
+                xQueueSend(s_wifi_queue, &lost, 0);
+            }
+            last_heartbeat_ms = hal_clock_now_ms();
+        }
     }
-}
\ No newline at end of file
+}
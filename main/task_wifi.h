@@ -6,14 +6,16 @@
 #include "freertos/event_groups.h"
 
 /**
- * @brief Tarea de conexión WiFi
+ * @brief Tarea de conexión y supervisión WiFi
  * 
- * Esta tarea se ejecuta una vez para establecer la conexión WiFi y luego se elimina.
+ * Máquina de estados guiada por eventos: duerme en una cola que llena el
+ * manejador de WIFI_EVENT/IP_EVENT, y solo despierta sin eventos al vencer un
+ * backoff, el plazo de un intento o el heartbeat.
  * Se encarga de:
  * - Inicializar el stack WiFi
- * - Configurar los parámetros de conexión
- * - Intentar conectar a la red especificada
- * - Reportar el resultado de la conexión
+ * - Conectar (directo al último AP o por escaneo) y reconectar con backoff
+ * - Mantener CONNECTIVITY_WIFI_CONNECTED_BIT (lo actualiza el propio manejador)
+ * - Reportar conexiones, cortes y fallos
  * 
  * @param pvParameters Parámetros de la tarea (no utilizados)
  */
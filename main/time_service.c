@@ -0,0 +1,168 @@
+#include "time_service.h"
+#include "config.h"
+#include "metrics.h"
+#include "sequence.h"
+#include "hal_clock.h"
+#include "hal_sntp.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+
+static const char *TAG = "TIME";
+
+// Recta epoch = mono + offset(mono), con offset(mono) = base_offset_us +
+// (mono - base_mono_us) * drift_ppb / 1e9. Cada sincronización mueve la base;
+// la deriva se mide contra un ancla separada al menos TIME_DRIFT_MIN_INTERVAL_MS.
+static SemaphoreHandle_t time_mutex = NULL;
+static bool synced = false;
+static int64_t base_mono_us = 0;
+static int64_t base_offset_us = 0;
+static int64_t anchor_mono_us = 0;
+static int64_t anchor_offset_us = 0;
+static int32_t drift_ppb = 0;
+static bool drift_valid = false;
+static uint32_t sync_count = 0;
+static int32_t last_correction_ms = 0;
+
+static void time_lock(void)
+{
+    if (time_mutex != NULL) {
+        xSemaphoreTake(time_mutex, portMAX_DELAY);
+    }
+}
+
+static void time_unlock(void)
+{
+    if (time_mutex != NULL) {
+        xSemaphoreGive(time_mutex);
+    }
+}
+
+// Desfase epoch - mono en un instante monotónico. Requiere time_lock().
+static int64_t offset_at_locked(int64_t mono_us)
+{
+    return base_offset_us + (mono_us - base_mono_us) * (int64_t)drift_ppb / 1000000000;
+}
+
+static void on_sntp_sync(int64_t epoch_us, int64_t mono_us)
+{
+    int64_t offset_us = epoch_us - mono_us;
+    bool stepped = false;
+
+    time_lock();
+    if (synced) {
+        last_correction_ms = (int32_t)((offset_us - offset_at_locked(mono_us)) / 1000);
+    }
+
+    int64_t elapsed_us = mono_us - anchor_mono_us;
+    bool rejected = false;
+    if (synced && (last_correction_ms >= TIME_STEP_THRESHOLD_MS || last_correction_ms <= -TIME_STEP_THRESHOLD_MS)) {
+        // La hora del servidor saltó: la deriva medida hasta acá no sirve
+        stepped = true;
+        drift_ppb = 0;
+        drift_valid = false;
+        anchor_mono_us = mono_us;
+        anchor_offset_us = offset_us;
+    } else if (!synced) {
+        anchor_mono_us = mono_us;
+        anchor_offset_us = offset_us;
+    } else if (elapsed_us >= (int64_t)TIME_DRIFT_MIN_INTERVAL_MS * 1000) {
+        double measured_ppb = (double)(offset_us - anchor_offset_us) * 1e9 / (double)elapsed_us;
+        if (measured_ppb > TIME_DRIFT_MAX_PPM * 1000.0 || measured_ppb < -TIME_DRIFT_MAX_PPM * 1000.0) {
+            rejected = true;    // Más de lo que deriva un cristal: ruido de la red, medir de nuevo
+        } else if (drift_valid) {
+            drift_ppb = (int32_t)((3.0 * drift_ppb + measured_ppb) / 4);
+        } else {
+            drift_ppb = (int32_t)measured_ppb;
+            drift_valid = true;
+        }
+        anchor_mono_us = mono_us;
+        anchor_offset_us = offset_us;
+    }
+
+    base_mono_us = mono_us;
+    base_offset_us = offset_us;
+    synced = true;
+    sync_count++;
+    uint32_t count = sync_count;
+    int32_t correction_ms = last_correction_ms;
+    int32_t drift = drift_ppb;
+    time_unlock();
+
+    metrics_counter_inc(METRIC_TIME_SYNCS);
+    if (stepped) {
+        metrics_counter_inc(METRIC_TIME_STEPS);
+        ESP_LOGW(TAG, "⚠️ Salto de hora de %ld ms: se vuelve a estimar la deriva", (long)correction_ms);
+    } else if (rejected) {
+        ESP_LOGD(TAG, "Deriva fuera de rango descartada (corrección %ld ms)", (long)correction_ms);
+    } else if (count == 1) {
+        ESP_LOGI(TAG, "🕒 Hora sincronizada: %lld ms UTC (arranque hace %lu ms)",
+                 (long long)(epoch_us / 1000), (unsigned long)(mono_us / 1000));
+    } else {
+        ESP_LOGI(TAG, "🕒 Sincronización %lu: corrección %ld ms, deriva %ld ppb",
+                 (unsigned long)count, (long)correction_ms, (long)drift);
+    }
+}
+
+esp_err_t time_service_init(void)
+{
+    if (time_mutex == NULL) {
+        time_mutex = xSemaphoreCreateMutex();
+        if (time_mutex == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    return hal_sntp_start(TIME_SNTP_SERVER, TIME_SNTP_INTERVAL_MS, on_sntp_sync);
+}
+
+bool time_service_is_synced(void)
+{
+    return synced;
+}
+
+int64_t time_service_now_epoch_ms(void)
+{
+    return time_service_stamp_to_epoch_ms(hal_clock_now_ms());
+}
+
+int64_t time_service_stamp_to_epoch_ms(uint32_t stamp_ms)
+{
+    if (!synced) {
+        return 0;
+    }
+    // Reconstruir el instante en µs de 64 bits a partir de los ms de 32 bits (con vuelta)
+    int64_t mono_us = hal_clock_now_us() - (int64_t)hal_clock_elapsed_ms(stamp_ms) * 1000;
+
+    time_lock();
+    int64_t epoch_us = mono_us + offset_at_locked(mono_us);
+    time_unlock();
+    return epoch_us / 1000;
+}
+
+void time_service_add_stamp_json(cJSON *object, uint32_t stamp_ms)
+{
+    if (object == NULL) {
+        return;
+    }
+    int64_t epoch_ms = time_service_stamp_to_epoch_ms(stamp_ms);
+    if (epoch_ms > 0) {
+        cJSON_AddNumberToObject(object, "timestamp", (double)epoch_ms);
+    }
+    cJSON_AddNumberToObject(object, "uptime_ms", stamp_ms);
+    cJSON_AddNumberToObject(object, "boot_id", sequence_boot_id());
+}
+
+void time_service_get_status(time_service_status_t *status)
+{
+    if (status == NULL) {
+        return;
+    }
+    time_lock();
+    status->synced = synced;
+    status->sync_count = sync_count;
+    status->last_sync_ms = (uint32_t)(base_mono_us / 1000);
+    status->last_correction_ms = last_correction_ms;
+    status->drift_ppb = drift_ppb;
+    status->drift_valid = drift_valid;
+    time_unlock();
+}
@@ -0,0 +1,66 @@
+#ifndef TIME_SERVICE_H
+#define TIME_SERVICE_H
+
+#include "esp_err.h"
+#include "cJSON.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Base de tiempo única: el tiempo monotónico es hal_clock (µs de esp_timer)
+// y la hora UTC se obtiene sumándole un desfase disciplinado por SNTP, con la
+// deriva del cristal estimada entre sincronizaciones.
+//
+// Las lecturas y los errores guardan solo el instante monotónico
+// (hal_clock_now_ms()); la hora UTC se calcula al armar el JSON. Así lo que
+// se tomó antes de la primera sincronización (o quedó en el buffer local)
+// sale igual con su hora real, corregida hacia atrás. Lo que se envía sin
+// sincronizar lleva uptime_ms y boot_id para que el backend lo ubique cuando
+// llegue un envío del mismo arranque con hora.
+
+// Estado de la sincronización (para logs)
+typedef struct {
+    bool synced;
+    uint32_t sync_count;
+    uint32_t last_sync_ms;          // hal_clock_now_ms() de la última sincronización
+    int32_t last_correction_ms;     // Error de la predicción corregido en la última sincronización
+    int32_t drift_ppb;              // Deriva estimada del reloj local (+ = atrasa)
+    bool drift_valid;
+} time_service_status_t;
+
+/**
+ * @brief Arrancar la sincronización SNTP (llamar con la red inicializada)
+ */
+esp_err_t time_service_init(void);
+
+/**
+ * @brief true si ya hubo al menos una sincronización
+ */
+bool time_service_is_synced(void);
+
+/**
+ * @brief Hora UTC actual en ms desde 1970 (0 sin sincronizar)
+ */
+int64_t time_service_now_epoch_ms(void);
+
+/**
+ * @brief Hora UTC de un instante tomado con hal_clock_now_ms() en este arranque
+ *
+ * El instante puede ser anterior a la primera sincronización (menos de ~49
+ * días atrás, por la vuelta de 32 bits).
+ *
+ * @return ms desde 1970, o 0 sin sincronizar
+ */
+int64_t time_service_stamp_to_epoch_ms(uint32_t stamp_ms);
+
+/**
+ * @brief Agregar a un payload "timestamp" (UTC en ms, solo sincronizado),
+ *        "uptime_ms" y "boot_id" de un instante de hal_clock_now_ms()
+ */
+void time_service_add_stamp_json(cJSON *object, uint32_t stamp_ms);
+
+/**
+ * @brief Copiar el estado de la sincronización
+ */
+void time_service_get_status(time_service_status_t *status);
+
+#endif // TIME_SERVICE_H